@@ -20,6 +20,7 @@
 
 #include "buffer_pool.h"
 
+#include <algorithm>
 #include <cstddef>
 
 #include "common/error.h"
@@ -31,24 +32,28 @@ namespace vkb
 BufferBlock::BufferBlock(Device &device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage) :
     buffer{device, size, usage, memory_usage}
 {
-	if (usage == VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+	const auto &limits = device.get_properties().limits;
+
+	// Allocations of buffers with several usages satisfy the offset alignment of each of them
+	if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
 	{
-		alignment = device.get_properties().limits.minUniformBufferOffsetAlignment;
+		alignment = std::max(alignment, limits.minUniformBufferOffsetAlignment);
 	}
-	else if (usage == VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+	if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
 	{
-		alignment = device.get_properties().limits.minStorageBufferOffsetAlignment;
+		alignment = std::max(alignment, limits.minStorageBufferOffsetAlignment);
 	}
-	else if (usage == VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT)
+	if (usage & VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT)
 	{
-		alignment = device.get_properties().limits.minTexelBufferOffsetAlignment;
+		alignment = std::max(alignment, limits.minTexelBufferOffsetAlignment);
 	}
-	else if (usage == VK_BUFFER_USAGE_INDEX_BUFFER_BIT || usage == VK_BUFFER_USAGE_VERTEX_BUFFER_BIT || usage == VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)
+	if (usage & (VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT))
 	{
 		// Used to calculate the offset, required when allocating memory (its value should be power of 2)
-		alignment = 16;
+		alignment = std::max<VkDeviceSize>(alignment, 16);
 	}
-	else
+
+	if (alignment == 0)
 	{
 		throw std::runtime_error("Usage not recognised");
 	}
@@ -133,12 +138,17 @@ BufferAllocation::BufferAllocation(core::Buffer &buffer, VkDeviceSize size, VkDe
 }
 
 void BufferAllocation::update(const std::vector<uint8_t> &data, uint32_t offset)
+{
+	update(data.data(), data.size(), offset);
+}
+
+void BufferAllocation::update(const uint8_t *data, size_t data_size, uint32_t offset)
 {
 	assert(buffer && "Invalid buffer pointer");
 
-	if (offset + data.size() <= size)
+	if (offset + data_size <= size)
 	{
-		buffer->update(data, static_cast<size_t>(base_offset) + offset);
+		buffer->update(data, data_size, static_cast<size_t>(base_offset) + offset);
 	}
 	else
 	{
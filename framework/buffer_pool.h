@@ -48,12 +48,12 @@ class BufferAllocation
 
 	void update(const std::vector<uint8_t> &data, uint32_t offset = 0);
 
+	void update(const uint8_t *data, size_t data_size, uint32_t offset = 0);
+
 	template <class T>
 	void update(const T &value, uint32_t offset = 0)
 	{
-		update(std::vector<uint8_t>{reinterpret_cast<const uint8_t *>(&value),
-		                            reinterpret_cast<const uint8_t *>(&value) + sizeof(T)},
-		       offset);
+		update(reinterpret_cast<const uint8_t *>(&value), sizeof(T), offset);
 	}
 
 	bool empty() const;
@@ -0,0 +1,118 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef VKB_TRACK_ALLOCATIONS
+namespace
+{
+std::atomic<uint64_t> heap_allocation_count{0};
+
+void *counted_malloc(std::size_t size) noexcept
+{
+	heap_allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+	return std::malloc(size == 0 ? 1 : size);
+}
+}        // namespace
+
+// The global allocation functions are replaced so that every allocation is counted,
+// this translation unit is linked in as long as the stats reference the counter
+
+void *operator new(std::size_t size)
+{
+	if (void *ptr = counted_malloc(size))
+	{
+		return ptr;
+	}
+
+	throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+	return counted_malloc(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+	return counted_malloc(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+	std::free(ptr);
+}
+#endif
+
+namespace vkb
+{
+bool is_heap_allocation_tracking_enabled()
+{
+#ifdef VKB_TRACK_ALLOCATIONS
+	return true;
+#else
+	return false;
+#endif
+}
+
+uint64_t get_heap_allocation_count()
+{
+#ifdef VKB_TRACK_ALLOCATIONS
+	return heap_allocation_count.load(std::memory_order_relaxed);
+#else
+	return 0;
+#endif
+}
+}        // namespace vkb
@@ -0,0 +1,198 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "frustum_culling.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#	define VKB_CULL_SSE
+#	include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#	define VKB_CULL_NEON
+#	include <arm_neon.h>
+#endif
+
+namespace vkb
+{
+namespace
+{
+/// Boxes tested per iteration
+constexpr size_t LANE_COUNT = 4;
+}        // namespace
+
+void extract_frustum_planes(const glm::mat4 &view_proj, glm::vec4 *planes)
+{
+	auto row = [&view_proj](int i) {
+		return glm::vec4{view_proj[0][i], view_proj[1][i], view_proj[2][i], view_proj[3][i]};
+	};
+
+	planes[0] = row(3) + row(0);
+	planes[1] = row(3) - row(0);
+	planes[2] = row(3) + row(1);
+	planes[3] = row(3) - row(1);
+	planes[4] = row(2);
+	planes[5] = row(3) - row(2);
+}
+
+void BoundsArray::resize(size_t new_count)
+{
+	count = new_count;
+
+	size_t padded_count = (count + LANE_COUNT - 1) / LANE_COUNT * LANE_COUNT;
+
+	for (auto values : {&center_x, &center_y, &center_z, &extent_x, &extent_y, &extent_z})
+	{
+		values->resize(padded_count, 0.0f);
+	}
+}
+
+size_t BoundsArray::size() const
+{
+	return count;
+}
+
+void BoundsArray::set(size_t index, const glm::vec3 &min, const glm::vec3 &max, const glm::mat4 &transform)
+{
+	assert(index < count && "Box index is out of bounds");
+
+	glm::vec3 center      = glm::vec3(transform * glm::vec4((min + max) * 0.5f, 1.0f));
+	glm::vec3 half_extent = (max - min) * 0.5f;
+
+	// Extent of the transformed box along the axes
+	glm::vec3 extent = glm::abs(glm::vec3(transform[0])) * half_extent.x +
+	                   glm::abs(glm::vec3(transform[1])) * half_extent.y +
+	                   glm::abs(glm::vec3(transform[2])) * half_extent.z;
+
+	center_x[index] = center.x;
+	center_y[index] = center.y;
+	center_z[index] = center.z;
+	extent_x[index] = extent.x;
+	extent_y[index] = extent.y;
+	extent_z[index] = extent.z;
+}
+
+glm::vec3 BoundsArray::get_center(size_t index) const
+{
+	return {center_x[index], center_y[index], center_z[index]};
+}
+
+size_t BoundsArray::cull(const glm::vec4 *planes, uint8_t *visible) const
+{
+	// A box is outside a plane if its center is further behind it than the projection of its extent on the normal
+	size_t visible_count = 0;
+
+	for (size_t first = 0; first < count; first += LANE_COUNT)
+	{
+		uint32_t lane_visible[LANE_COUNT];
+
+#if defined(VKB_CULL_SSE)
+		__m128 cx = _mm_loadu_ps(&center_x[first]);
+		__m128 cy = _mm_loadu_ps(&center_y[first]);
+		__m128 cz = _mm_loadu_ps(&center_z[first]);
+		__m128 ex = _mm_loadu_ps(&extent_x[first]);
+		__m128 ey = _mm_loadu_ps(&extent_y[first]);
+		__m128 ez = _mm_loadu_ps(&extent_z[first]);
+
+		__m128 inside = _mm_cmpeq_ps(cx, cx);
+
+		for (size_t i = 0; i < 6; ++i)
+		{
+			const auto &plane = planes[i];
+
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_mul_ps(cy, _mm_set1_ps(plane.y))),
+			                             _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+
+			__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(std::abs(plane.x))), _mm_mul_ps(ey, _mm_set1_ps(std::abs(plane.y)))),
+			                           _mm_mul_ps(ez, _mm_set1_ps(std::abs(plane.z))));
+
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+
+		for (size_t lane = 0; lane < LANE_COUNT; ++lane)
+		{
+			lane_visible[lane] = (mask >> lane) & 1;
+		}
+#elif defined(VKB_CULL_NEON)
+		float32x4_t cx = vld1q_f32(&center_x[first]);
+		float32x4_t cy = vld1q_f32(&center_y[first]);
+		float32x4_t cz = vld1q_f32(&center_z[first]);
+		float32x4_t ex = vld1q_f32(&extent_x[first]);
+		float32x4_t ey = vld1q_f32(&extent_y[first]);
+		float32x4_t ez = vld1q_f32(&extent_z[first]);
+
+		uint32x4_t inside = vdupq_n_u32(~0U);
+
+		for (size_t i = 0; i < 6; ++i)
+		{
+			const auto &plane = planes[i];
+
+			float32x4_t distance = vdupq_n_f32(plane.w);
+			distance             = vmlaq_n_f32(distance, cx, plane.x);
+			distance             = vmlaq_n_f32(distance, cy, plane.y);
+			distance             = vmlaq_n_f32(distance, cz, plane.z);
+			distance             = vmlaq_n_f32(distance, ex, std::abs(plane.x));
+			distance             = vmlaq_n_f32(distance, ey, std::abs(plane.y));
+			distance             = vmlaq_n_f32(distance, ez, std::abs(plane.z));
+
+			inside = vandq_u32(inside, vcgeq_f32(distance, vdupq_n_f32(0.0f)));
+		}
+
+		vst1q_u32(lane_visible, vshrq_n_u32(inside, 31));
+#else
+		for (size_t lane = 0; lane < LANE_COUNT; ++lane)
+		{
+			size_t index = first + lane;
+
+			lane_visible[lane] = 1;
+
+			for (size_t i = 0; i < 6; ++i)
+			{
+				const auto &plane = planes[i];
+
+				float distance = center_x[index] * plane.x + center_y[index] * plane.y + center_z[index] * plane.z + plane.w;
+				float radius   = extent_x[index] * std::abs(plane.x) + extent_y[index] * std::abs(plane.y) + extent_z[index] * std::abs(plane.z);
+
+				if (distance + radius < 0.0f)
+				{
+					lane_visible[lane] = 0;
+					break;
+				}
+			}
+		}
+#endif
+
+		// The padding boxes are tested along with the last ones, but not written
+		size_t lane_count = std::min(LANE_COUNT, count - first);
+
+		for (size_t lane = 0; lane < lane_count; ++lane)
+		{
+			visible[first + lane] = static_cast<uint8_t>(lane_visible[lane]);
+			visible_count += lane_visible[lane];
+		}
+	}
+
+	return visible_count;
+}
+}        // namespace vkb
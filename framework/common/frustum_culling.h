@@ -0,0 +1,106 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+/**
+ * @brief Extracts the frustum planes of a view projection matrix with a [0, 1] depth range
+ *        The normals of the planes point inside the frustum. The planes are not normalized,
+ *        as testing a box against them does not require it
+ * @param view_proj The view projection matrix
+ * @param planes Receives the left, right, bottom, top, near and far planes
+ */
+void extract_frustum_planes(const glm::mat4 &view_proj, glm::vec4 *planes);
+
+/**
+ * @brief Counters of the mesh instances tested against the camera frustum
+ */
+struct CullingCounters
+{
+	/// Mesh instances drawn
+	uint64_t visible{0};
+
+	/// Mesh instances skipped as they were outside the frustum
+	uint64_t culled{0};
+};
+
+/**
+ * @brief Axis aligned boxes stored as a structure of arrays, with the centers and the half
+ *        extents along each axis in arrays of their own, so that the frustum test of four
+ *        boxes takes the same SSE or NEON instructions as the test of one
+ */
+class BoundsArray
+{
+  public:
+	/**
+	 * @brief Resizes the array, new boxes are empty at the origin
+	 */
+	void resize(size_t count);
+
+	size_t size() const;
+
+	/**
+	 * @brief Stores the bounds of a box once transformed
+	 * @param index The index of the box
+	 * @param min Minimum corner of the box before the transform
+	 * @param max Maximum corner of the box before the transform
+	 * @param transform The transform of the box, usually its world matrix
+	 */
+	void set(size_t index, const glm::vec3 &min, const glm::vec3 &max, const glm::mat4 &transform);
+
+	glm::vec3 get_center(size_t index) const;
+
+	/**
+	 * @brief Tests every box against a frustum
+	 * @param planes The six planes of the frustum, with normals pointing inside
+	 * @param visible Receives 1 for each box intersecting the frustum, 0 otherwise
+	 * @return The number of visible boxes
+	 */
+	size_t cull(const glm::vec4 *planes, uint8_t *visible) const;
+
+  private:
+	size_t count{0};
+
+	// Padded to a multiple of the SIMD width, so that every box is loaded with a full vector
+	std::vector<float> center_x;
+
+	std::vector<float> center_y;
+
+	std::vector<float> center_z;
+
+	std::vector<float> extent_x;
+
+	std::vector<float> extent_y;
+
+	std::vector<float> extent_z;
+};
+}        // namespace vkb
@@ -47,12 +47,12 @@ VKBP_ENABLE_WARNINGS()
 namespace vkb
 {
 template <typename T>
-inline void read(std::istringstream &is, T &value)
+inline void read(std::istream &is, T &value)
 {
 	is.read(reinterpret_cast<char *>(&value), sizeof(T));
 }
 
-inline void read(std::istringstream &is, std::string &value)
+inline void read(std::istream &is, std::string &value)
 {
 	std::size_t size;
 	read(is, size);
@@ -61,7 +61,7 @@ inline void read(std::istringstream &is, std::string &value)
 }
 
 template <class T>
-inline void read(std::istringstream &is, std::set<T> &value)
+inline void read(std::istream &is, std::set<T> &value)
 {
 	std::size_t size;
 	read(is, size);
@@ -74,7 +74,7 @@ inline void read(std::istringstream &is, std::set<T> &value)
 }
 
 template <class T>
-inline void read(std::istringstream &is, std::vector<T> &value)
+inline void read(std::istream &is, std::vector<T> &value)
 {
 	std::size_t size;
 	read(is, size);
@@ -83,7 +83,7 @@ inline void read(std::istringstream &is, std::vector<T> &value)
 }
 
 template <class T, class S>
-inline void read(std::istringstream &is, std::map<T, S> &value)
+inline void read(std::istream &is, std::map<T, S> &value)
 {
 	std::size_t size;
 	read(is, size);
@@ -99,13 +99,13 @@ inline void read(std::istringstream &is, std::map<T, S> &value)
 }
 
 template <class T, uint32_t N>
-inline void read(std::istringstream &is, std::array<T, N> &value)
+inline void read(std::istream &is, std::array<T, N> &value)
 {
 	is.read(reinterpret_cast<char *>(value.data()), N * sizeof(T));
 }
 
 template <typename T, typename... Args>
-inline void read(std::istringstream &is, T &first_arg, Args &... args)
+inline void read(std::istream &is, T &first_arg, Args &... args)
 {
 	read(is, first_arg);
 
@@ -178,6 +178,21 @@ inline void hash_combine(size_t &seed, const T &v)
 	glm::detail::hash_combine(seed, hasher(v));
 }
 
+/**
+ * @brief FNV-1a hash of a byte range, used instead of std::hash
+ *        where the hash has to be stable across builds and runs
+ */
+inline uint64_t hash_bytes(const uint8_t *data, size_t size, uint64_t seed = 0xcbf29ce484222325ULL)
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		seed ^= data[i];
+		seed *= 0x100000001b3ULL;
+	}
+
+	return seed;
+}
+
 /**
  * @brief Helper function to convert a data type
  *        to string using output stream operator.
@@ -0,0 +1,126 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "linear_arena.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace vkb
+{
+constexpr size_t LinearArena::DEFAULT_BLOCK_SIZE;
+
+constexpr uint32_t LinearArena::SHRINK_RESET_COUNT;
+
+LinearArena::LinearArena(size_t block_size) :
+    min_block_size{block_size},
+    block_size{block_size}
+{
+	blocks.push_back({std::make_unique<uint8_t[]>(block_size), block_size});
+}
+
+void *LinearArena::allocate(size_t size, size_t alignment)
+{
+	assert((alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+
+	while (true)
+	{
+		auto &block = blocks[block_index];
+
+		auto address         = reinterpret_cast<uintptr_t>(block.data.get()) + block_offset;
+		auto aligned_address = (address + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+		auto aligned_offset  = block_offset + (aligned_address - address);
+
+		if (aligned_offset + size <= block.size)
+		{
+			block_offset = aligned_offset + size;
+			used_size    = used_size_in_previous_blocks + block_offset;
+
+			return block.data.get() + aligned_offset;
+		}
+
+		// Move to the next block, creating it if the current one was the last
+		used_size_in_previous_blocks += block.size;
+		block_offset = 0;
+		++block_index;
+
+		if (block_index == blocks.size())
+		{
+			auto new_block_size = std::max(block_size, size + alignment);
+			blocks.push_back({std::make_unique<uint8_t[]>(new_block_size), new_block_size});
+		}
+	}
+}
+
+void LinearArena::reset()
+{
+	peak_used_size = std::max(peak_used_size, used_size);
+
+	if (blocks.size() > 1)
+	{
+		// Merge the blocks so that the next frame fits in a single one
+		replace_blocks(get_capacity());
+	}
+	else if (++reset_count == SHRINK_RESET_COUNT)
+	{
+		// Give back the memory of a past spike, but not below the peak of the recent frames
+		if (peak_used_size < block_size / 2 && block_size > min_block_size)
+		{
+			replace_blocks(std::max(min_block_size, peak_used_size));
+		}
+
+		peak_used_size = 0;
+		reset_count    = 0;
+	}
+
+	block_index                  = 0;
+	block_offset                 = 0;
+	used_size                    = 0;
+	used_size_in_previous_blocks = 0;
+}
+
+void LinearArena::replace_blocks(size_t size)
+{
+	block_size = size;
+
+	blocks.clear();
+	blocks.push_back({std::make_unique<uint8_t[]>(block_size), block_size});
+
+	peak_used_size = 0;
+	reset_count    = 0;
+}
+
+size_t LinearArena::get_used_size() const
+{
+	return used_size;
+}
+
+size_t LinearArena::get_capacity() const
+{
+	size_t capacity{0};
+
+	for (auto &block : blocks)
+	{
+		capacity += block.size;
+	}
+
+	return capacity;
+}
+}        // namespace vkb
@@ -0,0 +1,183 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief Bump allocator for transient CPU data recorded within a frame
+ *
+ * Allocations are never freed individually, the whole arena is rewound by reset().
+ * If a frame needed more than one block, reset() replaces them with a single block
+ * big enough for all of them, so that a steady frame does not touch the heap.
+ * The block shrinks back once the frames have used less than half of it for a while,
+ * so that a single spike does not hold its memory for the lifetime of the arena.
+ */
+class LinearArena
+{
+  public:
+	/**
+	 * @brief Size of the first block in bytes
+	 */
+	static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+	/**
+	 * @brief Number of resets over which the peak usage is measured to shrink the block
+	 */
+	static constexpr uint32_t SHRINK_RESET_COUNT = 256;
+
+	LinearArena(size_t block_size = DEFAULT_BLOCK_SIZE);
+
+	LinearArena(const LinearArena &) = delete;
+
+	LinearArena(LinearArena &&) = default;
+
+	LinearArena &operator=(const LinearArena &) = delete;
+
+	LinearArena &operator=(LinearArena &&) = delete;
+
+	/**
+	 * @brief Allocates memory which stays valid until the next reset
+	 * @param size Size in bytes
+	 * @param alignment Alignment in bytes, must be a power of two
+	 * @return Pointer to the allocated memory
+	 */
+	void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	/**
+	 * @brief Allocates uninitialized memory for count objects of type T
+	 */
+	template <class T>
+	T *allocate(size_t count)
+	{
+		return static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	/**
+	 * @brief Rewinds the arena, invalidating all the allocations made from it
+	 *        The blocks are merged if there are several, and the block is shrunk to
+	 *        the peak usage if it stayed under half of it for SHRINK_RESET_COUNT resets
+	 */
+	void reset();
+
+	/**
+	 * @return Bytes allocated since the last reset, including alignment padding
+	 */
+	size_t get_used_size() const;
+
+	/**
+	 * @return Bytes owned by the arena
+	 */
+	size_t get_capacity() const;
+
+  private:
+	struct Block
+	{
+		std::unique_ptr<uint8_t[]> data;
+
+		size_t size;
+	};
+
+	/**
+	 * @brief Replaces the blocks with a single one
+	 */
+	void replace_blocks(size_t size);
+
+	std::vector<Block> blocks;
+
+	/// Size of the first block, which the arena does not shrink below
+	size_t min_block_size;
+
+	size_t block_size;
+
+	size_t block_index{0};
+
+	size_t block_offset{0};
+
+	size_t used_size{0};
+
+	size_t used_size_in_previous_blocks{0};
+
+	/// Highest usage since the block was last resized
+	size_t peak_used_size{0};
+
+	uint32_t reset_count{0};
+};
+
+/**
+ * @brief Standard allocator adaptor for containers whose memory lives in a LinearArena,
+ *        such containers must not outlive the reset of the arena
+ */
+template <class T>
+class ArenaAllocator
+{
+  public:
+	using value_type = T;
+
+	ArenaAllocator(LinearArena &arena) :
+	    arena{&arena}
+	{}
+
+	template <class U>
+	ArenaAllocator(const ArenaAllocator<U> &other) :
+	    arena{other.arena}
+	{}
+
+	T *allocate(size_t count)
+	{
+		return arena->allocate<T>(count);
+	}
+
+	void deallocate(T *, size_t)
+	{}
+
+	template <class U>
+	bool operator==(const ArenaAllocator<U> &other) const
+	{
+		return arena == other.arena;
+	}
+
+	template <class U>
+	bool operator!=(const ArenaAllocator<U> &other) const
+	{
+		return arena != other.arena;
+	}
+
+  private:
+	template <class U>
+	friend class ArenaAllocator;
+
+	LinearArena *arena;
+};
+
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+template <class Key, class T, class Compare = std::less<Key>>
+using ArenaMultimap = std::multimap<Key, T, Compare, ArenaAllocator<std::pair<const Key, T>>>;
+}        // namespace vkb
@@ -0,0 +1,64 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "push_constant_block.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace vkb
+{
+constexpr uint32_t PushConstantBlock::MAX_SIZE;
+
+void PushConstantBlock::store(const uint8_t *data, uint32_t data_size)
+{
+	if (size + data_size > MAX_SIZE)
+	{
+		throw std::runtime_error("Stored push constants exceed " + std::to_string(MAX_SIZE) + " bytes");
+	}
+
+	std::copy(data, data + data_size, values.begin() + size);
+	size += data_size;
+}
+
+uint32_t PushConstantBlock::accumulate(const uint8_t *data, uint32_t data_size, std::array<uint8_t, MAX_SIZE> &accumulated_values) const
+{
+	if (size + data_size > MAX_SIZE)
+	{
+		throw std::runtime_error("Accumulated push constants exceed " + std::to_string(MAX_SIZE) + " bytes");
+	}
+
+	auto end = std::copy(values.begin(), values.begin() + size, accumulated_values.begin());
+	std::copy(data, data + data_size, end);
+
+	return size + data_size;
+}
+
+void PushConstantBlock::clear()
+{
+	size = 0;
+}
+
+uint32_t PushConstantBlock::get_size() const
+{
+	return size;
+}
+}        // namespace vkb
@@ -0,0 +1,71 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace vkb
+{
+/**
+ * @brief Push constants stored by a command buffer to be prepended to the ones it records,
+ *        kept inline so that recording them does not touch the heap
+ */
+class PushConstantBlock
+{
+  public:
+	/// Capacity of the block, the largest maxPushConstantsSize exposed by mobile GPUs
+	static constexpr uint32_t MAX_SIZE = 256;
+
+	/**
+	 * @brief Appends data to the stored push constants
+	 * @param data Pointer to the data to be stored
+	 * @param size Size in bytes of the data
+	 * @throws std::runtime_error if the stored push constants would exceed MAX_SIZE
+	 */
+	void store(const uint8_t *data, uint32_t size);
+
+	/**
+	 * @brief Assembles the stored push constants followed by the given data
+	 * @param data Pointer to the data to be appended
+	 * @param size Size in bytes of the data
+	 * @param accumulated_values Receives the stored push constants followed by the data
+	 * @return The size in bytes of the accumulated push constants
+	 * @throws std::runtime_error if the accumulated push constants would exceed MAX_SIZE
+	 */
+	uint32_t accumulate(const uint8_t *data, uint32_t size, std::array<uint8_t, MAX_SIZE> &accumulated_values) const;
+
+	/**
+	 * @brief Removes the stored push constants
+	 */
+	void clear();
+
+	/**
+	 * @return The size in bytes of the stored push constants
+	 */
+	uint32_t get_size() const;
+
+  private:
+	std::array<uint8_t, MAX_SIZE> values{};
+
+	uint32_t size{0};
+};
+}        // namespace vkb
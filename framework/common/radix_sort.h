@@ -0,0 +1,108 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace vkb
+{
+/**
+ * @brief Sorts items by a 64-bit key with a least significant digit radix sort
+ *
+ * The sort is stable and runs one pass per byte of the key, skipping the bytes
+ * which are the same for all items, so keys which only use a few of their bits
+ * sort in fewer passes.
+ * @param items The items to sort
+ * @param scratch Storage for as many items, used between passes
+ * @param count The number of items
+ * @param get_key Returns the 64-bit key of an item
+ */
+template <class T, class KeyFunc>
+void radix_sort(T *items, T *scratch, size_t count, KeyFunc get_key)
+{
+	constexpr size_t DIGIT_BITS  = 8;
+	constexpr size_t DIGIT_COUNT = 64 / DIGIT_BITS;
+	constexpr size_t RADIX       = 1 << DIGIT_BITS;
+
+	if (count < 2)
+	{
+		return;
+	}
+
+	// Count the occurrences of every digit value in a single pass over the keys
+	std::array<std::array<size_t, RADIX>, DIGIT_COUNT> histograms{};
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		uint64_t key = get_key(items[i]);
+
+		for (size_t digit = 0; digit < DIGIT_COUNT; ++digit)
+		{
+			++histograms[digit][(key >> (digit * DIGIT_BITS)) & (RADIX - 1)];
+		}
+	}
+
+	T *source      = items;
+	T *destination = scratch;
+
+	for (size_t digit = 0; digit < DIGIT_COUNT; ++digit)
+	{
+		auto &histogram = histograms[digit];
+
+		// Skip the digit if all keys share its value
+		uint64_t first_value = (get_key(source[0]) >> (digit * DIGIT_BITS)) & (RADIX - 1);
+		if (histogram[first_value] == count)
+		{
+			continue;
+		}
+
+		// Turn the counts into the offset of the first item with each value
+		size_t offset = 0;
+		for (auto &value_count : histogram)
+		{
+			size_t value_offset = offset;
+			offset += value_count;
+			value_count = value_offset;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint64_t value = (get_key(source[i]) >> (digit * DIGIT_BITS)) & (RADIX - 1);
+
+			destination[histogram[value]++] = std::move(source[i]);
+		}
+
+		std::swap(source, destination);
+	}
+
+	// An odd number of passes leaves the result in the scratch storage
+	if (source != items)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			items[i] = std::move(source[i]);
+		}
+	}
+}
+}        // namespace vkb
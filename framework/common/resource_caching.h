@@ -28,8 +28,10 @@
 #include "rendering/pipeline_state.h"
 #include "rendering/render_target.h"
 #include "resource_record.h"
+#include "timer.h"
 
 #include "common/helpers.h"
+#include "common/resource_map.h"
 
 namespace std
 {
@@ -178,18 +180,7 @@ struct hash<vkb::SpecializationConstantState>
 {
 	std::size_t operator()(const vkb::SpecializationConstantState &specialization_constant_state) const
 	{
-		std::size_t result = 0;
-
-		for (auto constants : specialization_constant_state.get_specialization_constant_state())
-		{
-			vkb::hash_combine(result, constants.first);
-			for (const auto data : constants.second)
-			{
-				vkb::hash_combine(result, data);
-			}
-		}
-
-		return result;
+		return specialization_constant_state.get_hash();
 	}
 };
 
@@ -394,79 +385,8 @@ struct hash<vkb::PipelineState>
 {
 	std::size_t operator()(const vkb::PipelineState &pipeline_state) const
 	{
-		std::size_t result = 0;
-
-		vkb::hash_combine(result, pipeline_state.get_pipeline_layout().get_handle());
-
-		// For graphics only
-		if (auto render_pass = pipeline_state.get_render_pass())
-		{
-			vkb::hash_combine(result, render_pass->get_handle());
-		}
-
-		vkb::hash_combine(result, pipeline_state.get_specialization_constant_state());
-
-		vkb::hash_combine(result, pipeline_state.get_subpass_index());
-
-		for (auto stage : pipeline_state.get_pipeline_layout().get_shader_program().get_shader_modules())
-		{
-			vkb::hash_combine(result, stage->get_id());
-		}
-
-		// VkPipelineVertexInputStateCreateInfo
-		for (auto &attribute : pipeline_state.get_vertex_input_state().attributes)
-		{
-			vkb::hash_combine(result, attribute);
-		}
-
-		for (auto &binding : pipeline_state.get_vertex_input_state().bindings)
-		{
-			vkb::hash_combine(result, binding);
-		}
-
-		// VkPipelineInputAssemblyStateCreateInfo
-		vkb::hash_combine(result, pipeline_state.get_input_assembly_state().primitive_restart_enable);
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkPrimitiveTopology>::type>(pipeline_state.get_input_assembly_state().topology));
-
-		//VkPipelineViewportStateCreateInfo
-		vkb::hash_combine(result, pipeline_state.get_viewport_state().viewport_count);
-		vkb::hash_combine(result, pipeline_state.get_viewport_state().scissor_count);
-
-		// VkPipelineRasterizationStateCreateInfo
-		vkb::hash_combine(result, pipeline_state.get_rasterization_state().cull_mode);
-		vkb::hash_combine(result, pipeline_state.get_rasterization_state().depth_bias_enable);
-		vkb::hash_combine(result, pipeline_state.get_rasterization_state().depth_clamp_enable);
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkFrontFace>::type>(pipeline_state.get_rasterization_state().front_face));
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkPolygonMode>::type>(pipeline_state.get_rasterization_state().polygon_mode));
-		vkb::hash_combine(result, pipeline_state.get_rasterization_state().rasterizer_discard_enable);
-
-		// VkPipelineMultisampleStateCreateInfo
-		vkb::hash_combine(result, pipeline_state.get_multisample_state().alpha_to_coverage_enable);
-		vkb::hash_combine(result, pipeline_state.get_multisample_state().alpha_to_one_enable);
-		vkb::hash_combine(result, pipeline_state.get_multisample_state().min_sample_shading);
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkSampleCountFlagBits>::type>(pipeline_state.get_multisample_state().rasterization_samples));
-		vkb::hash_combine(result, pipeline_state.get_multisample_state().sample_shading_enable);
-		vkb::hash_combine(result, pipeline_state.get_multisample_state().sample_mask);
-
-		// VkPipelineDepthStencilStateCreateInfo
-		vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().back);
-		vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().depth_bounds_test_enable);
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkCompareOp>::type>(pipeline_state.get_depth_stencil_state().depth_compare_op));
-		vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().depth_test_enable);
-		vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().depth_write_enable);
-		vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().front);
-		vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().stencil_test_enable);
-
-		// VkPipelineColorBlendStateCreateInfo
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkLogicOp>::type>(pipeline_state.get_color_blend_state().logic_op));
-		vkb::hash_combine(result, pipeline_state.get_color_blend_state().logic_op_enable);
-
-		for (auto &attachment : pipeline_state.get_color_blend_state().attachments)
-		{
-			vkb::hash_combine(result, attachment);
-		}
-
-		return result;
+		// Maintained incrementally by the pipeline state setters
+		return pipeline_state.get_hash();
 	}
 };
 }        // namespace std
@@ -618,6 +538,20 @@ struct RecordHelper<ShaderModule, A...>
 	}
 };
 
+template <class... A>
+struct RecordHelper<DescriptorSetLayout, A...>
+{
+	size_t record(ResourceRecord &recorder, A &... args)
+	{
+		return recorder.register_descriptor_set_layout(args...);
+	}
+
+	void index(ResourceRecord &recorder, size_t index, DescriptorSetLayout &descriptor_set_layout)
+	{
+		recorder.set_descriptor_set_layout(index, descriptor_set_layout);
+	}
+};
+
 template <class... A>
 struct RecordHelper<PipelineLayout, A...>
 {
@@ -659,22 +593,26 @@ struct RecordHelper<GraphicsPipeline, A...>
 		recorder.set_graphics_pipeline(index, graphics_pipeline);
 	}
 };
-}        // namespace
 
-template <class T, class... A>
-T &request_resource(Device &device, ResourceRecord *recorder, std::unordered_map<std::size_t, T> &resources, A &... args)
+template <class... A>
+struct RecordHelper<ComputePipeline, A...>
 {
-	RecordHelper<T, A...> record_helper;
-
-	std::size_t hash{0U};
-	hash_param(hash, args...);
-
-	auto res_it = resources.find(hash);
+	size_t record(ResourceRecord &recorder, A &... args)
+	{
+		return recorder.register_compute_pipeline(args...);
+	}
 
-	if (res_it != resources.end())
+	void index(ResourceRecord &recorder, size_t index, ComputePipeline &compute_pipeline)
 	{
-		return res_it->second;
+		recorder.set_compute_pipeline(index, compute_pipeline);
 	}
+};
+}        // namespace
+
+template <class T, class M, class... A>
+T &create_resource(Device &device, ResourceRecord *recorder, M &resources, std::size_t hash, A &... args)
+{
+	RecordHelper<T, A...> record_helper;
 
 	// If we do not have it already, create and cache it
 	const char *res_type = typeid(T).name();
@@ -696,13 +634,13 @@ T &request_resource(Device &device, ResourceRecord *recorder, std::unordered_map
 			throw std::runtime_error{std::string{"Insertion error for #"} + std::to_string(res_id) + "cache object (" + res_type + ")"};
 		}
 
-		res_it = res_ins_it.first;
-
 		if (recorder)
 		{
 			size_t index = record_helper.record(*recorder, args...);
-			record_helper.index(*recorder, index, res_it->second);
+			record_helper.index(*recorder, index, res_ins_it.first->second);
 		}
+
+		return res_ins_it.first->second;
 #ifndef DEBUG
 	}
 	catch (const std::exception &e)
@@ -711,7 +649,59 @@ T &request_resource(Device &device, ResourceRecord *recorder, std::unordered_map
 		throw e;
 	}
 #endif
+}
+
+template <class T, class... A>
+T &request_resource(Device &device, ResourceRecord *recorder, std::unordered_map<std::size_t, T> &resources, A &... args)
+{
+	std::size_t hash{0U};
+	hash_param(hash, args...);
+
+	auto res_it = resources.find(hash);
+
+	if (res_it != resources.end())
+	{
+		return res_it->second;
+	}
+
+	return create_resource<T>(device, recorder, resources, hash, args...);
+}
+
+/**
+ * @brief Requests a resource from a map shared between threads
+ *        Lookups of existing resources do not lock, only creation synchronizes
+ *        and at most one resource is created per hash
+ */
+template <class T, class... A>
+T &request_resource(Device &device, ResourceRecord *recorder, ResourceMap<T> &resources, A &... args)
+{
+	std::size_t hash{0U};
+	hash_param(hash, args...);
+
+	if (T *resource = resources.find(hash))
+	{
+		resources.record_hit();
+
+		return *resource;
+	}
+
+	std::lock_guard<std::mutex> guard(resources.get_mutex());
+
+	// Another thread may have created it while we were waiting for the lock
+	if (T *resource = resources.find(hash))
+	{
+		resources.record_hit();
+
+		return *resource;
+	}
+
+	Timer timer;
+	timer.start();
+
+	T &resource = create_resource<T>(device, recorder, resources, hash, args...);
+
+	resources.record_miss(static_cast<uint64_t>(timer.stop<Timer::Microseconds>()));
 
-	return res_it->second;
+	return resource;
 }
 }        // namespace vkb
@@ -0,0 +1,602 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief Limits on the resources kept alive by a ResourceMap, a value of zero disables a limit
+ */
+struct EvictionPolicy
+{
+	/// Resources which have not been requested for this many frames are retired
+	uint32_t max_unused_frames{0};
+
+	/// Least recently used resources are retired while there are more than this
+	std::size_t max_count{0};
+
+	/**
+	 * @return Whether any limit is set, otherwise resources are only destroyed in bulk
+	 */
+	bool is_enabled() const
+	{
+		return max_unused_frames != 0 || max_count != 0;
+	}
+};
+
+/**
+ * @brief Number of resources in a ResourceMap and an estimate of the host memory they use
+ */
+struct ResourceUsage
+{
+	std::size_t count{0};
+
+	std::size_t retired_count{0};
+
+	std::size_t host_bytes{0};
+};
+
+/**
+ * @brief Snapshot of the lookups served by a ResourceMap
+ */
+struct ResourceCounters
+{
+	/// Number of buckets of the creation time histogram
+	static const std::size_t histogram_bucket_count = 8;
+
+	/// Requests served by an existing resource
+	uint64_t hits{0};
+
+	/// Requests which created a new resource
+	uint64_t misses{0};
+
+	/// Total time spent creating resources, in microseconds
+	uint64_t creation_time{0};
+
+	/// Creation times bucketed by get_histogram_bucket_bound()
+	std::array<uint64_t, histogram_bucket_count> creation_histogram{};
+
+	/**
+	 * @param bucket Index of a histogram bucket
+	 * @return The exclusive upper bound of the bucket in microseconds, or zero for the last (unbounded) bucket
+	 */
+	static uint64_t get_histogram_bucket_bound(std::size_t bucket)
+	{
+		static const std::array<uint64_t, histogram_bucket_count> bounds{{100, 500, 1000, 5000, 10000, 50000, 100000, 0}};
+
+		return bounds[bucket];
+	}
+
+	/**
+	 * @return The index of the histogram bucket holding a creation time
+	 */
+	static std::size_t get_histogram_bucket(uint64_t microseconds)
+	{
+		std::size_t bucket = 0;
+
+		while (bucket < histogram_bucket_count - 1 && microseconds >= get_histogram_bucket_bound(bucket))
+		{
+			++bucket;
+		}
+
+		return bucket;
+	}
+};
+
+/**
+ * @brief Read-mostly map of cached resources indexed by hash.
+ *
+ * Resources are owned by an unordered_map, which keeps references stable across rehashes.
+ * Next to it the map publishes a lock-free index (array of atomic bucket chains) so that
+ * find() never takes a lock. Writers serialize on the map mutex, and insert new entries
+ * at the head of a bucket with release semantics, so a reader either sees a fully built
+ * entry or falls back to the locked path of request_resource.
+ *
+ * When the index grows, a new table is published and the old one is retired. Retired tables
+ * are only freed by clear(), erase() or evict(), which must not run concurrently with any lookup.
+ *
+ * Every lookup stamps the resource with the current frame number. evict() moves resources out
+ * of the map according to an EvictionPolicy, and keeps them alive until release_retired() is told
+ * that the last frame which used them has completed on the GPU.
+ *
+ * Hits, misses and creation times reported by request_resource are accumulated with relaxed
+ * atomics, and can be read at any time with get_counters(). Hits are reported on every lookup,
+ * so each thread counts them in its own cache line, and they are only summed by get_counters().
+ */
+template <class T>
+class ResourceMap
+{
+  public:
+	using iterator = typename std::unordered_map<std::size_t, T>::iterator;
+
+	using const_iterator = typename std::unordered_map<std::size_t, T>::const_iterator;
+
+	ResourceMap()
+	{
+		rebuild_index(true);
+	}
+
+	ResourceMap(const ResourceMap &) = delete;
+
+	ResourceMap(ResourceMap &&) = delete;
+
+	ResourceMap &operator=(const ResourceMap &) = delete;
+
+	ResourceMap &operator=(ResourceMap &&) = delete;
+
+	/**
+	 * @brief Lock-free lookup of a resource
+	 * @param hash Hash of the resource
+	 * @return Pointer to the resource, or nullptr if it is not (yet) published
+	 */
+	T *find(std::size_t hash) const
+	{
+		const Table *table = current.load(std::memory_order_acquire);
+
+		for (const Entry *entry = table->buckets[hash & table->mask].load(std::memory_order_acquire); entry != nullptr; entry = entry->next)
+		{
+			if (entry->hash == hash)
+			{
+				// Only write when the stamp changes, to avoid sharing the cache line on every hit
+				uint64_t frame_number = frame.load(std::memory_order_relaxed);
+				if (entry->last_used->load(std::memory_order_relaxed) != frame_number)
+				{
+					entry->last_used->store(frame_number, std::memory_order_relaxed);
+				}
+
+				return entry->resource;
+			}
+		}
+
+		return nullptr;
+	}
+
+	/**
+	 * @brief Checks if a resource is cached, without stamping it. Not safe against concurrent insertions
+	 */
+	bool contains(std::size_t hash) const
+	{
+		return resources.find(hash) != resources.end();
+	}
+
+	/**
+	 * @brief Mutex that writers must hold while calling emplace()
+	 */
+	std::mutex &get_mutex()
+	{
+		return mutex;
+	}
+
+	/**
+	 * @brief Inserts a resource and publishes it to lock-free readers
+	 *        The caller must hold the map mutex
+	 */
+	std::pair<iterator, bool> emplace(std::size_t hash, T &&resource)
+	{
+		auto res_ins_it = resources.emplace(hash, std::move(resource));
+
+		if (res_ins_it.second)
+		{
+			auto &last_used_frame = last_used.emplace(std::piecewise_construct,
+			                                          std::forward_as_tuple(hash),
+			                                          std::forward_as_tuple(frame.load(std::memory_order_relaxed)))
+			                            .first->second;
+
+			publish(hash, res_ins_it.first->second, last_used_frame);
+		}
+
+		return res_ins_it;
+	}
+
+	/**
+	 * @brief Removes a resource. Not safe against concurrent lookups
+	 */
+	void erase(std::size_t hash)
+	{
+		resources.erase(hash);
+		last_used.erase(hash);
+
+		rebuild_index(true);
+	}
+
+	/**
+	 * @brief Removes several resources by unlinking them from the index, so the cost does not
+	 *        depend on the number of cached resources. Not safe against concurrent lookups
+	 * @param hashes Container of the hashes of the resources
+	 */
+	template <class Hashes>
+	void erase_all(const Hashes &hashes)
+	{
+		Table &table = *tables.back();
+
+		for (auto hash : hashes)
+		{
+			unlink(table, hash);
+
+			resources.erase(hash);
+			last_used.erase(hash);
+		}
+
+		// Older tables still refer to the removed resources, only the current one is kept
+		tables.erase(tables.begin(), tables.end() - 1);
+	}
+
+	/**
+	 * @brief Removes all resources. Not safe against concurrent lookups
+	 */
+	void clear()
+	{
+		resources.clear();
+		last_used.clear();
+		retired.clear();
+
+		rebuild_index(true);
+	}
+
+	/**
+	 * @brief Sets the frame number stamped on resources when they are requested
+	 */
+	void set_frame(uint64_t frame_number)
+	{
+		frame.store(frame_number, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Retires resources according to a policy. Not safe against concurrent lookups
+	 * @return The number of resources retired
+	 */
+	std::size_t evict(const EvictionPolicy &policy)
+	{
+		if (!policy.is_enabled())
+		{
+			return 0;
+		}
+
+		uint64_t frame_number = frame.load(std::memory_order_relaxed);
+
+		std::vector<std::size_t>                      expired;
+		std::vector<std::pair<uint64_t, std::size_t>> candidates;
+
+		for (auto &last_used_it : last_used)
+		{
+			uint64_t used = last_used_it.second.load(std::memory_order_relaxed);
+
+			if (policy.max_unused_frames > 0 && frame_number - used >= policy.max_unused_frames)
+			{
+				expired.push_back(last_used_it.first);
+			}
+			else
+			{
+				candidates.emplace_back(used, last_used_it.first);
+			}
+		}
+
+		// Retire the least recently used resources over capacity
+		if (policy.max_count > 0 && candidates.size() > policy.max_count)
+		{
+			auto excess = candidates.size() - policy.max_count;
+
+			std::nth_element(candidates.begin(), candidates.begin() + excess, candidates.end());
+
+			std::transform(candidates.begin(), candidates.begin() + excess, std::back_inserter(expired),
+			               [](const std::pair<uint64_t, std::size_t> &candidate) { return candidate.second; });
+		}
+
+		if (expired.empty())
+		{
+			return 0;
+		}
+
+		for (auto hash : expired)
+		{
+			auto res_it = resources.find(hash);
+			auto it     = last_used.find(hash);
+
+			retired.emplace_back(it->second.load(std::memory_order_relaxed), std::move(res_it->second));
+
+			resources.erase(res_it);
+			last_used.erase(it);
+		}
+
+		rebuild_index(true);
+
+		return expired.size();
+	}
+
+	/**
+	 * @brief Destroys retired resources whose last frame has completed on the GPU
+	 * @param completed_frame Latest frame number known to have finished executing
+	 * @param release Called on each resource right before it is destroyed
+	 */
+	template <class F>
+	void release_retired(uint64_t completed_frame, F release)
+	{
+		auto it = retired.begin();
+		while (it != retired.end())
+		{
+			if (it->first <= completed_frame)
+			{
+				release(it->second);
+				it = retired.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	/**
+	 * @brief Counts a request served by an existing resource
+	 */
+	void record_hit()
+	{
+		hit_shards[get_hit_shard()].count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Counts a request which created a new resource
+	 * @param microseconds Time spent creating the resource
+	 */
+	void record_miss(uint64_t microseconds)
+	{
+		miss_count.fetch_add(1, std::memory_order_relaxed);
+		creation_time.fetch_add(microseconds, std::memory_order_relaxed);
+		creation_histogram[ResourceCounters::get_histogram_bucket(microseconds)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	ResourceCounters get_counters() const
+	{
+		ResourceCounters counters{};
+
+		for (auto &shard : hit_shards)
+		{
+			counters.hits += shard.count.load(std::memory_order_relaxed);
+		}
+
+		counters.misses        = miss_count.load(std::memory_order_relaxed);
+		counters.creation_time = creation_time.load(std::memory_order_relaxed);
+
+		for (std::size_t bucket = 0; bucket < ResourceCounters::histogram_bucket_count; ++bucket)
+		{
+			counters.creation_histogram[bucket] = creation_histogram[bucket].load(std::memory_order_relaxed);
+		}
+
+		return counters;
+	}
+
+	ResourceUsage get_usage() const
+	{
+		ResourceUsage usage{};
+
+		usage.count         = resources.size();
+		usage.retired_count = retired.size();
+		usage.host_bytes    = (usage.count + usage.retired_count) * sizeof(T) + last_used.size() * sizeof(std::atomic<uint64_t>);
+
+		for (auto &table : tables)
+		{
+			usage.host_bytes += table->entries.size() * sizeof(Entry) + (table->mask + 1) * sizeof(std::atomic<Entry *>);
+		}
+
+		return usage;
+	}
+
+	std::size_t size() const
+	{
+		return resources.size();
+	}
+
+	bool empty() const
+	{
+		return resources.empty();
+	}
+
+	iterator begin()
+	{
+		return resources.begin();
+	}
+
+	iterator end()
+	{
+		return resources.end();
+	}
+
+	const_iterator begin() const
+	{
+		return resources.begin();
+	}
+
+	const_iterator end() const
+	{
+		return resources.end();
+	}
+
+  private:
+	struct Entry
+	{
+		std::size_t hash;
+
+		T *resource;
+
+		std::atomic<uint64_t> *last_used;
+
+		Entry *next;
+	};
+
+	struct Table
+	{
+		explicit Table(std::size_t bucket_count) :
+		    mask{bucket_count - 1},
+		    buckets{new std::atomic<Entry *>[bucket_count]}
+		{
+			for (std::size_t i = 0; i < bucket_count; ++i)
+			{
+				buckets[i].store(nullptr, std::memory_order_relaxed);
+			}
+		}
+
+		std::size_t mask;
+
+		std::unique_ptr<std::atomic<Entry *>[]> buckets;
+
+		std::vector<std::unique_ptr<Entry>> entries;
+	};
+
+	static constexpr std::size_t min_bucket_count = 64;
+
+	/// Number of hit counters, threads beyond this share them
+	static constexpr std::size_t hit_shard_count = 16;
+
+	/// Size of the cache line a hit counter is padded to
+	static constexpr std::size_t cache_line_size = 64;
+
+	struct HitShard
+	{
+		std::atomic<uint64_t> count{0};
+
+		uint8_t padding[cache_line_size - sizeof(std::atomic<uint64_t>)];
+	};
+
+	/**
+	 * @return The hit counter of the calling thread, threads are assigned one in turn
+	 */
+	static std::size_t get_hit_shard()
+	{
+		static std::atomic<std::size_t> next_shard{0};
+
+		static thread_local std::size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % hit_shard_count;
+
+		return shard;
+	}
+
+	void publish(std::size_t hash, T &resource, std::atomic<uint64_t> &last_used_frame)
+	{
+		Table *table = tables.back().get();
+
+		// Keep load factor at most one, growing into a fresh table readers can switch to
+		if (table->entries.size() >= table->mask + 1)
+		{
+			rebuild_index(false);
+			return;
+		}
+
+		link(*table, hash, resource, last_used_frame);
+	}
+
+	static void link(Table &table, std::size_t hash, T &resource, std::atomic<uint64_t> &last_used_frame)
+	{
+		auto &bucket = table.buckets[hash & table.mask];
+
+		table.entries.emplace_back(new Entry{hash, &resource, &last_used_frame, bucket.load(std::memory_order_relaxed)});
+
+		bucket.store(table.entries.back().get(), std::memory_order_release);
+	}
+
+	/**
+	 * @brief Removes the entry of a resource from the chain of its bucket, the entry itself
+	 *        is owned by the table until the index is rebuilt
+	 */
+	static void unlink(Table &table, std::size_t hash)
+	{
+		auto &bucket = table.buckets[hash & table.mask];
+
+		Entry *entry = bucket.load(std::memory_order_relaxed);
+
+		if (entry != nullptr && entry->hash == hash)
+		{
+			bucket.store(entry->next, std::memory_order_relaxed);
+			return;
+		}
+
+		for (; entry != nullptr && entry->next != nullptr; entry = entry->next)
+		{
+			if (entry->next->hash == hash)
+			{
+				entry->next = entry->next->next;
+				return;
+			}
+		}
+	}
+
+	void rebuild_index(bool release_retired)
+	{
+		std::size_t bucket_count = min_bucket_count;
+		while (bucket_count < resources.size() * 2)
+		{
+			bucket_count *= 2;
+		}
+
+		std::unique_ptr<Table> table = std::make_unique<Table>(bucket_count);
+
+		for (auto &resource_it : resources)
+		{
+			link(*table, resource_it.first, resource_it.second, last_used.at(resource_it.first));
+		}
+
+		current.store(table.get(), std::memory_order_release);
+
+		// Readers may still walk older tables, so they are only released outside of lookups
+		if (release_retired)
+		{
+			tables.clear();
+		}
+
+		tables.push_back(std::move(table));
+	}
+
+	std::unordered_map<std::size_t, T> resources;
+
+	/// Frame in which each resource was last requested
+	std::unordered_map<std::size_t, std::atomic<uint64_t>> last_used;
+
+	/// Resources evicted from the map, with the last frame they were used in
+	std::list<std::pair<uint64_t, T>> retired;
+
+	std::atomic<uint64_t> frame{0};
+
+	std::array<HitShard, hit_shard_count> hit_shards{};
+
+	std::atomic<uint64_t> miss_count{0};
+
+	std::atomic<uint64_t> creation_time{0};
+
+	std::array<std::atomic<uint64_t>, ResourceCounters::histogram_bucket_count> creation_histogram{};
+
+	std::atomic<Table *> current{nullptr};
+
+	std::vector<std::unique_ptr<Table>> tables;
+
+	std::mutex mutex;
+};
+}        // namespace vkb
@@ -20,6 +20,8 @@
 
 #include "command_buffer.h"
 
+#include <cstring>
+
 #include "command_pool.h"
 #include "common/error.h"
 #include "device.h"
@@ -29,6 +31,10 @@
 
 namespace vkb
 {
+constexpr uint32_t CommandBuffer::MAX_PUSH_CONSTANTS_SIZE;
+
+constexpr uint32_t CommandBuffer::MAX_SHADOWED_BINDINGS;
+
 CommandBuffer::CommandBuffer(CommandPool &command_pool, VkCommandBufferLevel level) :
     command_pool{command_pool},
     level{level}
@@ -60,7 +66,8 @@ CommandBuffer::CommandBuffer(CommandBuffer &&other) :
     command_pool{other.command_pool},
     level{other.level},
     handle{other.handle},
-    state{other.state}
+    state{other.state},
+    deferred_recording{other.deferred_recording}
 {
 	other.handle = VK_NULL_HANDLE;
 	other.state  = State::Invalid;
@@ -76,6 +83,13 @@ const VkCommandBuffer &CommandBuffer::get_handle() const
 	return handle;
 }
 
+LinearArena &CommandBuffer::get_arena()
+{
+	assert(command_pool.get_render_frame() && "The command pool must be associated to a render frame");
+
+	return command_pool.get_render_frame()->get_arena(command_pool.get_thread_index());
+}
+
 bool CommandBuffer::is_recording() const
 {
 	return state == State::Recording;
@@ -83,7 +97,14 @@ bool CommandBuffer::is_recording() const
 
 void CommandBuffer::clear(VkClearAttachment attachment, VkClearRect rect)
 {
-	vkCmdClearAttachments(handle, 1, &attachment, 1, &rect);
+	if (recording_to_stream)
+	{
+		command_stream.clear_attachments(1, &attachment, 1, &rect);
+	}
+	else
+	{
+		vkCmdClearAttachments(handle, 1, &attachment, 1, &rect);
+	}
 }
 
 VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, CommandBuffer *primary_cmd_buf)
@@ -101,7 +122,11 @@ VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, CommandBuffer *pr
 	pipeline_state.reset();
 	resource_binding_state.reset();
 	descriptor_set_layout_binding_state.clear();
+	descriptor_set_binding_state.clear();
 	stored_push_constants.clear();
+	shadow_state             = {};
+	state_command_counters   = {};
+	current_subpass_contents = VK_SUBPASS_CONTENTS_INLINE;
 
 	VkCommandBufferBeginInfo       begin_info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
 	VkCommandBufferInheritanceInfo inheritance = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
@@ -114,12 +139,34 @@ VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, CommandBuffer *pr
 		auto render_pass_binding        = primary_cmd_buf->get_current_render_pass();
 		current_render_pass.render_pass = render_pass_binding.render_pass;
 		current_render_pass.framebuffer = render_pass_binding.framebuffer;
+		current_render_pass.extent      = render_pass_binding.extent;
 
 		inheritance.renderPass  = current_render_pass.render_pass->get_handle();
 		inheritance.framebuffer = current_render_pass.framebuffer->get_handle();
 		inheritance.subpass     = primary_cmd_buf->get_current_subpass_index();
 
 		begin_info.pInheritanceInfo = &inheritance;
+
+		// Pipelines are created for the subpass continued by this command buffer
+		pipeline_state.set_subpass_index(inheritance.subpass);
+
+		auto blend_state = pipeline_state.get_color_blend_state();
+		blend_state.attachments.resize(current_render_pass.render_pass->get_color_output_count(inheritance.subpass));
+		pipeline_state.set_color_blend_state(blend_state);
+	}
+
+	recording_to_stream = deferred_recording;
+
+	if (recording_to_stream)
+	{
+		assert(command_pool.get_render_frame() && "Deferred recording needs a command buffer allocated from a render frame");
+
+		// The command buffer is begun at end(), when the stream is translated
+		begin_flags      = flags;
+		inheritance_info = inheritance;
+		command_stream.reset(get_arena());
+
+		return VK_SUCCESS;
 	}
 
 	return vkBeginCommandBuffer(get_handle(), &begin_info);
@@ -134,6 +181,28 @@ VkResult CommandBuffer::end()
 		return VK_NOT_READY;
 	}
 
+	if (recording_to_stream)
+	{
+		VkCommandBufferBeginInfo begin_info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+		begin_info.flags = begin_flags;
+
+		if (level == VK_COMMAND_BUFFER_LEVEL_SECONDARY)
+		{
+			begin_info.pInheritanceInfo = &inheritance_info;
+		}
+
+		VkResult result = vkBeginCommandBuffer(get_handle(), &begin_info);
+
+		if (result != VK_SUCCESS)
+		{
+			return result;
+		}
+
+		command_stream.execute(get_handle());
+
+		recording_to_stream = false;
+	}
+
 	vkEndCommandBuffer(get_handle());
 
 	state = State::Executable;
@@ -147,11 +216,13 @@ void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const s
 	pipeline_state.reset();
 	resource_binding_state.reset();
 	descriptor_set_layout_binding_state.clear();
+	descriptor_set_binding_state.clear();
 
 	// Create render pass
 	assert(subpasses.size() > 0 && "Cannot create a render pass without any subpass");
-	std::vector<SubpassInfo> subpass_infos(subpasses.size());
-	auto                     subpass_info_it = subpass_infos.begin();
+	// The subpass infos are kept between render passes so that their storage is reused
+	subpass_infos.resize(subpasses.size());
+	auto subpass_info_it = subpass_infos.begin();
 	for (auto &subpass : subpasses)
 	{
 		subpass_info_it->input_attachments  = subpass->get_input_attachments();
@@ -161,6 +232,8 @@ void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const s
 	}
 	current_render_pass.render_pass = &get_device().get_resource_cache().request_render_pass(render_target.get_attachments(), load_store_infos, subpass_infos);
 	current_render_pass.framebuffer = &get_device().get_resource_cache().request_framebuffer(render_target, *current_render_pass.render_pass);
+	current_render_pass.extent      = render_target.get_extent();
+	current_subpass_contents        = contents;
 
 	// Begin render pass
 	VkRenderPassBeginInfo begin_info{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
@@ -170,7 +243,14 @@ void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const s
 	begin_info.clearValueCount   = to_u32(clear_values.size());
 	begin_info.pClearValues      = clear_values.data();
 
-	vkCmdBeginRenderPass(get_handle(), &begin_info, contents);
+	if (recording_to_stream)
+	{
+		command_stream.begin_render_pass(begin_info, contents);
+	}
+	else
+	{
+		vkCmdBeginRenderPass(get_handle(), &begin_info, contents);
+	}
 
 	// Update blend state attachments for first subpass
 	auto blend_state = pipeline_state.get_color_blend_state();
@@ -178,8 +258,10 @@ void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const s
 	pipeline_state.set_color_blend_state(blend_state);
 }
 
-void CommandBuffer::next_subpass()
+void CommandBuffer::next_subpass(VkSubpassContents contents)
 {
+	current_subpass_contents = contents;
+
 	// Increment subpass index
 	pipeline_state.set_subpass_index(pipeline_state.get_subpass_index() + 1);
 
@@ -191,16 +273,72 @@ void CommandBuffer::next_subpass()
 	// Reset descriptor sets
 	resource_binding_state.reset();
 	descriptor_set_layout_binding_state.clear();
+	descriptor_set_binding_state.clear();
 
 	// Clear stored push constants
 	stored_push_constants.clear();
 
-	vkCmdNextSubpass(get_handle(), VK_SUBPASS_CONTENTS_INLINE);
+	if (recording_to_stream)
+	{
+		command_stream.next_subpass(contents);
+	}
+	else
+	{
+		vkCmdNextSubpass(get_handle(), contents);
+	}
+}
+
+VkSubpassContents CommandBuffer::get_current_subpass_contents() const
+{
+	return current_subpass_contents;
+}
+
+CommandBuffer &CommandBuffer::request_secondary_command_buffer(size_t thread_index)
+{
+	auto render_frame = command_pool.get_render_frame();
+
+	assert(render_frame && "Secondary command buffers are requested from the render frame of the primary one");
+
+	auto &queue = get_device().get_queue(command_pool.get_queue_family_index(), 0);
+
+	auto &secondary_command_buffer = render_frame->request_command_buffer(queue, command_pool.get_reset_mode(), VK_COMMAND_BUFFER_LEVEL_SECONDARY, thread_index);
+
+	secondary_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, this);
+
+	// Specialization constants set on the primary command buffer apply to the pipelines of the secondary one
+	for (auto &constant : pipeline_state.get_specialization_constant_state().get_specialization_constant_state())
+	{
+		secondary_command_buffer.set_specialization_constant(constant.first, constant.second);
+	}
+
+	// Dynamic state is not inherited by secondary command buffers
+	VkViewport viewport{};
+	viewport.width    = static_cast<float>(current_render_pass.extent.width);
+	viewport.height   = static_cast<float>(current_render_pass.extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	secondary_command_buffer.set_viewport(0, 1, &viewport);
+
+	VkRect2D scissor{};
+	scissor.extent = current_render_pass.extent;
+	secondary_command_buffer.set_scissor(0, 1, &scissor);
+
+	return secondary_command_buffer;
 }
 
 void CommandBuffer::execute_commands(CommandBuffer &secondary_command_buffer)
 {
-	vkCmdExecuteCommands(get_handle(), 1, &secondary_command_buffer.get_handle());
+	if (recording_to_stream)
+	{
+		command_stream.execute_commands(1, &secondary_command_buffer.get_handle());
+	}
+	else
+	{
+		vkCmdExecuteCommands(get_handle(), 1, &secondary_command_buffer.get_handle());
+	}
+
+	// The state is undefined after executing secondary command buffers
+	shadow_state = {};
 }
 
 void CommandBuffer::execute_commands(std::vector<CommandBuffer *> &secondary_command_buffers)
@@ -208,12 +346,29 @@ void CommandBuffer::execute_commands(std::vector<CommandBuffer *> &secondary_com
 	std::vector<VkCommandBuffer> sec_cmd_buf_handles(secondary_command_buffers.size(), VK_NULL_HANDLE);
 	std::transform(secondary_command_buffers.begin(), secondary_command_buffers.end(), sec_cmd_buf_handles.begin(),
 	               [](const vkb::CommandBuffer *sec_cmd_buf) { return sec_cmd_buf->get_handle(); });
-	vkCmdExecuteCommands(get_handle(), to_u32(sec_cmd_buf_handles.size()), sec_cmd_buf_handles.data());
+	if (recording_to_stream)
+	{
+		command_stream.execute_commands(to_u32(sec_cmd_buf_handles.size()), sec_cmd_buf_handles.data());
+	}
+	else
+	{
+		vkCmdExecuteCommands(get_handle(), to_u32(sec_cmd_buf_handles.size()), sec_cmd_buf_handles.data());
+	}
+
+	// The state is undefined after executing secondary command buffers
+	shadow_state = {};
 }
 
 void CommandBuffer::end_render_pass()
 {
-	vkCmdEndRenderPass(get_handle());
+	if (recording_to_stream)
+	{
+		command_stream.end_render_pass();
+	}
+	else
+	{
+		vkCmdEndRenderPass(get_handle());
+	}
 }
 
 void CommandBuffer::bind_pipeline_layout(PipelineLayout &pipeline_layout)
@@ -228,33 +383,59 @@ void CommandBuffer::set_specialization_constant(uint32_t constant_id, const std:
 
 void CommandBuffer::set_push_constants(const std::vector<uint8_t> &values)
 {
-	stored_push_constants.insert(stored_push_constants.end(), values.begin(), values.end());
+	set_push_constants(values.data(), to_u32(values.size()));
+}
+
+void CommandBuffer::set_push_constants(const uint8_t *data, uint32_t size)
+{
+	stored_push_constants.store(data, size);
 }
 
 void CommandBuffer::push_constants_accumulated(const std::vector<uint8_t> &values, uint32_t offset)
 {
-	auto accumulated_values = stored_push_constants;
-	accumulated_values.insert(accumulated_values.end(), values.begin(), values.end());
+	push_constants_accumulated(values.data(), to_u32(values.size()), offset);
+}
 
-	push_constants(offset, accumulated_values);
+void CommandBuffer::push_constants_accumulated(const uint8_t *data, uint32_t size, uint32_t offset)
+{
+	if (stored_push_constants.get_size() == 0)
+	{
+		push_constants(offset, data, size);
+		return;
+	}
+
+	std::array<uint8_t, MAX_PUSH_CONSTANTS_SIZE> accumulated_values;
+
+	uint32_t accumulated_size = stored_push_constants.accumulate(data, size, accumulated_values);
+
+	push_constants(offset, accumulated_values.data(), accumulated_size);
 }
 
 void CommandBuffer::push_constants(uint32_t offset, const std::vector<uint8_t> &values)
 {
-	auto accumulated_values = stored_push_constants;
-	accumulated_values.insert(accumulated_values.end(), values.begin(), values.end());
+	push_constants(offset, values.data(), to_u32(values.size()));
+}
 
+void CommandBuffer::push_constants(uint32_t offset, const uint8_t *data, uint32_t size)
+{
 	const PipelineLayout &pipeline_layout = pipeline_state.get_pipeline_layout();
 
-	VkShaderStageFlags shader_stage = pipeline_layout.get_push_constant_range_stage(offset, to_u32(values.size()));
+	VkShaderStageFlags shader_stage = pipeline_layout.get_push_constant_range_stage(offset, size);
 
 	if (shader_stage)
 	{
-		vkCmdPushConstants(get_handle(), pipeline_layout.get_handle(), shader_stage, offset, to_u32(values.size()), values.data());
+		if (recording_to_stream)
+		{
+			command_stream.push_constants(pipeline_layout.get_handle(), shader_stage, offset, size, data);
+		}
+		else
+		{
+			vkCmdPushConstants(get_handle(), pipeline_layout.get_handle(), shader_stage, offset, size, data);
+		}
 	}
 	else
 	{
-		LOGW("Push constant range [{}, {}] not found", offset, values.size());
+		LOGW("Push constant range [{}, {}] not found", offset, size);
 	}
 }
 
@@ -273,17 +454,117 @@ void CommandBuffer::bind_input(const core::ImageView &image_view, uint32_t set,
 	resource_binding_state.bind_input(image_view, set, binding, array_element);
 }
 
+void CommandBuffer::bind_descriptor_set(uint32_t set, const DescriptorSet &descriptor_set)
+{
+	auto &bound_descriptor_set = descriptor_set_binding_state[set];
+
+	if (bound_descriptor_set != &descriptor_set)
+	{
+		bound_descriptor_set = &descriptor_set;
+
+		// Force the set to be bound on the next flush
+		descriptor_set_layout_binding_state.erase(set);
+	}
+}
+
 void CommandBuffer::bind_vertex_buffers(uint32_t first_binding, const std::vector<std::reference_wrapper<const vkb::core::Buffer>> &buffers, const std::vector<VkDeviceSize> &offsets)
 {
-	std::vector<VkBuffer> buffer_handles(buffers.size(), VK_NULL_HANDLE);
-	std::transform(buffers.begin(), buffers.end(), buffer_handles.begin(),
+	// Bindings past the shadowed ones are always bound, but the shadowed bindings
+	// the command overwrites are updated so that a later bind is compared with them
+	bool bound = first_binding + buffers.size() <= MAX_SHADOWED_BINDINGS;
+
+	for (size_t i = 0; i < buffers.size() && first_binding + i < MAX_SHADOWED_BINDINGS; ++i)
+	{
+		bound = bound && shadow_state.vertex_buffers[first_binding + i] == buffers[i].get().get_handle() &&
+		        shadow_state.vertex_buffer_offsets[first_binding + i] == offsets[i];
+
+		shadow_state.vertex_buffers[first_binding + i]        = buffers[i].get().get_handle();
+		shadow_state.vertex_buffer_offsets[first_binding + i] = offsets[i];
+	}
+
+	if (bound)
+	{
+		count_state_command(StateCommand::BindVertexBuffers, true);
+		return;
+	}
+
+	count_state_command(StateCommand::BindVertexBuffers, false);
+
+	auto render_frame = command_pool.get_render_frame();
+
+	if (!render_frame)
+	{
+		std::vector<VkBuffer> buffer_handles(buffers.size(), VK_NULL_HANDLE);
+		std::transform(buffers.begin(), buffers.end(), buffer_handles.begin(),
+		               [](const core::Buffer &buffer) { return buffer.get_handle(); });
+		vkCmdBindVertexBuffers(get_handle(), first_binding, to_u32(buffer_handles.size()), buffer_handles.data(), offsets.data());
+		return;
+	}
+
+	// The handles only need to live until the command is recorded
+	auto buffer_handles = render_frame->get_arena(command_pool.get_thread_index()).allocate<VkBuffer>(buffers.size());
+	std::transform(buffers.begin(), buffers.end(), buffer_handles,
 	               [](const core::Buffer &buffer) { return buffer.get_handle(); });
-	vkCmdBindVertexBuffers(get_handle(), first_binding, to_u32(buffer_handles.size()), buffer_handles.data(), offsets.data());
+	if (recording_to_stream)
+	{
+		command_stream.bind_vertex_buffers(first_binding, to_u32(buffers.size()), buffer_handles, offsets.data());
+	}
+	else
+	{
+		vkCmdBindVertexBuffers(get_handle(), first_binding, to_u32(buffers.size()), buffer_handles, offsets.data());
+	}
+}
+
+void CommandBuffer::bind_vertex_buffer(uint32_t binding, const core::Buffer &buffer, VkDeviceSize offset)
+{
+	VkBuffer buffer_handle = buffer.get_handle();
+
+	if (binding < MAX_SHADOWED_BINDINGS)
+	{
+		if (shadow_state.vertex_buffers[binding] == buffer_handle && shadow_state.vertex_buffer_offsets[binding] == offset)
+		{
+			count_state_command(StateCommand::BindVertexBuffers, true);
+			return;
+		}
+
+		shadow_state.vertex_buffers[binding]        = buffer_handle;
+		shadow_state.vertex_buffer_offsets[binding] = offset;
+	}
+
+	count_state_command(StateCommand::BindVertexBuffers, false);
+
+	if (recording_to_stream)
+	{
+		command_stream.bind_vertex_buffers(binding, 1, &buffer_handle, &offset);
+	}
+	else
+	{
+		vkCmdBindVertexBuffers(get_handle(), binding, 1, &buffer_handle, &offset);
+	}
 }
 
 void CommandBuffer::bind_index_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkIndexType index_type)
 {
-	vkCmdBindIndexBuffer(get_handle(), buffer.get_handle(), offset, index_type);
+	if (shadow_state.index_buffer == buffer.get_handle() && shadow_state.index_buffer_offset == offset && shadow_state.index_type == index_type)
+	{
+		count_state_command(StateCommand::BindIndexBuffer, true);
+		return;
+	}
+
+	shadow_state.index_buffer        = buffer.get_handle();
+	shadow_state.index_buffer_offset = offset;
+	shadow_state.index_type          = index_type;
+
+	count_state_command(StateCommand::BindIndexBuffer, false);
+
+	if (recording_to_stream)
+	{
+		command_stream.bind_index_buffer(buffer.get_handle(), offset, index_type);
+	}
+	else
+	{
+		vkCmdBindIndexBuffer(get_handle(), buffer.get_handle(), offset, index_type);
+	}
 }
 
 void CommandBuffer::set_viewport_state(const ViewportState &state_info)
@@ -323,59 +604,187 @@ void CommandBuffer::set_color_blend_state(const ColorBlendState &state_info)
 
 void CommandBuffer::set_viewport(uint32_t first_viewport, const std::vector<VkViewport> &viewports)
 {
-	vkCmdSetViewport(get_handle(), first_viewport, to_u32(viewports.size()), viewports.data());
+	set_viewport(first_viewport, to_u32(viewports.size()), viewports.data());
+}
+
+void CommandBuffer::set_viewport(uint32_t first_viewport, uint32_t viewport_count, const VkViewport *viewports)
+{
+	// Viewports past the shadowed ones are always set, but the shadowed viewports
+	// the command overwrites are updated so that a later command is compared with them
+	bool set = first_viewport + viewport_count <= MAX_SHADOWED_BINDINGS;
+
+	for (uint32_t i = 0; i < viewport_count && first_viewport + i < MAX_SHADOWED_BINDINGS; ++i)
+	{
+		auto index = first_viewport + i;
+
+		set = set && (shadow_state.valid_viewports & (1u << index)) &&
+		      std::memcmp(&shadow_state.viewports[index], &viewports[i], sizeof(VkViewport)) == 0;
+
+		shadow_state.viewports[index] = viewports[i];
+		shadow_state.valid_viewports |= 1u << index;
+	}
+
+	if (set)
+	{
+		count_state_command(StateCommand::SetViewport, true);
+		return;
+	}
+
+	count_state_command(StateCommand::SetViewport, false);
+
+	if (recording_to_stream)
+	{
+		command_stream.set_viewport(first_viewport, viewport_count, viewports);
+	}
+	else
+	{
+		vkCmdSetViewport(get_handle(), first_viewport, viewport_count, viewports);
+	}
 }
 
 void CommandBuffer::set_scissor(uint32_t first_scissor, const std::vector<VkRect2D> &scissors)
 {
-	vkCmdSetScissor(get_handle(), first_scissor, to_u32(scissors.size()), scissors.data());
+	set_scissor(first_scissor, to_u32(scissors.size()), scissors.data());
+}
+
+void CommandBuffer::set_scissor(uint32_t first_scissor, uint32_t scissor_count, const VkRect2D *scissors)
+{
+	// Scissors past the shadowed ones are always set, but the shadowed scissors
+	// the command overwrites are updated so that a later command is compared with them
+	bool set = first_scissor + scissor_count <= MAX_SHADOWED_BINDINGS;
+
+	for (uint32_t i = 0; i < scissor_count && first_scissor + i < MAX_SHADOWED_BINDINGS; ++i)
+	{
+		auto index = first_scissor + i;
+
+		set = set && (shadow_state.valid_scissors & (1u << index)) &&
+		      std::memcmp(&shadow_state.scissors[index], &scissors[i], sizeof(VkRect2D)) == 0;
+
+		shadow_state.scissors[index] = scissors[i];
+		shadow_state.valid_scissors |= 1u << index;
+	}
+
+	if (set)
+	{
+		count_state_command(StateCommand::SetScissor, true);
+		return;
+	}
+
+	count_state_command(StateCommand::SetScissor, false);
+
+	if (recording_to_stream)
+	{
+		command_stream.set_scissor(first_scissor, scissor_count, scissors);
+	}
+	else
+	{
+		vkCmdSetScissor(get_handle(), first_scissor, scissor_count, scissors);
+	}
 }
 
 void CommandBuffer::set_line_width(float line_width)
 {
-	vkCmdSetLineWidth(get_handle(), line_width);
+	if (recording_to_stream)
+	{
+		command_stream.set_line_width(line_width);
+	}
+	else
+	{
+		vkCmdSetLineWidth(get_handle(), line_width);
+	}
 }
 
 void CommandBuffer::set_depth_bias(float depth_bias_constant_factor, float depth_bias_clamp, float depth_bias_slope_factor)
 {
-	vkCmdSetDepthBias(get_handle(), depth_bias_constant_factor, depth_bias_clamp, depth_bias_slope_factor);
+	if (recording_to_stream)
+	{
+		command_stream.set_depth_bias(depth_bias_constant_factor, depth_bias_clamp, depth_bias_slope_factor);
+	}
+	else
+	{
+		vkCmdSetDepthBias(get_handle(), depth_bias_constant_factor, depth_bias_clamp, depth_bias_slope_factor);
+	}
 }
 
 void CommandBuffer::set_blend_constants(const std::array<float, 4> &blend_constants)
 {
-	vkCmdSetBlendConstants(get_handle(), blend_constants.data());
+	if (recording_to_stream)
+	{
+		command_stream.set_blend_constants(blend_constants.data());
+	}
+	else
+	{
+		vkCmdSetBlendConstants(get_handle(), blend_constants.data());
+	}
 }
 
 void CommandBuffer::set_depth_bounds(float min_depth_bounds, float max_depth_bounds)
 {
-	vkCmdSetDepthBounds(get_handle(), min_depth_bounds, max_depth_bounds);
+	if (recording_to_stream)
+	{
+		command_stream.set_depth_bounds(min_depth_bounds, max_depth_bounds);
+	}
+	else
+	{
+		vkCmdSetDepthBounds(get_handle(), min_depth_bounds, max_depth_bounds);
+	}
 }
 
 void CommandBuffer::draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance)
 {
-	flush_pipeline_state(VK_PIPELINE_BIND_POINT_GRAPHICS);
+	if (!flush_pipeline_state(VK_PIPELINE_BIND_POINT_GRAPHICS))
+	{
+		return;
+	}
 
 	flush_descriptor_state(VK_PIPELINE_BIND_POINT_GRAPHICS);
 
-	vkCmdDraw(get_handle(), vertex_count, instance_count, first_vertex, first_instance);
+	if (recording_to_stream)
+	{
+		command_stream.draw(vertex_count, instance_count, first_vertex, first_instance);
+	}
+	else
+	{
+		vkCmdDraw(get_handle(), vertex_count, instance_count, first_vertex, first_instance);
+	}
 }
 
 void CommandBuffer::draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance)
 {
-	flush_pipeline_state(VK_PIPELINE_BIND_POINT_GRAPHICS);
+	if (!flush_pipeline_state(VK_PIPELINE_BIND_POINT_GRAPHICS))
+	{
+		return;
+	}
 
 	flush_descriptor_state(VK_PIPELINE_BIND_POINT_GRAPHICS);
 
-	vkCmdDrawIndexed(get_handle(), index_count, instance_count, first_index, vertex_offset, first_instance);
+	if (recording_to_stream)
+	{
+		command_stream.draw_indexed(index_count, instance_count, first_index, vertex_offset, first_instance);
+	}
+	else
+	{
+		vkCmdDrawIndexed(get_handle(), index_count, instance_count, first_index, vertex_offset, first_instance);
+	}
 }
 
 void CommandBuffer::draw_indexed_indirect(const core::Buffer &buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride)
 {
-	flush_pipeline_state(VK_PIPELINE_BIND_POINT_GRAPHICS);
+	if (!flush_pipeline_state(VK_PIPELINE_BIND_POINT_GRAPHICS))
+	{
+		return;
+	}
 
 	flush_descriptor_state(VK_PIPELINE_BIND_POINT_GRAPHICS);
 
-	vkCmdDrawIndexedIndirect(get_handle(), buffer.get_handle(), offset, draw_count, stride);
+	if (recording_to_stream)
+	{
+		command_stream.draw_indexed_indirect(buffer.get_handle(), offset, draw_count, stride);
+	}
+	else
+	{
+		vkCmdDrawIndexedIndirect(get_handle(), buffer.get_handle(), offset, draw_count, stride);
+	}
 }
 
 void CommandBuffer::dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
@@ -384,7 +793,14 @@ void CommandBuffer::dispatch(uint32_t group_count_x, uint32_t group_count_y, uin
 
 	flush_descriptor_state(VK_PIPELINE_BIND_POINT_COMPUTE);
 
-	vkCmdDispatch(get_handle(), group_count_x, group_count_y, group_count_z);
+	if (recording_to_stream)
+	{
+		command_stream.dispatch(group_count_x, group_count_y, group_count_z);
+	}
+	else
+	{
+		vkCmdDispatch(get_handle(), group_count_x, group_count_y, group_count_z);
+	}
 }
 
 void CommandBuffer::dispatch_indirect(const core::Buffer &buffer, VkDeviceSize offset)
@@ -393,40 +809,82 @@ void CommandBuffer::dispatch_indirect(const core::Buffer &buffer, VkDeviceSize o
 
 	flush_descriptor_state(VK_PIPELINE_BIND_POINT_COMPUTE);
 
-	vkCmdDispatchIndirect(get_handle(), buffer.get_handle(), offset);
+	if (recording_to_stream)
+	{
+		command_stream.dispatch_indirect(buffer.get_handle(), offset);
+	}
+	else
+	{
+		vkCmdDispatchIndirect(get_handle(), buffer.get_handle(), offset);
+	}
 }
 
 void CommandBuffer::update_buffer(const core::Buffer &buffer, VkDeviceSize offset, const std::vector<uint8_t> &data)
 {
-	vkCmdUpdateBuffer(get_handle(), buffer.get_handle(), offset, data.size(), data.data());
+	if (recording_to_stream)
+	{
+		command_stream.update_buffer(buffer.get_handle(), offset, data.size(), data.data());
+	}
+	else
+	{
+		vkCmdUpdateBuffer(get_handle(), buffer.get_handle(), offset, data.size(), data.data());
+	}
 }
 
 void CommandBuffer::blit_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageBlit> &regions)
 {
-	vkCmdBlitImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-	               dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	               to_u32(regions.size()), regions.data(), VK_FILTER_NEAREST);
+	if (recording_to_stream)
+	{
+		command_stream.blit_image(src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, to_u32(regions.size()), regions.data(), VK_FILTER_NEAREST);
+	}
+	else
+	{
+		vkCmdBlitImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		               dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		               to_u32(regions.size()), regions.data(), VK_FILTER_NEAREST);
+	}
 }
 
 void CommandBuffer::copy_buffer(const core::Buffer &src_buffer, const core::Buffer &dst_buffer, VkDeviceSize size)
 {
 	VkBufferCopy copy_region = {};
 	copy_region.size         = size;
-	vkCmdCopyBuffer(get_handle(), src_buffer.get_handle(), dst_buffer.get_handle(), 1, &copy_region);
+	if (recording_to_stream)
+	{
+		command_stream.copy_buffer(src_buffer.get_handle(), dst_buffer.get_handle(), 1, &copy_region);
+	}
+	else
+	{
+		vkCmdCopyBuffer(get_handle(), src_buffer.get_handle(), dst_buffer.get_handle(), 1, &copy_region);
+	}
 }
 
 void CommandBuffer::copy_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageCopy> &regions)
 {
-	vkCmdCopyImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-	               dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	               to_u32(regions.size()), regions.data());
+	if (recording_to_stream)
+	{
+		command_stream.copy_image(src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, to_u32(regions.size()), regions.data());
+	}
+	else
+	{
+		vkCmdCopyImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		               dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		               to_u32(regions.size()), regions.data());
+	}
 }
 
 void CommandBuffer::copy_buffer_to_image(const core::Buffer &buffer, const core::Image &image, const std::vector<VkBufferImageCopy> &regions)
 {
-	vkCmdCopyBufferToImage(get_handle(), buffer.get_handle(),
-	                       image.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	                       to_u32(regions.size()), regions.data());
+	if (recording_to_stream)
+	{
+		command_stream.copy_buffer_to_image(buffer.get_handle(), image.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, to_u32(regions.size()), regions.data());
+	}
+	else
+	{
+		vkCmdCopyBufferToImage(get_handle(), buffer.get_handle(),
+		                       image.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		                       to_u32(regions.size()), regions.data());
+	}
 }
 
 void CommandBuffer::image_memory_barrier(const core::ImageView &image_view, const ImageMemoryBarrier &memory_barrier)
@@ -442,15 +900,22 @@ void CommandBuffer::image_memory_barrier(const core::ImageView &image_view, cons
 	VkPipelineStageFlags src_stage_mask = memory_barrier.src_stage_mask;
 	VkPipelineStageFlags dst_stage_mask = memory_barrier.dst_stage_mask;
 
-	vkCmdPipelineBarrier(
-	    get_handle(),
-	    src_stage_mask,
-	    dst_stage_mask,
-	    0,
-	    0, nullptr,
-	    0, nullptr,
-	    1,
-	    &image_memory_barrier);
+	if (recording_to_stream)
+	{
+		command_stream.pipeline_barrier(src_stage_mask, dst_stage_mask, 0, 0, nullptr, 0, nullptr, 1, &image_memory_barrier);
+	}
+	else
+	{
+		vkCmdPipelineBarrier(
+		    get_handle(),
+		    src_stage_mask,
+		    dst_stage_mask,
+		    0,
+		    0, nullptr,
+		    0, nullptr,
+		    1,
+		    &image_memory_barrier);
+	}
 }
 
 void CommandBuffer::buffer_memory_barrier(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size, const BufferMemoryBarrier &memory_barrier)
@@ -465,48 +930,79 @@ void CommandBuffer::buffer_memory_barrier(const core::Buffer &buffer, VkDeviceSi
 	VkPipelineStageFlags src_stage_mask = memory_barrier.src_stage_mask;
 	VkPipelineStageFlags dst_stage_mask = memory_barrier.dst_stage_mask;
 
-	vkCmdPipelineBarrier(
-	    get_handle(),
-	    src_stage_mask,
-	    dst_stage_mask,
-	    0,
-	    0, nullptr,
-	    1, &buffer_memory_barrier,
-	    0, nullptr);
+	if (recording_to_stream)
+	{
+		command_stream.pipeline_barrier(src_stage_mask, dst_stage_mask, 0, 0, nullptr, 1, &buffer_memory_barrier, 0, nullptr);
+	}
+	else
+	{
+		vkCmdPipelineBarrier(
+		    get_handle(),
+		    src_stage_mask,
+		    dst_stage_mask,
+		    0,
+		    0, nullptr,
+		    1, &buffer_memory_barrier,
+		    0, nullptr);
+	}
 }
 
-void CommandBuffer::flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point)
+bool CommandBuffer::flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point)
 {
 	// Create a new pipeline only if the graphics state changed
 	if (!pipeline_state.is_dirty())
 	{
-		return;
+		return true;
 	}
 
-	pipeline_state.clear_dirty();
+	auto &resource_cache = get_device().get_resource_cache();
 
 	// Create and bind pipeline
 	if (pipeline_bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS)
 	{
 		pipeline_state.set_render_pass(*current_render_pass.render_pass);
-		auto &pipeline = get_device().get_resource_cache().request_graphics_pipeline(pipeline_state);
 
-		vkCmdBindPipeline(get_handle(),
-		                  pipeline_bind_point,
-		                  pipeline.get_handle());
+		if (resource_cache.is_async_pipeline_compilation())
+		{
+			auto request = resource_cache.request_graphics_pipeline_async(pipeline_state);
+
+			// Keep the state dirty until the pipeline is ready, so that later draws pick it up
+			if (request.ready)
+			{
+				pipeline_state.clear_dirty();
+			}
+
+			if (!request.pipeline)
+			{
+				return false;
+			}
+
+			record_bind_pipeline(pipeline_bind_point, request.pipeline->get_handle());
+
+			return true;
+		}
+
+		pipeline_state.clear_dirty();
+
+		auto &pipeline = resource_cache.request_graphics_pipeline(pipeline_state);
+
+		record_bind_pipeline(pipeline_bind_point, pipeline.get_handle());
 	}
 	else if (pipeline_bind_point == VK_PIPELINE_BIND_POINT_COMPUTE)
 	{
-		auto &pipeline = get_device().get_resource_cache().request_compute_pipeline(pipeline_state);
+		pipeline_state.clear_dirty();
 
-		vkCmdBindPipeline(get_handle(),
-		                  pipeline_bind_point,
-		                  pipeline.get_handle());
+		// Dispatches cannot be skipped, so compute pipelines are always created in place
+		auto &pipeline = resource_cache.request_compute_pipeline(pipeline_state);
+
+		record_bind_pipeline(pipeline_bind_point, pipeline.get_handle());
 	}
 	else
 	{
 		throw "Only graphics and compute pipeline bind points are supported now";
 	}
+
+	return true;
 }
 
 void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_point)
@@ -517,7 +1013,12 @@ void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_poi
 
 	const auto &shader_program = pipeline_layout.get_shader_program();
 
-	std::unordered_set<uint32_t> update_descriptor_sets;
+	auto render_frame = command_pool.get_render_frame();
+	auto thread_index = command_pool.get_thread_index();
+
+	auto &arena = render_frame->get_arena(thread_index);
+
+	ArenaVector<uint32_t> update_descriptor_sets{arena};
 
 	// Iterate over the shader sets to check if they have already been bound
 	// If they have, add the set so that the command buffer later updates it
@@ -531,7 +1032,7 @@ void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_poi
 		{
 			if (descriptor_set_layout_it->second->get_handle() != pipeline_layout.get_descriptor_set_layout(descriptor_set_id).get_handle())
 			{
-				update_descriptor_sets.emplace(descriptor_set_id);
+				update_descriptor_sets.push_back(descriptor_set_id);
 			}
 		}
 	}
@@ -549,6 +1050,38 @@ void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_poi
 		}
 	}
 
+	// Bind the descriptor sets provided by the caller, unless already bound with the same layout
+	for (auto &set_it : descriptor_set_binding_state)
+	{
+		uint32_t descriptor_set_id = set_it.first;
+		auto &   descriptor_set    = *set_it.second;
+
+		if (!pipeline_layout.has_descriptor_set_layout(descriptor_set_id))
+		{
+			continue;
+		}
+
+		auto &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(descriptor_set_id);
+
+		if (descriptor_set_layout.get_handle() != descriptor_set.get_layout().get_handle())
+		{
+			LOGW("Descriptor set bound at #{} does not match the pipeline layout", descriptor_set_id);
+			continue;
+		}
+
+		auto descriptor_set_layout_it = descriptor_set_layout_binding_state.find(descriptor_set_id);
+
+		if (descriptor_set_layout_it != descriptor_set_layout_binding_state.end() &&
+		    descriptor_set_layout_it->second->get_handle() == descriptor_set_layout.get_handle())
+		{
+			continue;
+		}
+
+		descriptor_set_layout_binding_state[descriptor_set_id] = &descriptor_set_layout;
+
+		record_bind_descriptor_set(pipeline_bind_point, pipeline_layout, descriptor_set_id, descriptor_set.get_handle());
+	}
+
 	// Check if a descriptor set needs to be created
 	if (resource_binding_state.is_dirty() || !update_descriptor_sets.empty())
 	{
@@ -561,7 +1094,7 @@ void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_poi
 			auto &   resource_set      = resource_set_it.second;
 
 			// Don't update resource set if it's not in the update list OR its state hasn't changed
-			if (!resource_set.is_dirty() && (update_descriptor_sets.find(descriptor_set_id) == update_descriptor_sets.end()))
+			if (!resource_set.is_dirty() && (std::find(update_descriptor_sets.begin(), update_descriptor_sets.end(), descriptor_set_id) == update_descriptor_sets.end()))
 			{
 				continue;
 			}
@@ -580,11 +1113,71 @@ void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_poi
 			// Make descriptor set layout bound for current set
 			descriptor_set_layout_binding_state[descriptor_set_id] = &descriptor_set_layout;
 
+			ArenaVector<uint32_t> dynamic_offsets{arena};
+
+			// Look the descriptor set up by the hash of the bound resources, which is kept by the resource set.
+			// Dynamic buffer offsets are not part of the descriptor set, while other buffer offsets are, so
+			// layouts mixing both are always resolved through the binding maps.
+			bool has_dynamic_buffers{false};
+			bool has_static_buffers{false};
+
+			for (auto &binding : descriptor_set_layout.get_bindings())
+			{
+				if (is_dynamic_buffer_descriptor_type(binding.descriptorType))
+				{
+					has_dynamic_buffers = true;
+				}
+				else if (is_buffer_descriptor_type(binding.descriptorType))
+				{
+					has_static_buffers = true;
+				}
+			}
+
+			size_t binding_hash{0};
+
+			if (!has_dynamic_buffers || !has_static_buffers)
+			{
+				binding_hash = resource_set.get_hash(has_static_buffers);
+				hash_combine(binding_hash, descriptor_set_layout.get_handle());
+			}
+
+			if (auto descriptor_set = render_frame->find_descriptor_set(binding_hash, descriptor_set_layout, resource_set.get_resource_bindings(), thread_index))
+			{
+				if (has_dynamic_buffers)
+				{
+					// Collect the dynamic offsets in the same order as when building the binding maps
+					auto &layout_bindings = descriptor_set_layout.get_bindings();
+
+					for (auto &binding_it : resource_set.get_resource_bindings())
+					{
+						auto binding_info = std::find_if(layout_bindings.begin(), layout_bindings.end(),
+						                                 [&binding_it](const VkDescriptorSetLayoutBinding &binding) { return binding.binding == binding_it.first; });
+
+						if (binding_info == layout_bindings.end() || !is_dynamic_buffer_descriptor_type(binding_info->descriptorType))
+						{
+							continue;
+						}
+
+						for (auto &element_it : binding_it.second)
+						{
+							if (element_it.second.buffer != nullptr)
+							{
+								dynamic_offsets.push_back(to_u32(element_it.second.offset));
+							}
+						}
+					}
+				}
+
+				// Bind descriptor set
+				record_bind_descriptor_set(pipeline_bind_point, pipeline_layout, descriptor_set_id, descriptor_set->get_handle(),
+				                           to_u32(dynamic_offsets.size()), dynamic_offsets.data());
+
+				continue;
+			}
+
 			BindingMap<VkDescriptorBufferInfo> buffer_infos;
 			BindingMap<VkDescriptorImageInfo>  image_infos;
 
-			std::vector<uint32_t> dynamic_offsets;
-
 			// Iterate over all resource bindings
 			for (auto &binding_it : resource_set.get_resource_bindings())
 			{
@@ -663,18 +1256,12 @@ void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_poi
 				}
 			}
 
-			auto &descriptor_set = command_pool.get_render_frame()->request_descriptor_set(descriptor_set_layout, buffer_infos, image_infos, command_pool.get_thread_index());
-
-			VkDescriptorSet descriptor_set_handle = descriptor_set.get_handle();
+			auto &descriptor_set = render_frame->request_descriptor_set(descriptor_set_layout, buffer_infos, image_infos, thread_index,
+			                                                            binding_hash, &resource_set.get_resource_bindings(), has_static_buffers);
 
 			// Bind descriptor set
-			vkCmdBindDescriptorSets(get_handle(),
-			                        pipeline_bind_point,
-			                        pipeline_layout.get_handle(),
-			                        descriptor_set_id,
-			                        1, &descriptor_set_handle,
-			                        to_u32(dynamic_offsets.size()),
-			                        dynamic_offsets.data());
+			record_bind_descriptor_set(pipeline_bind_point, pipeline_layout, descriptor_set_id, descriptor_set.get_handle(),
+			                           to_u32(dynamic_offsets.size()), dynamic_offsets.data());
 		}
 	}
 }
@@ -694,6 +1281,114 @@ const uint32_t CommandBuffer::get_current_subpass_index() const
 	return pipeline_state.get_subpass_index();
 }
 
+void CommandBuffer::count_state_command(StateCommand command, bool eliminated)
+{
+	auto &counter = state_command_counters[static_cast<size_t>(command)];
+
+	if (eliminated)
+	{
+		++counter.eliminated;
+	}
+	else
+	{
+		++counter.issued;
+	}
+}
+
+void CommandBuffer::record_bind_pipeline(VkPipelineBindPoint pipeline_bind_point, VkPipeline pipeline)
+{
+	auto &bound_pipeline = shadow_state.pipelines.at(pipeline_bind_point);
+
+	if (bound_pipeline == pipeline)
+	{
+		count_state_command(StateCommand::BindPipeline, true);
+		return;
+	}
+
+	bound_pipeline = pipeline;
+
+	count_state_command(StateCommand::BindPipeline, false);
+
+	if (recording_to_stream)
+	{
+		command_stream.bind_pipeline(pipeline_bind_point, pipeline);
+	}
+	else
+	{
+		vkCmdBindPipeline(get_handle(), pipeline_bind_point, pipeline);
+	}
+}
+
+void CommandBuffer::record_bind_descriptor_set(VkPipelineBindPoint pipeline_bind_point, const PipelineLayout &pipeline_layout, uint32_t set_index,
+                                               VkDescriptorSet descriptor_set, uint32_t dynamic_offset_count, const uint32_t *dynamic_offsets)
+{
+	auto &bound_sets = shadow_state.descriptor_sets.at(pipeline_bind_point);
+
+	if (set_index < MAX_SHADOWED_BINDINGS && dynamic_offset_count == 0)
+	{
+		auto &bound_set = bound_sets[set_index];
+
+		if (bound_set.pipeline_layout == pipeline_layout.get_handle() && bound_set.descriptor_set == descriptor_set)
+		{
+			count_state_command(StateCommand::BindDescriptorSets, true);
+			return;
+		}
+	}
+
+	// Binding with a pipeline layout may disturb the sets bound with other layouts
+	for (auto &bound_set : bound_sets)
+	{
+		if (bound_set.pipeline_layout != pipeline_layout.get_handle())
+		{
+			bound_set = {};
+		}
+	}
+
+	if (set_index < MAX_SHADOWED_BINDINGS)
+	{
+		// Sets with dynamic offsets are not tracked, as their offsets change with every draw
+		bound_sets[set_index].pipeline_layout = pipeline_layout.get_handle();
+		bound_sets[set_index].descriptor_set  = dynamic_offset_count == 0 ? descriptor_set : VK_NULL_HANDLE;
+	}
+
+	count_state_command(StateCommand::BindDescriptorSets, false);
+
+	if (recording_to_stream)
+	{
+		command_stream.bind_descriptor_sets(pipeline_bind_point, pipeline_layout.get_handle(), set_index, 1, &descriptor_set, dynamic_offset_count, dynamic_offsets);
+	}
+	else
+	{
+		vkCmdBindDescriptorSets(get_handle(),
+		                        pipeline_bind_point,
+		                        pipeline_layout.get_handle(),
+		                        set_index,
+		                        1, &descriptor_set,
+		                        dynamic_offset_count,
+		                        dynamic_offsets);
+	}
+}
+
+const StateCommandCounters &CommandBuffer::get_state_command_counters() const
+{
+	return state_command_counters;
+}
+
+void CommandBuffer::set_deferred_recording(bool enable)
+{
+	deferred_recording = enable;
+}
+
+bool CommandBuffer::is_deferred_recording() const
+{
+	return deferred_recording;
+}
+
+const CommandStream &CommandBuffer::get_command_stream() const
+{
+	return command_stream;
+}
+
 VkResult CommandBuffer::reset(ResetMode reset_mode)
 {
 	VkResult result = VK_SUCCESS;
@@ -20,17 +20,22 @@
 
 #pragma once
 
+#include <array>
 #include <list>
 
 #include "common/helpers.h"
+#include "common/linear_arena.h"
+#include "common/push_constant_block.h"
 #include "common/vk_common.h"
 #include "core/buffer.h"
+#include "core/command_stream.h"
 #include "core/image.h"
 #include "core/image_view.h"
 #include "core/sampler.h"
 #include "rendering/pipeline_state.h"
 #include "rendering/render_target.h"
 #include "resource_binding_state.h"
+#include "resource_cache.h"
 
 namespace vkb
 {
@@ -43,6 +48,34 @@ class PipelineState;
 class RenderTarget;
 class Subpass;
 
+/**
+ * @brief State commands which command buffers skip if they would not change the bound state
+ */
+enum class StateCommand
+{
+	BindPipeline,
+	BindDescriptorSets,
+	BindVertexBuffers,
+	BindIndexBuffer,
+	SetViewport,
+	SetScissor,
+	MaxValue
+};
+
+/**
+ * @brief Counters of a state command recorded by command buffers
+ */
+struct StateCommandCounter
+{
+	/// Commands recorded
+	uint64_t issued{0};
+
+	/// Commands skipped as the same state was already bound
+	uint64_t eliminated{0};
+};
+
+using StateCommandCounters = std::array<StateCommandCounter, static_cast<size_t>(StateCommand::MaxValue)>;
+
 /**
  * @brief Helper class to manage and record a command buffer, building and
  *        keeping track of pipeline state and resource bindings
@@ -73,6 +106,8 @@ class CommandBuffer
 		const RenderPass *render_pass;
 
 		const Framebuffer *framebuffer;
+
+		VkExtent2D extent;
 	};
 
 	CommandBuffer(CommandPool &command_pool, VkCommandBufferLevel level);
@@ -93,7 +128,18 @@ class CommandBuffer
 
 	bool is_recording() const;
 
-	std::vector<uint8_t> stored_push_constants;
+	/**
+	 * @brief The command pool must be associated to a render frame
+	 * @return The arena of the render frame for the thread recording this command buffer,
+	 *         for transient allocations which are not needed after the frame is reset
+	 */
+	LinearArena &get_arena();
+
+	/// Capacity of the inline push constant block, the largest maxPushConstantsSize exposed by mobile GPUs
+	static constexpr uint32_t MAX_PUSH_CONSTANTS_SIZE = PushConstantBlock::MAX_SIZE;
+
+	/// Number of descriptor sets, vertex buffers, viewports and scissors tracked to skip redundant state commands
+	static constexpr uint32_t MAX_SHADOWED_BINDINGS = 16;
 
 	/**
 	 * @brief Sets the command buffer so that it is ready for recording
@@ -111,7 +157,22 @@ class CommandBuffer
 
 	void begin_render_pass(const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<VkClearValue> &clear_values, const std::vector<std::unique_ptr<Subpass>> &subpasses, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 
-	void next_subpass();
+	void next_subpass(VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+
+	/**
+	 * @return Whether the current subpass is recorded inline or in secondary command buffers
+	 */
+	VkSubpassContents get_current_subpass_contents() const;
+
+	/**
+	 * @brief Requests a secondary command buffer from the render frame and pool reset mode of this one,
+	 *        and begins it so that it continues the current subpass, with a viewport and scissor
+	 *        covering the render area and the specialization constants of this one.
+	 *        Can be called from several threads with different thread indices
+	 * @param thread_index Selects the thread's command pool used to manage the buffer
+	 * @return A secondary command buffer ready for recording
+	 */
+	CommandBuffer &request_secondary_command_buffer(size_t thread_index = 0);
 
 	void execute_commands(CommandBuffer &secondary_command_buffer);
 
@@ -136,24 +197,44 @@ class CommandBuffer
 
 	void set_push_constants(const std::vector<uint8_t> &values);
 
+	/**
+	 * @brief Appends data to the inline push constant block, without touching the heap
+	 * @param data Pointer to the data to be stored
+	 * @param size Size in bytes of the data, the block must not grow past MAX_PUSH_CONSTANTS_SIZE
+	 */
+	void set_push_constants(const uint8_t *data, uint32_t size);
+
 	void push_constants_accumulated(const std::vector<uint8_t> &values, uint32_t offset = 0);
 
+	/**
+	 * @brief Records the stored push constants followed by the given data, assembled on the stack
+	 * @param data Pointer to the data to be appended to the stored push constants
+	 * @param size Size in bytes of the data
+	 * @param offset Offset of the push constant range
+	 * @throws std::runtime_error if the accumulated push constants exceed MAX_PUSH_CONSTANTS_SIZE
+	 */
+	void push_constants_accumulated(const uint8_t *data, uint32_t size, uint32_t offset = 0);
+
 	template <typename T>
 	void push_constants_accumulated(const T &value, uint32_t offset = 0)
 	{
-		push_constants_accumulated(std::vector<uint8_t>{reinterpret_cast<const uint8_t *>(&value),
-		                                                reinterpret_cast<const uint8_t *>(&value) + sizeof(T)},
-		                           offset);
+		push_constants_accumulated(reinterpret_cast<const uint8_t *>(&value), to_u32(sizeof(T)), offset);
 	}
 
 	void push_constants(uint32_t offset, const std::vector<uint8_t> &values);
 
+	/**
+	 * @brief Records the given data in the push constant range at offset
+	 * @param offset Offset of the push constant range
+	 * @param data Pointer to the data to be recorded
+	 * @param size Size in bytes of the data
+	 */
+	void push_constants(uint32_t offset, const uint8_t *data, uint32_t size);
+
 	template <typename T>
 	void push_constants(uint32_t offset, const T &value)
 	{
-		push_constants(offset,
-		               std::vector<uint8_t>{reinterpret_cast<const uint8_t *>(&value),
-		                                    reinterpret_cast<const uint8_t *>(&value) + sizeof(T)});
+		push_constants(offset, reinterpret_cast<const uint8_t *>(&value), to_u32(sizeof(T)));
 	}
 
 	void bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element);
@@ -162,8 +243,20 @@ class CommandBuffer
 
 	void bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element);
 
+	/**
+	 * @brief Binds a descriptor set owned by the caller, e.g. written once at load time,
+	 *        instead of one built from the resources bound to the command buffer.
+	 *        The set is rebound whenever the pipeline layout changes the layout of that set,
+	 *        until the command buffer, render pass or subpass is reset
+	 * @param set The set index, which must not also be used with bind_buffer/bind_image/bind_input
+	 * @param descriptor_set The descriptor set, which must outlive the recording
+	 */
+	void bind_descriptor_set(uint32_t set, const DescriptorSet &descriptor_set);
+
 	void bind_vertex_buffers(uint32_t first_binding, const std::vector<std::reference_wrapper<const vkb::core::Buffer>> &buffers, const std::vector<VkDeviceSize> &offsets);
 
+	void bind_vertex_buffer(uint32_t binding, const core::Buffer &buffer, VkDeviceSize offset);
+
 	void bind_index_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkIndexType index_type);
 
 	void set_viewport_state(const ViewportState &state_info);
@@ -182,8 +275,12 @@ class CommandBuffer
 
 	void set_viewport(uint32_t first_viewport, const std::vector<VkViewport> &viewports);
 
+	void set_viewport(uint32_t first_viewport, uint32_t viewport_count, const VkViewport *viewports);
+
 	void set_scissor(uint32_t first_scissor, const std::vector<VkRect2D> &scissors);
 
+	void set_scissor(uint32_t first_scissor, uint32_t scissor_count, const VkRect2D *scissors);
+
 	void set_line_width(float line_width);
 
 	void set_depth_bias(float depth_bias_constant_factor, float depth_bias_clamp, float depth_bias_slope_factor);
@@ -224,9 +321,72 @@ class CommandBuffer
 	 */
 	VkResult reset(ResetMode reset_mode);
 
+	/**
+	 * @return The state commands recorded and skipped since the command buffer last began
+	 */
+	const StateCommandCounters &get_state_command_counters() const;
+
+	/**
+	 * @brief Records the next commands to a CommandStream instead of the command buffer,
+	 *        which are then translated to Vulkan at end(). The command buffer is only
+	 *        begun at end(), so its pool is not used while recording
+	 * @param enable Whether to defer recording, which takes effect at the next begin()
+	 *        and requires the command buffer to be allocated from a render frame
+	 */
+	void set_deferred_recording(bool enable);
+
+	bool is_deferred_recording() const;
+
+	/**
+	 * @return The commands recorded since begin() when recording is deferred
+	 */
+	const CommandStream &get_command_stream() const;
+
 	const VkCommandBufferLevel level;
 
   private:
+	/**
+	 * @brief A descriptor set last bound at a set index
+	 */
+	struct DescriptorSetBinding
+	{
+		VkPipelineLayout pipeline_layout{VK_NULL_HANDLE};
+
+		VkDescriptorSet descriptor_set{VK_NULL_HANDLE};
+	};
+
+	/**
+	 * @brief The Vulkan state last recorded in the command buffer, used to skip
+	 *        commands which would bind the same state again. Null handles and
+	 *        cleared valid bits stand for state that is not known
+	 */
+	struct ShadowState
+	{
+		/// Bound pipelines, indexed by graphics and compute bind point
+		std::array<VkPipeline, 2> pipelines{};
+
+		/// Bound descriptor sets without dynamic offsets, indexed by bind point and set index
+		std::array<std::array<DescriptorSetBinding, MAX_SHADOWED_BINDINGS>, 2> descriptor_sets{};
+
+		std::array<VkBuffer, MAX_SHADOWED_BINDINGS> vertex_buffers{};
+
+		std::array<VkDeviceSize, MAX_SHADOWED_BINDINGS> vertex_buffer_offsets{};
+
+		VkBuffer index_buffer{VK_NULL_HANDLE};
+
+		VkDeviceSize index_buffer_offset{0};
+
+		VkIndexType index_type{VK_INDEX_TYPE_UINT16};
+
+		std::array<VkViewport, MAX_SHADOWED_BINDINGS> viewports{};
+
+		uint32_t valid_viewports{0};
+
+		std::array<VkRect2D, MAX_SHADOWED_BINDINGS> scissors{};
+
+		uint32_t valid_scissors{0};
+	};
+
 	State state{State::Initial};
 
 	CommandPool &command_pool;
@@ -235,20 +395,66 @@ class CommandBuffer
 
 	RenderPassBinding current_render_pass;
 
+	VkSubpassContents current_subpass_contents{VK_SUBPASS_CONTENTS_INLINE};
+
 	PipelineState pipeline_state;
 
 	ResourceBindingState resource_binding_state;
 
 	std::unordered_map<uint32_t, DescriptorSetLayout *> descriptor_set_layout_binding_state;
 
+	/// Descriptor sets bound directly with bind_descriptor_set
+	std::unordered_map<uint32_t, const DescriptorSet *> descriptor_set_binding_state;
+
+	/// Push constants prepended by push_constants_accumulated(), stored inline to keep draws allocation free
+	PushConstantBlock stored_push_constants;
+
+	/// Subpass infos of the last render pass begun, kept to reuse their storage
+	std::vector<SubpassInfo> subpass_infos;
+
+	ShadowState shadow_state;
+
+	StateCommandCounters state_command_counters{};
+
+	bool deferred_recording{false};
+
+	/// Whether the commands since begin() go to the command stream
+	bool recording_to_stream{false};
+
+	CommandStream command_stream;
+
+	/// Begin info kept to begin the command buffer at end() when recording is deferred
+	VkCommandBufferUsageFlags begin_flags{0};
+
+	VkCommandBufferInheritanceInfo inheritance_info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+
+	/**
+	 * @brief Counts a state command, either recorded or skipped
+	 */
+	void count_state_command(StateCommand command, bool eliminated);
+
+	/**
+	 * @brief Binds a pipeline unless it is already bound
+	 */
+	void record_bind_pipeline(VkPipelineBindPoint pipeline_bind_point, VkPipeline pipeline);
+
+	/**
+	 * @brief Binds a descriptor set unless it is already bound with the same pipeline layout,
+	 *        descriptor sets with dynamic offsets are always bound
+	 */
+	void record_bind_descriptor_set(VkPipelineBindPoint pipeline_bind_point, const PipelineLayout &pipeline_layout, uint32_t set_index,
+	                                VkDescriptorSet descriptor_set, uint32_t dynamic_offset_count = 0, const uint32_t *dynamic_offsets = nullptr);
+
 	const RenderPassBinding &get_current_render_pass() const;
 
 	const uint32_t get_current_subpass_index() const;
 
 	/**
 	 * @brief Flush the piplines state
+	 * @return False if the draw must be skipped, as its pipeline is being compiled
+	 *         in the background and there is no fallback pipeline
 	 */
-	void flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point);
+	bool flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point);
 
 	/**
 	 * @brief Flush the descriptor set state
@@ -259,9 +465,7 @@ class CommandBuffer
 template <class T>
 inline void CommandBuffer::set_push_constants(const T &data)
 {
-	set_push_constants(
-	    {reinterpret_cast<const uint8_t *>(&data),
-	     reinterpret_cast<const uint8_t *>(&data) + sizeof(T)});
+	set_push_constants(reinterpret_cast<const uint8_t *>(&data), to_u32(sizeof(T)));
 }
 
 template <>
@@ -269,9 +473,7 @@ inline void CommandBuffer::set_push_constants<bool>(const bool &data)
 {
 	uint32_t value = to_u32(data);
 
-	set_push_constants(
-	    {reinterpret_cast<const uint8_t *>(&value),
-	     reinterpret_cast<const uint8_t *>(&value) + sizeof(std::uint32_t)});
+	set_push_constants(reinterpret_cast<const uint8_t *>(&value), to_u32(sizeof(std::uint32_t)));
 }
 
 template <class T>
@@ -222,4 +222,31 @@ CommandBuffer::ResetMode const CommandPool::get_reset_mode() const
 {
 	return reset_mode;
 }
+
+StateCommandCounters CommandPool::get_state_command_counters() const
+{
+	StateCommandCounters counters{};
+
+	auto add_counters = [&counters](const CommandBuffer &command_buffer) {
+		const auto &command_buffer_counters = command_buffer.get_state_command_counters();
+
+		for (size_t i = 0; i < counters.size(); ++i)
+		{
+			counters[i].issued += command_buffer_counters[i].issued;
+			counters[i].eliminated += command_buffer_counters[i].eliminated;
+		}
+	};
+
+	for (uint32_t i = 0; i < active_primary_command_buffer_count; ++i)
+	{
+		add_counters(*primary_command_buffers[i]);
+	}
+
+	for (uint32_t i = 0; i < active_secondary_command_buffer_count; ++i)
+	{
+		add_counters(*secondary_command_buffers[i]);
+	}
+
+	return counters;
+}
 }        // namespace vkb
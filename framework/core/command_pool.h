@@ -62,6 +62,11 @@ class CommandPool
 
 	const CommandBuffer::ResetMode get_reset_mode() const;
 
+	/**
+	 * @return The state commands recorded and skipped by the command buffers requested since the pool was last reset
+	 */
+	StateCommandCounters get_state_command_counters() const;
+
   private:
 	Device &device;
 
@@ -0,0 +1,717 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "command_stream.h"
+
+#include <cassert>
+#include <cstring>
+#include <new>
+
+namespace vkb
+{
+namespace
+{
+struct BeginRenderPassArgs
+{
+	VkRenderPass        render_pass;
+	VkFramebuffer       framebuffer;
+	VkRect2D            render_area;
+	uint32_t            clear_value_count;
+	const VkClearValue *clear_values;
+	VkSubpassContents   contents;
+};
+
+struct NextSubpassArgs
+{
+	VkSubpassContents contents;
+};
+
+struct EndRenderPassArgs
+{};
+
+struct ExecuteCommandsArgs
+{
+	uint32_t               command_buffer_count;
+	const VkCommandBuffer *command_buffers;
+};
+
+struct BindPipelineArgs
+{
+	VkPipelineBindPoint pipeline_bind_point;
+	VkPipeline          pipeline;
+};
+
+struct BindDescriptorSetsArgs
+{
+	VkPipelineBindPoint    pipeline_bind_point;
+	VkPipelineLayout       pipeline_layout;
+	uint32_t               first_set;
+	uint32_t               descriptor_set_count;
+	const VkDescriptorSet *descriptor_sets;
+	uint32_t               dynamic_offset_count;
+	const uint32_t *       dynamic_offsets;
+};
+
+struct BindVertexBuffersArgs
+{
+	uint32_t            first_binding;
+	uint32_t            binding_count;
+	const VkBuffer *    buffers;
+	const VkDeviceSize *offsets;
+};
+
+struct BindIndexBufferArgs
+{
+	VkBuffer     buffer;
+	VkDeviceSize offset;
+	VkIndexType  index_type;
+};
+
+struct PushConstantsArgs
+{
+	VkPipelineLayout   pipeline_layout;
+	VkShaderStageFlags stage_flags;
+	uint32_t           offset;
+	uint32_t           size;
+	const uint8_t *    values;
+};
+
+struct SetViewportArgs
+{
+	uint32_t          first_viewport;
+	uint32_t          viewport_count;
+	const VkViewport *viewports;
+};
+
+struct SetScissorArgs
+{
+	uint32_t        first_scissor;
+	uint32_t        scissor_count;
+	const VkRect2D *scissors;
+};
+
+struct SetLineWidthArgs
+{
+	float line_width;
+};
+
+struct SetDepthBiasArgs
+{
+	float depth_bias_constant_factor;
+	float depth_bias_clamp;
+	float depth_bias_slope_factor;
+};
+
+struct SetBlendConstantsArgs
+{
+	float blend_constants[4];
+};
+
+struct SetDepthBoundsArgs
+{
+	float min_depth_bounds;
+	float max_depth_bounds;
+};
+
+struct DrawArgs
+{
+	uint32_t vertex_count;
+	uint32_t instance_count;
+	uint32_t first_vertex;
+	uint32_t first_instance;
+};
+
+struct DrawIndexedArgs
+{
+	uint32_t index_count;
+	uint32_t instance_count;
+	uint32_t first_index;
+	int32_t  vertex_offset;
+	uint32_t first_instance;
+};
+
+struct DrawIndexedIndirectArgs
+{
+	VkBuffer     buffer;
+	VkDeviceSize offset;
+	uint32_t     draw_count;
+	uint32_t     stride;
+};
+
+struct DispatchArgs
+{
+	uint32_t group_count_x;
+	uint32_t group_count_y;
+	uint32_t group_count_z;
+};
+
+struct DispatchIndirectArgs
+{
+	VkBuffer     buffer;
+	VkDeviceSize offset;
+};
+
+struct ClearAttachmentsArgs
+{
+	uint32_t                 attachment_count;
+	const VkClearAttachment *attachments;
+	uint32_t                 rect_count;
+	const VkClearRect *      rects;
+};
+
+struct UpdateBufferArgs
+{
+	VkBuffer       buffer;
+	VkDeviceSize   offset;
+	VkDeviceSize   size;
+	const uint8_t *data;
+};
+
+struct CopyBufferArgs
+{
+	VkBuffer            src_buffer;
+	VkBuffer            dst_buffer;
+	uint32_t            region_count;
+	const VkBufferCopy *regions;
+};
+
+struct CopyImageArgs
+{
+	VkImage            src_image;
+	VkImageLayout      src_layout;
+	VkImage            dst_image;
+	VkImageLayout      dst_layout;
+	uint32_t           region_count;
+	const VkImageCopy *regions;
+};
+
+struct CopyBufferToImageArgs
+{
+	VkBuffer                 src_buffer;
+	VkImage                  dst_image;
+	VkImageLayout            dst_layout;
+	uint32_t                 region_count;
+	const VkBufferImageCopy *regions;
+};
+
+struct BlitImageArgs
+{
+	VkImage            src_image;
+	VkImageLayout      src_layout;
+	VkImage            dst_image;
+	VkImageLayout      dst_layout;
+	uint32_t           region_count;
+	const VkImageBlit *regions;
+	VkFilter           filter;
+};
+
+struct PipelineBarrierArgs
+{
+	VkPipelineStageFlags         src_stage_mask;
+	VkPipelineStageFlags         dst_stage_mask;
+	VkDependencyFlags            dependency_flags;
+	uint32_t                     memory_barrier_count;
+	const VkMemoryBarrier *      memory_barriers;
+	uint32_t                     buffer_memory_barrier_count;
+	const VkBufferMemoryBarrier *buffer_memory_barriers;
+	uint32_t                     image_memory_barrier_count;
+	const VkImageMemoryBarrier * image_memory_barriers;
+};
+}        // namespace
+
+template <class T>
+struct CommandStream::CommandWithArgs : Command
+{
+	T args;
+};
+
+template <class T>
+T &CommandStream::push(Opcode opcode)
+{
+	assert(arena && "The command stream must be reset with an arena before recording");
+
+	auto command = new (arena->allocate<CommandWithArgs<T>>(1)) CommandWithArgs<T>{};
+
+	command->opcode = opcode;
+
+	if (last_command)
+	{
+		last_command->next = command;
+	}
+	else
+	{
+		first_command = command;
+	}
+
+	last_command = command;
+	++command_count;
+
+	return command->args;
+}
+
+template <class T>
+const T *CommandStream::copy(const T *data, size_t count)
+{
+	if (count == 0)
+	{
+		return nullptr;
+	}
+
+	auto copied_data = arena->allocate<T>(count);
+	std::memcpy(copied_data, data, sizeof(T) * count);
+
+	return copied_data;
+}
+
+void CommandStream::reset(LinearArena &new_arena)
+{
+	arena         = &new_arena;
+	first_command = nullptr;
+	last_command  = nullptr;
+	command_count = 0;
+}
+
+size_t CommandStream::get_command_count() const
+{
+	return command_count;
+}
+
+void CommandStream::begin_render_pass(const VkRenderPassBeginInfo &begin_info, VkSubpassContents contents)
+{
+	auto &args             = push<BeginRenderPassArgs>(Opcode::BeginRenderPass);
+	args.render_pass       = begin_info.renderPass;
+	args.framebuffer       = begin_info.framebuffer;
+	args.render_area       = begin_info.renderArea;
+	args.clear_value_count = begin_info.clearValueCount;
+	args.clear_values      = copy(begin_info.pClearValues, begin_info.clearValueCount);
+	args.contents          = contents;
+}
+
+void CommandStream::next_subpass(VkSubpassContents contents)
+{
+	push<NextSubpassArgs>(Opcode::NextSubpass).contents = contents;
+}
+
+void CommandStream::end_render_pass()
+{
+	push<EndRenderPassArgs>(Opcode::EndRenderPass);
+}
+
+void CommandStream::execute_commands(uint32_t command_buffer_count, const VkCommandBuffer *command_buffers)
+{
+	auto &args                = push<ExecuteCommandsArgs>(Opcode::ExecuteCommands);
+	args.command_buffer_count = command_buffer_count;
+	args.command_buffers      = copy(command_buffers, command_buffer_count);
+}
+
+void CommandStream::bind_pipeline(VkPipelineBindPoint pipeline_bind_point, VkPipeline pipeline)
+{
+	auto &args               = push<BindPipelineArgs>(Opcode::BindPipeline);
+	args.pipeline_bind_point = pipeline_bind_point;
+	args.pipeline            = pipeline;
+}
+
+void CommandStream::bind_descriptor_sets(VkPipelineBindPoint pipeline_bind_point, VkPipelineLayout pipeline_layout, uint32_t first_set,
+                                         uint32_t descriptor_set_count, const VkDescriptorSet *descriptor_sets,
+                                         uint32_t dynamic_offset_count, const uint32_t *dynamic_offsets)
+{
+	auto &args                = push<BindDescriptorSetsArgs>(Opcode::BindDescriptorSets);
+	args.pipeline_bind_point  = pipeline_bind_point;
+	args.pipeline_layout      = pipeline_layout;
+	args.first_set            = first_set;
+	args.descriptor_set_count = descriptor_set_count;
+	args.descriptor_sets      = copy(descriptor_sets, descriptor_set_count);
+	args.dynamic_offset_count = dynamic_offset_count;
+	args.dynamic_offsets      = copy(dynamic_offsets, dynamic_offset_count);
+}
+
+void CommandStream::bind_vertex_buffers(uint32_t first_binding, uint32_t binding_count, const VkBuffer *buffers, const VkDeviceSize *offsets)
+{
+	auto &args         = push<BindVertexBuffersArgs>(Opcode::BindVertexBuffers);
+	args.first_binding = first_binding;
+	args.binding_count = binding_count;
+	args.buffers       = copy(buffers, binding_count);
+	args.offsets       = copy(offsets, binding_count);
+}
+
+void CommandStream::bind_index_buffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType index_type)
+{
+	auto &args      = push<BindIndexBufferArgs>(Opcode::BindIndexBuffer);
+	args.buffer     = buffer;
+	args.offset     = offset;
+	args.index_type = index_type;
+}
+
+void CommandStream::push_constants(VkPipelineLayout pipeline_layout, VkShaderStageFlags stage_flags, uint32_t offset, uint32_t size, const void *values)
+{
+	auto &args           = push<PushConstantsArgs>(Opcode::PushConstants);
+	args.pipeline_layout = pipeline_layout;
+	args.stage_flags     = stage_flags;
+	args.offset          = offset;
+	args.size            = size;
+	args.values          = copy(static_cast<const uint8_t *>(values), size);
+}
+
+void CommandStream::set_viewport(uint32_t first_viewport, uint32_t viewport_count, const VkViewport *viewports)
+{
+	auto &args          = push<SetViewportArgs>(Opcode::SetViewport);
+	args.first_viewport = first_viewport;
+	args.viewport_count = viewport_count;
+	args.viewports      = copy(viewports, viewport_count);
+}
+
+void CommandStream::set_scissor(uint32_t first_scissor, uint32_t scissor_count, const VkRect2D *scissors)
+{
+	auto &args         = push<SetScissorArgs>(Opcode::SetScissor);
+	args.first_scissor = first_scissor;
+	args.scissor_count = scissor_count;
+	args.scissors      = copy(scissors, scissor_count);
+}
+
+void CommandStream::set_line_width(float line_width)
+{
+	push<SetLineWidthArgs>(Opcode::SetLineWidth).line_width = line_width;
+}
+
+void CommandStream::set_depth_bias(float depth_bias_constant_factor, float depth_bias_clamp, float depth_bias_slope_factor)
+{
+	auto &args                      = push<SetDepthBiasArgs>(Opcode::SetDepthBias);
+	args.depth_bias_constant_factor = depth_bias_constant_factor;
+	args.depth_bias_clamp           = depth_bias_clamp;
+	args.depth_bias_slope_factor    = depth_bias_slope_factor;
+}
+
+void CommandStream::set_blend_constants(const float blend_constants[4])
+{
+	auto &args = push<SetBlendConstantsArgs>(Opcode::SetBlendConstants);
+	std::memcpy(args.blend_constants, blend_constants, sizeof(args.blend_constants));
+}
+
+void CommandStream::set_depth_bounds(float min_depth_bounds, float max_depth_bounds)
+{
+	auto &args            = push<SetDepthBoundsArgs>(Opcode::SetDepthBounds);
+	args.min_depth_bounds = min_depth_bounds;
+	args.max_depth_bounds = max_depth_bounds;
+}
+
+void CommandStream::draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance)
+{
+	auto &args          = push<DrawArgs>(Opcode::Draw);
+	args.vertex_count   = vertex_count;
+	args.instance_count = instance_count;
+	args.first_vertex   = first_vertex;
+	args.first_instance = first_instance;
+}
+
+void CommandStream::draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance)
+{
+	auto &args          = push<DrawIndexedArgs>(Opcode::DrawIndexed);
+	args.index_count    = index_count;
+	args.instance_count = instance_count;
+	args.first_index    = first_index;
+	args.vertex_offset  = vertex_offset;
+	args.first_instance = first_instance;
+}
+
+void CommandStream::draw_indexed_indirect(VkBuffer buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride)
+{
+	auto &args      = push<DrawIndexedIndirectArgs>(Opcode::DrawIndexedIndirect);
+	args.buffer     = buffer;
+	args.offset     = offset;
+	args.draw_count = draw_count;
+	args.stride     = stride;
+}
+
+void CommandStream::dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
+{
+	auto &args         = push<DispatchArgs>(Opcode::Dispatch);
+	args.group_count_x = group_count_x;
+	args.group_count_y = group_count_y;
+	args.group_count_z = group_count_z;
+}
+
+void CommandStream::dispatch_indirect(VkBuffer buffer, VkDeviceSize offset)
+{
+	auto &args  = push<DispatchIndirectArgs>(Opcode::DispatchIndirect);
+	args.buffer = buffer;
+	args.offset = offset;
+}
+
+void CommandStream::clear_attachments(uint32_t attachment_count, const VkClearAttachment *attachments, uint32_t rect_count, const VkClearRect *rects)
+{
+	auto &args            = push<ClearAttachmentsArgs>(Opcode::ClearAttachments);
+	args.attachment_count = attachment_count;
+	args.attachments      = copy(attachments, attachment_count);
+	args.rect_count       = rect_count;
+	args.rects            = copy(rects, rect_count);
+}
+
+void CommandStream::update_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const void *data)
+{
+	auto &args  = push<UpdateBufferArgs>(Opcode::UpdateBuffer);
+	args.buffer = buffer;
+	args.offset = offset;
+	args.size   = size;
+	args.data   = copy(static_cast<const uint8_t *>(data), static_cast<size_t>(size));
+}
+
+void CommandStream::copy_buffer(VkBuffer src_buffer, VkBuffer dst_buffer, uint32_t region_count, const VkBufferCopy *regions)
+{
+	auto &args        = push<CopyBufferArgs>(Opcode::CopyBuffer);
+	args.src_buffer   = src_buffer;
+	args.dst_buffer   = dst_buffer;
+	args.region_count = region_count;
+	args.regions      = copy(regions, region_count);
+}
+
+void CommandStream::copy_image(VkImage src_image, VkImageLayout src_layout, VkImage dst_image, VkImageLayout dst_layout, uint32_t region_count, const VkImageCopy *regions)
+{
+	auto &args        = push<CopyImageArgs>(Opcode::CopyImage);
+	args.src_image    = src_image;
+	args.src_layout   = src_layout;
+	args.dst_image    = dst_image;
+	args.dst_layout   = dst_layout;
+	args.region_count = region_count;
+	args.regions      = copy(regions, region_count);
+}
+
+void CommandStream::copy_buffer_to_image(VkBuffer src_buffer, VkImage dst_image, VkImageLayout dst_layout, uint32_t region_count, const VkBufferImageCopy *regions)
+{
+	auto &args        = push<CopyBufferToImageArgs>(Opcode::CopyBufferToImage);
+	args.src_buffer   = src_buffer;
+	args.dst_image    = dst_image;
+	args.dst_layout   = dst_layout;
+	args.region_count = region_count;
+	args.regions      = copy(regions, region_count);
+}
+
+void CommandStream::blit_image(VkImage src_image, VkImageLayout src_layout, VkImage dst_image, VkImageLayout dst_layout, uint32_t region_count, const VkImageBlit *regions, VkFilter filter)
+{
+	auto &args        = push<BlitImageArgs>(Opcode::BlitImage);
+	args.src_image    = src_image;
+	args.src_layout   = src_layout;
+	args.dst_image    = dst_image;
+	args.dst_layout   = dst_layout;
+	args.region_count = region_count;
+	args.regions      = copy(regions, region_count);
+	args.filter       = filter;
+}
+
+void CommandStream::pipeline_barrier(VkPipelineStageFlags src_stage_mask, VkPipelineStageFlags dst_stage_mask, VkDependencyFlags dependency_flags,
+                                     uint32_t memory_barrier_count, const VkMemoryBarrier *memory_barriers,
+                                     uint32_t buffer_memory_barrier_count, const VkBufferMemoryBarrier *buffer_memory_barriers,
+                                     uint32_t image_memory_barrier_count, const VkImageMemoryBarrier *image_memory_barriers)
+{
+	auto &args                       = push<PipelineBarrierArgs>(Opcode::PipelineBarrier);
+	args.src_stage_mask              = src_stage_mask;
+	args.dst_stage_mask              = dst_stage_mask;
+	args.dependency_flags            = dependency_flags;
+	args.memory_barrier_count        = memory_barrier_count;
+	args.memory_barriers             = copy(memory_barriers, memory_barrier_count);
+	args.buffer_memory_barrier_count = buffer_memory_barrier_count;
+	args.buffer_memory_barriers      = copy(buffer_memory_barriers, buffer_memory_barrier_count);
+	args.image_memory_barrier_count  = image_memory_barrier_count;
+	args.image_memory_barriers       = copy(image_memory_barriers, image_memory_barrier_count);
+}
+
+void CommandStream::execute(VkCommandBuffer command_buffer) const
+{
+	for (auto command = first_command; command != nullptr; command = command->next)
+	{
+		switch (command->opcode)
+		{
+			case Opcode::BeginRenderPass:
+			{
+				auto &args = static_cast<const CommandWithArgs<BeginRenderPassArgs> *>(command)->args;
+
+				VkRenderPassBeginInfo begin_info{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+				begin_info.renderPass      = args.render_pass;
+				begin_info.framebuffer     = args.framebuffer;
+				begin_info.renderArea      = args.render_area;
+				begin_info.clearValueCount = args.clear_value_count;
+				begin_info.pClearValues    = args.clear_values;
+
+				vkCmdBeginRenderPass(command_buffer, &begin_info, args.contents);
+				break;
+			}
+			case Opcode::NextSubpass:
+			{
+				auto &args = static_cast<const CommandWithArgs<NextSubpassArgs> *>(command)->args;
+				vkCmdNextSubpass(command_buffer, args.contents);
+				break;
+			}
+			case Opcode::EndRenderPass:
+			{
+				vkCmdEndRenderPass(command_buffer);
+				break;
+			}
+			case Opcode::ExecuteCommands:
+			{
+				auto &args = static_cast<const CommandWithArgs<ExecuteCommandsArgs> *>(command)->args;
+				vkCmdExecuteCommands(command_buffer, args.command_buffer_count, args.command_buffers);
+				break;
+			}
+			case Opcode::BindPipeline:
+			{
+				auto &args = static_cast<const CommandWithArgs<BindPipelineArgs> *>(command)->args;
+				vkCmdBindPipeline(command_buffer, args.pipeline_bind_point, args.pipeline);
+				break;
+			}
+			case Opcode::BindDescriptorSets:
+			{
+				auto &args = static_cast<const CommandWithArgs<BindDescriptorSetsArgs> *>(command)->args;
+				vkCmdBindDescriptorSets(command_buffer, args.pipeline_bind_point, args.pipeline_layout, args.first_set,
+				                        args.descriptor_set_count, args.descriptor_sets,
+				                        args.dynamic_offset_count, args.dynamic_offsets);
+				break;
+			}
+			case Opcode::BindVertexBuffers:
+			{
+				auto &args = static_cast<const CommandWithArgs<BindVertexBuffersArgs> *>(command)->args;
+				vkCmdBindVertexBuffers(command_buffer, args.first_binding, args.binding_count, args.buffers, args.offsets);
+				break;
+			}
+			case Opcode::BindIndexBuffer:
+			{
+				auto &args = static_cast<const CommandWithArgs<BindIndexBufferArgs> *>(command)->args;
+				vkCmdBindIndexBuffer(command_buffer, args.buffer, args.offset, args.index_type);
+				break;
+			}
+			case Opcode::PushConstants:
+			{
+				auto &args = static_cast<const CommandWithArgs<PushConstantsArgs> *>(command)->args;
+				vkCmdPushConstants(command_buffer, args.pipeline_layout, args.stage_flags, args.offset, args.size, args.values);
+				break;
+			}
+			case Opcode::SetViewport:
+			{
+				auto &args = static_cast<const CommandWithArgs<SetViewportArgs> *>(command)->args;
+				vkCmdSetViewport(command_buffer, args.first_viewport, args.viewport_count, args.viewports);
+				break;
+			}
+			case Opcode::SetScissor:
+			{
+				auto &args = static_cast<const CommandWithArgs<SetScissorArgs> *>(command)->args;
+				vkCmdSetScissor(command_buffer, args.first_scissor, args.scissor_count, args.scissors);
+				break;
+			}
+			case Opcode::SetLineWidth:
+			{
+				auto &args = static_cast<const CommandWithArgs<SetLineWidthArgs> *>(command)->args;
+				vkCmdSetLineWidth(command_buffer, args.line_width);
+				break;
+			}
+			case Opcode::SetDepthBias:
+			{
+				auto &args = static_cast<const CommandWithArgs<SetDepthBiasArgs> *>(command)->args;
+				vkCmdSetDepthBias(command_buffer, args.depth_bias_constant_factor, args.depth_bias_clamp, args.depth_bias_slope_factor);
+				break;
+			}
+			case Opcode::SetBlendConstants:
+			{
+				auto &args = static_cast<const CommandWithArgs<SetBlendConstantsArgs> *>(command)->args;
+				vkCmdSetBlendConstants(command_buffer, args.blend_constants);
+				break;
+			}
+			case Opcode::SetDepthBounds:
+			{
+				auto &args = static_cast<const CommandWithArgs<SetDepthBoundsArgs> *>(command)->args;
+				vkCmdSetDepthBounds(command_buffer, args.min_depth_bounds, args.max_depth_bounds);
+				break;
+			}
+			case Opcode::Draw:
+			{
+				auto &args = static_cast<const CommandWithArgs<DrawArgs> *>(command)->args;
+				vkCmdDraw(command_buffer, args.vertex_count, args.instance_count, args.first_vertex, args.first_instance);
+				break;
+			}
+			case Opcode::DrawIndexed:
+			{
+				auto &args = static_cast<const CommandWithArgs<DrawIndexedArgs> *>(command)->args;
+				vkCmdDrawIndexed(command_buffer, args.index_count, args.instance_count, args.first_index, args.vertex_offset, args.first_instance);
+				break;
+			}
+			case Opcode::DrawIndexedIndirect:
+			{
+				auto &args = static_cast<const CommandWithArgs<DrawIndexedIndirectArgs> *>(command)->args;
+				vkCmdDrawIndexedIndirect(command_buffer, args.buffer, args.offset, args.draw_count, args.stride);
+				break;
+			}
+			case Opcode::Dispatch:
+			{
+				auto &args = static_cast<const CommandWithArgs<DispatchArgs> *>(command)->args;
+				vkCmdDispatch(command_buffer, args.group_count_x, args.group_count_y, args.group_count_z);
+				break;
+			}
+			case Opcode::DispatchIndirect:
+			{
+				auto &args = static_cast<const CommandWithArgs<DispatchIndirectArgs> *>(command)->args;
+				vkCmdDispatchIndirect(command_buffer, args.buffer, args.offset);
+				break;
+			}
+			case Opcode::ClearAttachments:
+			{
+				auto &args = static_cast<const CommandWithArgs<ClearAttachmentsArgs> *>(command)->args;
+				vkCmdClearAttachments(command_buffer, args.attachment_count, args.attachments, args.rect_count, args.rects);
+				break;
+			}
+			case Opcode::UpdateBuffer:
+			{
+				auto &args = static_cast<const CommandWithArgs<UpdateBufferArgs> *>(command)->args;
+				vkCmdUpdateBuffer(command_buffer, args.buffer, args.offset, args.size, args.data);
+				break;
+			}
+			case Opcode::CopyBuffer:
+			{
+				auto &args = static_cast<const CommandWithArgs<CopyBufferArgs> *>(command)->args;
+				vkCmdCopyBuffer(command_buffer, args.src_buffer, args.dst_buffer, args.region_count, args.regions);
+				break;
+			}
+			case Opcode::CopyImage:
+			{
+				auto &args = static_cast<const CommandWithArgs<CopyImageArgs> *>(command)->args;
+				vkCmdCopyImage(command_buffer, args.src_image, args.src_layout, args.dst_image, args.dst_layout, args.region_count, args.regions);
+				break;
+			}
+			case Opcode::CopyBufferToImage:
+			{
+				auto &args = static_cast<const CommandWithArgs<CopyBufferToImageArgs> *>(command)->args;
+				vkCmdCopyBufferToImage(command_buffer, args.src_buffer, args.dst_image, args.dst_layout, args.region_count, args.regions);
+				break;
+			}
+			case Opcode::BlitImage:
+			{
+				auto &args = static_cast<const CommandWithArgs<BlitImageArgs> *>(command)->args;
+				vkCmdBlitImage(command_buffer, args.src_image, args.src_layout, args.dst_image, args.dst_layout, args.region_count, args.regions, args.filter);
+				break;
+			}
+			case Opcode::PipelineBarrier:
+			{
+				auto &args = static_cast<const CommandWithArgs<PipelineBarrierArgs> *>(command)->args;
+				vkCmdPipelineBarrier(command_buffer, args.src_stage_mask, args.dst_stage_mask, args.dependency_flags,
+				                     args.memory_barrier_count, args.memory_barriers,
+				                     args.buffer_memory_barrier_count, args.buffer_memory_barriers,
+				                     args.image_memory_barrier_count, args.image_memory_barriers);
+				break;
+			}
+		}
+	}
+}
+}        // namespace vkb
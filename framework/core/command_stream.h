@@ -0,0 +1,188 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "common/helpers.h"
+#include "common/linear_arena.h"
+#include "common/vk_common.h"
+
+namespace vkb
+{
+/**
+ * @brief A list of Vulkan commands recorded on the CPU, with their arguments
+ *        packed in a LinearArena, and translated to a command buffer later.
+ *
+ * Recording does not call Vulkan, so that it does not need the command pool,
+ * and array arguments are copied so the caller's storage can go away.
+ */
+class CommandStream
+{
+  public:
+	enum class Opcode
+	{
+		BeginRenderPass,
+		NextSubpass,
+		EndRenderPass,
+		ExecuteCommands,
+		BindPipeline,
+		BindDescriptorSets,
+		BindVertexBuffers,
+		BindIndexBuffer,
+		PushConstants,
+		SetViewport,
+		SetScissor,
+		SetLineWidth,
+		SetDepthBias,
+		SetBlendConstants,
+		SetDepthBounds,
+		Draw,
+		DrawIndexed,
+		DrawIndexedIndirect,
+		Dispatch,
+		DispatchIndirect,
+		ClearAttachments,
+		UpdateBuffer,
+		CopyBuffer,
+		CopyImage,
+		CopyBufferToImage,
+		BlitImage,
+		PipelineBarrier
+	};
+
+	CommandStream() = default;
+
+	CommandStream(const CommandStream &) = delete;
+
+	CommandStream(CommandStream &&) = default;
+
+	CommandStream &operator=(const CommandStream &) = delete;
+
+	CommandStream &operator=(CommandStream &&) = delete;
+
+	/**
+	 * @brief Empties the stream and makes it allocate from an arena
+	 * @param arena The arena for commands and their arguments, which must not be reset until the stream is executed
+	 */
+	void reset(LinearArena &arena);
+
+	/**
+	 * @brief Records all the commands of the stream in order
+	 * @param command_buffer A command buffer in the recording state
+	 */
+	void execute(VkCommandBuffer command_buffer) const;
+
+	size_t get_command_count() const;
+
+	void begin_render_pass(const VkRenderPassBeginInfo &begin_info, VkSubpassContents contents);
+
+	void next_subpass(VkSubpassContents contents);
+
+	void end_render_pass();
+
+	void execute_commands(uint32_t command_buffer_count, const VkCommandBuffer *command_buffers);
+
+	void bind_pipeline(VkPipelineBindPoint pipeline_bind_point, VkPipeline pipeline);
+
+	void bind_descriptor_sets(VkPipelineBindPoint pipeline_bind_point, VkPipelineLayout pipeline_layout, uint32_t first_set,
+	                          uint32_t descriptor_set_count, const VkDescriptorSet *descriptor_sets,
+	                          uint32_t dynamic_offset_count, const uint32_t *dynamic_offsets);
+
+	void bind_vertex_buffers(uint32_t first_binding, uint32_t binding_count, const VkBuffer *buffers, const VkDeviceSize *offsets);
+
+	void bind_index_buffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType index_type);
+
+	void push_constants(VkPipelineLayout pipeline_layout, VkShaderStageFlags stage_flags, uint32_t offset, uint32_t size, const void *values);
+
+	void set_viewport(uint32_t first_viewport, uint32_t viewport_count, const VkViewport *viewports);
+
+	void set_scissor(uint32_t first_scissor, uint32_t scissor_count, const VkRect2D *scissors);
+
+	void set_line_width(float line_width);
+
+	void set_depth_bias(float depth_bias_constant_factor, float depth_bias_clamp, float depth_bias_slope_factor);
+
+	void set_blend_constants(const float blend_constants[4]);
+
+	void set_depth_bounds(float min_depth_bounds, float max_depth_bounds);
+
+	void draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance);
+
+	void draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance);
+
+	void draw_indexed_indirect(VkBuffer buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride);
+
+	void dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z);
+
+	void dispatch_indirect(VkBuffer buffer, VkDeviceSize offset);
+
+	void clear_attachments(uint32_t attachment_count, const VkClearAttachment *attachments, uint32_t rect_count, const VkClearRect *rects);
+
+	void update_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const void *data);
+
+	void copy_buffer(VkBuffer src_buffer, VkBuffer dst_buffer, uint32_t region_count, const VkBufferCopy *regions);
+
+	void copy_image(VkImage src_image, VkImageLayout src_layout, VkImage dst_image, VkImageLayout dst_layout, uint32_t region_count, const VkImageCopy *regions);
+
+	void copy_buffer_to_image(VkBuffer src_buffer, VkImage dst_image, VkImageLayout dst_layout, uint32_t region_count, const VkBufferImageCopy *regions);
+
+	void blit_image(VkImage src_image, VkImageLayout src_layout, VkImage dst_image, VkImageLayout dst_layout, uint32_t region_count, const VkImageBlit *regions, VkFilter filter);
+
+	void pipeline_barrier(VkPipelineStageFlags src_stage_mask, VkPipelineStageFlags dst_stage_mask, VkDependencyFlags dependency_flags,
+	                      uint32_t memory_barrier_count, const VkMemoryBarrier *memory_barriers,
+	                      uint32_t buffer_memory_barrier_count, const VkBufferMemoryBarrier *buffer_memory_barriers,
+	                      uint32_t image_memory_barrier_count, const VkImageMemoryBarrier *image_memory_barriers);
+
+  private:
+	/**
+	 * @brief Header of a command, followed by its arguments
+	 */
+	struct Command
+	{
+		Opcode opcode;
+
+		Command *next{nullptr};
+	};
+
+	template <class T>
+	struct CommandWithArgs;
+
+	LinearArena *arena{nullptr};
+
+	Command *first_command{nullptr};
+
+	Command *last_command{nullptr};
+
+	size_t command_count{0};
+
+	/**
+	 * @brief Appends a command to the stream
+	 * @return The arguments of the command, to be filled in
+	 */
+	template <class T>
+	T &push(Opcode opcode);
+
+	/**
+	 * @brief Copies an array argument to the arena
+	 */
+	template <class T>
+	const T *copy(const T *data, size_t count);
+};
+}        // namespace vkb
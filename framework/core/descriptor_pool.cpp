@@ -20,17 +20,37 @@
 
 #include "descriptor_pool.h"
 
+#include <numeric>
+
 #include "common/error.h"
+#include "common/logging.h"
 #include "descriptor_set_layout.h"
 #include "device.h"
 
 namespace vkb
 {
-DescriptorPool::DescriptorPool(Device &                   device,
-                               const DescriptorSetLayout &descriptor_set_layout,
-                               uint32_t                   pool_size) :
+namespace
+{
+inline uint32_t next_power_of_two(uint32_t value)
+{
+	uint32_t result = 1;
+
+	while (result < value)
+	{
+		result <<= 1;
+	}
+
+	return result;
+}
+}        // namespace
+
+DescriptorPool::DescriptorPool(Device &                    device,
+                               const DescriptorSetLayout & descriptor_set_layout,
+                               uint32_t                    pool_size,
+                               VkDescriptorPoolCreateFlags flags) :
     device{device},
-    descriptor_set_layout{&descriptor_set_layout}
+    descriptor_set_layout{&descriptor_set_layout},
+    pool_flags{flags}
 {
 	const auto &bindings = descriptor_set_layout.get_bindings();
 
@@ -47,17 +67,17 @@ DescriptorPool::DescriptorPool(Device &                   device,
 
 	auto pool_size_it = pool_sizes.begin();
 
-	// Fill pool size for each descriptor type count multiplied by the pool size
+	// Fill pool size for each descriptor type count of a single set, pools multiply it by their number of sets
 	for (auto &it : descriptor_type_counts)
 	{
 		pool_size_it->type = it.first;
 
-		pool_size_it->descriptorCount = it.second * pool_size;
+		pool_size_it->descriptorCount = it.second;
 
 		++pool_size_it;
 	}
 
-	pool_max_sets = pool_size;
+	pool_max_sets = std::max(pool_size, 1u);
 }
 
 DescriptorPool::~DescriptorPool()
@@ -71,6 +91,9 @@ DescriptorPool::~DescriptorPool()
 
 void DescriptorPool::reset()
 {
+	// Sets allocated before the reset are likely to be allocated again
+	uint32_t required_sets = std::max(to_u32(set_pool_mapping.size()), frame_allocations);
+
 	// Reset all descriptor pools
 	for (auto pool : pools)
 	{
@@ -83,6 +106,15 @@ void DescriptorPool::reset()
 
 	// Reset the pool index from which descriptor sets are allocated
 	pool_index = 0;
+
+	// Merge the pools into a single one, so that allocating the same sets again does not create pools
+	if (pools.size() > 1)
+	{
+		uint32_t capacity = std::max(get_capacity(), next_power_of_two(required_sets));
+
+		destroy_pools(0);
+		create_pool(capacity);
+	}
 }
 
 const DescriptorSetLayout &DescriptorPool::get_descriptor_set_layout() const
@@ -100,6 +132,15 @@ VkDescriptorSet DescriptorPool::allocate()
 {
 	pool_index = find_available_pool(pool_index);
 
+	if (pool_index >= pools.size())
+	{
+		pool_index = 0;
+
+		++counters.failed_allocations;
+
+		return VK_NULL_HANDLE;
+	}
+
 	// Increment allocated set count for the current pool
 	++pool_sets_count[pool_index];
 
@@ -121,17 +162,54 @@ VkDescriptorSet DescriptorPool::allocate()
 		// Decrement allocated set count for the current pool
 		--pool_sets_count[pool_index];
 
-		return VK_NULL_HANDLE;
+		++counters.failed_allocations;
+
+		// The pool may be fragmented by individually freed sets, so retry once in a new pool
+		pool_index = find_available_pool(to_u32(pools.size()));
+
+		if (pool_index < pools.size())
+		{
+			++pool_sets_count[pool_index];
+
+			allocInfo.descriptorPool = pools[pool_index];
+
+			result = vkAllocateDescriptorSets(device.get_handle(), &allocInfo, &handle);
+
+			if (result != VK_SUCCESS)
+			{
+				--pool_sets_count[pool_index];
+
+				++counters.failed_allocations;
+			}
+		}
+		else
+		{
+			pool_index = 0;
+		}
+
+		if (result != VK_SUCCESS)
+		{
+			return VK_NULL_HANDLE;
+		}
 	}
 
 	// Store mapping between the descriptor set and the pool
 	set_pool_mapping.emplace(handle, pool_index);
 
+	++frame_allocations;
+
+	++counters.sets_allocated;
+
 	return handle;
 }
 
 VkResult DescriptorPool::free(VkDescriptorSet descriptor_set)
 {
+	if (!(pool_flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT))
+	{
+		return VK_INCOMPLETE;
+	}
+
 	// Get the pool index of the descriptor set
 	auto it = set_pool_mapping.find(descriptor_set);
 
@@ -157,43 +235,142 @@ VkResult DescriptorPool::free(VkDescriptorSet descriptor_set)
 	return VK_SUCCESS;
 }
 
-std::uint32_t DescriptorPool::find_available_pool(std::uint32_t search_index)
+void DescriptorPool::begin_frame()
 {
-	// Create a new pool
-	if (pools.size() <= search_index)
+	// New pools are sized for the highest allocation count seen so far in the window
+	peak_allocations        = std::max(peak_allocations, frame_allocations);
+	window_peak_allocations = std::max(window_peak_allocations, frame_allocations);
+
+	frame_allocations = 0;
+
+	counters = {};
+
+	if (++window_frame_count < SHRINK_FRAME_COUNT)
 	{
-		VkDescriptorPoolCreateInfo create_info{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+		return;
+	}
 
-		// We do not set FREE_DESCRIPTOR_SET_BIT as we do not need to free individual descriptor sets
-		create_info.flags         = 0;
-		create_info.poolSizeCount = to_u32(pool_sizes.size());
-		create_info.pPoolSizes    = pool_sizes.data();
-		create_info.maxSets       = pool_max_sets;
+	// Forget older peaks, so that pools can shrink after a sustained period of low usage
+	peak_allocations        = window_peak_allocations;
+	window_peak_allocations = 0;
+	window_frame_count      = 0;
 
-		VkDescriptorPool handle = VK_NULL_HANDLE;
+	shrink();
+}
 
-		// Create the Vulkan descriptor pool
-		auto result = vkCreateDescriptorPool(device.get_handle(), &create_info, nullptr, &handle);
+uint32_t DescriptorPool::get_capacity() const
+{
+	return std::accumulate(pool_capacities.begin(), pool_capacities.end(), 0u);
+}
 
-		if (result != VK_SUCCESS)
+const DescriptorPoolCounters &DescriptorPool::get_counters() const
+{
+	return counters;
+}
+
+std::uint32_t DescriptorPool::find_available_pool(std::uint32_t search_index)
+{
+	for (; search_index < pools.size(); ++search_index)
+	{
+		if (pool_sets_count[search_index] < pool_capacities[search_index])
 		{
-			return VK_NULL_HANDLE;
+			return search_index;
 		}
+	}
+
+	// All pools are full, so grow geometrically: the new pool holds at least as many sets as the existing ones
+	uint32_t max_sets = std::max({pool_max_sets, get_capacity(), next_power_of_two(peak_allocations)});
+
+	if (!create_pool(max_sets))
+	{
+		return to_u32(pools.size());
+	}
+
+	return to_u32(pools.size() - 1);
+}
+
+bool DescriptorPool::create_pool(uint32_t max_sets)
+{
+	std::vector<VkDescriptorPoolSize> sizes = pool_sizes;
+
+	for (auto &size : sizes)
+	{
+		size.descriptorCount *= max_sets;
+	}
+
+	VkDescriptorPoolCreateInfo create_info{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+
+	// FREE_DESCRIPTOR_SET_BIT is only set by owners which need to free individual descriptor sets
+	create_info.flags         = pool_flags;
+	create_info.poolSizeCount = to_u32(sizes.size());
+	create_info.pPoolSizes    = sizes.data();
+	create_info.maxSets       = max_sets;
+
+	VkDescriptorPool handle = VK_NULL_HANDLE;
 
-		// Store internally the Vulkan handle
-		pools.push_back(handle);
+	// Create the Vulkan descriptor pool
+	auto result = vkCreateDescriptorPool(device.get_handle(), &create_info, nullptr, &handle);
 
-		// Add set count for the descriptor pool
-		pool_sets_count.push_back(0);
+	if (result != VK_SUCCESS)
+	{
+		LOGE("Cannot create a descriptor pool for {} sets: {}", max_sets, to_string(result));
+		return false;
+	}
+
+	// Store internally the Vulkan handle
+	pools.push_back(handle);
+
+	// Add set count and capacity for the descriptor pool
+	pool_sets_count.push_back(0);
+	pool_capacities.push_back(max_sets);
+
+	++counters.pools_created;
+
+	return true;
+}
+
+void DescriptorPool::destroy_pools(size_t first_pool)
+{
+	for (size_t i = first_pool; i < pools.size(); ++i)
+	{
+		assert(pool_sets_count[i] == 0 && "Cannot destroy a descriptor pool holding descriptor sets");
+
+		vkDestroyDescriptorPool(device.get_handle(), pools[i], nullptr);
+	}
+
+	pools.resize(first_pool);
+	pool_sets_count.resize(first_pool);
+	pool_capacities.resize(first_pool);
+
+	pool_index = std::min(pool_index, to_u32(first_pool));
+}
+
+void DescriptorPool::shrink()
+{
+	// Keep room for the live sets and a peak frame of new allocations
+	uint32_t required_sets = std::max(pool_max_sets, to_u32(set_pool_mapping.size()) + peak_allocations);
 
-		return search_index;
+	uint32_t capacity   = get_capacity();
+	size_t   pool_count = pools.size();
+
+	// Only trailing pools can be destroyed, as sets are mapped to pool indices
+	while (pool_count > 0 && pool_sets_count[pool_count - 1] == 0 && capacity - pool_capacities[pool_count - 1] >= required_sets)
+	{
+		--pool_count;
+		capacity -= pool_capacities[pool_count];
 	}
-	else if (pool_sets_count[search_index] < pool_max_sets)
+
+	// A single empty pool much larger than needed is recreated on the next allocation
+	if (pool_count == 1 && pool_sets_count[0] == 0 && pool_capacities[0] >= 4 * next_power_of_two(required_sets))
 	{
-		return search_index;
+		pool_count = 0;
 	}
 
-	// Increment pool index
-	return find_available_pool(++search_index);
+	if (pool_count < pools.size())
+	{
+		LOGD("Releasing {} unused descriptor pools", pools.size() - pool_count);
+
+		destroy_pools(pool_count);
+	}
 }
 }        // namespace vkb
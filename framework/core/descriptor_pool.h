@@ -31,16 +31,40 @@ class Device;
 class DescriptorSetLayout;
 
 /**
- * @brief Manages an array of fixed size VkDescriptorPool and is able to allocate descriptor sets
+ * @brief Counters of descriptor pool activity in a frame
+ */
+struct DescriptorPoolCounters
+{
+	/// Vulkan descriptor pools created
+	uint64_t pools_created{0};
+
+	/// Descriptor sets allocated
+	uint64_t sets_allocated{0};
+
+	/// Descriptor set allocations which failed, including those retried in a new pool
+	uint64_t failed_allocations{0};
+};
+
+/**
+ * @brief Manages an array of VkDescriptorPool and is able to allocate descriptor sets.
+ *
+ * Pools grow geometrically: a new pool holds at least as many sets as all the existing ones,
+ * and as many as the peak number of sets allocated in a frame. When reset, multiple pools are
+ * merged into a single one large enough for the previous frame, so steady state frames do not
+ * create pools. Empty pools are destroyed after SHRINK_FRAME_COUNT frames of low usage.
  */
 class DescriptorPool
 {
   public:
 	static const uint32_t MAX_SETS_PER_POOL = 16;
 
-	DescriptorPool(Device &                   device,
-	               const DescriptorSetLayout &descriptor_set_layout,
-	               uint32_t                   pool_size = MAX_SETS_PER_POOL);
+	/// Number of frames over which the peak allocation is measured before shrinking
+	static const uint32_t SHRINK_FRAME_COUNT = 120;
+
+	DescriptorPool(Device &                    device,
+	               const DescriptorSetLayout & descriptor_set_layout,
+	               uint32_t                    pool_size = MAX_SETS_PER_POOL,
+	               VkDescriptorPoolCreateFlags flags     = 0);
 
 	DescriptorPool(const DescriptorPool &) = delete;
 
@@ -60,19 +84,61 @@ class DescriptorPool
 
 	VkDescriptorSet allocate();
 
+	/**
+	 * @brief Frees a descriptor set back to its pool
+	 * @return VK_INCOMPLETE if the set was not allocated from this pool, or the pool was not
+	 *         created with FREE_DESCRIPTOR_SET_BIT, in which case the set is released when the pool is reset
+	 */
 	VkResult free(VkDescriptorSet descriptor_set);
 
+	/**
+	 * @brief Marks the start of a new frame, to track the per frame peak allocation
+	 *        and release pools which stayed unused
+	 */
+	void begin_frame();
+
+	/**
+	 * @return The number of descriptor sets the pools can hold
+	 */
+	uint32_t get_capacity() const;
+
+	/**
+	 * @return The activity of the pool since the start of the frame
+	 */
+	const DescriptorPoolCounters &get_counters() const;
+
   private:
 	Device &device;
 
 	const DescriptorSetLayout *descriptor_set_layout{nullptr};
 
-	// Descriptor pool size
+	// Descriptor count of each type needed by a single set
 	std::vector<VkDescriptorPoolSize> pool_sizes;
 
-	// Number of sets to allocate for each pool
+	// Minimum number of sets to allocate for each pool
 	uint32_t pool_max_sets{0};
 
+	// Number of sets each pool was created for
+	std::vector<uint32_t> pool_capacities;
+
+	// Sets allocated since the start of the frame
+	uint32_t frame_allocations{0};
+
+	// Highest frame_allocations of the current measuring window
+	uint32_t window_peak_allocations{0};
+
+	// Frames elapsed in the current measuring window
+	uint32_t window_frame_count{0};
+
+	// Highest frame_allocations of the last complete window, used to size new pools
+	uint32_t peak_allocations{0};
+
+	// Activity since the start of the frame, kept per pool so that allocations do not share a counter across threads
+	DescriptorPoolCounters counters{};
+
+	// Flags used to create each pool, sets can only be freed individually with FREE_DESCRIPTOR_SET_BIT
+	VkDescriptorPoolCreateFlags pool_flags{0};
+
 	// Total descriptor pools created
 	std::vector<VkDescriptorPool> pools;
 
@@ -85,7 +151,16 @@ class DescriptorPool
 	// Map between descriptor set and pool index
 	std::unordered_map<VkDescriptorSet, uint32_t> set_pool_mapping;
 
-	// Find next pool index or create new pool
+	// Find next pool index or create new pool, returns pools.size() if no pool could be created
 	uint32_t find_available_pool(uint32_t pool_index);
+
+	// Create a pool holding the given number of sets
+	bool create_pool(uint32_t max_sets);
+
+	// Destroy the pools from the given index onwards, which must not hold any set
+	void destroy_pools(size_t first_pool);
+
+	// Release empty pools not needed for the observed usage
+	void shrink();
 };
 }        // namespace vkb
@@ -48,6 +48,11 @@ void DescriptorSet::update(const BindingMap<VkDescriptorBufferInfo> &buffer_info
 	this->buffer_infos = buffer_infos;
 	this->image_infos  = image_infos;
 
+	if (update_with_template(buffer_infos, image_infos))
+	{
+		return;
+	}
+
 	std::vector<VkWriteDescriptorSet> set_updates;
 
 	// Iterate over all buffer bindings
@@ -117,6 +122,83 @@ void DescriptorSet::update(const BindingMap<VkDescriptorBufferInfo> &buffer_info
 	vkUpdateDescriptorSets(device.get_handle(), to_u32(set_updates.size()), set_updates.data(), 0, nullptr);
 }
 
+bool DescriptorSet::update_with_template(const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos)
+{
+	VkDescriptorUpdateTemplateKHR update_template = descriptor_set_layout.get_update_template();
+
+	if (update_template == VK_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	// A template writes every descriptor of the layout, so partial updates go through the write path
+	size_t descriptor_count = 0;
+
+	for (auto &binding_it : buffer_infos)
+	{
+		descriptor_count += binding_it.second.size();
+	}
+
+	for (auto &binding_it : image_infos)
+	{
+		descriptor_count += binding_it.second.size();
+	}
+
+	if (descriptor_count != descriptor_set_layout.get_update_template_descriptor_count())
+	{
+		return false;
+	}
+
+	// The layout only has a template if the packed data fits, so no update allocates
+	alignas(VkDescriptorImageInfo) uint8_t data[DescriptorSetLayout::MAX_UPDATE_TEMPLATE_SIZE];
+
+	for (auto &entry : descriptor_set_layout.get_update_template_entries())
+	{
+		uint8_t *dst = data + entry.offset;
+
+		if (is_buffer_descriptor_type(entry.descriptorType) && buffer_infos.count(entry.dstBinding) > 0)
+		{
+			auto &buffer_bindings = buffer_infos.at(entry.dstBinding);
+
+			for (uint32_t array_element = 0; array_element < entry.descriptorCount; ++array_element, dst += entry.stride)
+			{
+				auto it = buffer_bindings.find(array_element);
+
+				if (it == buffer_bindings.end())
+				{
+					return false;
+				}
+
+				std::memcpy(dst, &it->second, sizeof(VkDescriptorBufferInfo));
+			}
+		}
+		else if (!is_buffer_descriptor_type(entry.descriptorType) && image_infos.count(entry.dstBinding) > 0)
+		{
+			auto &image_bindings = image_infos.at(entry.dstBinding);
+
+			for (uint32_t array_element = 0; array_element < entry.descriptorCount; ++array_element, dst += entry.stride)
+			{
+				auto it = image_bindings.find(array_element);
+
+				if (it == image_bindings.end())
+				{
+					return false;
+				}
+
+				std::memcpy(dst, &it->second, sizeof(VkDescriptorImageInfo));
+			}
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	vkUpdateDescriptorSetWithTemplateKHR(device.get_handle(), handle, update_template, data);
+
+	return true;
+}
+
 DescriptorSet::DescriptorSet(DescriptorSet &&other) :
     device{other.device},
     descriptor_set_layout{other.descriptor_set_layout},
@@ -138,6 +220,11 @@ const DescriptorSetLayout &DescriptorSet::get_layout() const
 	return descriptor_set_layout;
 }
 
+DescriptorPool &DescriptorSet::get_pool()
+{
+	return descriptor_pool;
+}
+
 BindingMap<VkDescriptorBufferInfo> &DescriptorSet::get_buffer_infos()
 {
 	return buffer_infos;
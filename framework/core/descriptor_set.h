@@ -58,6 +58,8 @@ class DescriptorSet
 
 	const DescriptorSetLayout &get_layout() const;
 
+	DescriptorPool &get_pool();
+
 	VkDescriptorSet get_handle() const;
 
 	BindingMap<VkDescriptorBufferInfo> &get_buffer_infos();
@@ -65,6 +67,14 @@ class DescriptorSet
 	BindingMap<VkDescriptorImageInfo> &get_image_infos();
 
   private:
+	/**
+	 * @brief Writes the descriptor set from a packed blob through the layout's descriptor update template
+	 * @return False if the layout has no template or the infos do not cover every descriptor of the layout,
+	 *         in which case the set must be written with vkUpdateDescriptorSets
+	 */
+	bool update_with_template(const BindingMap<VkDescriptorBufferInfo> &buffer_infos,
+	                          const BindingMap<VkDescriptorImageInfo> & image_infos);
+
 	Device &device;
 
 	DescriptorSetLayout &descriptor_set_layout;
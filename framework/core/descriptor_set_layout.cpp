@@ -20,6 +20,7 @@
 
 #include "descriptor_set_layout.h"
 
+#include "common/logging.h"
 #include "device.h"
 #include "shader_module.h"
 
@@ -118,20 +119,94 @@ DescriptorSetLayout::DescriptorSetLayout(Device &device, const std::vector<Shade
 	{
 		throw VulkanException{result, "Cannot create DescriptorSetLayout"};
 	}
+
+	if (bindings.empty() ||
+	    !device.is_extension_enabled(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME) ||
+	    !vkCreateDescriptorUpdateTemplateKHR)
+	{
+		return;
+	}
+
+	// Lay out every binding contiguously, so a descriptor set can be written from a single packed blob
+	for (auto &binding : bindings)
+	{
+		if (binding.descriptorCount == 0)
+		{
+			// Unsized arrays cannot be described by a fixed template
+			update_template_entries.clear();
+			update_template_size             = 0;
+			update_template_descriptor_count = 0;
+			return;
+		}
+
+		VkDescriptorUpdateTemplateEntryKHR entry{};
+
+		entry.dstBinding      = binding.binding;
+		entry.dstArrayElement = 0;
+		entry.descriptorCount = binding.descriptorCount;
+		entry.descriptorType  = binding.descriptorType;
+		entry.offset          = update_template_size;
+		entry.stride          = is_buffer_descriptor_type(binding.descriptorType) ? sizeof(VkDescriptorBufferInfo) : sizeof(VkDescriptorImageInfo);
+
+		update_template_entries.push_back(entry);
+
+		update_template_size += entry.stride * entry.descriptorCount;
+		update_template_descriptor_count += entry.descriptorCount;
+	}
+
+	if (update_template_size > MAX_UPDATE_TEMPLATE_SIZE)
+	{
+		// Descriptor sets of this layout will be written with vkUpdateDescriptorSets
+		update_template_entries.clear();
+		update_template_size             = 0;
+		update_template_descriptor_count = 0;
+		return;
+	}
+
+	VkDescriptorUpdateTemplateCreateInfoKHR template_info{VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR};
+
+	template_info.descriptorUpdateEntryCount = to_u32(update_template_entries.size());
+	template_info.pDescriptorUpdateEntries   = update_template_entries.data();
+	template_info.templateType               = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR;
+	template_info.descriptorSetLayout        = handle;
+
+	result = vkCreateDescriptorUpdateTemplateKHR(device.get_handle(), &template_info, nullptr, &update_template);
+
+	if (result != VK_SUCCESS)
+	{
+		// Descriptor sets of this layout will be written with vkUpdateDescriptorSets
+		LOGW("Cannot create descriptor update template, falling back to vkUpdateDescriptorSets");
+
+		update_template = VK_NULL_HANDLE;
+		update_template_entries.clear();
+		update_template_size             = 0;
+		update_template_descriptor_count = 0;
+	}
 }
 
 DescriptorSetLayout::DescriptorSetLayout(DescriptorSetLayout &&other) :
     device{other.device},
     handle{other.handle},
+    update_template{other.update_template},
+    update_template_entries{std::move(other.update_template_entries)},
+    update_template_size{other.update_template_size},
+    update_template_descriptor_count{other.update_template_descriptor_count},
     bindings{std::move(other.bindings)},
     bindings_lookup{std::move(other.bindings_lookup)},
     resources_lookup{std::move(other.resources_lookup)}
 {
-	other.handle = VK_NULL_HANDLE;
+	other.handle          = VK_NULL_HANDLE;
+	other.update_template = VK_NULL_HANDLE;
 }
 
 DescriptorSetLayout::~DescriptorSetLayout()
 {
+	// Destroy descriptor update template
+	if (update_template != VK_NULL_HANDLE)
+	{
+		vkDestroyDescriptorUpdateTemplateKHR(device.get_handle(), update_template, nullptr);
+	}
+
 	// Destroy descriptor set layout
 	if (handle != VK_NULL_HANDLE)
 	{
@@ -172,4 +247,24 @@ std::unique_ptr<VkDescriptorSetLayoutBinding> DescriptorSetLayout::get_layout_bi
 
 	return get_layout_binding(it->second);
 }
+
+VkDescriptorUpdateTemplateKHR DescriptorSetLayout::get_update_template() const
+{
+	return update_template;
+}
+
+const std::vector<VkDescriptorUpdateTemplateEntryKHR> &DescriptorSetLayout::get_update_template_entries() const
+{
+	return update_template_entries;
+}
+
+size_t DescriptorSetLayout::get_update_template_size() const
+{
+	return update_template_size;
+}
+
+uint32_t DescriptorSetLayout::get_update_template_descriptor_count() const
+{
+	return update_template_descriptor_count;
+}
 }        // namespace vkb
@@ -37,6 +37,12 @@ struct ShaderResource;
 class DescriptorSetLayout
 {
   public:
+	/**
+	 * @brief Largest packed update data in bytes, so that a descriptor set can be
+	 *        written from a buffer on the stack. Larger layouts have no update template
+	 */
+	static constexpr size_t MAX_UPDATE_TEMPLATE_SIZE = 1024;
+
 	/**
 	 * @brief Creates a descriptor set layout from a set of resources
 	 * @param device A valid Vulkan device
@@ -63,11 +69,42 @@ class DescriptorSetLayout
 
 	std::unique_ptr<VkDescriptorSetLayoutBinding> get_layout_binding(const std::string &name) const;
 
+	/**
+	 * @return The descriptor update template writing every binding of the layout,
+	 *         or VK_NULL_HANDLE if descriptor update templates are not available
+	 *         or the packed data would exceed MAX_UPDATE_TEMPLATE_SIZE
+	 */
+	VkDescriptorUpdateTemplateKHR get_update_template() const;
+
+	/**
+	 * @return The template entries, one per binding, describing where each
+	 *         binding's descriptors live in the packed update data
+	 */
+	const std::vector<VkDescriptorUpdateTemplateEntryKHR> &get_update_template_entries() const;
+
+	/**
+	 * @return The size in bytes of the packed data consumed by the update template
+	 */
+	size_t get_update_template_size() const;
+
+	/**
+	 * @return The total number of descriptors written by the update template
+	 */
+	uint32_t get_update_template_descriptor_count() const;
+
   private:
 	Device &device;
 
 	VkDescriptorSetLayout handle{VK_NULL_HANDLE};
 
+	VkDescriptorUpdateTemplateKHR update_template{VK_NULL_HANDLE};
+
+	std::vector<VkDescriptorUpdateTemplateEntryKHR> update_template_entries;
+
+	size_t update_template_size{0};
+
+	uint32_t update_template_descriptor_count{0};
+
 	std::vector<VkDescriptorSetLayoutBinding> bindings;
 
 	std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings_lookup;
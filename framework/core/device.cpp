@@ -38,6 +38,18 @@ Device::Device(VkPhysicalDevice physical_device, VkSurfaceKHR surface, std::vect
 		requested_features.textureCompressionASTC_LDR = VK_TRUE;
 	}
 
+	// Check whether sampled image arrays can be indexed dynamically, as needed by bindless textures
+	if (features.shaderSampledImageArrayDynamicIndexing)
+	{
+		requested_features.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+	}
+
+	// Check whether indirect draws can start at an instance other than 0, as needed by GPU driven drawing
+	if (features.drawIndirectFirstInstance)
+	{
+		requested_features.drawIndirectFirstInstance = VK_TRUE;
+	}
+
 	// Gpu properties
 	vkGetPhysicalDeviceProperties(physical_device, &properties);
 	LOGI("GPU: {}", properties.deviceName);
@@ -84,6 +96,17 @@ Device::Device(VkPhysicalDevice physical_device, VkSurfaceKHR surface, std::vect
 		LOGI("Dedicated Allocation enabled");
 	}
 
+	// Check extensions to enable descriptor update templates
+	bool has_descriptor_update_template = std::find_if(std::begin(device_extensions),
+	                                                   std::end(device_extensions),
+	                                                   [](auto &extension) { return std::strcmp(extension.extensionName, VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME) == 0; }) != std::end(device_extensions);
+
+	if (has_descriptor_update_template)
+	{
+		extensions.push_back(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+		LOGI("Descriptor update templates enabled");
+	}
+
 	VkDeviceCreateInfo create_info{VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
 
 	create_info.pQueueCreateInfos       = queue_create_infos.data();
@@ -99,6 +122,8 @@ Device::Device(VkPhysicalDevice physical_device, VkSurfaceKHR surface, std::vect
 		throw VulkanException{result, "Cannot create device"};
 	}
 
+	enabled_extensions.assign(extensions.begin(), extensions.end());
+
 	queues.resize(queue_family_properties_count);
 
 	for (uint32_t queue_family_index = 0U; queue_family_index < queue_family_properties_count; ++queue_family_index)
@@ -232,6 +257,12 @@ bool Device::is_image_format_supported(VkFormat format) const
 	return result != VK_ERROR_FORMAT_NOT_SUPPORTED;
 }
 
+bool Device::is_extension_enabled(const char *extension) const
+{
+	return std::find_if(enabled_extensions.begin(), enabled_extensions.end(),
+	                    [extension](const std::string &enabled) { return enabled == extension; }) != enabled_extensions.end();
+}
+
 const VkFormatProperties Device::get_format_properties(VkFormat format) const
 {
 	VkFormatProperties format_properties;
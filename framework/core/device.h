@@ -86,6 +86,11 @@ class Device
 
 	const VkFormatProperties get_format_properties(VkFormat format) const;
 
+	/**
+	 * @return Whether a device extension was enabled when the device was created
+	 */
+	bool is_extension_enabled(const char *extension) const;
+
 	const Queue &get_queue(uint32_t queue_family_index, uint32_t queue_index);
 
 	const Queue &get_queue_by_flags(VkQueueFlags queue_flags, uint32_t queue_index);
@@ -142,6 +147,8 @@ class Device
 
 	VkPhysicalDeviceProperties properties;
 
+	std::vector<std::string> enabled_extensions;
+
 	std::vector<std::vector<Queue>> queues;
 
 	/// A command pool associated to the primary queue
@@ -71,21 +71,9 @@ ComputePipeline::ComputePipeline(Device &        device,
 
 	VkPipelineShaderStageCreateInfo stage{VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
 
-	stage.stage = shader_module->get_stage();
-	stage.pName = shader_module->get_entry_point().c_str();
-
-	// Create the Vulkan handle
-	VkShaderModuleCreateInfo vk_create_info{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
-
-	vk_create_info.codeSize = shader_module->get_binary().size() * sizeof(uint32_t);
-	vk_create_info.pCode    = shader_module->get_binary().data();
-
-	VkResult result = vkCreateShaderModule(device.get_handle(), &vk_create_info, nullptr, &stage.module);
-
-	if (result != VK_SUCCESS)
-	{
-		throw VulkanException{result};
-	}
+	stage.stage  = shader_module->get_stage();
+	stage.pName  = shader_module->get_entry_point().c_str();
+	stage.module = shader_module->get_handle();
 
 	// Create specialization info from tracked state.
 	std::vector<uint8_t>                  data{};
@@ -112,14 +100,12 @@ ComputePipeline::ComputePipeline(Device &        device,
 	create_info.layout = pipeline_state.get_pipeline_layout().get_handle();
 	create_info.stage  = stage;
 
-	result = vkCreateComputePipelines(device.get_handle(), pipeline_cache, 1, &create_info, nullptr, &handle);
+	VkResult result = vkCreateComputePipelines(device.get_handle(), pipeline_cache, 1, &create_info, nullptr, &handle);
 
 	if (result != VK_SUCCESS)
 	{
 		throw VulkanException{result, "Cannot create ComputePipelines"};
 	}
-
-	vkDestroyShaderModule(device.get_handle(), stage.module, nullptr);
 }
 
 GraphicsPipeline::GraphicsPipeline(Device &        device,
@@ -127,8 +113,6 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
                                    PipelineState & pipeline_state) :
     Pipeline{device}
 {
-	std::vector<VkShaderModule> shader_modules;
-
 	std::vector<VkPipelineShaderStageCreateInfo> stage_create_infos;
 
 	// Create specialization info from tracked state. This is shared by all shaders.
@@ -153,26 +137,13 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 	{
 		VkPipelineShaderStageCreateInfo stage_create_info{VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
 
-		stage_create_info.stage = shader_module->get_stage();
-		stage_create_info.pName = shader_module->get_entry_point().c_str();
-
-		// Create the Vulkan handle
-		VkShaderModuleCreateInfo vk_create_info{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
-
-		vk_create_info.codeSize = shader_module->get_binary().size() * sizeof(uint32_t);
-		vk_create_info.pCode    = shader_module->get_binary().data();
-
-		VkResult result = vkCreateShaderModule(device.get_handle(), &vk_create_info, nullptr, &stage_create_info.module);
-
-		if (result != VK_SUCCESS)
-		{
-			throw VulkanException{result};
-		}
+		stage_create_info.stage  = shader_module->get_stage();
+		stage_create_info.pName  = shader_module->get_entry_point().c_str();
+		stage_create_info.module = shader_module->get_handle();
 
 		stage_create_info.pSpecializationInfo = &specialization_info;
 
 		stage_create_infos.push_back(stage_create_info);
-		shader_modules.push_back(stage_create_info.module);
 	}
 
 	VkGraphicsPipelineCreateInfo create_info{VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
@@ -293,11 +264,6 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 		throw VulkanException{result, "Cannot create GraphicsPipelines"};
 	}
 
-	for (auto shader_module : shader_modules)
-	{
-		vkDestroyShaderModule(device.get_handle(), shader_module, nullptr);
-	}
-
 	state = pipeline_state;
 }
 }        // namespace vkb
@@ -22,8 +22,9 @@
 
 #include "common/logging.h"
 #include "device.h"
-#include "glsl_compiler.h"
 #include "platform/filesystem.h"
+#include "resource_cache.h"
+#include "shader_compiler.h"
 #include "spirv_reflection.h"
 
 namespace vkb
@@ -45,44 +46,93 @@ ShaderModule::ShaderModule(Device &device, VkShaderStageFlagBits stage, const Sh
 		throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
 	}
 
-	GLSLCompiler glsl_compiler;
+	auto &spirv_cache = device.get_resource_cache().get_spirv_cache();
 
-	// Compile the GLSL source
-	if (!glsl_compiler.compile_to_spirv(stage, glsl_source.get_data(), entry_point, shader_variant, spirv, info_log))
+	uint64_t spirv_key = SpirvCache::get_key(stage, glsl_source, entry_point, shader_variant);
+
+	// Only needed until the Vulkan shader module is created
+	std::vector<uint32_t> spirv;
+
+	// Compile the GLSL source, unless it was compiled by a previous run
+	if (!spirv_cache.find(spirv_key, spirv))
 	{
-		if (glsl_source.get_filename().empty())
-		{
-			throw VulkanException{VK_ERROR_INITIALIZATION_FAILED, "Shader compilation failed:\n" + info_log};
-		}
-		else
+		// Takes the result if the shader was submitted to the compiler service
+		auto result = ShaderCompiler::get().compile(stage, glsl_source, entry_point, shader_variant);
+
+		spirv    = std::move(result.spirv);
+		info_log = std::move(result.info_log);
+
+		if (!result.success)
 		{
-			throw VulkanException{VK_ERROR_INITIALIZATION_FAILED, "Compilation failed for shader \"" + glsl_source.get_filename() + "\":\n" + info_log};
+			if (glsl_source.get_filename().empty())
+			{
+				throw VulkanException{VK_ERROR_INITIALIZATION_FAILED, "Shader compilation failed:\n" + info_log};
+			}
+			else
+			{
+				throw VulkanException{VK_ERROR_INITIALIZATION_FAILED, "Compilation failed for shader \"" + glsl_source.get_filename() + "\":\n" + info_log};
+			}
 		}
+
+		spirv_cache.insert(spirv_key, spirv);
 	}
 
-	SPIRVReflection spirv_reflection;
+	uint64_t reflection_key = SpirvCache::get_reflection_key(shader_variant);
 
-	// Reflect all shader resouces
-	if (!spirv_reflection.reflect_shader_resources(stage, spirv, resources, shader_variant))
+	// Reflect all shader resouces, unless they were cached with the SPIR-V
+	if (!spirv_cache.find_resources(spirv_key, reflection_key, resources))
 	{
-		throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
+		SPIRVReflection spirv_reflection;
+
+		if (!spirv_reflection.reflect_shader_resources(stage, spirv, resources, shader_variant))
+		{
+			throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
+		}
+
+		spirv_cache.insert_resources(spirv_key, reflection_key, resources);
 	}
 
 	// Generate a unique id, determined by source and variant
 	std::hash<std::string> hasher{};
 	id = hasher(std::string{spirv.cbegin(), spirv.cend()});
+
+	VkShaderModuleCreateInfo create_info{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+
+	create_info.codeSize = spirv.size() * sizeof(uint32_t);
+	create_info.pCode    = spirv.data();
+
+	VkResult result = vkCreateShaderModule(device.get_handle(), &create_info, nullptr, &handle);
+
+	if (result != VK_SUCCESS)
+	{
+		throw VulkanException{result, "Cannot create ShaderModule"};
+	}
 }
 
 ShaderModule::ShaderModule(ShaderModule &&other) :
     device{other.device},
+    handle{other.handle},
     id{other.id},
     stage{other.stage},
-    entry_point{other.entry_point},
-    spirv{other.spirv},
-    resources{other.resources},
-    info_log{other.info_log}
+    entry_point{std::move(other.entry_point)},
+    resources{std::move(other.resources)},
+    info_log{std::move(other.info_log)}
 {
-	other.stage = {};
+	other.handle = VK_NULL_HANDLE;
+	other.stage  = {};
+}
+
+ShaderModule::~ShaderModule()
+{
+	if (handle != VK_NULL_HANDLE)
+	{
+		vkDestroyShaderModule(device.get_handle(), handle, nullptr);
+	}
+}
+
+VkShaderModule ShaderModule::get_handle() const
+{
+	return handle;
 }
 
 size_t ShaderModule::get_id() const
@@ -110,11 +160,6 @@ const std::string &ShaderModule::get_info_log() const
 	return info_log;
 }
 
-const std::vector<uint32_t> &ShaderModule::get_binary() const
-{
-	return spirv;
-}
-
 void ShaderModule::set_resource_dynamic(const std::string &resource_name)
 {
 	auto it = std::find_if(resources.begin(), resources.end(), [&resource_name](const ShaderResource &resource) { return resource.name == resource_name; });
@@ -158,6 +158,9 @@ class ShaderSource
 /**
  * @brief Contains shader code, with an entry point, for a specific shader stage.
  * It is needed by a PipelineLayout to create a Pipeline.
+ * The compiled SPIR-V and its reflected resources are taken from the SpirvCache when possible.
+ * The Vulkan shader module is created once and shared by all pipelines, so the SPIR-V is
+ * released right after its creation.
  * ShaderModule can do auto-pairing between shader code and textures.
  * The low level code can change bindings, just keeping the name of the texture.
  * Variants for each texture are also generated, such as HAS_BASE_COLOR_TEX.
@@ -177,10 +180,14 @@ class ShaderModule
 
 	ShaderModule(ShaderModule &&other);
 
+	~ShaderModule();
+
 	ShaderModule &operator=(const ShaderModule &) = delete;
 
 	ShaderModule &operator=(ShaderModule &&) = delete;
 
+	VkShaderModule get_handle() const;
+
 	size_t get_id() const;
 
 	VkShaderStageFlagBits get_stage() const;
@@ -191,13 +198,13 @@ class ShaderModule
 
 	const std::string &get_info_log() const;
 
-	const std::vector<uint32_t> &get_binary() const;
-
 	void set_resource_dynamic(const std::string &resource_name);
 
   private:
 	Device &device;
 
+	VkShaderModule handle{VK_NULL_HANDLE};
+
 	/// Shader unique id
 	size_t id;
 
@@ -207,9 +214,6 @@ class ShaderModule
 	/// Name of the main function
 	std::string entry_point;
 
-	/// Compiled source
-	std::vector<uint32_t> spirv;
-
 	std::vector<ShaderResource> resources;
 
 	std::string info_log;
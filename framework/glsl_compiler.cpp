@@ -59,8 +59,31 @@ inline EShLanguage FindShaderLanguage(VkShaderStageFlagBits stage)
 			return EShLangVertex;
 	}
 }
+
+/**
+ * @brief Scoped glslang process lifetime
+ */
+class GlslangProcess
+{
+  public:
+	GlslangProcess()
+	{
+		glslang::InitializeProcess();
+	}
+
+	~GlslangProcess()
+	{
+		glslang::FinalizeProcess();
+	}
+};
 }        // namespace
 
+void GLSLCompiler::initialize_process()
+{
+	// Function-local static, so initialization is thread-safe and happens once
+	static GlslangProcess glslang_process;
+}
+
 bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
                                     const std::vector<uint8_t> &glsl_source,
                                     const std::string &         entry_point,
@@ -68,8 +91,7 @@ bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
                                     std::vector<std::uint32_t> &spirv,
                                     std::string &               info_log)
 {
-	// Initialize glslang library.
-	glslang::InitializeProcess();
+	initialize_process();
 
 	EShMessages messages = static_cast<EShMessages>(EShMsgDefault | EShMsgVulkanRules | EShMsgSpvRules);
 
@@ -129,9 +151,11 @@ bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
 
 	info_log += logger.getAllMessages() + "\n";
 
-	// Shutdown glslang library.
-	glslang::FinalizeProcess();
-
 	return true;
 }
+
+uint32_t GLSLCompiler::get_version()
+{
+	return GLSLANG_PATCH_LEVEL;
+}
 }        // namespace vkb
@@ -36,9 +36,17 @@ namespace vkb
 {
 /// Helper class to generate SPIRV code from GLSL source
 /// A very simple version of the glslValidator application
+/// glslang is initialized once for the whole process, so compilations can run on several threads
 class GLSLCompiler
 {
   public:
+	/**
+	 * @brief Initializes glslang for the process, it is finalized at exit
+	 *        compile_to_spirv() calls it, an explicit call makes glslang outlive
+	 *        static objects constructed afterwards
+	 */
+	static void initialize_process();
+
 	/**
 	 * @brief Compiles GLSL to SPIRV code
 	 * @param stage The Vulkan shader stage flag
@@ -54,5 +62,10 @@ class GLSLCompiler
 	                      const ShaderVariant &       shader_variant,
 	                      std::vector<std::uint32_t> &spirv,
 	                      std::string &               info_log);
+
+	/**
+	 * @return The glslang version, which identifies the SPIR-V the compiler generates
+	 */
+	static uint32_t get_version();
 };
 }        // namespace vkb
@@ -260,12 +260,7 @@ void Gui::update_buffers(CommandBuffer &command_buffer)
 
 	vertex_allocation.update(vertex_data);
 
-	std::vector<std::reference_wrapper<const core::Buffer>> buffers;
-	buffers.emplace_back(std::ref(vertex_allocation.get_buffer()));
-
-	std::vector<VkDeviceSize> offsets{vertex_allocation.get_offset()};
-
-	command_buffer.bind_vertex_buffers(0, buffers, offsets);
+	command_buffer.bind_vertex_buffer(0, vertex_allocation.get_buffer(), vertex_allocation.get_offset());
 
 	auto index_allocation = sample.get_render_context().get_active_frame().allocate_buffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, index_buffer_size);
 
@@ -288,6 +283,20 @@ void Gui::draw(CommandBuffer &command_buffer)
 		return;
 	}
 
+	// Commands cannot be recorded inline in a subpass which executes secondary command buffers
+	if (command_buffer.get_current_subpass_contents() == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+	{
+		auto &secondary_command_buffer = command_buffer.request_secondary_command_buffer();
+
+		draw(secondary_command_buffer);
+
+		secondary_command_buffer.end();
+
+		command_buffer.execute_commands(secondary_command_buffer);
+
+		return;
+	}
+
 	// Vertex input state
 	VkVertexInputBindingDescription vertex_input_binding{};
 	vertex_input_binding.stride = to_u32(sizeof(ImDrawVert));
@@ -421,7 +430,7 @@ void Gui::draw(CommandBuffer &command_buffer)
 					}
 				}
 
-				command_buffer.set_scissor(0, {scissor_rect});
+				command_buffer.set_scissor(0, 1, &scissor_rect);
 				command_buffer.draw_indexed(cmd->ElemCount, 1, index_offset, vertex_offset, 0);
 				index_offset += cmd->ElemCount;
 			}
@@ -197,7 +197,77 @@ class Gui
 		        {StatIndex::l2_ext_write_bytes,
 		         {/* name = */ "External Write Bytes",
 		          /* format = */ "{:4.1f} MiB/s",
-		          /* scale_factor = */ 1.0f / (1024.0f * 1024.0f)}}};
+		          /* scale_factor = */ 1.0f / (1024.0f * 1024.0f)}},
+		        {StatIndex::cache_hits,
+		         {/* name = */ "Cache Hits",
+		          /* format = */ "{:4.0f}/frame"}},
+		        {StatIndex::cache_creation_time,
+		         {/* name = */ "Cache Creation Time",
+		          /* format = */ "{:3.2f} ms/frame"}},
+		        {StatIndex::cache_objects,
+		         {/* name = */ "Cached Objects",
+		          /* format = */ "{:4.0f}"}},
+		        {StatIndex::cache_host_bytes,
+		         {/* name = */ "Cache Host Memory",
+		          /* format = */ "{:4.1f} KiB",
+		          /* scale_factor = */ 1.0f / 1024.0f}},
+		        {StatIndex::shader_module_misses,
+		         {/* name = */ "Shader Module Misses",
+		          /* format = */ "{:3.1f}/frame"}},
+		        {StatIndex::pipeline_layout_misses,
+		         {/* name = */ "Pipeline Layout Misses",
+		          /* format = */ "{:3.1f}/frame"}},
+		        {StatIndex::descriptor_set_layout_misses,
+		         {/* name = */ "Descriptor Set Layout Misses",
+		          /* format = */ "{:3.1f}/frame"}},
+		        {StatIndex::pipeline_misses,
+		         {/* name = */ "Pipeline Misses",
+		          /* format = */ "{:3.1f}/frame"}},
+		        {StatIndex::descriptor_set_misses,
+		         {/* name = */ "Descriptor Set Misses",
+		          /* format = */ "{:3.1f}/frame"}},
+		        {StatIndex::render_pass_misses,
+		         {/* name = */ "Render Pass Misses",
+		          /* format = */ "{:3.1f}/frame"}},
+		        {StatIndex::framebuffer_misses,
+		         {/* name = */ "Framebuffer Misses",
+		          /* format = */ "{:3.1f}/frame"}},
+		        {StatIndex::descriptor_pools_created,
+		         {/* name = */ "Descriptor Pools Created",
+		          /* format = */ "{:3.1f}/frame"}},
+		        {StatIndex::descriptor_sets_allocated,
+		         {/* name = */ "Descriptor Sets Allocated",
+		          /* format = */ "{:4.0f}/frame"}},
+		        {StatIndex::descriptor_allocation_failures,
+		         {/* name = */ "Descriptor Allocation Failures",
+		          /* format = */ "{:3.1f}/frame"}},
+		        {StatIndex::heap_allocations,
+		         {/* name = */ "Heap Allocations",
+		          /* format = */ "{:4.0f}/frame"}},
+		        {StatIndex::state_commands_issued,
+		         {/* name = */ "State Commands Issued",
+		          /* format = */ "{:4.0f}/frame"}},
+		        {StatIndex::state_commands_eliminated,
+		         {/* name = */ "State Commands Eliminated",
+		          /* format = */ "{:4.0f}/frame"}},
+		        {StatIndex::pipeline_binds_eliminated,
+		         {/* name = */ "Pipeline Binds Eliminated",
+		          /* format = */ "{:4.0f}/frame"}},
+		        {StatIndex::descriptor_set_binds_eliminated,
+		         {/* name = */ "Descriptor Set Binds Eliminated",
+		          /* format = */ "{:4.0f}/frame"}},
+		        {StatIndex::buffer_binds_eliminated,
+		         {/* name = */ "Buffer Binds Eliminated",
+		          /* format = */ "{:4.0f}/frame"}},
+		        {StatIndex::dynamic_state_sets_eliminated,
+		         {/* name = */ "Viewport/Scissor Sets Eliminated",
+		          /* format = */ "{:4.0f}/frame"}},
+		        {StatIndex::meshes_visible,
+		         {/* name = */ "Meshes Visible",
+		          /* format = */ "{:4.0f}/frame"}},
+		        {StatIndex::meshes_culled,
+		         {/* name = */ "Meshes Culled",
+		          /* format = */ "{:4.0f}/frame"}}};
 
 		float graph_height{50.0f};
 
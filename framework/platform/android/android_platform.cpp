@@ -21,6 +21,9 @@
 #include "android_platform.h"
 
 #include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <unordered_map>
 
@@ -379,6 +382,58 @@ void create_directory(const std::string &path)
 		mkdir(path.c_str(), 0777);
 	}
 }
+
+void rename_file(const std::string &from, const std::string &to)
+{
+	// Replaces the destination atomically, mappings of the previous file stay valid
+	if (rename(from.c_str(), to.c_str()) != 0)
+	{
+		throw std::runtime_error("Failed to rename file: " + from + " to " + to);
+	}
+}
+
+MappedFile::MappedFile(const std::string &path)
+{
+	int file = open(path.c_str(), O_RDONLY);
+
+	if (file < 0)
+	{
+		throw std::runtime_error("Failed to open file: " + path);
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0)
+	{
+		close(file);
+		throw std::runtime_error("Failed to read size of file: " + path);
+	}
+
+	size = static_cast<size_t>(info.st_size);
+
+	if (size > 0)
+	{
+		void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+
+		if (mapping == MAP_FAILED)
+		{
+			close(file);
+			throw std::runtime_error("Failed to map file: " + path);
+		}
+
+		data = static_cast<const uint8_t *>(mapping);
+	}
+
+	// The mapping stays valid after the file is closed
+	close(file);
+}
+
+MappedFile::~MappedFile()
+{
+	if (data)
+	{
+		munmap(const_cast<uint8_t *>(data), size);
+	}
+}
 }        // namespace fs
 
 AndroidPlatform::AndroidPlatform(android_app *app) :
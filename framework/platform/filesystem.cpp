@@ -156,6 +156,11 @@ static void write_binary_file(const std::vector<uint8_t> &data, const std::strin
 
 	file.write(reinterpret_cast<const char *>(data.data()), write_count);
 	file.close();
+
+	if (file.fail())
+	{
+		throw std::runtime_error("Failed to write file: " + filename);
+	}
 }
 
 std::vector<uint8_t> read_asset(const std::string &filename, const uint32_t count)
@@ -173,11 +178,31 @@ std::vector<uint8_t> read_temp(const std::string &filename, const uint32_t count
 	return read_binary_file(path::get(path::Type::Temp) + filename, count);
 }
 
+const uint8_t *MappedFile::get_data() const
+{
+	return data;
+}
+
+size_t MappedFile::get_size() const
+{
+	return size;
+}
+
+std::unique_ptr<MappedFile> map_temp(const std::string &filename)
+{
+	return std::make_unique<MappedFile>(path::get(path::Type::Temp) + filename);
+}
+
 void write_temp(const std::vector<uint8_t> &data, const std::string &filename, const uint32_t count)
 {
 	write_binary_file(data, path::get(path::Type::Temp) + filename, count);
 }
 
+void rename_temp(const std::string &from, const std::string &to)
+{
+	rename_file(path::get(path::Type::Temp) + from, path::get(path::Type::Temp) + to);
+}
+
 void write_image(const uint8_t *data, const std::string &filename, const uint32_t width, const uint32_t height, const uint32_t components, const uint32_t row_stride)
 {
 	stbi_write_png((path::get(path::Type::Screenshots) + filename + ".png").c_str(), width, height, components, data, row_stride);
@@ -23,6 +23,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <sys/stat.h>
 #include <unordered_map>
@@ -85,6 +86,54 @@ void create_directory(const std::string &path);
  */
 void create_path(const std::string &root, const std::string &path);
 
+/**
+ * @brief Platform specific implementation to rename a file, replacing the destination if it exists
+ *        Processes which opened or mapped the destination keep reading its previous content
+ * @param from A path to the file to rename
+ * @param to The new path of the file
+ * @throws runtime_error if the file cannot be renamed, in which case the destination is unchanged
+ */
+void rename_file(const std::string &from, const std::string &to);
+
+/**
+ * @brief Read-only view of a file mapped in memory, the file is unmapped on destruction
+ */
+class MappedFile
+{
+  public:
+	/**
+	 * @brief Platform specific implementation to map a file in memory
+	 * @param path A path to a file
+	 * @throws runtime_error if the file cannot be opened or mapped
+	 */
+	MappedFile(const std::string &path);
+
+	/**
+	 * @brief Platform specific implementation to unmap the file
+	 */
+	~MappedFile();
+
+	MappedFile(const MappedFile &) = delete;
+
+	MappedFile(MappedFile &&) = delete;
+
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	MappedFile &operator=(MappedFile &&) = delete;
+
+	const uint8_t *get_data() const;
+
+	size_t get_size() const;
+
+  private:
+	const uint8_t *data{nullptr};
+
+	size_t size{0};
+
+	/// Platform specific handle of the mapping, if any
+	void *handle{nullptr};
+};
+
 /**
  * @brief Helper to read an asset file into a byte-array
  *
@@ -113,6 +162,15 @@ std::vector<uint8_t> read_shader(const std::string &filename);
  */
 std::vector<uint8_t> read_temp(const std::string &filename, const uint32_t count = 0);
 
+/**
+ * @brief Helper to map a temporary file in memory, so it can be read without a copy
+ *
+ * @param filename The path to the file (relative to the temporary storage directory)
+ * @throws runtime_error if the file cannot be opened or mapped
+ * @return The mapped file
+ */
+std::unique_ptr<MappedFile> map_temp(const std::string &filename);
+
 /**
  * @brief Helper to write to a file in temporary storage
  *
@@ -123,6 +181,14 @@ std::vector<uint8_t> read_temp(const std::string &filename, const uint32_t count
  */
 void write_temp(const std::vector<uint8_t> &data, const std::string &filename, const uint32_t count = 0);
 
+/**
+ * @brief Helper to rename a file in temporary storage, replacing the destination if it exists
+ *
+ * @param from The path to the file (relative to the temporary storage directory)
+ * @param to The new path to the file (relative to the temporary storage directory)
+ */
+void rename_temp(const std::string &from, const std::string &to);
+
 /**
  * @brief Helper to write to a png image in permanent storage
  *
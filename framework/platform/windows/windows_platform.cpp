@@ -105,6 +105,73 @@ void create_directory(const std::string &path)
 		CreateDirectory(path.c_str(), NULL);
 	}
 }
+
+void rename_file(const std::string &from, const std::string &to)
+{
+	if (!MoveFileEx(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		throw std::runtime_error("Failed to rename file: " + from + " to " + to);
+	}
+}
+
+MappedFile::MappedFile(const std::string &path)
+{
+	HANDLE file = CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error("Failed to open file: " + path);
+	}
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size))
+	{
+		CloseHandle(file);
+		throw std::runtime_error("Failed to read size of file: " + path);
+	}
+
+	size = static_cast<size_t>(file_size.QuadPart);
+
+	if (size > 0)
+	{
+		HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+		// The mapping keeps the file open
+		CloseHandle(file);
+
+		if (mapping == NULL)
+		{
+			throw std::runtime_error("Failed to map file: " + path);
+		}
+
+		data = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+		if (data == nullptr)
+		{
+			CloseHandle(mapping);
+			throw std::runtime_error("Failed to map file: " + path);
+		}
+
+		handle = mapping;
+	}
+	else
+	{
+		CloseHandle(file);
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if (data)
+	{
+		UnmapViewOfFile(data);
+	}
+
+	if (handle)
+	{
+		CloseHandle(handle);
+	}
+}
 }        // namespace fs
 
 WindowsPlatform::WindowsPlatform(HINSTANCE hInstance, HINSTANCE hPrevInstance,
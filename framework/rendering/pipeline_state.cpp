@@ -20,6 +20,8 @@
 
 #include "pipeline_state.h"
 
+#include "common/resource_caching.h"
+
 bool operator==(const VkVertexInputAttributeDescription &lhs, const VkVertexInputAttributeDescription &rhs)
 {
 	return std::tie(lhs.binding, lhs.format, lhs.location, lhs.offset) == std::tie(rhs.binding, rhs.format, rhs.location, rhs.offset);
@@ -87,11 +89,154 @@ bool operator!=(const vkb::ColorBlendState &lhs, const vkb::ColorBlendState &rhs
 
 namespace vkb
 {
+namespace
+{
+inline size_t hash_pipeline_layout(const PipelineLayout *pipeline_layout)
+{
+	size_t result = 0;
+
+	if (pipeline_layout)
+	{
+		hash_combine(result, pipeline_layout->get_handle());
+
+		for (auto stage : pipeline_layout->get_shader_program().get_shader_modules())
+		{
+			hash_combine(result, stage->get_id());
+		}
+	}
+
+	return result;
+}
+
+inline size_t hash_render_pass(const RenderPass *render_pass)
+{
+	size_t result = 0;
+
+	// For graphics only
+	if (render_pass)
+	{
+		hash_combine(result, render_pass->get_handle());
+	}
+
+	return result;
+}
+
+inline size_t hash_vertex_input_state(const VertexInputState &vertex_input_state)
+{
+	size_t result = 0;
+
+	for (auto &attribute : vertex_input_state.attributes)
+	{
+		hash_combine(result, attribute);
+	}
+
+	for (auto &binding : vertex_input_state.bindings)
+	{
+		hash_combine(result, binding);
+	}
+
+	return result;
+}
+
+inline size_t hash_input_assembly_state(const InputAssemblyState &input_assembly_state)
+{
+	size_t result = 0;
+
+	hash_combine(result, input_assembly_state.primitive_restart_enable);
+	hash_combine(result, static_cast<std::underlying_type<VkPrimitiveTopology>::type>(input_assembly_state.topology));
+
+	return result;
+}
+
+inline size_t hash_rasterization_state(const RasterizationState &rasterization_state)
+{
+	size_t result = 0;
+
+	hash_combine(result, rasterization_state.cull_mode);
+	hash_combine(result, rasterization_state.depth_bias_enable);
+	hash_combine(result, rasterization_state.depth_clamp_enable);
+	hash_combine(result, static_cast<std::underlying_type<VkFrontFace>::type>(rasterization_state.front_face));
+	hash_combine(result, static_cast<std::underlying_type<VkPolygonMode>::type>(rasterization_state.polygon_mode));
+	hash_combine(result, rasterization_state.rasterizer_discard_enable);
+
+	return result;
+}
+
+inline size_t hash_viewport_state(const ViewportState &viewport_state)
+{
+	size_t result = 0;
+
+	hash_combine(result, viewport_state.viewport_count);
+	hash_combine(result, viewport_state.scissor_count);
+
+	return result;
+}
+
+inline size_t hash_multisample_state(const MultisampleState &multisample_state)
+{
+	size_t result = 0;
+
+	hash_combine(result, multisample_state.alpha_to_coverage_enable);
+	hash_combine(result, multisample_state.alpha_to_one_enable);
+	hash_combine(result, multisample_state.min_sample_shading);
+	hash_combine(result, static_cast<std::underlying_type<VkSampleCountFlagBits>::type>(multisample_state.rasterization_samples));
+	hash_combine(result, multisample_state.sample_shading_enable);
+	hash_combine(result, multisample_state.sample_mask);
+
+	return result;
+}
+
+inline size_t hash_depth_stencil_state(const DepthStencilState &depth_stencil_state)
+{
+	size_t result = 0;
+
+	hash_combine(result, depth_stencil_state.back);
+	hash_combine(result, depth_stencil_state.depth_bounds_test_enable);
+	hash_combine(result, static_cast<std::underlying_type<VkCompareOp>::type>(depth_stencil_state.depth_compare_op));
+	hash_combine(result, depth_stencil_state.depth_test_enable);
+	hash_combine(result, depth_stencil_state.depth_write_enable);
+	hash_combine(result, depth_stencil_state.front);
+	hash_combine(result, depth_stencil_state.stencil_test_enable);
+
+	return result;
+}
+
+inline size_t hash_color_blend_state(const ColorBlendState &color_blend_state)
+{
+	size_t result = 0;
+
+	hash_combine(result, static_cast<std::underlying_type<VkLogicOp>::type>(color_blend_state.logic_op));
+	hash_combine(result, color_blend_state.logic_op_enable);
+
+	for (auto &attachment : color_blend_state.attachments)
+	{
+		hash_combine(result, attachment);
+	}
+
+	return result;
+}
+
+/**
+ * @brief Salts the hash of a part with its index, so that parts can be combined with XOR
+ *        and replaced one at a time
+ */
+inline size_t mix_part_hash(uint32_t part, size_t part_hash)
+{
+	size_t result = part;
+
+	hash_combine(result, part_hash);
+
+	return result;
+}
+}        // namespace
+
 void SpecializationConstantState::reset()
 {
 	if (dirty)
 	{
 		specialization_constant_state.clear();
+
+		update_hash();
 	}
 
 	dirty = false;
@@ -119,11 +264,15 @@ void SpecializationConstantState::set_constant(uint32_t constant_id, const std::
 	dirty = true;
 
 	specialization_constant_state[constant_id] = value;
+
+	update_hash();
 }
 
 void SpecializationConstantState::set_specialization_constant_state(const std::map<uint32_t, std::vector<uint8_t>> &state)
 {
 	specialization_constant_state = state;
+
+	update_hash();
 }
 
 const std::map<uint32_t, std::vector<uint8_t>> &SpecializationConstantState::get_specialization_constant_state() const
@@ -131,6 +280,31 @@ const std::map<uint32_t, std::vector<uint8_t>> &SpecializationConstantState::get
 	return specialization_constant_state;
 }
 
+size_t SpecializationConstantState::get_hash() const
+{
+	return hash;
+}
+
+void SpecializationConstantState::update_hash()
+{
+	hash = 0;
+
+	for (auto &constant : specialization_constant_state)
+	{
+		hash_combine(hash, constant.first);
+
+		for (auto data : constant.second)
+		{
+			hash_combine(hash, data);
+		}
+	}
+}
+
+PipelineState::PipelineState()
+{
+	rehash();
+}
+
 void PipelineState::reset()
 {
 	clear_dirty();
@@ -154,6 +328,8 @@ void PipelineState::reset()
 	color_blend_state = {};
 
 	subpass_index = {0U};
+
+	rehash();
 }
 
 void PipelineState::set_pipeline_layout(PipelineLayout &new_pipeline_layout)
@@ -164,6 +340,8 @@ void PipelineState::set_pipeline_layout(PipelineLayout &new_pipeline_layout)
 		{
 			pipeline_layout = &new_pipeline_layout;
 
+			update_hash(PipelineLayoutPart, hash_pipeline_layout(pipeline_layout));
+
 			dirty = true;
 		}
 	}
@@ -171,6 +349,8 @@ void PipelineState::set_pipeline_layout(PipelineLayout &new_pipeline_layout)
 	{
 		pipeline_layout = &new_pipeline_layout;
 
+		update_hash(PipelineLayoutPart, hash_pipeline_layout(pipeline_layout));
+
 		dirty = true;
 	}
 }
@@ -183,6 +363,8 @@ void PipelineState::set_render_pass(const RenderPass &new_render_pass)
 		{
 			render_pass = &new_render_pass;
 
+			update_hash(RenderPassPart, hash_render_pass(render_pass));
+
 			dirty = true;
 		}
 	}
@@ -190,6 +372,8 @@ void PipelineState::set_render_pass(const RenderPass &new_render_pass)
 	{
 		render_pass = &new_render_pass;
 
+		update_hash(RenderPassPart, hash_render_pass(render_pass));
+
 		dirty = true;
 	}
 }
@@ -200,6 +384,8 @@ void PipelineState::set_specialization_constant(uint32_t constant_id, const std:
 
 	if (specialization_constant_state.is_dirty())
 	{
+		update_hash(SpecializationConstantPart, specialization_constant_state.get_hash());
+
 		dirty = true;
 	}
 }
@@ -210,6 +396,8 @@ void PipelineState::set_vertex_input_state(const VertexInputState &new_vertex_in
 	{
 		vertex_input_sate = new_vertex_input_sate;
 
+		update_hash(VertexInputPart, hash_vertex_input_state(vertex_input_sate));
+
 		dirty = true;
 	}
 }
@@ -220,6 +408,8 @@ void PipelineState::set_input_assembly_state(const InputAssemblyState &new_input
 	{
 		input_assembly_state = new_input_assembly_state;
 
+		update_hash(InputAssemblyPart, hash_input_assembly_state(input_assembly_state));
+
 		dirty = true;
 	}
 }
@@ -230,6 +420,8 @@ void PipelineState::set_rasterization_state(const RasterizationState &new_raster
 	{
 		rasterization_state = new_rasterization_state;
 
+		update_hash(RasterizationPart, hash_rasterization_state(rasterization_state));
+
 		dirty = true;
 	}
 }
@@ -240,6 +432,8 @@ void PipelineState::set_viewport_state(const ViewportState &new_viewport_state)
 	{
 		viewport_state = new_viewport_state;
 
+		update_hash(ViewportPart, hash_viewport_state(viewport_state));
+
 		dirty = true;
 	}
 }
@@ -250,6 +444,8 @@ void PipelineState::set_multisample_state(const MultisampleState &new_multisampl
 	{
 		multisample_state = new_multisample_state;
 
+		update_hash(MultisamplePart, hash_multisample_state(multisample_state));
+
 		dirty = true;
 	}
 }
@@ -260,6 +456,8 @@ void PipelineState::set_depth_stencil_state(const DepthStencilState &new_depth_s
 	{
 		depth_stencil_state = new_depth_stencil_state;
 
+		update_hash(DepthStencilPart, hash_depth_stencil_state(depth_stencil_state));
+
 		dirty = true;
 	}
 }
@@ -270,6 +468,8 @@ void PipelineState::set_color_blend_state(const ColorBlendState &new_color_blend
 	{
 		color_blend_state = new_color_blend_state;
 
+		update_hash(ColorBlendPart, hash_color_blend_state(color_blend_state));
+
 		dirty = true;
 	}
 }
@@ -280,6 +480,8 @@ void PipelineState::set_subpass_index(uint32_t new_subpass_index)
 	{
 		subpass_index = new_subpass_index;
 
+		update_hash(SubpassPart, std::hash<uint32_t>{}(subpass_index));
+
 		dirty = true;
 	}
 }
@@ -350,4 +552,40 @@ void PipelineState::clear_dirty()
 	dirty = false;
 	specialization_constant_state.clear_dirty();
 }
+
+size_t PipelineState::get_hash() const
+{
+	return hash;
+}
+
+void PipelineState::update_hash(HashPart part, size_t part_hash)
+{
+	hash ^= mix_part_hash(part, part_hashes[part]);
+
+	part_hashes[part] = part_hash;
+
+	hash ^= mix_part_hash(part, part_hash);
+}
+
+void PipelineState::rehash()
+{
+	part_hashes[PipelineLayoutPart]         = hash_pipeline_layout(pipeline_layout);
+	part_hashes[RenderPassPart]             = hash_render_pass(render_pass);
+	part_hashes[SpecializationConstantPart] = specialization_constant_state.get_hash();
+	part_hashes[VertexInputPart]            = hash_vertex_input_state(vertex_input_sate);
+	part_hashes[InputAssemblyPart]          = hash_input_assembly_state(input_assembly_state);
+	part_hashes[RasterizationPart]          = hash_rasterization_state(rasterization_state);
+	part_hashes[ViewportPart]               = hash_viewport_state(viewport_state);
+	part_hashes[MultisamplePart]            = hash_multisample_state(multisample_state);
+	part_hashes[DepthStencilPart]           = hash_depth_stencil_state(depth_stencil_state);
+	part_hashes[ColorBlendPart]             = hash_color_blend_state(color_blend_state);
+	part_hashes[SubpassPart]                = std::hash<uint32_t>{}(subpass_index);
+
+	hash = 0;
+
+	for (uint32_t part = 0; part < HashPartCount; ++part)
+	{
+		hash ^= mix_part_hash(part, part_hashes[part]);
+	}
+}
 }        // namespace vkb
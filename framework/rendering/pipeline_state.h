@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include <array>
 #include <vector>
 
 #include "common/vk_common.h"
@@ -155,10 +156,19 @@ class SpecializationConstantState
 
 	const std::map<uint32_t, std::vector<uint8_t>> &get_specialization_constant_state() const;
 
+	/**
+	 * @brief Hash of all constants, updated whenever a constant changes
+	 */
+	size_t get_hash() const;
+
   private:
+	void update_hash();
+
 	bool dirty{false};
 	// Map tracking state of the Specialization Constants
 	std::map<uint32_t, std::vector<uint8_t>> specialization_constant_state;
+
+	size_t hash{0};
 };
 
 template <class T>
@@ -181,9 +191,15 @@ inline void SpecializationConstantState::set_constant<bool>(std::uint32_t consta
 	              reinterpret_cast<const uint8_t *>(&value) + sizeof(std::uint32_t)});
 }
 
+/**
+ * @brief Tracks the state of a pipeline. Every setter updates the hash of the part of the
+ *        state it changed, so that looking up the pipeline does not need to re-hash the whole state.
+ */
 class PipelineState
 {
   public:
+	PipelineState();
+
 	void reset();
 
 	void set_pipeline_layout(PipelineLayout &pipeline_layout);
@@ -234,7 +250,39 @@ class PipelineState
 
 	void clear_dirty();
 
+	/**
+	 * @return Hash of the whole state
+	 */
+	size_t get_hash() const;
+
   private:
+	/// Parts of the state which are hashed independently
+	enum HashPart : uint32_t
+	{
+		PipelineLayoutPart,
+		RenderPassPart,
+		SpecializationConstantPart,
+		VertexInputPart,
+		InputAssemblyPart,
+		RasterizationPart,
+		ViewportPart,
+		MultisamplePart,
+		DepthStencilPart,
+		ColorBlendPart,
+		SubpassPart,
+		HashPartCount
+	};
+
+	/**
+	 * @brief Replaces the contribution of one part to the state hash
+	 */
+	void update_hash(HashPart part, size_t part_hash);
+
+	/**
+	 * @brief Recomputes the hash of every part
+	 */
+	void rehash();
+
 	bool dirty{false};
 
 	PipelineLayout *pipeline_layout{nullptr};
@@ -258,5 +306,9 @@ class PipelineState
 	ColorBlendState color_blend_state{};
 
 	uint32_t subpass_index{0U};
+
+	std::array<size_t, HashPartCount> part_hashes{};
+
+	size_t hash{0};
 };
 }        // namespace vkb
@@ -72,6 +72,8 @@ void RenderContext::prepare(size_t thread_count, RenderTarget::CreateFunc create
 		frames.emplace_back(RenderFrame{device, std::move(render_target), thread_count});
 	}
 
+	frame_numbers.resize(frames.size(), 0);
+
 	this->prepared                  = true;
 	this->create_render_target_func = create_render_target_func;
 }
@@ -275,6 +277,9 @@ VkSemaphore RenderContext::begin_frame()
 
 	wait_frame();
 
+	// The previous submission of this frame has completed, and so have all submissions before it
+	frame_numbers.at(active_frame_index) = device.get_resource_cache().begin_frame(frame_numbers.at(active_frame_index));
+
 	return aquired_semaphore;
 }
 
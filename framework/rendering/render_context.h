@@ -203,6 +203,9 @@ class RenderContext
 
 	std::vector<RenderFrame> frames;
 
+	/// Resource cache frame number last submitted by each render frame
+	std::vector<uint64_t> frame_numbers;
+
 	VkSemaphore acquired_semaphore;
 
 	bool prepared{false};
@@ -25,6 +25,32 @@
 
 namespace vkb
 {
+namespace
+{
+inline bool is_same_resource(const ResourceInfo &lhs, const ResourceInfo &rhs, bool compare_buffer_offsets)
+{
+	return lhs.buffer == rhs.buffer &&
+	       (!compare_buffer_offsets || lhs.offset == rhs.offset) &&
+	       lhs.range == rhs.range &&
+	       lhs.image_view == rhs.image_view &&
+	       lhs.sampler == rhs.sampler;
+}
+
+inline bool is_same_resource_bindings(const BindingMap<ResourceInfo> &lhs, const BindingMap<ResourceInfo> &rhs, bool compare_buffer_offsets)
+{
+	return lhs.size() == rhs.size() &&
+	       std::equal(lhs.begin(), lhs.end(), rhs.begin(), [compare_buffer_offsets](const auto &lhs_binding, const auto &rhs_binding) {
+		       return lhs_binding.first == rhs_binding.first &&
+		              lhs_binding.second.size() == rhs_binding.second.size() &&
+		              std::equal(lhs_binding.second.begin(), lhs_binding.second.end(), rhs_binding.second.begin(),
+		                         [compare_buffer_offsets](const auto &lhs_element, const auto &rhs_element) {
+			                         return lhs_element.first == rhs_element.first &&
+			                                is_same_resource(lhs_element.second, rhs_element.second, compare_buffer_offsets);
+		                         });
+	       });
+}
+}        // namespace
+
 RenderFrame::RenderFrame(Device &device, RenderTarget &&render_target, size_t thread_count) :
     device{device},
     fence_pool{device},
@@ -32,7 +58,12 @@ RenderFrame::RenderFrame(Device &device, RenderTarget &&render_target, size_t th
     swapchain_render_target{std::move(render_target)},
     thread_count{thread_count}
 {
-	const std::vector<VkBufferUsageFlags> supported_usages = {VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_BUFFER_USAGE_INDEX_BUFFER_BIT};
+	const std::vector<VkBufferUsageFlags> supported_usages = {VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+	                                                          VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+	                                                          VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+	                                                          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+	                                                          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+	                                                          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT};
 	for (auto &usage : supported_usages)
 	{
 		std::vector<std::pair<BufferPool, BufferBlock *>> usage_buffer_pools;
@@ -53,6 +84,8 @@ RenderFrame::RenderFrame(Device &device, RenderTarget &&render_target, size_t th
 	{
 		descriptor_pools.push_back(std::make_unique<std::unordered_map<std::size_t, DescriptorPool>>());
 		descriptor_sets.push_back(std::make_unique<std::unordered_map<std::size_t, DescriptorSet>>());
+		descriptor_set_bindings.push_back(std::make_unique<std::unordered_map<std::size_t, DescriptorSetBinding>>());
+		arenas.push_back(std::make_unique<LinearArena>());
 	}
 }
 
@@ -93,6 +126,19 @@ void RenderFrame::reset(bool wait_with_fence)
 	}
 
 	semaphore_pool.reset();
+
+	for (auto &arena : arenas)
+	{
+		arena->reset();
+	}
+
+	for (auto &desc_pools_per_thread : descriptor_pools)
+	{
+		for (auto &desc_pool : *desc_pools_per_thread)
+		{
+			desc_pool.second.begin_frame();
+		}
+	}
 }
 
 std::vector<std::unique_ptr<CommandPool>> &RenderFrame::get_command_pools(const Queue &queue, CommandBuffer::ResetMode reset_mode)
@@ -173,16 +219,66 @@ CommandBuffer &RenderFrame::request_command_buffer(const Queue &queue, CommandBu
 	return (*command_pool_it)->request_command_buffer(level);
 }
 
-DescriptorSet &RenderFrame::request_descriptor_set(DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos, size_t thread_index)
+DescriptorSet &RenderFrame::request_descriptor_set(DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos, size_t thread_index, size_t binding_hash, const BindingMap<ResourceInfo> *resource_bindings, bool compare_buffer_offsets)
 {
 	assert(thread_index < thread_count && "Thread index is out of bounds");
 
 	auto &descriptor_pool = request_resource(device, nullptr, *descriptor_pools.at(thread_index), descriptor_set_layout);
-	return request_resource(device, nullptr, *descriptor_sets.at(thread_index), descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+	auto &descriptor_set  = request_resource(device, nullptr, *descriptor_sets.at(thread_index), descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+
+	if (binding_hash != 0)
+	{
+		assert(resource_bindings && "The resources of a binding hash are needed to tell collisions apart");
+
+		// On a collision, the last descriptor set requested with the hash replaces the previous one
+		auto &binding = (*descriptor_set_bindings.at(thread_index))[binding_hash];
+
+		binding.descriptor_set         = &descriptor_set;
+		binding.descriptor_set_layout  = &descriptor_set_layout;
+		binding.resource_bindings      = *resource_bindings;
+		binding.compare_buffer_offsets = compare_buffer_offsets;
+	}
+
+	return descriptor_set;
+}
+
+DescriptorSet *RenderFrame::find_descriptor_set(size_t binding_hash, const DescriptorSetLayout &descriptor_set_layout, const BindingMap<ResourceInfo> &resource_bindings, size_t thread_index)
+{
+	assert(thread_index < thread_count && "Thread index is out of bounds");
+
+	if (binding_hash == 0)
+	{
+		return nullptr;
+	}
+
+	auto &bindings = *descriptor_set_bindings.at(thread_index);
+
+	auto it = bindings.find(binding_hash);
+
+	if (it == bindings.end())
+	{
+		return nullptr;
+	}
+
+	// The hash is not trusted alone, as different resources may share it
+	auto &binding = it->second;
+
+	if (binding.descriptor_set_layout != &descriptor_set_layout ||
+	    !is_same_resource_bindings(binding.resource_bindings, resource_bindings, binding.compare_buffer_offsets))
+	{
+		return nullptr;
+	}
+
+	return binding.descriptor_set;
 }
 
 void RenderFrame::clear_descriptors()
 {
+	for (auto &desc_set_bindings_per_thread : descriptor_set_bindings)
+	{
+		desc_set_bindings_per_thread->clear();
+	}
+
 	for (auto &desc_sets_per_thread : descriptor_sets)
 	{
 		desc_sets_per_thread->clear();
@@ -236,4 +332,56 @@ BufferAllocation RenderFrame::allocate_buffer(const VkBufferUsageFlags usage, co
 
 	return data;
 }
+
+LinearArena &RenderFrame::get_arena(size_t thread_index)
+{
+	assert(thread_index < thread_count && "Thread index is out of bounds");
+
+	return *arenas.at(thread_index);
+}
+
+size_t RenderFrame::get_thread_count() const
+{
+	return thread_count;
+}
+
+StateCommandCounters RenderFrame::get_state_command_counters() const
+{
+	StateCommandCounters counters{};
+
+	for (auto &command_pools_per_queue : command_pools)
+	{
+		for (auto &command_pool : command_pools_per_queue.second)
+		{
+			auto pool_counters = command_pool->get_state_command_counters();
+
+			for (size_t i = 0; i < counters.size(); ++i)
+			{
+				counters[i].issued += pool_counters[i].issued;
+				counters[i].eliminated += pool_counters[i].eliminated;
+			}
+		}
+	}
+
+	return counters;
+}
+
+DescriptorPoolCounters RenderFrame::get_descriptor_pool_counters() const
+{
+	DescriptorPoolCounters counters{};
+
+	for (auto &desc_pools_per_thread : descriptor_pools)
+	{
+		for (auto &desc_pool : *desc_pools_per_thread)
+		{
+			auto &pool_counters = desc_pool.second.get_counters();
+
+			counters.pools_created += pool_counters.pools_created;
+			counters.sets_allocated += pool_counters.sets_allocated;
+			counters.failed_allocations += pool_counters.failed_allocations;
+		}
+	}
+
+	return counters;
+}
 }        // namespace vkb
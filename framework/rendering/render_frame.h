@@ -22,6 +22,7 @@
 
 #include "buffer_pool.h"
 #include "common/helpers.h"
+#include "common/linear_arena.h"
 #include "common/resource_caching.h"
 #include "common/vk_common.h"
 #include "core/buffer.h"
@@ -110,10 +111,38 @@ class RenderFrame
 	                                      VkCommandBufferLevel     level        = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
 	                                      size_t                   thread_index = 0);
 
+	/**
+	 * @brief Requests a descriptor set for the given resources
+	 * @param descriptor_set_layout The layout of the descriptor set
+	 * @param buffer_infos The buffers written to the descriptor set
+	 * @param image_infos The images written to the descriptor set
+	 * @param thread_index Index of the descriptor pools to be used by the current thread
+	 * @param binding_hash If not zero, a hash of the bound resources under which the descriptor set
+	 *        can later be found with find_descriptor_set, without building the binding maps
+	 * @param resource_bindings The bound resources the binding hash was computed from, kept to tell
+	 *        apart resources with the same hash. Required if the binding hash is not zero
+	 * @param compare_buffer_offsets Whether the buffer offsets are part of the binding hash
+	 */
 	DescriptorSet &request_descriptor_set(DescriptorSetLayout &                     descriptor_set_layout,
 	                                      const BindingMap<VkDescriptorBufferInfo> &buffer_infos,
 	                                      const BindingMap<VkDescriptorImageInfo> & image_infos,
-	                                      size_t                                    thread_index = 0);
+	                                      size_t                                    thread_index           = 0,
+	                                      size_t                                    binding_hash           = 0,
+	                                      const BindingMap<ResourceInfo> *          resource_bindings      = nullptr,
+	                                      bool                                      compare_buffer_offsets = true);
+
+	/**
+	 * @param binding_hash The hash of the bound resources the descriptor set was requested with
+	 * @param descriptor_set_layout The layout of the descriptor set
+	 * @param resource_bindings The bound resources the binding hash was computed from
+	 * @param thread_index Index of the descriptor pools to be used by the current thread
+	 * @return The descriptor set previously requested with this binding hash for the same layout
+	 *         and resources, or nullptr
+	 */
+	DescriptorSet *find_descriptor_set(size_t                          binding_hash,
+	                                   const DescriptorSetLayout &     descriptor_set_layout,
+	                                   const BindingMap<ResourceInfo> &resource_bindings,
+	                                   size_t                          thread_index = 0);
 
 	void clear_descriptors();
 
@@ -131,7 +160,43 @@ class RenderFrame
 	 */
 	BufferAllocation allocate_buffer(VkBufferUsageFlags usage, VkDeviceSize size, size_t thread_index = 0);
 
+	/**
+	 * @param thread_index Index of the arena to be used by the current thread
+	 * @return The arena for transient CPU allocations of the current thread, rewound when the frame is reset
+	 */
+	LinearArena &get_arena(size_t thread_index = 0);
+
+	/**
+	 * @return The number of threads the frame has resources for
+	 */
+	size_t get_thread_count() const;
+
+	/**
+	 * @return The state commands recorded and skipped by the command buffers of the frame since it was last reset
+	 */
+	StateCommandCounters get_state_command_counters() const;
+
+	/**
+	 * @return The descriptor pool activity of all threads of the frame since it was last reset
+	 */
+	DescriptorPoolCounters get_descriptor_pool_counters() const;
+
   private:
+	/**
+	 * @brief A descriptor set found by the hash of the resources it was requested for
+	 */
+	struct DescriptorSetBinding
+	{
+		DescriptorSet *descriptor_set{nullptr};
+
+		const DescriptorSetLayout *descriptor_set_layout{nullptr};
+
+		/// Copy of the resources the hash was computed from
+		BindingMap<ResourceInfo> resource_bindings;
+
+		bool compare_buffer_offsets{true};
+	};
+
 	Device &device;
 
 	/**
@@ -152,6 +217,12 @@ class RenderFrame
 	/// Descriptor sets for the frame
 	std::vector<std::unique_ptr<std::unordered_map<std::size_t, DescriptorSet>>> descriptor_sets;
 
+	/// Descriptor sets for the frame, indexed by the hash of the resources bound by a command buffer
+	std::vector<std::unique_ptr<std::unordered_map<std::size_t, DescriptorSetBinding>>> descriptor_set_bindings;
+
+	/// Arenas for transient CPU allocations recorded in the frame, one per thread
+	std::vector<std::unique_ptr<LinearArena>> arenas;
+
 	FencePool fence_pool;
 
 	SemaphorePool semaphore_pool;
@@ -37,7 +37,7 @@ RenderPipeline::RenderPipeline(std::vector<std::unique_ptr<Subpass>> &&subpasses
 {
 	for (auto &subpass : subpasses)
 	{
-		subpass->prepare();
+		subpass->setup();
 	}
 
 	// Default clear values
@@ -49,7 +49,7 @@ RenderPipeline::RenderPipeline(std::vector<std::unique_ptr<Subpass>> &&subpasses
 
 void RenderPipeline::add_subpass(std::unique_ptr<Subpass> &&subpass)
 {
-	subpass->prepare();
+	subpass->setup();
 	subpasses.emplace_back(std::move(subpass));
 }
 
@@ -88,6 +88,12 @@ void RenderPipeline::draw(CommandBuffer &command_buffer, RenderTarget &render_ta
 		clear_value.push_back({0.0f, 0.0f, 0.0f, 1.0f});
 	}
 
+	// Record what the subpasses need before the render pass, as it cannot be recorded inside of it
+	for (auto &subpass : subpasses)
+	{
+		subpass->pre_render_pass(command_buffer);
+	}
+
 	for (size_t i = 0; i < subpasses.size(); ++i)
 	{
 		active_subpass_index = i;
@@ -96,13 +102,19 @@ void RenderPipeline::draw(CommandBuffer &command_buffer, RenderTarget &render_ta
 
 		subpass->update_render_target_attachments();
 
+		auto subpass_contents = contents;
+		if (subpass->get_subpass_contents() == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+		{
+			subpass_contents = VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS;
+		}
+
 		if (i == 0)
 		{
-			command_buffer.begin_render_pass(render_target, load_store, clear_value, subpasses, contents);
+			command_buffer.begin_render_pass(render_target, load_store, clear_value, subpasses, subpass_contents);
 		}
 		else
 		{
-			command_buffer.next_subpass();
+			command_buffer.next_subpass(subpass_contents);
 		}
 
 		subpass->draw(command_buffer);
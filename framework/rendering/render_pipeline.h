@@ -84,6 +84,9 @@ class RenderPipeline
 
 	/**
 	 * @brief Record draw commands for each Subpass
+	 * @param command_buffer Command buffer to record
+	 * @param render_target Render target to draw to
+	 * @param contents Contents of the subpasses, unless a subpass records in secondary command buffers
 	 */
 	void draw(CommandBuffer &command_buffer, RenderTarget &render_target, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 
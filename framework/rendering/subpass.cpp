@@ -21,6 +21,7 @@
 #include "subpass.h"
 
 #include "render_context.h"
+#include "shader_compiler.h"
 
 namespace vkb
 {
@@ -45,6 +46,17 @@ Subpass::Subpass(RenderContext &render_context, ShaderSource &&vertex_source, Sh
 {
 }
 
+void Subpass::setup()
+{
+	prepare();
+
+	finish_prepare();
+}
+
+void Subpass::finish_prepare()
+{
+}
+
 void Subpass::update_render_target_attachments()
 {
 	auto &render_target = render_context.get_active_frame().get_render_target();
@@ -53,6 +65,55 @@ void Subpass::update_render_target_attachments()
 	render_target.set_output_attachments(output_attachments);
 }
 
+void Subpass::compile_shaders(const std::vector<const ShaderVariant *> &variants)
+{
+	auto &spirv_cache     = render_context.get_device().get_resource_cache().get_spirv_cache();
+	auto &shader_compiler = ShaderCompiler::get();
+
+	std::vector<uint64_t>         keys;
+	std::vector<ShaderCompileJob> jobs;
+
+	for (auto variant : variants)
+	{
+		for (auto &stage_source : {std::make_pair(VK_SHADER_STAGE_VERTEX_BIT, &vertex_shader),
+		                           std::make_pair(VK_SHADER_STAGE_FRAGMENT_BIT, &fragment_shader)})
+		{
+			uint64_t key = SpirvCache::get_key(stage_source.first, *stage_source.second, "main", *variant);
+
+			if (!spirv_cache.contains(key))
+			{
+				keys.push_back(key);
+				jobs.push_back(shader_compiler.compile_async(stage_source.first, *stage_source.second, *variant));
+			}
+		}
+	}
+
+	ShaderCompiler::wait(jobs);
+
+	// Drain the jobs, so that the variants which are never requested do not keep their SPIR-V in the compiler.
+	// Failed jobs are dropped too, the shader module compiles them again to report the error
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		auto &result = jobs[i].get();
+
+		if (result.success && !spirv_cache.contains(keys[i]))
+		{
+			spirv_cache.insert(keys[i], result.spirv);
+		}
+
+		shader_compiler.release(keys[i]);
+	}
+}
+
+void Subpass::pre_render_pass(CommandBuffer &command_buffer)
+{
+}
+
+VkSubpassContents Subpass::get_subpass_contents() const
+{
+	return VK_SUBPASS_CONTENTS_INLINE;
+}
+
 RenderContext &Subpass::get_render_context()
 {
 	return render_context;
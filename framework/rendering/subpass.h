@@ -76,6 +76,13 @@ class Subpass
 
 	virtual void prepare() = 0;
 
+	/**
+	 * @brief Prepares the subpass: calls prepare(), then finish_prepare(), so that the steps a base
+	 *        subpass runs once its derived classes are prepared cannot be skipped.
+	 *        This function is called by the RenderPipeline when the subpass is added.
+	 */
+	void setup();
+
 	/**
 	 * @brief Updates the render target attachments with the ones stored in this subpass
 	 *        This function is called by the RenderPipeline before beginning the render
@@ -89,6 +96,20 @@ class Subpass
 	 */
 	virtual void draw(CommandBuffer &command_buffer) = 0;
 
+	/**
+	 * @brief Records the commands the draws of this subpass depend on, which cannot be
+	 *        recorded inside a render pass, such as compute dispatches.
+	 *        This function is called by the RenderPipeline before beginning the render pass,
+	 *        samples which begin the render pass themselves must call it for each subpass.
+	 * @param command_buffer Command buffer to use to record the commands
+	 */
+	virtual void pre_render_pass(CommandBuffer &command_buffer);
+
+	/**
+	 * @return Whether the subpass records its commands inline or in secondary command buffers
+	 */
+	virtual VkSubpassContents get_subpass_contents() const;
+
 	RenderContext &get_render_context();
 
 	const ShaderSource &get_vertex_shader() const;
@@ -115,6 +136,15 @@ class Subpass
 	 */
 	void add_definitions(ShaderVariant &variant, const std::vector<std::string> &definitions);
 
+	/**
+	 * @brief Compiles the vertex and fragment shaders of several variants in parallel and waits for them
+	 *        Variants already in the SPIR-V cache are skipped. The compiled SPIR-V is added to the cache,
+	 *        so that the shader modules requested afterwards do not run the compiler
+	 *
+	 * @param variants Variants to compile, duplicates are compiled once
+	 */
+	void compile_shaders(const std::vector<const ShaderVariant *> &variants);
+
 	/**
 	 * @brief Create a buffer allocation from scene graph lights to be bound to shaders
 	 * 
@@ -186,6 +216,11 @@ class Subpass
 	}
 
   protected:
+	/**
+	 * @brief Runs after prepare(), for a base subpass to complete what its derived classes prepared
+	 */
+	virtual void finish_prepare();
+
 	RenderContext &render_context;
 
 	bool use_dynamic_resources{false};
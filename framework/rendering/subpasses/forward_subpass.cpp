@@ -45,7 +45,6 @@ void ForwardSubpass::prepare()
 	// By default use dynamic resources
 	use_dynamic_resources = true;
 
-	auto &device = render_context.get_device();
 	for (auto &mesh : meshes)
 	{
 		for (auto &sub_mesh : mesh->get_submeshes())
@@ -55,18 +54,19 @@ void ForwardSubpass::prepare()
 			// Same as Geometry except adds lighting definitions to sub mesh variants.
 			add_definitions(variant, {"MAX_FORWARD_LIGHT_COUNT " + std::to_string(MAX_FORWARD_LIGHT_COUNT)});
 			add_definitions(variant, light_type_definitions);
-
-			auto &vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
-			auto &frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
 		}
 	}
 }
 
 void ForwardSubpass::draw(CommandBuffer &command_buffer)
 {
-	auto lights_buffer = allocate_lights<ForwardLights>(scene.get_components<sg::Light>(), MAX_FORWARD_LIGHT_COUNT);
-	command_buffer.bind_buffer(lights_buffer.get_buffer(), lights_buffer.get_offset(), lights_buffer.get_size(), 0, 4, 0);
+	light_buffer = allocate_lights<ForwardLights>(get_visible_lights(), MAX_FORWARD_LIGHT_COUNT);
 
 	GeometrySubpass::draw(command_buffer);
 }
+
+void ForwardSubpass::bind_draw_resources(CommandBuffer &command_buffer)
+{
+	command_buffer.bind_buffer(light_buffer.get_buffer(), light_buffer.get_offset(), light_buffer.get_size(), 0, 4, 0);
+}
 }        // namespace vkb
@@ -68,6 +68,15 @@ class ForwardSubpass : public GeometrySubpass
 	 * @brief Record draw commands
 	 */
 	virtual void draw(CommandBuffer &command_buffer) override;
+
+  protected:
+	/**
+	 * @brief Binds the light buffer allocated for the current draw
+	 */
+	virtual void bind_draw_resources(CommandBuffer &command_buffer) override;
+
+	/// Lights of the current draw, shared by all the command buffers it is recorded in
+	BufferAllocation light_buffer;
 };
 
 }        // namespace vkb
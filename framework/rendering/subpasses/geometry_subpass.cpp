@@ -19,11 +19,22 @@
  */
 
 #include "rendering/subpasses/geometry_subpass.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#include <ctpl_stl.h>
+
+#include "common/frustum_culling.h"
+#include "common/logging.h"
+#include "common/radix_sort.h"
 #include "common/utils.h"
 #include "common/vk_common.h"
 #include "rendering/render_context.h"
 #include "scene_graph/components/camera.h"
 #include "scene_graph/components/image.h"
+#include "scene_graph/components/light.h"
 #include "scene_graph/components/material.h"
 #include "scene_graph/components/mesh.h"
 #include "scene_graph/components/pbr_material.h"
@@ -33,106 +44,1238 @@
 
 namespace vkb
 {
+namespace
+{
+/// Bits of the sort key holding the pipeline id, below the transparent bit
+constexpr uint32_t PIPELINE_ID_BITS = 15;
+
+/// Bits of the sort key holding the material id
+constexpr uint32_t MATERIAL_ID_BITS = 16;
+
+/// Bits of the state key holding the sub mesh id, below the pipeline and material ids
+constexpr uint32_t SUB_MESH_ID_BITS = 16;
+
+constexpr uint64_t TRANSPARENT_BIT = uint64_t{1} << 63;
+
+/// Name of the vertex shader input with the model matrix of each instance
+const std::string INSTANCE_MODEL_INPUT = "instance_model";
+
+/// Path of the compute shader culling the GPU driven draws
+const std::string CULL_SHADER = "gpu_driven/cull.comp";
+
+/// Invocations per work group of the cull shader
+constexpr uint32_t CULL_GROUP_SIZE = 64;
+
+/// Command index of the draw records the cull shader skips
+constexpr uint32_t INVALID_COMMAND_INDEX = ~0U;
+
+/// Object index of what the scene BVH does not hold
+constexpr uint32_t INVALID_BVH_OBJECT = ~0U;
+
+/**
+ * @return Whether the node has a negative scale, which inverts the front face of its meshes
+ */
+bool is_flipped(sg::Node &node)
+{
+	const auto &scale = node.get_transform().get_scale();
+
+	return scale.x * scale.y * scale.z < 0;
+}
+
+/**
+ * @brief Quantizes a distance to the camera so that the order of the integers is the order of the distances
+ *        The bits of a non-negative float compare like the float itself
+ */
+uint32_t quantize_distance(float distance)
+{
+	distance = std::max(distance, 0.0f);
+
+	uint32_t bits;
+	std::memcpy(&bits, &distance, sizeof(bits));
+
+	return bits;
+}
+
+uint64_t make_opaque_sort_key(uint64_t state_key, float distance, bool instancing)
+{
+	if (instancing)
+	{
+		// Keep the exponent and the top of the mantissa, enough to order instances roughly front-to-back
+		return (state_key << 16) | (quantize_distance(distance) >> 16);
+	}
+
+	return ((state_key >> SUB_MESH_ID_BITS) << 32) | quantize_distance(distance);
+}
+
+uint64_t make_transparent_sort_key(uint64_t state_key, float distance)
+{
+	uint64_t inverted_distance = ~quantize_distance(distance);
+
+	return TRANSPARENT_BIT | (inverted_distance << 31) | (state_key >> SUB_MESH_ID_BITS);
+}
+}        // namespace
+
 GeometrySubpass::GeometrySubpass(RenderContext &render_context, ShaderSource &&vertex_source, ShaderSource &&fragment_source, sg::Scene &scene_, sg::Camera &camera) :
     Subpass{render_context, std::move(vertex_source), std::move(fragment_source)},
     meshes{scene_.get_components<sg::Mesh>()},
     camera{camera},
     scene{scene_}
 {
+	// Split the draws across the threads the render frames have resources for
+	auto &render_frames = render_context.get_render_frames();
+	if (!render_frames.empty() && render_frames.front().get_thread_count() > 1)
+	{
+		secondary_command_buffer_count = to_u32(render_frames.front().get_thread_count());
+		multi_threading                = true;
+	}
+}
+
+GeometrySubpass::~GeometrySubpass()
+{
+	for (auto &transform_it : indirect_transform_nodes)
+	{
+		transform_it.first->remove_observer(*this);
+	}
+}
+
+void GeometrySubpass::prepare()
+{
+	// By default use dynamic resources
+	use_dynamic_resources = true;
+}
+
+void GeometrySubpass::finish_prepare()
+{
+	prepare_shader_variants();
+
+	prepare_bindless_textures();
+
+	prepare_instancing();
+
+	// Compile all shader variants upfront, in parallel
+	std::vector<const ShaderVariant *> variants;
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			variants.push_back(&get_shader_variant(*sub_mesh));
+		}
+	}
+
+	compile_shaders(variants);
+
+	// Build all shader modules upfront
+	auto &device = render_context.get_device();
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			auto &variant     = get_shader_variant(*sub_mesh);
+			auto &vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
+			auto &frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
+
+			vert_module.set_resource_dynamic("GlobalUniform");
+			frag_module.set_resource_dynamic("GlobalUniform");
+		}
+	}
+
+	create_bindless_descriptor_set();
+
+	check_instance_input();
+
+	prepare_sort_keys();
+
+	prepare_world_bounds();
+
+	prepare_gpu_driven();
+}
+
+void GeometrySubpass::set_bindless_textures(bool enable)
+{
+	bindless_textures = enable;
+}
+
+bool GeometrySubpass::is_bindless_textures() const
+{
+	return bindless_textures;
+}
+
+void GeometrySubpass::set_instancing(bool enable)
+{
+	instancing = enable;
+}
+
+bool GeometrySubpass::is_instancing() const
+{
+	return instancing;
+}
+
+void GeometrySubpass::set_frustum_culling(bool enable)
+{
+	frustum_culling = enable;
+}
+
+bool GeometrySubpass::is_frustum_culling() const
+{
+	return frustum_culling;
+}
+
+void GeometrySubpass::set_hierarchical_culling(bool enable)
+{
+	hierarchical_culling = enable;
+}
+
+bool GeometrySubpass::is_hierarchical_culling() const
+{
+	return hierarchical_culling;
+}
+
+const CullingCounters &GeometrySubpass::get_culling_counters() const
+{
+	return culling_counters;
+}
+
+void GeometrySubpass::set_gpu_driven(bool enable)
+{
+	gpu_driven = enable;
+}
+
+bool GeometrySubpass::is_gpu_driven() const
+{
+	return gpu_driven;
+}
+
+void GeometrySubpass::prepare_shader_variants()
+{
+	shader_variants.clear();
+
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			shader_variants.emplace(sub_mesh, sub_mesh->get_shader_variant());
+		}
+	}
+}
+
+const ShaderVariant &GeometrySubpass::get_shader_variant(const sg::SubMesh &sub_mesh) const
+{
+	auto it = shader_variants.find(&sub_mesh);
+
+	// Sub meshes which were not prepared by this subpass use their own variant
+	if (it == shader_variants.end())
+	{
+		return sub_mesh.get_shader_variant();
+	}
+
+	return it->second;
+}
+
+void GeometrySubpass::prepare_instancing()
+{
+	if (!instancing)
+	{
+		return;
+	}
+
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			shader_variants.at(sub_mesh).add_define("INSTANCING");
+		}
+	}
+}
+
+void GeometrySubpass::check_instance_input()
+{
+	if (!instancing)
+	{
+		return;
+	}
+
+	auto &device = render_context.get_device();
+
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			auto &vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), get_shader_variant(*sub_mesh));
+
+			auto &resources = vert_module.get_resources();
+
+			auto instance_input = std::find_if(resources.begin(), resources.end(), [](const ShaderResource &resource) {
+				return resource.type == ShaderResourceType::Input && resource.name == INSTANCE_MODEL_INPUT;
+			});
+
+			if (instance_input == resources.end())
+			{
+				LOGW("Instancing disabled: the vertex shader does not declare the {} input", INSTANCE_MODEL_INPUT);
+				instancing = false;
+				return;
+			}
+		}
+	}
+}
+
+void GeometrySubpass::prepare_gpu_driven()
+{
+	for (auto &transform_it : indirect_transform_nodes)
+	{
+		transform_it.first->remove_observer(*this);
+	}
+
+	indirect_draws.clear();
+	indirect_draw_indices.clear();
+	indirect_instance_count = 0;
+	indirect_nodes.clear();
+	indirect_transform_nodes.clear();
+	indirect_frames.clear();
+	indirect_seed_buffer.reset();
+
+	if (!gpu_driven)
+	{
+		return;
+	}
+
+	// The indirect draws read the model matrices the cull shader writes as instance attributes
+	if (!instancing)
+	{
+		LOGW("GPU driven drawing disabled: instancing is disabled");
+		gpu_driven = false;
+		return;
+	}
+
+	// Each sub mesh draws its instances from its own range of the instance buffer
+	auto &device = render_context.get_device();
+	if (!device.get_features().drawIndirectFirstInstance)
+	{
+		LOGW("GPU driven drawing disabled: indirect draws cannot start at an instance other than 0");
+		gpu_driven = false;
+		return;
+	}
+
+	cull_shader = ShaderSource{CULL_SHADER};
+
+	for (size_t mesh_index = 0; mesh_index < meshes.size(); ++mesh_index)
+	{
+		auto &               mesh = meshes[mesh_index];
+		std::vector<int32_t> draw_indices;
+
+		auto node_count = to_u32(mesh->get_nodes().size());
+
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			// Transparent draws are sorted back-to-front on the CPU, and only indexed draws are driven by the GPU
+			if (sub_mesh->get_material()->alpha_mode == sg::AlphaMode::Blend || sub_mesh->vertex_indices == 0 || node_count == 0)
+			{
+				draw_indices.push_back(-1);
+				continue;
+			}
+
+			draw_indices.push_back(static_cast<int32_t>(indirect_draws.size()));
+
+			indirect_draws.push_back({mesh, sub_mesh, indirect_instance_count});
+
+			indirect_instance_count += node_count;
+		}
+
+		// The records of the nodes are rewritten when their transform changes
+		if (std::any_of(draw_indices.begin(), draw_indices.end(), [](int32_t draw_index) { return draw_index >= 0; }))
+		{
+			auto &nodes = mesh->get_nodes();
+			for (uint32_t node_index = 0; node_index < node_count; ++node_index)
+			{
+				auto &transform = nodes[node_index]->get_transform();
+
+				auto &transform_nodes = indirect_transform_nodes[&transform];
+				if (transform_nodes.empty())
+				{
+					transform.add_observer(*this);
+				}
+				transform_nodes.push_back(to_u32(indirect_nodes.size()));
+
+				indirect_nodes.push_back({nodes[node_index], mesh_index, node_index});
+			}
+		}
+
+		indirect_draw_indices.push_back(std::move(draw_indices));
+	}
+
+	if (indirect_draws.empty())
+	{
+		return;
+	}
+
+	// The commands start without instances, the cull shader counts the visible ones
+	std::vector<VkDrawIndexedIndirectCommand> commands(indirect_draws.size());
+	for (size_t i = 0; i < indirect_draws.size(); ++i)
+	{
+		commands[i].indexCount    = indirect_draws[i].sub_mesh->vertex_indices;
+		commands[i].instanceCount = 0;
+		commands[i].firstIndex    = 0;
+		commands[i].vertexOffset  = 0;
+		commands[i].firstInstance = indirect_draws[i].first_instance;
+	}
+
+	auto command_size = commands.size() * sizeof(VkDrawIndexedIndirectCommand);
+
+	indirect_seed_buffer = std::make_unique<core::Buffer>(device, command_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+	indirect_seed_buffer->update(reinterpret_cast<const uint8_t *>(commands.data()), command_size);
+
+	// Every record is written the first time each render frame is drawn
+	for (size_t i = 0; i < render_context.get_render_frames().size(); ++i)
+	{
+		IndirectFrame frame;
+
+		frame.record_buffer = std::make_unique<core::Buffer>(device, indirect_instance_count * sizeof(DrawRecord),
+		                                                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		                                                     VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+		frame.command_buffer = std::make_unique<core::Buffer>(device, command_size,
+		                                                      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		                                                      VMA_MEMORY_USAGE_GPU_ONLY);
+
+		frame.instance_buffer = std::make_unique<core::Buffer>(device, indirect_instance_count * sizeof(glm::mat4),
+		                                                       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		                                                       VMA_MEMORY_USAGE_GPU_ONLY);
+
+		frame.dirty_nodes.resize(indirect_nodes.size());
+		std::iota(frame.dirty_nodes.begin(), frame.dirty_nodes.end(), 0U);
+		frame.dirty.assign(indirect_nodes.size(), true);
+
+		indirect_frames.push_back(std::move(frame));
+	}
+}
+
+void GeometrySubpass::on_world_matrix_invalidated(sg::Transform &transform)
+{
+	auto transform_it = indirect_transform_nodes.find(&transform);
+	if (transform_it == indirect_transform_nodes.end())
+	{
+		return;
+	}
+
+	for (auto &frame : indirect_frames)
+	{
+		for (auto node : transform_it->second)
+		{
+			if (!frame.dirty[node])
+			{
+				frame.dirty[node] = true;
+				frame.dirty_nodes.push_back(node);
+			}
+		}
+	}
+}
+
+bool GeometrySubpass::is_gpu_draw(size_t mesh_index, size_t sub_mesh_index, sg::Node &node) const
+{
+	// Flipped nodes need another front face, so they are drawn by the CPU
+	return !indirect_command_buffer.empty() && indirect_draw_indices[mesh_index][sub_mesh_index] >= 0 && !is_flipped(node);
+}
+
+void GeometrySubpass::update_indirect_records(uint32_t frame_index)
+{
+	auto &frame = indirect_frames.at(frame_index);
+
+	if (frame.dirty_nodes.empty())
+	{
+		return;
+	}
+
+	auto records = reinterpret_cast<DrawRecord *>(frame.record_buffer->map());
+
+	for (auto node : frame.dirty_nodes)
+	{
+		auto &indirect_node = indirect_nodes[node];
+
+		auto &          mesh   = meshes[indirect_node.mesh_index];
+		const sg::AABB &bounds = mesh->get_bounds();
+
+		auto model   = indirect_node.node->get_transform().get_world_matrix();
+		bool flipped = is_flipped(*indirect_node.node);
+
+		// A record per indirect draw of the mesh, at the instance of the node in the draw
+		for (auto draw_index : indirect_draw_indices[indirect_node.mesh_index])
+		{
+			if (draw_index < 0)
+			{
+				continue;
+			}
+
+			auto &record         = records[indirect_draws[draw_index].first_instance + indirect_node.node_index];
+			record.model         = model;
+			record.bounds_min    = glm::vec4{bounds.get_min(), 1.0f};
+			record.bounds_max    = glm::vec4{bounds.get_max(), 1.0f};
+			record.command_index = flipped ? INVALID_COMMAND_INDEX : to_u32(draw_index);
+		}
+
+		frame.dirty[node] = false;
+	}
+
+	frame.record_buffer->flush();
+	frame.record_buffer->unmap();
+
+	frame.dirty_nodes.clear();
+}
+
+void GeometrySubpass::pre_render_pass(CommandBuffer &command_buffer)
+{
+	indirect_command_buffer  = {};
+	indirect_instance_buffer = {};
+
+	if (!gpu_driven || indirect_draws.empty())
+	{
+		return;
+	}
+
+	// The render frame waited for the GPU to be done with it, so its records can be rewritten
+	auto frame_index = render_context.get_active_frame_index();
+	update_indirect_records(frame_index);
+
+	auto &frame = indirect_frames.at(frame_index);
+
+	CullUniform cull_uniform{};
+	extract_frustum_planes(vulkan_style_projection(camera.get_projection()) * camera.get_view(), cull_uniform.frustum_planes);
+	cull_uniform.record_count = indirect_instance_count;
+
+	auto uniform_buffer = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(CullUniform));
+	uniform_buffer.update(cull_uniform);
+
+	indirect_command_buffer  = BufferAllocation{*frame.command_buffer, frame.command_buffer->get_size(), 0};
+	indirect_instance_buffer = BufferAllocation{*frame.instance_buffer, frame.instance_buffer->get_size(), 0};
+
+	// Reset the instance counts of the commands
+	command_buffer.copy_buffer(*indirect_seed_buffer, *frame.command_buffer, indirect_seed_buffer->get_size());
+
+	BufferMemoryBarrier seed_barrier{};
+	seed_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	seed_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	seed_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	seed_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	command_buffer.buffer_memory_barrier(*frame.command_buffer, 0, frame.command_buffer->get_size(), seed_barrier);
+
+	auto &resource_cache = command_buffer.get_device().get_resource_cache();
+
+	auto &cull_module = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, cull_shader);
+
+	std::vector<ShaderModule *> shader_modules{&cull_module};
+
+	command_buffer.bind_pipeline_layout(resource_cache.request_pipeline_layout(shader_modules, false));
+
+	command_buffer.bind_buffer(uniform_buffer.get_buffer(), uniform_buffer.get_offset(), uniform_buffer.get_size(), 0, 0, 0);
+	command_buffer.bind_buffer(*frame.record_buffer, 0, frame.record_buffer->get_size(), 0, 1, 0);
+	command_buffer.bind_buffer(*frame.command_buffer, 0, frame.command_buffer->get_size(), 0, 2, 0);
+	command_buffer.bind_buffer(*frame.instance_buffer, 0, frame.instance_buffer->get_size(), 0, 3, 0);
+
+	command_buffer.dispatch((indirect_instance_count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+	// The draws of the render pass read what the cull shader wrote
+	BufferMemoryBarrier command_barrier{};
+	command_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	command_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+	command_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	command_barrier.dst_access_mask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+	command_buffer.buffer_memory_barrier(*frame.command_buffer, 0, frame.command_buffer->get_size(), command_barrier);
+
+	BufferMemoryBarrier instance_barrier{};
+	instance_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	instance_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+	instance_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	instance_barrier.dst_access_mask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+
+	command_buffer.buffer_memory_barrier(*frame.instance_buffer, 0, frame.instance_buffer->get_size(), instance_barrier);
+}
+
+void GeometrySubpass::record_indirect_draws(CommandBuffer &command_buffer)
+{
+	for (size_t i = 0; i < indirect_draws.size(); ++i)
+	{
+		auto &indirect_draw = indirect_draws[i];
+
+		// The model matrix of the uniform is unused, as the instance attributes provide it
+		update_uniform(command_buffer, *indirect_draw.mesh->get_nodes().front());
+
+		bind_submesh(command_buffer, *indirect_draw.sub_mesh, VK_FRONT_FACE_COUNTER_CLOCKWISE, &indirect_instance_buffer);
+
+		command_buffer.bind_index_buffer(*indirect_draw.sub_mesh->index_buffer, indirect_draw.sub_mesh->index_offset, indirect_draw.sub_mesh->index_type);
+
+		command_buffer.draw_indexed_indirect(indirect_command_buffer.get_buffer(),
+		                                     indirect_command_buffer.get_offset() + i * sizeof(VkDrawIndexedIndirectCommand),
+		                                     1, to_u32(sizeof(VkDrawIndexedIndirectCommand)));
+	}
+}
+
+void GeometrySubpass::prepare_bindless_textures()
+{
+	bindless_texture_indices.clear();
+
+	if (!bindless_textures)
+	{
+		return;
+	}
+
+	auto &device = render_context.get_device();
+
+	if (!device.get_features().shaderSampledImageArrayDynamicIndexing)
+	{
+		LOGW("Bindless textures disabled: sampled image arrays cannot be indexed dynamically");
+		bindless_textures = false;
+		return;
+	}
+
+	std::vector<sg::Texture *> textures;
+	for (auto texture : scene.get_components<sg::Texture>())
+	{
+		if (texture->get_image() != nullptr && texture->get_sampler() != nullptr)
+		{
+			textures.push_back(texture);
+		}
+	}
+
+	const auto &limits       = device.get_properties().limits;
+	uint32_t    max_textures = std::min({limits.maxPerStageDescriptorSamplers,
+                                      limits.maxPerStageDescriptorSampledImages,
+                                      limits.maxDescriptorSetSamplers,
+                                      limits.maxDescriptorSetSampledImages});
+
+	if (textures.empty() || textures.size() > max_textures)
+	{
+		LOGW("Bindless textures disabled: {} scene textures for a limit of {}", textures.size(), max_textures);
+		bindless_textures = false;
+		return;
+	}
+
+	for (uint32_t index = 0; index < to_u32(textures.size()); ++index)
+	{
+		bindless_texture_indices.emplace(textures[index], index);
+	}
+
+	// The array size is fixed at load time, so the shaders only need dynamically uniform indexing
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			shader_variants.at(sub_mesh).add_define("BINDLESS_TEXTURE_COUNT " + std::to_string(textures.size()));
+		}
+	}
+}
+
+void GeometrySubpass::create_bindless_descriptor_set()
+{
+	bindless_descriptor_set.reset();
+	bindless_descriptor_pool.reset();
+
+	if (!bindless_textures)
+	{
+		return;
+	}
+
+	auto &device = render_context.get_device();
+
+	// The texture array has the same layout in every variant, so any sub mesh provides it
+	sg::SubMesh *sub_mesh{nullptr};
+	for (auto &mesh : meshes)
+	{
+		if (!mesh->get_submeshes().empty())
+		{
+			sub_mesh = mesh->get_submeshes().front();
+			break;
+		}
+	}
+
+	if (sub_mesh == nullptr)
+	{
+		bindless_textures = false;
+		return;
+	}
+
+	auto &vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), get_shader_variant(*sub_mesh));
+	auto &frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), get_shader_variant(*sub_mesh));
+
+	std::vector<ShaderModule *> shader_modules{&vert_module, &frag_module};
+
+	auto &pipeline_layout = device.get_resource_cache().request_pipeline_layout(shader_modules, use_dynamic_resources);
+
+	auto layout_binding = pipeline_layout.has_descriptor_set_layout(1) ? pipeline_layout.get_descriptor_set_layout(1).get_layout_binding(0) : nullptr;
+
+	if (!layout_binding || layout_binding->descriptorCount != to_u32(bindless_texture_indices.size()))
+	{
+		LOGW("Bindless textures disabled: the shaders do not declare the texture array at set 1");
+		bindless_textures = false;
+		return;
+	}
+
+	auto &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(1);
+
+	BindingMap<VkDescriptorImageInfo> image_infos;
+
+	for (auto &texture_it : bindless_texture_indices)
+	{
+		VkDescriptorImageInfo image_info{};
+		image_info.sampler     = texture_it.first->get_sampler()->vk_sampler.get_handle();
+		image_info.imageView   = texture_it.first->get_image()->get_vk_image_view().get_handle();
+		image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		image_infos[0][texture_it.second] = image_info;
+	}
+
+	// The descriptor set is written once and bound by every draw
+	bindless_descriptor_pool = std::make_unique<DescriptorPool>(device, descriptor_set_layout, 1);
+	bindless_descriptor_set  = std::make_unique<DescriptorSet>(device, descriptor_set_layout, *bindless_descriptor_pool, BindingMap<VkDescriptorBufferInfo>{}, image_infos);
+}
+
+void GeometrySubpass::prepare_sort_keys()
+{
+	// Ids are assigned in order of appearance, and wrap around if there are more than the key can hold
+	std::unordered_map<size_t, uint32_t>               pipeline_ids;
+	std::unordered_map<const sg::Material *, uint32_t> material_ids;
+	uint32_t                                           sub_mesh_id{0};
+
+	sub_mesh_state_keys.clear();
+	draw_count = 0;
+
+	for (auto &mesh : meshes)
+	{
+		std::vector<uint64_t> state_keys;
+
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			auto material = sub_mesh->get_material();
+
+			// Double sided materials change the rasterization state, so they need a pipeline of their own
+			size_t pipeline_hash = get_shader_variant(*sub_mesh).get_id();
+			hash_combine(pipeline_hash, material->double_sided);
+
+			auto pipeline_id = pipeline_ids.emplace(pipeline_hash, to_u32(pipeline_ids.size())).first->second;
+			auto material_id = material_ids.emplace(material, to_u32(material_ids.size())).first->second;
+
+			pipeline_id &= (1U << PIPELINE_ID_BITS) - 1;
+			material_id &= (1U << MATERIAL_ID_BITS) - 1;
+
+			uint64_t state_key = (pipeline_id << MATERIAL_ID_BITS) | material_id;
+
+			state_keys.push_back((state_key << SUB_MESH_ID_BITS) | (sub_mesh_id++ & ((1U << SUB_MESH_ID_BITS) - 1)));
+		}
+
+		draw_count += mesh->get_nodes().size() * state_keys.size();
+
+		sub_mesh_state_keys.push_back(std::move(state_keys));
+	}
 }
 
-void GeometrySubpass::prepare()
+void GeometrySubpass::prepare_world_bounds()
 {
-	// By default use dynamic resources
-	use_dynamic_resources = true;
+	size_t node_count = 0;
+
+	mesh_bounds_offsets.clear();
 
-	// Build all shader variance upfront
-	auto &device = render_context.get_device();
 	for (auto &mesh : meshes)
 	{
-		for (auto &sub_mesh : mesh->get_submeshes())
+		mesh_bounds_offsets.push_back(node_count);
+
+		node_count += mesh->get_nodes().size();
+	}
+
+	world_bounds.resize(node_count);
+
+	// No version matches, so that all bounds are computed in the first frame
+	world_bounds_versions.assign(node_count, ~0U);
+
+	bvh_object_bounds_indices.clear();
+	bounds_bvh_objects.clear();
+	light_bvh_objects.clear();
+
+	if (!hierarchical_culling)
+	{
+		return;
+	}
+
+	auto &bvh = scene.get_bvh();
+
+	// Match the mesh objects of the scene BVH with the world bounds of their nodes
+	std::unordered_map<const sg::Node *, size_t> node_bounds_indices;
+
+	for (size_t mesh_index = 0; mesh_index < meshes.size(); ++mesh_index)
+	{
+		auto &nodes = meshes[mesh_index]->get_nodes();
+
+		for (size_t node_index = 0; node_index < nodes.size(); ++node_index)
 		{
-			auto &variant     = sub_mesh->get_shader_variant();
-			auto &vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
-			auto &frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
+			node_bounds_indices.emplace(nodes[node_index], mesh_bounds_offsets[mesh_index] + node_index);
+		}
+	}
 
-			vert_module.set_resource_dynamic("GlobalUniform");
-			frag_module.set_resource_dynamic("GlobalUniform");
+	// Lights are matched with their objects too, for light assignment
+	std::unordered_map<const sg::Component *, uint32_t> light_objects;
+
+	bvh_object_bounds_indices.assign(bvh.get_object_count(), node_count);
+	bounds_bvh_objects.assign(node_count, INVALID_BVH_OBJECT);
+
+	for (uint32_t object = 0; object < to_u32(bvh.get_object_count()); ++object)
+	{
+		if (bvh.get_type(object) == sg::BVH::LightObject)
+		{
+			light_objects.emplace(&bvh.get_component(object), object);
+			continue;
+		}
+
+		auto node_it = node_bounds_indices.find(&bvh.get_node(object));
+
+		if (bvh.get_type(object) == sg::BVH::MeshObject && node_it != node_bounds_indices.end())
+		{
+			bvh_object_bounds_indices[object]   = node_it->second;
+			bounds_bvh_objects[node_it->second] = object;
+		}
+	}
+
+	for (auto light : scene.get_components<sg::Light>())
+	{
+		auto light_it = light_objects.find(light);
+
+		light_bvh_objects.push_back(light_it != light_objects.end() ? light_it->second : INVALID_BVH_OBJECT);
+	}
+
+	if (std::find(bounds_bvh_objects.begin(), bounds_bvh_objects.end(), INVALID_BVH_OBJECT) != bounds_bvh_objects.end())
+	{
+		LOGW("Hierarchical culling disabled: the scene BVH does not hold every mesh instance");
+		hierarchical_culling = false;
+	}
+}
+
+void GeometrySubpass::update_world_bounds()
+{
+	for (size_t mesh_index = 0; mesh_index < meshes.size(); ++mesh_index)
+	{
+		auto &          mesh        = meshes[mesh_index];
+		const sg::AABB &mesh_bounds = mesh->get_bounds();
+		auto &          nodes       = mesh->get_nodes();
+
+		for (size_t node_index = 0; node_index < nodes.size(); ++node_index)
+		{
+			size_t bounds_index = mesh_bounds_offsets[mesh_index] + node_index;
+
+			auto &transform = nodes[node_index]->get_transform();
+			auto  version   = transform.get_world_matrix_version();
+
+			if (version != world_bounds_versions[bounds_index])
+			{
+				world_bounds.set(bounds_index, mesh_bounds.get_min(), mesh_bounds.get_max(), transform.get_world_matrix());
+
+				world_bounds_versions[bounds_index] = version;
+			}
+		}
+	}
+}
+
+std::vector<sg::Light *> GeometrySubpass::get_visible_lights()
+{
+	auto lights = scene.get_components<sg::Light>();
+
+	if (!frustum_culling || !hierarchical_culling || light_bvh_objects.size() != lights.size())
+	{
+		return lights;
+	}
+
+	auto &bvh = scene.get_bvh();
+	bvh.update();
+
+	glm::vec4 frustum_planes[6];
+	extract_frustum_planes(vulkan_style_projection(camera.get_projection()) * camera.get_view(), frustum_planes);
+
+	visible_bvh_objects.clear();
+	bvh.query_frustum(frustum_planes, visible_bvh_objects, sg::BVH::LightObject);
+
+	std::sort(visible_bvh_objects.begin(), visible_bvh_objects.end());
+
+	std::vector<sg::Light *> visible_lights;
+
+	for (size_t i = 0; i < lights.size(); ++i)
+	{
+		// Lights out of the BVH reach the whole scene
+		auto object = light_bvh_objects[i];
+
+		if (object == INVALID_BVH_OBJECT || std::binary_search(visible_bvh_objects.begin(), visible_bvh_objects.end(), object))
+		{
+			visible_lights.push_back(lights[i]);
 		}
 	}
+
+	return visible_lights;
 }
 
-void GeometrySubpass::get_sorted_nodes(std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes, std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes)
+size_t GeometrySubpass::get_sorted_draws(DrawList &draws)
 {
 	auto camera_transform = camera.get_node()->get_transform().get_world_matrix();
 
-	for (auto &mesh : meshes)
+	// The scene BVH keeps the world bounds itself, refitting those of the moved nodes only
+	bool bvh_culling = frustum_culling && hierarchical_culling;
+
+	if (!bvh_culling)
+	{
+		update_world_bounds();
+	}
+
+	// Nodes are visible unless their world bounds are outside the camera frustum
+	auto visible = ArenaAllocator<uint8_t>{draws.get_allocator()}.allocate(world_bounds.size());
+
+	glm::vec4 frustum_planes[6];
+	extract_frustum_planes(vulkan_style_projection(camera.get_projection()) * camera.get_view(), frustum_planes);
+
+	if (bvh_culling)
+	{
+		auto &bvh = scene.get_bvh();
+		bvh.update();
+
+		visible_bvh_objects.clear();
+		bvh.query_frustum(frustum_planes, visible_bvh_objects, sg::BVH::MeshObject);
+
+		std::fill(visible, visible + world_bounds.size(), uint8_t{0});
+
+		for (auto object : visible_bvh_objects)
+		{
+			visible[bvh_object_bounds_indices[object]] = 1;
+		}
+	}
+	else if (frustum_culling)
+	{
+		world_bounds.cull(frustum_planes, visible);
+	}
+	else
+	{
+		std::fill(visible, visible + world_bounds.size(), uint8_t{1});
+	}
+
+	auto get_world_center = [this, bvh_culling](size_t bounds_index) {
+		return bvh_culling ? scene.get_bvh().get_center(bounds_bvh_objects[bounds_index]) : world_bounds.get_center(bounds_index);
+	};
+
+	culling_counters = {};
+
+	draws.reserve(draw_count);
+
+	size_t transparent_count = 0;
+
+	for (size_t mesh_index = 0; mesh_index < meshes.size(); ++mesh_index)
 	{
-		for (auto &node : mesh->get_nodes())
+		auto &mesh       = meshes[mesh_index];
+		auto &state_keys = sub_mesh_state_keys[mesh_index];
+		auto &sub_meshes = mesh->get_submeshes();
+
+		// Nodes with all their sub meshes drawn by the GPU need no sort key
+		bool gpu_draws_only = !indirect_command_buffer.empty() &&
+		                      std::none_of(indirect_draw_indices[mesh_index].begin(), indirect_draw_indices[mesh_index].end(),
+		                                   [](int32_t draw_index) { return draw_index < 0; });
+
+		auto &nodes = mesh->get_nodes();
+
+		for (size_t node_index = 0; node_index < nodes.size(); ++node_index)
 		{
-			auto node_transform = node->get_transform().get_world_matrix();
+			auto node = nodes[node_index];
+
+			if (gpu_draws_only && !is_flipped(*node))
+			{
+				continue;
+			}
 
-			const sg::AABB &mesh_bounds = mesh->get_bounds();
+			size_t bounds_index = mesh_bounds_offsets[mesh_index] + node_index;
+
+			if (!visible[bounds_index])
+			{
+				culling_counters.culled++;
+				continue;
+			}
 
-			sg::AABB world_bounds{mesh_bounds.get_min(), mesh_bounds.get_max()};
-			world_bounds.transform(node_transform);
+			culling_counters.visible++;
 
-			float distance = glm::length(glm::vec3(camera_transform[3]) - world_bounds.get_center());
+			float distance = glm::length(glm::vec3(camera_transform[3]) - get_world_center(bounds_index));
 
-			for (auto &sub_mesh : mesh->get_submeshes())
+			for (size_t sub_mesh_index = 0; sub_mesh_index < sub_meshes.size(); ++sub_mesh_index)
 			{
+				auto sub_mesh = sub_meshes[sub_mesh_index];
+
+				if (is_gpu_draw(mesh_index, sub_mesh_index, *node))
+				{
+					continue;
+				}
+
 				if (sub_mesh->get_material()->alpha_mode == sg::AlphaMode::Blend)
 				{
-					transparent_nodes.emplace(distance, std::make_pair(node, sub_mesh));
+					draws.push_back({make_transparent_sort_key(state_keys[sub_mesh_index], distance), node, sub_mesh});
+					transparent_count++;
 				}
 				else
 				{
-					opaque_nodes.emplace(distance, std::make_pair(node, sub_mesh));
+					draws.push_back({make_opaque_sort_key(state_keys[sub_mesh_index], distance, instancing), node, sub_mesh});
 				}
 			}
 		}
 	}
+
+	// The scratch memory for sorting lives in the frame arena, as the draw list does
+	auto scratch = draws.get_allocator().allocate(draws.size());
+
+	radix_sort(draws.data(), scratch, draws.size(), [](const Draw &draw) { return draw.sort_key; });
+
+	return draws.size() - transparent_count;
 }
 
 void GeometrySubpass::draw(CommandBuffer &command_buffer)
 {
-	std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> opaque_nodes;
-	std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> transparent_nodes;
+	// The draws live in the frame arena, so that sorting does not allocate
+	DrawList draws{command_buffer.get_arena()};
+
+	auto transparent_start = get_sorted_draws(draws);
+
+	bool secondary = command_buffer.get_current_subpass_contents() == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS;
+
+	// Opaque draws culled by the GPU come first, in a secondary command buffer of their own if needed
+	if (!indirect_command_buffer.empty())
+	{
+		if (secondary)
+		{
+			auto &secondary_command_buffer = command_buffer.request_secondary_command_buffer();
+
+			bind_draw_resources(secondary_command_buffer);
+
+			record_indirect_draws(secondary_command_buffer);
+
+			secondary_command_buffer.end();
+
+			command_buffer.execute_commands(secondary_command_buffer);
+		}
+		else
+		{
+			bind_draw_resources(command_buffer);
+
+			record_indirect_draws(command_buffer);
+		}
+
+		// The buffers are valid for this frame only
+		indirect_command_buffer  = {};
+		indirect_instance_buffer = {};
+	}
+
+	if (secondary)
+	{
+		record_draws_secondary(command_buffer, draws, transparent_start);
+		return;
+	}
+
+	avg_draws_per_buffer = 0;
+
+	bind_draw_resources(command_buffer);
+
+	// Draw opaque objects grouped by state, then transparent objects in back-to-front order
+	record_draws(command_buffer, draws, 0, transparent_start, false);
+
+	record_draws(command_buffer, draws, transparent_start, draws.size(), true);
+}
+
+VkSubpassContents GeometrySubpass::get_subpass_contents() const
+{
+	return secondary_command_buffer_count > 0 ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+}
+
+void GeometrySubpass::set_secondary_command_buffer_count(uint32_t count)
+{
+	secondary_command_buffer_count = count;
+}
+
+uint32_t GeometrySubpass::get_secondary_command_buffer_count() const
+{
+	return secondary_command_buffer_count;
+}
+
+void GeometrySubpass::set_multi_threading(bool enable)
+{
+	multi_threading = enable;
+}
+
+bool GeometrySubpass::is_multi_threading() const
+{
+	return multi_threading;
+}
+
+float GeometrySubpass::get_avg_draws_per_buffer() const
+{
+	return avg_draws_per_buffer;
+}
+
+void GeometrySubpass::bind_draw_resources(CommandBuffer &command_buffer)
+{
+}
 
-	get_sorted_nodes(opaque_nodes, transparent_nodes);
+void GeometrySubpass::record_draws(CommandBuffer &command_buffer, const DrawList &draws, size_t draw_start, size_t draw_end, bool transparent, size_t thread_index)
+{
+	if (draw_start == draw_end)
+	{
+		return;
+	}
 
-	// Draw opaque objects in front-to-back order
-	for (auto node_it = opaque_nodes.begin(); node_it != opaque_nodes.end(); node_it++)
+	if (transparent)
 	{
-		update_uniform(command_buffer, *node_it->second.first);
+		// Enable alpha blending
+		ColorBlendAttachmentState color_blend_attachment{};
+		color_blend_attachment.blend_enable           = VK_TRUE;
+		color_blend_attachment.src_color_blend_factor = VK_BLEND_FACTOR_SRC_ALPHA;
+		color_blend_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+		ColorBlendState color_blend_state{};
+		color_blend_state.attachments.resize(get_output_attachments().size());
+		color_blend_state.attachments[0] = color_blend_attachment;
+		command_buffer.set_color_blend_state(color_blend_state);
 
+		command_buffer.set_depth_stencil_state(get_depth_stencil_state());
+	}
+
+	auto get_front_face = [transparent](const Draw &draw) {
 		// Invert the front face if the mesh was flipped
-		const auto &scale      = node_it->second.first->get_transform().get_scale();
-		bool        flipped    = scale.x * scale.y * scale.z < 0;
-		VkFrontFace front_face = flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		if (!transparent && is_flipped(*draw.node))
+		{
+			return VK_FRONT_FACE_CLOCKWISE;
+		}
+
+		return VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	};
+
+	for (size_t i = draw_start; i < draw_end;)
+	{
+		auto &node     = *draws[i].node;
+		auto &sub_mesh = *draws[i].sub_mesh;
+
+		VkFrontFace front_face = get_front_face(draws[i]);
+
+		update_uniform(command_buffer, node, thread_index);
+
+		if (!instancing)
+		{
+			draw_submesh(command_buffer, sub_mesh, front_face);
+			i++;
+			continue;
+		}
+
+		// The following draws of the same sub mesh become instances of a single draw
+		size_t instance_end = i + 1;
+		while (instance_end < draw_end && draws[instance_end].sub_mesh == &sub_mesh && get_front_face(draws[instance_end]) == front_face)
+		{
+			instance_end++;
+		}
+
+		uint32_t instance_count = to_u32(instance_end - i);
+
+		// Gather the model matrices first, so that the instance buffer is written once
+		auto models = command_buffer.get_arena().allocate<glm::mat4>(instance_count);
+		for (uint32_t instance = 0; instance < instance_count; ++instance)
+		{
+			models[instance] = draws[i + instance].node->get_transform().get_world_matrix();
+		}
 
-		draw_submesh(command_buffer, *node_it->second.second, front_face);
+		auto instance_buffer = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, instance_count * sizeof(glm::mat4), thread_index);
+		instance_buffer.update(reinterpret_cast<const uint8_t *>(models), instance_count * sizeof(glm::mat4));
+
+		draw_submesh(command_buffer, sub_mesh, front_face, &instance_buffer, instance_count);
+
+		i = instance_end;
 	}
+}
+
+void GeometrySubpass::record_draws_secondary(CommandBuffer &primary_command_buffer, const DrawList &draws, size_t transparent_start)
+{
+	// A range of draws recorded in one secondary command buffer
+	struct DrawRange
+	{
+		size_t draw_start;
+
+		size_t draw_end;
+
+		bool transparent;
+	};
 
-	// Enable alpha blending
-	ColorBlendAttachmentState color_blend_attachment{};
-	color_blend_attachment.blend_enable           = VK_TRUE;
-	color_blend_attachment.src_color_blend_factor = VK_BLEND_FACTOR_SRC_ALPHA;
-	color_blend_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	auto &render_frame = render_context.get_active_frame();
 
-	ColorBlendState color_blend_state{};
-	color_blend_state.attachments.resize(get_output_attachments().size());
-	color_blend_state.attachments[0] = color_blend_attachment;
-	command_buffer.set_color_blend_state(color_blend_state);
+	// Split the opaque and transparent draws into balanced ranges, the first ones taking the draws left over.
+	// Transparent ranges come last, so that executing the buffers in order keeps the blending order
+	ArenaVector<DrawRange> ranges{primary_command_buffer.get_arena()};
 
-	command_buffer.set_depth_stencil_state(get_depth_stencil_state());
+	auto split_draws = [this, &ranges](size_t start, size_t end, bool transparent) {
+		size_t count       = end - start;
+		size_t range_count = std::min<size_t>(std::max(secondary_command_buffer_count, 1U), count);
+		size_t draw_start  = start;
 
-	// Draw transparent objects in back-to-front order
-	for (auto node_it = transparent_nodes.rbegin(); node_it != transparent_nodes.rend(); node_it++)
+		for (size_t i = 0; i < range_count; i++)
+		{
+			size_t draw_end = draw_start + count / range_count + (i < count % range_count ? 1 : 0);
+
+			ranges.push_back({draw_start, draw_end, transparent});
+
+			draw_start = draw_end;
+		}
+	};
+
+	split_draws(0, transparent_start, false);
+	split_draws(transparent_start, draws.size(), true);
+
+	avg_draws_per_buffer = ranges.empty() ? 0 : static_cast<float>(draws.size()) / ranges.size();
+
+	auto record_range = [this, &primary_command_buffer, &draws](const DrawRange &range, size_t thread_index) {
+		auto &secondary_command_buffer = primary_command_buffer.request_secondary_command_buffer(thread_index);
+
+		bind_draw_resources(secondary_command_buffer);
+
+		record_draws(secondary_command_buffer, draws, range.draw_start, range.draw_end, range.transparent, thread_index);
+
+		secondary_command_buffer.end();
+
+		return &secondary_command_buffer;
+	};
+
+	std::vector<CommandBuffer *> secondary_command_buffers;
+	secondary_command_buffers.reserve(ranges.size());
+
+	// Worker threads use the render frame resources matching their index
+	size_t thread_count = std::min(render_frame.get_thread_count(), ranges.size());
+
+	if (multi_threading && thread_count > 1)
+	{
+		if (!thread_pool)
+		{
+			thread_pool = std::make_unique<ctpl::thread_pool>(static_cast<int>(thread_count));
+		}
+		else if (static_cast<size_t>(thread_pool->size()) != thread_count)
+		{
+			thread_pool->resize(static_cast<int>(thread_count));
+		}
+
+		std::vector<std::future<CommandBuffer *>> secondary_command_buffer_futures;
+		secondary_command_buffer_futures.reserve(ranges.size());
+
+		for (auto &range : ranges)
+		{
+			secondary_command_buffer_futures.push_back(thread_pool->push([&record_range, &range](size_t thread_index) {
+				return record_range(range, thread_index);
+			}));
+		}
+
+		for (auto &future : secondary_command_buffer_futures)
+		{
+			secondary_command_buffers.push_back(future.get());
+		}
+	}
+	else
 	{
-		update_uniform(command_buffer, *node_it->second.first);
+		for (auto &range : ranges)
+		{
+			secondary_command_buffers.push_back(record_range(range, 0));
+		}
+	}
 
-		draw_submesh(command_buffer, *node_it->second.second);
+	if (!secondary_command_buffers.empty())
+	{
+		primary_command_buffer.execute_commands(secondary_command_buffers);
 	}
 }
 
@@ -157,7 +1300,15 @@ void GeometrySubpass::update_uniform(CommandBuffer &command_buffer, sg::Node &no
 	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 1, 0);
 }
 
-void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face)
+void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face,
+                                   BufferAllocation *instance_buffer, uint32_t instance_count)
+{
+	bind_submesh(command_buffer, sub_mesh, front_face, instance_buffer);
+
+	draw_submesh_command(command_buffer, sub_mesh, instance_count);
+}
+
+void GeometrySubpass::bind_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, BufferAllocation *instance_buffer)
 {
 	auto &device = command_buffer.get_device();
 
@@ -171,8 +1322,9 @@ void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &s
 
 	command_buffer.set_rasterization_state(rasterization_state);
 
-	auto &vert_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), sub_mesh.get_shader_variant());
-	auto &frag_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), sub_mesh.get_shader_variant());
+	auto &variant            = get_shader_variant(sub_mesh);
+	auto &vert_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
+	auto &frag_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
 
 	std::vector<ShaderModule *> shader_modules{&vert_shader_module, &frag_shader_module};
 
@@ -187,17 +1339,41 @@ void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &s
 	pbr_material_uniform.metallic_factor   = pbr_material->metallic_factor;
 	pbr_material_uniform.roughness_factor  = pbr_material->roughness_factor;
 
-	command_buffer.push_constants_accumulated(pbr_material_uniform);
+	if (bindless_descriptor_set)
+	{
+		// Textures are selected by index in the array bound at set 1
+		command_buffer.bind_descriptor_set(1, *bindless_descriptor_set);
+
+		BindlessPBRMaterialUniform bindless_material_uniform{};
+		bindless_material_uniform.material = pbr_material_uniform;
 
-	auto &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(0);
+		auto &textures   = sub_mesh.get_material()->textures;
+		auto  texture_it = textures.find("base_color_texture");
+		if (texture_it != textures.end())
+		{
+			auto index_it = bindless_texture_indices.find(texture_it->second);
+			if (index_it != bindless_texture_indices.end())
+			{
+				bindless_material_uniform.base_color_texture_index = index_it->second;
+			}
+		}
 
-	for (auto &texture : sub_mesh.get_material()->textures)
+		command_buffer.push_constants_accumulated(bindless_material_uniform);
+	}
+	else
 	{
-		if (auto layout_binding = descriptor_set_layout.get_layout_binding(texture.first))
+		command_buffer.push_constants_accumulated(pbr_material_uniform);
+
+		auto &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(0);
+
+		for (auto &texture : sub_mesh.get_material()->textures)
 		{
-			command_buffer.bind_image(texture.second->get_image()->get_vk_image_view(),
-			                          texture.second->get_sampler()->vk_sampler,
-			                          0, layout_binding->binding, 0);
+			if (auto layout_binding = descriptor_set_layout.get_layout_binding(texture.first))
+			{
+				command_buffer.bind_image(texture.second->get_image()->get_vk_image_view(),
+				                          texture.second->get_sampler()->vk_sampler,
+				                          0, layout_binding->binding, 0);
+			}
 		}
 	}
 
@@ -207,6 +1383,30 @@ void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &s
 
 	for (auto &input_resource : vertex_input_resources)
 	{
+		if (instance_buffer && input_resource.name == INSTANCE_MODEL_INPUT)
+		{
+			// The model matrix takes one location per column, and advances once per instance
+			for (uint32_t column = 0; column < 4; ++column)
+			{
+				VkVertexInputAttributeDescription instance_attribute{};
+				instance_attribute.binding  = input_resource.location;
+				instance_attribute.format   = VK_FORMAT_R32G32B32A32_SFLOAT;
+				instance_attribute.location = input_resource.location + column;
+				instance_attribute.offset   = to_u32(column * sizeof(glm::vec4));
+
+				vertex_input_state.attributes.push_back(instance_attribute);
+			}
+
+			VkVertexInputBindingDescription instance_binding{};
+			instance_binding.binding   = input_resource.location;
+			instance_binding.stride    = to_u32(sizeof(glm::mat4));
+			instance_binding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+			vertex_input_state.bindings.push_back(instance_binding);
+
+			continue;
+		}
+
 		sg::VertexAttribute attribute;
 
 		if (!sub_mesh.get_attribute(input_resource.name, attribute))
@@ -234,22 +1434,23 @@ void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &s
 	// Find submesh vertex buffers matching the shader input attribute names
 	for (auto &input_resource : vertex_input_resources)
 	{
+		if (instance_buffer && input_resource.name == INSTANCE_MODEL_INPUT)
+		{
+			command_buffer.bind_vertex_buffer(input_resource.location, instance_buffer->get_buffer(), instance_buffer->get_offset());
+			continue;
+		}
+
 		const auto &buffer_iter = sub_mesh.vertex_buffers.find(input_resource.name);
 
 		if (buffer_iter != sub_mesh.vertex_buffers.end())
 		{
-			std::vector<std::reference_wrapper<const core::Buffer>> buffers;
-			buffers.emplace_back(std::ref(buffer_iter->second));
-
 			// Bind vertex buffers only for the attribute locations defined
-			command_buffer.bind_vertex_buffers(input_resource.location, std::move(buffers), {0});
+			command_buffer.bind_vertex_buffer(input_resource.location, buffer_iter->second, 0);
 		}
 	}
-
-	draw_submesh_command(command_buffer, sub_mesh);
 }
 
-void GeometrySubpass::draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh)
+void GeometrySubpass::draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, uint32_t instance_count)
 {
 	// Draw submesh indexed if indices exists
 	if (sub_mesh.vertex_indices != 0)
@@ -258,12 +1459,12 @@ void GeometrySubpass::draw_submesh_command(CommandBuffer &command_buffer, sg::Su
 		command_buffer.bind_index_buffer(*sub_mesh.index_buffer, sub_mesh.index_offset, sub_mesh.index_type);
 
 		// Draw submesh using indexed data
-		command_buffer.draw_indexed(sub_mesh.vertex_indices, 1, 0, 0, 0);
+		command_buffer.draw_indexed(sub_mesh.vertex_indices, instance_count, 0, 0, 0);
 	}
 	else
 	{
 		// Draw submesh using vertices only
-		command_buffer.draw(sub_mesh.vertices_count, 1, 0, 0);
+		command_buffer.draw(sub_mesh.vertices_count, instance_count, 0, 0);
 	}
 }
 }        // namespace vkb
@@ -26,7 +26,17 @@ VKBP_DISABLE_WARNINGS()
 #include "common/glm_common.h"
 VKBP_ENABLE_WARNINGS()
 
+#include "common/frustum_culling.h"
+#include "common/linear_arena.h"
+#include "core/descriptor_pool.h"
+#include "core/descriptor_set.h"
 #include "rendering/subpass.h"
+#include "scene_graph/components/transform.h"
+
+namespace ctpl
+{
+class thread_pool;
+}
 
 namespace vkb
 {
@@ -37,6 +47,8 @@ class Node;
 class Mesh;
 class SubMesh;
 class Camera;
+class Light;
+class Texture;
 }        // namespace sg
 
 /**
@@ -63,12 +75,71 @@ struct PBRMaterialUniform
 	float roughness_factor;
 };
 
+/**
+ * @brief PBR material uniform for base shader with bindless textures,
+ *        indexing the scene texture array instead of binding textures per draw
+ */
+struct BindlessPBRMaterialUniform
+{
+	PBRMaterialUniform material;
+
+	uint32_t base_color_texture_index;
+};
+
+/**
+ * @brief Node drawn by the GPU, culled against the camera frustum by a compute shader.
+ *        The command index is ~0 if the node is drawn by the CPU
+ */
+struct alignas(16) DrawRecord
+{
+	glm::mat4 model;
+
+	glm::vec4 bounds_min;
+
+	glm::vec4 bounds_max;
+
+	uint32_t command_index;
+};
+
+/**
+ * @brief Frustum culling uniform for the cull compute shader
+ */
+struct alignas(16) CullUniform
+{
+	glm::vec4 frustum_planes[6];
+
+	uint32_t record_count;
+};
+
 /**
  * @brief This subpass is responsible for rendering a Scene
  */
-class GeometrySubpass : public Subpass
+class GeometrySubpass : public Subpass, public sg::TransformObserver
 {
   public:
+	/**
+	 * @brief A sub mesh drawn for a scene node, with the key it is sorted by
+	 *
+	 * Opaque keys sort by pipeline, then material, then front-to-back distance,
+	 * so that draws sharing state are recorded together. With instancing, the
+	 * sub mesh comes before a coarser distance, so that its instances are next
+	 * to each other. Transparent keys have the top bit set and sort back-to-front
+	 * first, as blending requires.
+	 */
+	struct Draw
+	{
+		uint64_t sort_key;
+
+		sg::Node *node;
+
+		sg::SubMesh *sub_mesh;
+	};
+
+	/**
+	 * @brief Draws in the order they are recorded, allocated from the frame arena
+	 */
+	using DrawList = ArenaVector<Draw>;
+
 	/**
 	 * @brief Constructs a subpass for the geometry pass of Deferred rendering
 	 * @param render_context Render context
@@ -79,26 +150,203 @@ class GeometrySubpass : public Subpass
 	 */
 	GeometrySubpass(RenderContext &render_context, ShaderSource &&vertex_shader, ShaderSource &&fragment_shader, sg::Scene &scene, sg::Camera &camera);
 
-	virtual ~GeometrySubpass() = default;
+	virtual ~GeometrySubpass();
 
 	virtual void prepare() override;
 
 	/**
-	 * @brief Record draw commands
+	 * @brief Culls the GPU driven draws with a compute shader, if GPU driven drawing is enabled
+	 */
+	virtual void pre_render_pass(CommandBuffer &command_buffer) override;
+
+	/**
+	 * @brief Record draw commands, either inline or split into secondary command buffers
+	 *        depending on the contents of the current subpass
 	 */
 	virtual void draw(CommandBuffer &command_buffer) override;
 
+	/**
+	 * @return Secondary command buffers if the draws are split into any
+	 */
+	virtual VkSubpassContents get_subpass_contents() const override;
+
+	/**
+	 * @brief Sets how many secondary command buffers the draws are split into.
+	 *        By default there is one per thread of the render frames, if they have more than one
+	 * @param count Number of secondary command buffers for opaque draws, and at most as many for
+	 *        transparent draws. If 0, the draws are recorded inline in the primary command buffer
+	 */
+	void set_secondary_command_buffer_count(uint32_t count);
+
+	uint32_t get_secondary_command_buffer_count() const;
+
+	/**
+	 * @brief Sets whether secondary command buffers are recorded in parallel, on at most
+	 *        as many worker threads as the render frame has resources for
+	 * @param enable Whether to record on worker threads
+	 */
+	void set_multi_threading(bool enable);
+
+	bool is_multi_threading() const;
+
+	/**
+	 * @return The average number of draws per secondary command buffer in the last frame
+	 */
+	float get_avg_draws_per_buffer() const;
+
 	void update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index = 0);
 
-	void draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE);
+	/**
+	 * @brief Records the state and the draw of a sub mesh
+	 * @param command_buffer The command buffer to record
+	 * @param sub_mesh The sub mesh to draw
+	 * @param front_face The front face of the node drawn
+	 * @param instance_buffer Model matrices of the instances to draw, if instancing is enabled
+	 * @param instance_count The number of instances to draw
+	 */
+	void draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+	                  BufferAllocation *instance_buffer = nullptr, uint32_t instance_count = 1);
+
+	/**
+	 * @brief Enables bindless textures: all scene textures are written once into a sampled
+	 *        image array at set 1, and each draw selects its textures with push constants,
+	 *        so no descriptor set is created per material. Must be called before prepare.
+	 *        Falls back to binding textures per draw if the device does not support it
+	 * @param enable Whether to use bindless textures
+	 */
+	void set_bindless_textures(bool enable);
+
+	/**
+	 * @return Whether bindless textures are in use, which is only known after prepare
+	 */
+	bool is_bindless_textures() const;
+
+	/**
+	 * @brief Enables automatic instancing: consecutive sorted draws of the same sub mesh are
+	 *        recorded as a single instanced draw, which reads the model matrix of each node from
+	 *        a per-frame instance buffer. Disabled by default, must be called before prepare.
+	 *        Falls back to one draw per node if the vertex shader does not declare the instance_model input
+	 * @param enable Whether to instance draws
+	 */
+	void set_instancing(bool enable);
+
+	/**
+	 * @return Whether draws are instanced, which is only known after prepare
+	 */
+	bool is_instancing() const;
+
+	/**
+	 * @brief Enables frustum culling: nodes are not drawn if the world bounds of their mesh are outside
+	 *        the camera frustum. The world bounds are kept until the transform of their node changes
+	 * @param enable Whether to cull nodes outside the frustum
+	 */
+	void set_frustum_culling(bool enable);
+
+	bool is_frustum_culling() const;
+
+	/**
+	 * @brief Enables hierarchical culling: nodes are culled by querying the bounding volume hierarchy
+	 *        of the scene, which skips whole groups of nodes and only refits the bounds of the nodes
+	 *        which moved. Suits scenes with many nodes. Must be called before prepare
+	 * @param enable Whether to cull with the scene BVH rather than node by node
+	 */
+	void set_hierarchical_culling(bool enable);
+
+	bool is_hierarchical_culling() const;
+
+	/**
+	 * @return The mesh instances drawn and culled by the last draw
+	 */
+	const CullingCounters &get_culling_counters() const;
+
+	/**
+	 * @brief Enables GPU driven drawing: before the render pass, a compute shader culls the opaque
+	 *        indexed draws against the camera frustum and writes the model matrices of the visible
+	 *        nodes, and the instance count of one indirect draw per sub mesh. The CPU then records
+	 *        one draw per sub mesh, whatever the number of nodes. Must be called before prepare.
+	 *        Falls back to CPU drawing if instancing is disabled or indirect draws cannot start at
+	 *        an instance other than 0
+	 * @param enable Whether to drive draws from the GPU
+	 */
+	void set_gpu_driven(bool enable);
+
+	/**
+	 * @return Whether draws are driven by the GPU, which is only known after prepare
+	 */
+	bool is_gpu_driven() const;
+
+	/**
+	 * @brief Marks the draw records of the GPU driven nodes of the transform out of date in every render frame
+	 */
+	virtual void on_world_matrix_invalidated(sg::Transform &transform) override;
 
   protected:
 	/**
-	 * @brief Sorts objects based on distance from camera and classifies them
-	 *        into opaque and transparent in the arrays provided
+	 * @brief Completes the shader variants which derived subpasses prepared, compiles them and
+	 *        builds their modules, then prepares the sort keys, the world bounds and the GPU driven
+	 *        draws. Derived subpasses cannot skip it
 	 */
-	void get_sorted_nodes(std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes,
-	                      std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes);
+	virtual void finish_prepare() override final;
+
+	/**
+	 * @return The shader variant of the sub mesh, with the defines of the options of this subpass
+	 */
+	const ShaderVariant &get_shader_variant(const sg::SubMesh &sub_mesh) const;
+
+	/**
+	 * @return Whether the sub mesh of a mesh is drawn by the GPU for the node in this frame
+	 */
+	bool is_gpu_draw(size_t mesh_index, size_t sub_mesh_index, sg::Node &node) const;
+
+	/**
+	 * @brief Writes the draw records of the nodes which moved since the render frame was last drawn
+	 */
+	void update_indirect_records(uint32_t frame_index);
+
+	/**
+	 * @brief Records the indirect draw of each GPU driven sub mesh
+	 */
+	void record_indirect_draws(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Transforms the bounds of the nodes whose world matrix changed since the last frame
+	 */
+	void update_world_bounds();
+
+	/**
+	 * @brief Lists the scene lights which may light what the camera sees. With hierarchical culling,
+	 *        the lights whose range is outside the camera frustum are found with the scene BVH and left out
+	 */
+	std::vector<sg::Light *> get_visible_lights();
+
+	/**
+	 * @brief Lists a draw for each sub mesh of each visible scene node, sorted by their key
+	 * @param draws The list to fill, opaque draws first
+	 * @return The index of the first transparent draw
+	 */
+	size_t get_sorted_draws(DrawList &draws);
+
+	/**
+	 * @brief Binds the resources shared by all draws, once per command buffer they are recorded in
+	 */
+	virtual void bind_draw_resources(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Records a range of draws
+	 * @param command_buffer The command buffer to record
+	 * @param draws The sorted draws
+	 * @param draw_start Index of the first draw
+	 * @param draw_end Index of the draw where recording stops (not included)
+	 * @param transparent Whether the draws are blended
+	 * @param thread_index Identifies the resources allocated for this thread
+	 */
+	void record_draws(CommandBuffer &command_buffer, const DrawList &draws, size_t draw_start, size_t draw_end, bool transparent, size_t thread_index = 0);
+
+	/**
+	 * @brief Splits the draws into balanced ranges, records each range in a secondary command buffer,
+	 *        possibly on worker threads, and executes them in order
+	 */
+	void record_draws_secondary(CommandBuffer &primary_command_buffer, const DrawList &draws, size_t transparent_start);
 
 	sg::Camera &camera;
 
@@ -107,7 +355,186 @@ class GeometrySubpass : public Subpass
 	sg::Scene &scene;
 
   private:
-	void draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh);
+	/**
+	 * @brief Copies the shader variant of each sub mesh, so that the defines of the options of
+	 *        this subpass are not added to the variants the sub meshes share with other subpasses
+	 */
+	void prepare_shader_variants();
+
+	/**
+	 * @brief Assigns each scene texture an index in the bindless texture array and adds
+	 *        the array size to the shader variants of this subpass, if bindless textures are enabled
+	 */
+	void prepare_bindless_textures();
+
+	/**
+	 * @brief Writes all scene textures to the bindless descriptor set, once the shader modules exist
+	 */
+	void create_bindless_descriptor_set();
+
+	/**
+	 * @brief Adds the instancing define to the shader variants of this subpass, if instancing is enabled
+	 */
+	void prepare_instancing();
+
+	/**
+	 * @brief Disables instancing if the vertex shaders do not read the instance model matrix,
+	 *        once the shader modules exist
+	 */
+	void check_instance_input();
+
+	/**
+	 * @brief Assigns each sub mesh the pipeline and material ids its draws are sorted by,
+	 *        once the shader variants are final
+	 */
+	void prepare_sort_keys();
+
+	/**
+	 * @brief Assigns an indirect command and a range of instances to each opaque indexed sub mesh,
+	 *        and creates the buffers of the records and commands, if GPU driven drawing is enabled
+	 */
+	void prepare_gpu_driven();
+
+	/**
+	 * @brief Assigns each node of each mesh its world bounds, and its object in the scene BVH
+	 *        if hierarchical culling is enabled
+	 */
+	void prepare_world_bounds();
+
+	/**
+	 * @brief Records the state of a sub mesh, and binds its vertex buffers and the instance buffer
+	 */
+	void bind_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, BufferAllocation *instance_buffer);
+
+	void draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, uint32_t instance_count = 1);
+
+	bool bindless_textures{false};
+
+	bool instancing{false};
+
+	bool frustum_culling{true};
+
+	/// World bounds of the mesh of each node, the nodes of each mesh being consecutive
+	BoundsArray world_bounds;
+
+	/// Version of the world matrix each bounds were computed from
+	std::vector<uint32_t> world_bounds_versions;
+
+	/// Index of the world bounds of the first node of each mesh
+	std::vector<size_t> mesh_bounds_offsets;
+
+	bool hierarchical_culling{false};
+
+	/// Mesh instances drawn and culled by the last draw
+	CullingCounters culling_counters{};
+
+	/// Index of the world bounds of each object of the scene BVH
+	std::vector<size_t> bvh_object_bounds_indices;
+
+	/// Object of the scene BVH for each world bounds
+	std::vector<uint32_t> bounds_bvh_objects;
+
+	/// Object of the scene BVH for each scene light, if its range is bounded
+	std::vector<uint32_t> light_bvh_objects;
+
+	/// Objects found by the last frustum query, kept to reuse the memory
+	std::vector<uint32_t> visible_bvh_objects;
+
+	bool gpu_driven{false};
+
+	/**
+	 * @brief Sub mesh drawn with an indirect command, instanced for the visible nodes of its mesh
+	 */
+	struct IndirectDraw
+	{
+		sg::Mesh *mesh;
+
+		sg::SubMesh *sub_mesh;
+
+		uint32_t first_instance;
+	};
+
+	std::vector<IndirectDraw> indirect_draws;
+
+	/// Index of the indirect draw of each sub mesh, or -1 if drawn by the CPU, indexed like meshes and their sub meshes
+	std::vector<std::vector<int32_t>> indirect_draw_indices;
+
+	/// Number of instances of all indirect draws, if every node is visible, which is also the number of draw records
+	uint32_t indirect_instance_count{0};
+
+	/**
+	 * @brief Node of a mesh with indirect draws, whose records are rewritten when its transform changes
+	 */
+	struct IndirectNode
+	{
+		sg::Node *node;
+
+		size_t mesh_index;
+
+		uint32_t node_index;
+	};
+
+	std::vector<IndirectNode> indirect_nodes;
+
+	/// Indirect nodes placed by each transform observed
+	std::unordered_map<sg::Transform *, std::vector<uint32_t>> indirect_transform_nodes;
+
+	/**
+	 * @brief Buffers of a render frame read and written by the cull shader, kept across frames
+	 */
+	struct IndirectFrame
+	{
+		/// A record per node and indirect draw, at the instance index of the node in the draw
+		std::unique_ptr<core::Buffer> record_buffer;
+
+		/// Indirect commands, reset from the seed commands before culling
+		std::unique_ptr<core::Buffer> command_buffer;
+
+		/// Model matrices of the visible nodes, packed from the first instance of each command
+		std::unique_ptr<core::Buffer> instance_buffer;
+
+		/// Indirect nodes whose records are out of date in this frame
+		std::vector<uint32_t> dirty_nodes;
+
+		std::vector<bool> dirty;
+	};
+
+	/// Buffers of each render frame, as the GPU may still read those of the other frames
+	std::vector<IndirectFrame> indirect_frames;
+
+	/// Indirect commands without instances, written once and copied over the commands of a frame before culling
+	std::unique_ptr<core::Buffer> indirect_seed_buffer;
+
+	ShaderSource cull_shader;
+
+	/// Commands and instance model matrices of the active frame, written by the cull shader
+	BufferAllocation indirect_command_buffer;
+
+	BufferAllocation indirect_instance_buffer;
+
+	/// Shader variant of each sub mesh, with the defines of the options of this subpass
+	std::unordered_map<const sg::SubMesh *, ShaderVariant> shader_variants;
+
+	/// Index of each scene texture in the bindless texture array
+	std::unordered_map<sg::Texture *, uint32_t> bindless_texture_indices;
+
+	std::unique_ptr<DescriptorPool> bindless_descriptor_pool;
+
+	std::unique_ptr<DescriptorSet> bindless_descriptor_set;
+
+	/// Pipeline, material and sub mesh ids of each sub mesh, indexed like meshes and their sub meshes
+	std::vector<std::vector<uint64_t>> sub_mesh_state_keys;
+
+	/// Number of draws in the scene, one per sub mesh of each node
+	size_t draw_count{0};
+
+	uint32_t secondary_command_buffer_count{0};
+
+	bool multi_threading{false};
+
+	float avg_draws_per_buffer{0};
+
+	std::unique_ptr<ctpl::thread_pool> thread_pool;
 };
 
 }        // namespace vkb
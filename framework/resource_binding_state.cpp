@@ -20,8 +20,43 @@
 
 #include "resource_binding_state.h"
 
+#include "common/helpers.h"
+
 namespace vkb
 {
+namespace
+{
+inline size_t hash_resource_info(uint32_t binding, uint32_t array_element, const ResourceInfo &resource_info)
+{
+	size_t result{0};
+
+	hash_combine(result, binding);
+	hash_combine(result, array_element);
+	hash_combine(result, resource_info.buffer);
+	hash_combine(result, resource_info.range);
+	hash_combine(result, resource_info.image_view);
+	hash_combine(result, resource_info.sampler);
+
+	return result;
+}
+
+inline size_t hash_buffer_offset(uint32_t binding, uint32_t array_element, const ResourceInfo &resource_info)
+{
+	if (resource_info.buffer == nullptr)
+	{
+		return 0;
+	}
+
+	size_t result{0};
+
+	hash_combine(result, binding);
+	hash_combine(result, array_element);
+	hash_combine(result, resource_info.offset);
+
+	return result;
+}
+}        // namespace
+
 void ResourceBindingState::reset()
 {
 	clear_dirty();
@@ -75,6 +110,9 @@ void ResourceSet::reset()
 	clear_dirty();
 
 	resource_bindings.clear();
+
+	hash        = 0;
+	offset_hash = 0;
 }
 
 bool ResourceSet::is_dirty() const
@@ -89,32 +127,50 @@ void ResourceSet::clear_dirty()
 
 void ResourceSet::clear_dirty(uint32_t binding, uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty = false;
+	request_resource_info(binding, array_element).dirty = false;
 }
 
 void ResourceSet::bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t binding, uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty  = true;
-	resource_bindings[binding][array_element].buffer = &buffer;
-	resource_bindings[binding][array_element].offset = offset;
-	resource_bindings[binding][array_element].range  = range;
+	auto &current_info = request_resource_info(binding, array_element);
+
+	ResourceInfo resource_info = current_info;
+
+	resource_info.dirty  = true;
+	resource_info.buffer = &buffer;
+	resource_info.offset = offset;
+	resource_info.range  = range;
+
+	update_hash(binding, array_element, current_info, resource_info);
 
 	dirty = true;
 }
 
 void ResourceSet::bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t binding, uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty      = true;
-	resource_bindings[binding][array_element].image_view = &image_view;
-	resource_bindings[binding][array_element].sampler    = &sampler;
+	auto &current_info = request_resource_info(binding, array_element);
+
+	ResourceInfo resource_info = current_info;
+
+	resource_info.dirty      = true;
+	resource_info.image_view = &image_view;
+	resource_info.sampler    = &sampler;
+
+	update_hash(binding, array_element, current_info, resource_info);
 
 	dirty = true;
 }
 
 void ResourceSet::bind_input(const core::ImageView &image_view, const uint32_t binding, const uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty      = true;
-	resource_bindings[binding][array_element].image_view = &image_view;
+	auto &current_info = request_resource_info(binding, array_element);
+
+	ResourceInfo resource_info = current_info;
+
+	resource_info.dirty      = true;
+	resource_info.image_view = &image_view;
+
+	update_hash(binding, array_element, current_info, resource_info);
 
 	dirty = true;
 }
@@ -124,4 +180,35 @@ const BindingMap<ResourceInfo> &ResourceSet::get_resource_bindings() const
 	return resource_bindings;
 }
 
+size_t ResourceSet::get_hash(bool include_buffer_offsets) const
+{
+	return include_buffer_offsets ? hash ^ offset_hash : hash;
+}
+
+ResourceInfo &ResourceSet::request_resource_info(uint32_t binding, uint32_t array_element)
+{
+	auto res_ins_it = resource_bindings[binding].emplace(array_element, ResourceInfo{});
+
+	if (res_ins_it.second)
+	{
+		// New resources are folded into the hash so that update_hash can remove them later
+		hash ^= hash_resource_info(binding, array_element, res_ins_it.first->second);
+		offset_hash ^= hash_buffer_offset(binding, array_element, res_ins_it.first->second);
+	}
+
+	return res_ins_it.first->second;
+}
+
+void ResourceSet::update_hash(uint32_t binding, uint32_t array_element, ResourceInfo &current_info, const ResourceInfo &resource_info)
+{
+	// Replace the contribution of the previous resource with the new one
+	hash ^= hash_resource_info(binding, array_element, current_info);
+	hash ^= hash_resource_info(binding, array_element, resource_info);
+
+	offset_hash ^= hash_buffer_offset(binding, array_element, current_info);
+	offset_hash ^= hash_buffer_offset(binding, array_element, resource_info);
+
+	current_info = resource_info;
+}
+
 }        // namespace vkb
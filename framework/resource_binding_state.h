@@ -72,10 +72,28 @@ class ResourceSet
 
 	const BindingMap<ResourceInfo> &get_resource_bindings() const;
 
+	/**
+	 * @brief Returns a hash of the bound resources, kept up to date as resources are bound
+	 *        so that a matching descriptor set can be found without walking the bindings
+	 * @param include_buffer_offsets Whether buffer offsets are part of the hash. Offsets of
+	 *        dynamic buffers are supplied when binding the descriptor set, so they can be left out
+	 */
+	size_t get_hash(bool include_buffer_offsets = true) const;
+
   private:
+	ResourceInfo &request_resource_info(uint32_t binding, uint32_t array_element);
+
+	void update_hash(uint32_t binding, uint32_t array_element, ResourceInfo &current_info, const ResourceInfo &resource_info);
+
 	bool dirty{false};
 
 	BindingMap<ResourceInfo> resource_bindings;
+
+	/// Order independent hash of the bound resources, excluding buffer offsets
+	size_t hash{0};
+
+	/// Order independent hash of the buffer offsets
+	size_t offset_hash{0};
 };
 
 /**
@@ -20,6 +20,8 @@
 
 #include "resource_cache.h"
 
+#include <ctpl_stl.h>
+
 #include "common/resource_caching.h"
 #include "core/device.h"
 
@@ -27,14 +29,29 @@ namespace vkb
 {
 namespace
 {
-template <class T, class... A>
-T &request_resource(Device &device, ResourceRecord &recorder, std::mutex &resource_mutex, std::unordered_map<std::size_t, T> &resources, A &... args)
+/**
+ * @brief Fallbacks are keyed by everything a draw binds with the state of its own pipeline,
+ *        so that descriptor sets, push constants and vertex buffers stay valid for the fallback
+ */
+inline size_t hash_fallback_key(const PipelineState &pipeline_state)
 {
-	std::lock_guard<std::mutex> guard(resource_mutex);
+	size_t result = 0;
 
-	auto &res = request_resource(device, &recorder, resources, args...);
+	hash_combine(result, pipeline_state.get_render_pass()->get_handle());
+	hash_combine(result, pipeline_state.get_subpass_index());
+	hash_combine(result, pipeline_state.get_pipeline_layout().get_handle());
+
+	for (auto &attribute : pipeline_state.get_vertex_input_state().attributes)
+	{
+		hash_combine(result, attribute);
+	}
+
+	for (auto &binding : pipeline_state.get_vertex_input_state().bindings)
+	{
+		hash_combine(result, binding);
+	}
 
-	return res;
+	return result;
 }
 }        // namespace
 
@@ -43,16 +60,47 @@ ResourceCache::ResourceCache(Device &device) :
 {
 }
 
-void ResourceCache::warmup(const std::vector<uint8_t> &data)
+ResourceCache::~ResourceCache()
+{
+	set_async_pipeline_compilation(false);
+}
+
+bool ResourceCache::warmup(const uint8_t *data, size_t size)
 {
-	recorder.set_data(data);
+	std::unique_ptr<RecordReader> reader;
+
+	try
+	{
+		reader = std::make_unique<RecordReader>(data, size, device.get_properties());
+	}
+	catch (const std::runtime_error &e)
+	{
+		LOGW("Resource cache warmup skipped: {}", e.what());
+		return false;
+	}
+
+	try
+	{
+		replayer.play(*this, *reader);
+	}
+	catch (const std::runtime_error &e)
+	{
+		// Objects created before the error stay cached, the others are created on first use
+		LOGW("Resource cache warmup stopped: {}", e.what());
+		return false;
+	}
 
-	replayer.play(*this, recorder);
+	return true;
 }
 
-std::vector<uint8_t> ResourceCache::serialize()
+bool ResourceCache::warmup(const std::vector<uint8_t> &data)
 {
-	return recorder.get_data();
+	return warmup(data.data(), data.size());
+}
+
+std::vector<uint8_t> ResourceCache::serialize(RecordCompression compression)
+{
+	return recorder.get_data(device.get_properties(), compression);
 }
 
 void ResourceCache::set_pipeline_cache(VkPipelineCache new_pipeline_cache)
@@ -60,50 +108,243 @@ void ResourceCache::set_pipeline_cache(VkPipelineCache new_pipeline_cache)
 	pipeline_cache = new_pipeline_cache;
 }
 
+SpirvCache &ResourceCache::get_spirv_cache()
+{
+	return spirv_cache;
+}
+
 ShaderModule &ResourceCache::request_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant)
 {
 	std::string entry_point{"main"};
-	return request_resource(device, recorder, shader_module_mutex, state.shader_modules, stage, glsl_source, entry_point, shader_variant);
+	return request_resource(device, &recorder, state.shader_modules, stage, glsl_source, entry_point, shader_variant);
 }
 
 PipelineLayout &ResourceCache::request_pipeline_layout(const std::vector<ShaderModule *> &shader_modules, bool use_dynamic_resources)
 {
-	return request_resource(device, recorder, pipeline_layout_mutex, state.pipeline_layouts, shader_modules, use_dynamic_resources);
+	return request_resource(device, &recorder, state.pipeline_layouts, shader_modules, use_dynamic_resources);
 }
 
 DescriptorSetLayout &ResourceCache::request_descriptor_set_layout(const std::vector<ShaderResource> &set_resources, bool use_dynamic_resources)
 {
-	return request_resource(device, recorder, descriptor_set_layout_mutex, state.descriptor_set_layouts, set_resources, use_dynamic_resources);
+	return request_resource(device, &recorder, state.descriptor_set_layouts, set_resources, use_dynamic_resources);
 }
 
 GraphicsPipeline &ResourceCache::request_graphics_pipeline(PipelineState &pipeline_state)
 {
-	return request_resource(device, recorder, graphics_pipeline_mutex, state.graphics_pipelines, pipeline_cache, pipeline_state);
+	return request_resource(device, &recorder, state.graphics_pipelines, pipeline_cache, pipeline_state);
+}
+
+GraphicsPipelineRequest ResourceCache::request_graphics_pipeline_async(PipelineState &pipeline_state)
+{
+	assert(compile_pool && "Asynchronous pipeline compilation is not enabled");
+
+	std::size_t hash{0U};
+	hash_param(hash, pipeline_cache, pipeline_state);
+
+	if (auto pipeline = state.graphics_pipelines.find(hash))
+	{
+		state.graphics_pipelines.record_hit();
+
+		return {pipeline, true};
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(pending_mutex);
+
+		if (pending_pipelines.insert(hash).second)
+		{
+			++pending_tasks;
+
+			compile_pool->push([this, hash, cache = pipeline_cache, compile_state = pipeline_state](size_t) mutable {
+				bool compiled = false;
+
+				try
+				{
+					request_resource(device, &recorder, state.graphics_pipelines, cache, compile_state);
+
+					compiled = true;
+				}
+				catch (const std::exception &e)
+				{
+					LOGE("Background pipeline compilation failed: {}", e.what());
+				}
+
+				std::lock_guard<std::mutex> lock(pending_mutex);
+
+				// Failed pipelines stay pending, so that draws keep using the fallback
+				if (compiled)
+				{
+					pending_pipelines.erase(hash);
+					++compiled_pipeline_count;
+				}
+
+				--pending_tasks;
+				pending_condition.notify_all();
+			});
+		}
+
+		auto fallback_it = fallback_pipelines.find(hash_fallback_key(pipeline_state));
+
+		// Looking the fallback up in the cache marks it as used, so that it is not evicted while draws use it
+		if (fallback_it != fallback_pipelines.end())
+		{
+			if (auto fallback = state.graphics_pipelines.find(fallback_it->second))
+			{
+				++fallback_draw_count;
+
+				return {fallback, false};
+			}
+		}
+	}
+
+	++skipped_draw_count;
+
+	return {};
 }
 
 ComputePipeline &ResourceCache::request_compute_pipeline(PipelineState &pipeline_state)
 {
-	return request_resource(device, recorder, compute_pipeline_mutex, state.compute_pipelines, pipeline_cache, pipeline_state);
+	return request_resource(device, &recorder, state.compute_pipelines, pipeline_cache, pipeline_state);
 }
 
 DescriptorSet &ResourceCache::request_descriptor_set(DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos)
 {
-	auto &descriptor_pool = request_resource(device, recorder, descriptor_set_mutex, state.descriptor_pools, descriptor_set_layout);
-	return request_resource(device, recorder, descriptor_set_mutex, state.descriptor_sets, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+	// Evicted descriptor sets are freed back to their pool, otherwise sets live as long as the pool
+	// and the pool does not need FREE_DESCRIPTOR_SET_BIT, which may cost memory or speed on some drivers
+	uint32_t                    pool_size  = DescriptorPool::MAX_SETS_PER_POOL;
+	VkDescriptorPoolCreateFlags pool_flags = descriptor_set_policy.is_enabled() ? VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT : 0;
+
+	auto &descriptor_pool = request_resource(device, &recorder, state.descriptor_pools, descriptor_set_layout, pool_size, pool_flags);
+
+	if (image_infos.empty())
+	{
+		return request_resource(device, &recorder, state.descriptor_sets, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+	}
+
+	// Sets referring to images are indexed when created, so update_descriptor_sets can find them
+	size_t key{0U};
+	hash_param(key, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+
+	bool cached = state.descriptor_sets.find(key) != nullptr;
+
+	auto &descriptor_set = request_resource(device, &recorder, state.descriptor_sets, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+
+	if (!cached)
+	{
+		index_descriptor_set(key, descriptor_set);
+	}
+
+	return descriptor_set;
 }
 
 RenderPass &ResourceCache::request_render_pass(const std::vector<Attachment> &attachments, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<SubpassInfo> &subpasses)
 {
-	return request_resource(device, recorder, render_pass_mutex, state.render_passes, attachments, load_store_infos, subpasses);
+	return request_resource(device, &recorder, state.render_passes, attachments, load_store_infos, subpasses);
 }
 
 Framebuffer &ResourceCache::request_framebuffer(const RenderTarget &render_target, const RenderPass &render_pass)
 {
-	return request_resource(device, recorder, framebuffer_mutex, state.framebuffers, render_target, render_pass);
+	return request_resource(device, &recorder, state.framebuffers, render_target, render_pass);
+}
+
+void ResourceCache::set_async_pipeline_compilation(bool enable)
+{
+	if (enable && !compile_pool)
+	{
+		// Leave a core to the recording thread
+		auto thread_count = std::thread::hardware_concurrency();
+		thread_count      = thread_count <= 1 ? 1 : thread_count - 1;
+
+		compile_pool = std::make_unique<ctpl::thread_pool>(thread_count);
+	}
+	else if (!enable && compile_pool)
+	{
+		wait_for_pipelines();
+
+		compile_pool.reset();
+	}
+}
+
+bool ResourceCache::is_async_pipeline_compilation() const
+{
+	return compile_pool != nullptr;
+}
+
+void ResourceCache::set_fallback_pipeline(GraphicsPipeline &pipeline)
+{
+	auto &pipeline_state = pipeline.get_state();
+
+	assert(pipeline_state.get_render_pass() && "A fallback pipeline needs a render pass");
+
+	std::size_t hash{0U};
+	hash_param(hash, pipeline_cache, pipeline_state);
+
+	assert(state.graphics_pipelines.find(hash) == &pipeline && "A fallback pipeline must be requested from the cache");
+
+	std::lock_guard<std::mutex> lock(pending_mutex);
+
+	fallback_pipelines[hash_fallback_key(pipeline_state)] = hash;
+}
+
+bool ResourceCache::has_fallback_pipeline(const PipelineState &pipeline_state) const
+{
+	std::lock_guard<std::mutex> lock(pending_mutex);
+
+	return fallback_pipelines.find(hash_fallback_key(pipeline_state)) != fallback_pipelines.end();
+}
+
+void ResourceCache::wait_for_pipelines()
+{
+	std::unique_lock<std::mutex> lock(pending_mutex);
+
+	pending_condition.wait(lock, [this] { return pending_tasks == 0; });
+}
+
+AsyncPipelineCounters ResourceCache::get_async_pipeline_counters() const
+{
+	AsyncPipelineCounters counters{};
+
+	{
+		std::lock_guard<std::mutex> lock(pending_mutex);
+
+		counters.pending = pending_tasks;
+	}
+
+	counters.compiled       = compiled_pipeline_count.load();
+	counters.fallback_draws = fallback_draw_count.load();
+	counters.skipped_draws  = skipped_draw_count.load();
+
+	return counters;
+}
+
+DescriptorPoolCounters ResourceCache::get_descriptor_pool_counters() const
+{
+	DescriptorPoolCounters counters{};
+
+	for (auto &descriptor_pool_it : state.descriptor_pools)
+	{
+		auto &pool_counters = descriptor_pool_it.second.get_counters();
+
+		counters.pools_created += pool_counters.pools_created;
+		counters.sets_allocated += pool_counters.sets_allocated;
+		counters.failed_allocations += pool_counters.failed_allocations;
+	}
+
+	return counters;
 }
 
 void ResourceCache::clear_pipelines()
 {
+	wait_for_pipelines();
+
+	{
+		std::lock_guard<std::mutex> lock(pending_mutex);
+
+		pending_pipelines.clear();
+
+		fallback_pipelines.clear();
+	}
+
 	state.graphics_pipelines.clear();
 	state.compute_pipelines.clear();
 }
@@ -114,17 +355,31 @@ void ResourceCache::update_descriptor_sets(const std::vector<core::ImageView> &o
 	std::vector<VkWriteDescriptorSet> set_updates;
 	std::set<size_t>                  matches;
 
+	std::lock_guard<std::mutex> lock(image_view_index_mutex);
+
 	for (size_t i = 0; i < old_views.size(); ++i)
 	{
 		auto &old_view = old_views[i];
 		auto &new_view = new_views[i];
 
-		for (auto &kd_pair : state.descriptor_sets)
+		auto index_it = image_view_descriptor_sets.find(old_view.get_handle());
+
+		if (index_it == image_view_descriptor_sets.end())
+		{
+			continue;
+		}
+
+		for (auto key : index_it->second)
 		{
-			auto &key            = kd_pair.first;
-			auto &descriptor_set = kd_pair.second;
+			auto descriptor_set = state.descriptor_sets.find(key);
+
+			// The set may have been evicted since it was indexed
+			if (descriptor_set == nullptr)
+			{
+				continue;
+			}
 
-			auto &image_infos = descriptor_set.get_image_infos();
+			auto &image_infos = descriptor_set->get_image_infos();
 
 			for (auto &ba_pair : image_infos)
 			{
@@ -148,12 +403,12 @@ void ResourceCache::update_descriptor_sets(const std::vector<core::ImageView> &o
 						{
 							VkWriteDescriptorSet write_descriptor_set{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
 
-							if (auto binding_info = descriptor_set.get_layout().get_layout_binding(binding))
+							if (auto binding_info = descriptor_set->get_layout().get_layout_binding(binding))
 							{
 								write_descriptor_set.dstBinding      = binding;
 								write_descriptor_set.descriptorType  = binding_info->descriptorType;
 								write_descriptor_set.pImageInfo      = &image_info;
-								write_descriptor_set.dstSet          = descriptor_set.get_handle();
+								write_descriptor_set.dstSet          = descriptor_set->get_handle();
 								write_descriptor_set.dstArrayElement = array_element;
 								write_descriptor_set.descriptorCount = 1;
 
@@ -168,6 +423,9 @@ void ResourceCache::update_descriptor_sets(const std::vector<core::ImageView> &o
 				}
 			}
 		}
+
+		// No cached set refers to the old view anymore
+		image_view_descriptor_sets.erase(index_it);
 	}
 
 	if (!set_updates.empty())
@@ -176,23 +434,85 @@ void ResourceCache::update_descriptor_sets(const std::vector<core::ImageView> &o
 		                       0, nullptr);
 	}
 
-	// Delete old entries (moved out descriptor sets)
+	// Move the updated sets out of the map, and remove their old entries with a single rebuild of its index
+	std::vector<std::pair<size_t, DescriptorSet>> updated_sets;
+	updated_sets.reserve(matches.size());
+
 	for (auto &match : matches)
 	{
-		// Move out of the map
-		auto it             = state.descriptor_sets.find(match);
-		auto descriptor_set = std::move(it->second);
-		state.descriptor_sets.erase(match);
+		updated_sets.emplace_back(match, std::move(*state.descriptor_sets.find(match)));
+	}
+
+	state.descriptor_sets.erase_all(matches);
+
+	for (auto &updated_set : updated_sets)
+	{
+		auto &descriptor_set = updated_set.second;
+
+		// Generate new key, matching the one computed by request_descriptor_set
+		size_t new_key = get_descriptor_set_key(descriptor_set);
 
-		// Generate new key
-		size_t new_key = 0U;
-		hash_param(new_key, descriptor_set.get_layout(), descriptor_set.get_buffer_infos(), descriptor_set.get_image_infos());
+		// Re-index the set under its new key, for the views it still refers to
+		for (auto &ba_pair : descriptor_set.get_image_infos())
+		{
+			for (auto &ai_pair : ba_pair.second)
+			{
+				auto &keys = image_view_descriptor_sets[ai_pair.second.imageView];
+				keys.erase(updated_set.first);
+				keys.insert(new_key);
+			}
+		}
 
 		// Add (key, resource) to the cache
 		state.descriptor_sets.emplace(new_key, std::move(descriptor_set));
 	}
 }
 
+size_t ResourceCache::get_descriptor_set_key(DescriptorSet &descriptor_set)
+{
+	size_t key{0U};
+
+	hash_param(key, descriptor_set.get_layout(), descriptor_set.get_pool(), descriptor_set.get_buffer_infos(), descriptor_set.get_image_infos());
+
+	return key;
+}
+
+void ResourceCache::index_descriptor_set(size_t key, DescriptorSet &descriptor_set)
+{
+	std::lock_guard<std::mutex> lock(image_view_index_mutex);
+
+	for (auto &ba_pair : descriptor_set.get_image_infos())
+	{
+		for (auto &ai_pair : ba_pair.second)
+		{
+			image_view_descriptor_sets[ai_pair.second.imageView].insert(key);
+		}
+	}
+}
+
+void ResourceCache::unindex_descriptor_set(size_t key, DescriptorSet &descriptor_set)
+{
+	std::lock_guard<std::mutex> lock(image_view_index_mutex);
+
+	for (auto &ba_pair : descriptor_set.get_image_infos())
+	{
+		for (auto &ai_pair : ba_pair.second)
+		{
+			auto index_it = image_view_descriptor_sets.find(ai_pair.second.imageView);
+
+			if (index_it != image_view_descriptor_sets.end())
+			{
+				index_it->second.erase(key);
+
+				if (index_it->second.empty())
+				{
+					image_view_descriptor_sets.erase(index_it);
+				}
+			}
+		}
+	}
+}
+
 void ResourceCache::clear_framebuffers()
 {
 	state.framebuffers.clear();
@@ -204,11 +524,125 @@ void ResourceCache::clear()
 	state.pipeline_layouts.clear();
 	state.descriptor_sets.clear();
 	state.descriptor_set_layouts.clear();
+
+	{
+		std::lock_guard<std::mutex> lock(image_view_index_mutex);
+		image_view_descriptor_sets.clear();
+	}
+
 	state.render_passes.clear();
 	clear_pipelines();
 	clear_framebuffers();
 }
 
+void ResourceCache::set_descriptor_set_policy(const EvictionPolicy &policy)
+{
+	descriptor_set_policy = policy;
+}
+
+void ResourceCache::set_framebuffer_policy(const EvictionPolicy &policy)
+{
+	framebuffer_policy = policy;
+}
+
+void ResourceCache::set_graphics_pipeline_policy(const EvictionPolicy &policy)
+{
+	graphics_pipeline_policy = policy;
+}
+
+uint64_t ResourceCache::begin_frame(uint64_t completed_frame)
+{
+	++frame_number;
+	completed_frame_number = std::max(completed_frame_number, completed_frame);
+
+	state.descriptor_sets.set_frame(frame_number);
+	state.framebuffers.set_frame(frame_number);
+	state.graphics_pipelines.set_frame(frame_number);
+
+	size_t evicted = state.descriptor_sets.evict(descriptor_set_policy);
+	evicted += state.framebuffers.evict(framebuffer_policy);
+
+	{
+		// Background compilations insert into the pipeline map, so eviction waits for a frame without any
+		std::lock_guard<std::mutex> lock(pending_mutex);
+
+		if (pending_tasks == 0)
+		{
+			size_t evicted_pipelines = state.graphics_pipelines.evict(graphics_pipeline_policy);
+
+			// Unregister the fallbacks which were evicted, as they will be destroyed
+			if (evicted_pipelines > 0)
+			{
+				for (auto it = fallback_pipelines.begin(); it != fallback_pipelines.end();)
+				{
+					if (state.graphics_pipelines.contains(it->second))
+					{
+						++it;
+					}
+					else
+					{
+						it = fallback_pipelines.erase(it);
+					}
+				}
+			}
+
+			evicted += evicted_pipelines;
+		}
+	}
+
+	if (evicted > 0)
+	{
+		LOGD("Retired {} cache objects at frame #{}", evicted, frame_number);
+	}
+
+	state.descriptor_sets.release_retired(completed_frame_number, [this](DescriptorSet &descriptor_set) {
+		size_t key = get_descriptor_set_key(descriptor_set);
+
+		// The key may have been requested again since the set was retired, with a new set to keep indexed
+		if (state.descriptor_sets.find(key) == nullptr)
+		{
+			unindex_descriptor_set(key, descriptor_set);
+		}
+
+		descriptor_set.get_pool().free(descriptor_set.get_handle());
+	});
+
+	for (auto &descriptor_pool_it : state.descriptor_pools)
+	{
+		descriptor_pool_it.second.begin_frame();
+	}
+	state.framebuffers.release_retired(completed_frame_number, [](Framebuffer &) {});
+	state.graphics_pipelines.release_retired(completed_frame_number, [](GraphicsPipeline &) {});
+
+	return frame_number;
+}
+
+std::map<std::string, ResourceUsage> ResourceCache::get_usage() const
+{
+	return {{"shader_modules", state.shader_modules.get_usage()},
+	        {"pipeline_layouts", state.pipeline_layouts.get_usage()},
+	        {"descriptor_set_layouts", state.descriptor_set_layouts.get_usage()},
+	        {"descriptor_pools", state.descriptor_pools.get_usage()},
+	        {"render_passes", state.render_passes.get_usage()},
+	        {"graphics_pipelines", state.graphics_pipelines.get_usage()},
+	        {"compute_pipelines", state.compute_pipelines.get_usage()},
+	        {"descriptor_sets", state.descriptor_sets.get_usage()},
+	        {"framebuffers", state.framebuffers.get_usage()}};
+}
+
+std::map<std::string, ResourceCounters> ResourceCache::get_counters() const
+{
+	return {{"shader_modules", state.shader_modules.get_counters()},
+	        {"pipeline_layouts", state.pipeline_layouts.get_counters()},
+	        {"descriptor_set_layouts", state.descriptor_set_layouts.get_counters()},
+	        {"descriptor_pools", state.descriptor_pools.get_counters()},
+	        {"render_passes", state.render_passes.get_counters()},
+	        {"graphics_pipelines", state.graphics_pipelines.get_counters()},
+	        {"compute_pipelines", state.compute_pipelines.get_counters()},
+	        {"descriptor_sets", state.descriptor_sets.get_counters()},
+	        {"framebuffers", state.framebuffers.get_counters()}};
+}
+
 const ResourceCacheState &ResourceCache::get_internal_state() const
 {
 	return state;
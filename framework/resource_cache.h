@@ -20,10 +20,19 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "common/helpers.h"
+#include "common/resource_map.h"
 #include "core/descriptor_pool.h"
 #include "core/descriptor_set.h"
 #include "core/descriptor_set_layout.h"
@@ -31,6 +40,12 @@
 #include "core/pipeline.h"
 #include "resource_record.h"
 #include "resource_replay.h"
+#include "spirv_cache.h"
+
+namespace ctpl
+{
+class thread_pool;
+}
 
 namespace vkb
 {
@@ -47,23 +62,53 @@ class ImageView;
  */
 struct ResourceCacheState
 {
-	std::unordered_map<std::size_t, ShaderModule> shader_modules;
+	ResourceMap<ShaderModule> shader_modules;
 
-	std::unordered_map<std::size_t, PipelineLayout> pipeline_layouts;
+	ResourceMap<PipelineLayout> pipeline_layouts;
 
-	std::unordered_map<std::size_t, DescriptorSetLayout> descriptor_set_layouts;
+	ResourceMap<DescriptorSetLayout> descriptor_set_layouts;
 
-	std::unordered_map<std::size_t, DescriptorPool> descriptor_pools;
+	ResourceMap<DescriptorPool> descriptor_pools;
 
-	std::unordered_map<std::size_t, RenderPass> render_passes;
+	ResourceMap<RenderPass> render_passes;
 
-	std::unordered_map<std::size_t, GraphicsPipeline> graphics_pipelines;
+	ResourceMap<GraphicsPipeline> graphics_pipelines;
 
-	std::unordered_map<std::size_t, ComputePipeline> compute_pipelines;
+	ResourceMap<ComputePipeline> compute_pipelines;
 
-	std::unordered_map<std::size_t, DescriptorSet> descriptor_sets;
+	ResourceMap<DescriptorSet> descriptor_sets;
 
-	std::unordered_map<std::size_t, Framebuffer> framebuffers;
+	ResourceMap<Framebuffer> framebuffers;
+};
+
+/**
+ * @brief Result of a non-blocking graphics pipeline request
+ */
+struct GraphicsPipelineRequest
+{
+	/// Pipeline to bind: the requested one if ready, otherwise the fallback, if any
+	GraphicsPipeline *pipeline{nullptr};
+
+	/// True if the requested pipeline is ready
+	bool ready{false};
+};
+
+/**
+ * @brief Counters of the asynchronous pipeline compilation
+ */
+struct AsyncPipelineCounters
+{
+	/// Pipelines queued or being compiled in the background
+	uint32_t pending{0};
+
+	/// Pipelines compiled in the background so far
+	uint64_t compiled{0};
+
+	/// Draws recorded with a fallback pipeline while theirs was compiling
+	uint64_t fallback_draws{0};
+
+	/// Draws skipped as there was no fallback pipeline
+	uint64_t skipped_draws{0};
 };
 
 /**
@@ -76,7 +121,17 @@ struct ResourceCacheState
  * The resource cache is also linked with ResourceRecord and ResourceReplay. Replay can warm-up
  * the cache on app startup by creating all necessary objects.
  * The cache holds pointers to objects and has a mapping from such pointers to hashes.
- * It can only be destroyed in bulk, single elements cannot be removed.
+ * Objects are destroyed in bulk by clear(), unless an eviction policy is set (see below).
+ * Requests are thread-safe: looking up an existing object does not lock, while creating a new one
+ * synchronizes on its ResourceMap so that only one object is built per hash.
+ *
+ * Descriptor sets, framebuffers and graphics pipelines can additionally be bounded by an EvictionPolicy.
+ * Evicted objects are destroyed by begin_frame() once the frames which used them have completed.
+ *
+ * With asynchronous pipeline compilation enabled, a graphics pipeline which is not cached yet is
+ * created on a background thread pool instead of stalling the recording thread. Until it is ready,
+ * draws use the fallback pipeline registered for their render pass, subpass, pipeline layout and
+ * vertex input, or are skipped.
  */
 class ResourceCache
 {
@@ -91,12 +146,28 @@ class ResourceCache
 
 	ResourceCache &operator=(ResourceCache &&) = delete;
 
-	void warmup(const std::vector<uint8_t> &data);
+	~ResourceCache();
+
+	/**
+	 * @brief Creates all objects of a serialized record, reading it in place
+	 * @param data Pointer to the record, e.g. a mapped file
+	 * @param size Size of the record in bytes
+	 * @return False if the record was rejected as stale or corrupt, in which case nothing is created,
+	 *         or if an object could not be created, in which case the remaining objects are created on first use
+	 */
+	bool warmup(const uint8_t *data, size_t size);
+
+	bool warmup(const std::vector<uint8_t> &data);
 
-	std::vector<uint8_t> serialize();
+	std::vector<uint8_t> serialize(RecordCompression compression = RecordCompression::None);
 
 	void set_pipeline_cache(VkPipelineCache pipeline_cache);
 
+	/**
+	 * @return The persistent cache of the SPIR-V compiled for shader modules
+	 */
+	SpirvCache &get_spirv_cache();
+
 	ShaderModule &request_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant = {});
 
 	PipelineLayout &request_pipeline_layout(const std::vector<ShaderModule *> &shader_modules, bool use_dynamic_resources);
@@ -105,8 +176,53 @@ class ResourceCache
 
 	GraphicsPipeline &request_graphics_pipeline(PipelineState &pipeline_state);
 
+	/**
+	 * @brief Requests a graphics pipeline without waiting for its creation
+	 *        If the pipeline is not cached, its creation is queued on the compile pool
+	 *        Must only be used when asynchronous pipeline compilation is enabled
+	 * @param pipeline_state The state of the requested pipeline
+	 * @return The requested pipeline if ready, otherwise the registered fallback pipeline, if any
+	 */
+	GraphicsPipelineRequest request_graphics_pipeline_async(PipelineState &pipeline_state);
+
 	ComputePipeline &request_compute_pipeline(PipelineState &pipeline_state);
 
+	/**
+	 * @brief Enables or disables the asynchronous creation of graphics pipelines
+	 *        Disabling it waits for the pipelines being compiled
+	 * @param enable True to create graphics pipelines on a background thread pool
+	 */
+	void set_async_pipeline_compilation(bool enable);
+
+	bool is_async_pipeline_compilation() const;
+
+	/**
+	 * @brief Registers a pipeline to be used while pipelines with the same render pass, subpass,
+	 *        pipeline layout and vertex input are compiled, so that the resources bound for them
+	 *        are valid for the fallback. Draws with no matching fallback are skipped.
+	 *        It stays registered until it is evicted or clear_pipelines() is called
+	 * @param pipeline A pipeline requested from the cache with the state to cover
+	 */
+	void set_fallback_pipeline(GraphicsPipeline &pipeline);
+
+	/**
+	 * @return True if a fallback pipeline is registered for the render pass, subpass,
+	 *         pipeline layout and vertex input of a state
+	 */
+	bool has_fallback_pipeline(const PipelineState &pipeline_state) const;
+
+	/**
+	 * @brief Blocks until all pipelines queued for compilation are created
+	 */
+	void wait_for_pipelines();
+
+	AsyncPipelineCounters get_async_pipeline_counters() const;
+
+	/**
+	 * @return The activity of the descriptor pools owned by the cache since the start of the frame
+	 */
+	DescriptorPoolCounters get_descriptor_pool_counters() const;
+
 	DescriptorSet &request_descriptor_set(DescriptorSetLayout &                     descriptor_set_layout,
 	                                      const BindingMap<VkDescriptorBufferInfo> &buffer_infos,
 	                                      const BindingMap<VkDescriptorImageInfo> & image_infos);
@@ -120,7 +236,8 @@ class ResourceCache
 
 	void clear_pipelines();
 
-	/// @brief Update those descriptor sets referring to old views
+	/// @brief Update those descriptor sets referring to old views.
+	///        Only the sets indexed under the old views are visited, not the whole cache
 	/// @param old_views Old image views referred by descriptor sets
 	/// @param new_views New image views to be referred
 	void update_descriptor_sets(const std::vector<core::ImageView> &old_views, const std::vector<core::ImageView> &new_views);
@@ -129,6 +246,36 @@ class ResourceCache
 
 	void clear();
 
+	/**
+	 * @brief Sets the eviction policy of descriptor sets. Sets are only allocated from pools
+	 *        which can free them individually while a policy is enabled, so the policy
+	 *        should be set before the first descriptor set is requested
+	 */
+	void set_descriptor_set_policy(const EvictionPolicy &policy);
+
+	void set_framebuffer_policy(const EvictionPolicy &policy);
+
+	void set_graphics_pipeline_policy(const EvictionPolicy &policy);
+
+	/**
+	 * @brief Starts a new frame: retires objects according to the eviction policies,
+	 *        and destroys retired objects which are no longer used by the GPU.
+	 *        Must not be called while other threads are requesting resources.
+	 * @param completed_frame Latest frame number known to have finished executing on the GPU
+	 * @return The number of the new frame
+	 */
+	uint64_t begin_frame(uint64_t completed_frame);
+
+	/**
+	 * @return Count and estimated host memory of the cached objects, per type
+	 */
+	std::map<std::string, ResourceUsage> get_usage() const;
+
+	/**
+	 * @return Hits, misses and creation times of the requests served so far, per type
+	 */
+	std::map<std::string, ResourceCounters> get_counters() const;
+
 	const ResourceCacheState &get_internal_state() const;
 
   private:
@@ -140,22 +287,60 @@ class ResourceCache
 
 	VkPipelineCache pipeline_cache{VK_NULL_HANDLE};
 
+	SpirvCache spirv_cache;
+
 	ResourceCacheState state;
 
-	std::mutex descriptor_set_mutex;
+	/// Keys of the cached descriptor sets referring to each image view
+	std::unordered_map<VkImageView, std::unordered_set<size_t>> image_view_descriptor_sets;
+
+	std::mutex image_view_index_mutex;
+
+	/**
+	 * @brief Computes the key a descriptor set is cached with
+	 */
+	static size_t get_descriptor_set_key(DescriptorSet &descriptor_set);
+
+	/**
+	 * @brief Adds a cached descriptor set to the image view index
+	 */
+	void index_descriptor_set(size_t key, DescriptorSet &descriptor_set);
+
+	/**
+	 * @brief Removes a descriptor set from the image view index
+	 */
+	void unindex_descriptor_set(size_t key, DescriptorSet &descriptor_set);
+
+	EvictionPolicy descriptor_set_policy;
+
+	EvictionPolicy framebuffer_policy;
+
+	EvictionPolicy graphics_pipeline_policy;
+
+	uint64_t frame_number{0};
+
+	uint64_t completed_frame_number{0};
+
+	/// Hashes of the cached fallback pipelines by render pass, subpass, pipeline layout and vertex input, guarded by pending_mutex
+	std::unordered_map<size_t, size_t> fallback_pipelines;
+
+	/// Hashes of the graphics pipelines queued for compilation, failed ones are never removed
+	std::unordered_set<size_t> pending_pipelines;
 
-	std::mutex pipeline_layout_mutex;
+	/// Number of compilation tasks not finished yet
+	uint32_t pending_tasks{0};
 
-	std::mutex shader_module_mutex;
+	mutable std::mutex pending_mutex;
 
-	std::mutex descriptor_set_layout_mutex;
+	std::condition_variable pending_condition;
 
-	std::mutex graphics_pipeline_mutex;
+	std::atomic<uint64_t> compiled_pipeline_count{0};
 
-	std::mutex render_pass_mutex;
+	std::atomic<uint64_t> fallback_draw_count{0};
 
-	std::mutex compute_pipeline_mutex;
+	std::atomic<uint64_t> skipped_draw_count{0};
 
-	std::mutex framebuffer_mutex;
+	/// Destroyed first, so that no compilation outlives the cached objects
+	std::unique_ptr<ctpl::thread_pool> compile_pool;
 };
 }        // namespace vkb
@@ -20,6 +20,10 @@
 
 #include "resource_record.h"
 
+#include <cstdint>
+#include <cstring>
+
+#include "core/descriptor_set_layout.h"
 #include "core/pipeline.h"
 #include "core/pipeline_layout.h"
 #include "core/render_pass.h"
@@ -30,6 +34,21 @@ namespace vkb
 {
 namespace
 {
+// Order in which sections are written, so that replaying them in sequence satisfies dependencies
+const ResourceType section_order[] = {ResourceType::ShaderModule,
+                                      ResourceType::DescriptorSetLayout,
+                                      ResourceType::PipelineLayout,
+                                      ResourceType::RenderPass,
+                                      ResourceType::GraphicsPipeline,
+                                      ResourceType::ComputePipeline};
+
+// Matches shorter than this are cheaper to store as literals
+const size_t min_match_length = 4;
+
+const size_t max_match_offset = 0xFFFF;
+
+const size_t match_table_size = 1 << 12;
+
 inline void write_subpass_info(std::ostringstream &os, const std::vector<SubpassInfo> &value)
 {
 	write(os, value.size());
@@ -48,45 +67,429 @@ inline void write_processes(std::ostringstream &os, const std::vector<std::strin
 		write(os, item);
 	}
 }
-}        // namespace
 
-void ResourceRecord::set_data(const std::vector<uint8_t> &data)
+inline void write_shader_resources(std::ostringstream &os, const std::vector<ShaderResource> &value)
+{
+	write(os, value.size());
+	for (const ShaderResource &item : value)
+	{
+		write(os,
+		      item.stages,
+		      item.type,
+		      item.set,
+		      item.binding,
+		      item.location,
+		      item.input_attachment_index,
+		      item.vec_size,
+		      item.columns,
+		      item.array_size,
+		      item.offset,
+		      item.size,
+		      item.constant_id,
+		      item.dynamic,
+		      item.name);
+	}
+}
+
+inline void write_length(std::vector<uint8_t> &dst, size_t length)
+{
+	while (length >= 0xFF)
+	{
+		dst.push_back(0xFF);
+		length -= 0xFF;
+	}
+
+	dst.push_back(static_cast<uint8_t>(length));
+}
+
+inline bool read_length(const uint8_t *&src, const uint8_t *end, size_t &length)
+{
+	uint8_t byte = 0xFF;
+	while (byte == 0xFF)
+	{
+		if (src == end)
+		{
+			return false;
+		}
+
+		byte = *src++;
+		length += byte;
+	}
+
+	return true;
+}
+
+inline void write_sequence(std::vector<uint8_t> &dst, const uint8_t *literals, size_t literal_length, size_t offset, size_t match_length)
+{
+	size_t extra_match_length = match_length > 0 ? match_length - min_match_length : 0;
+
+	uint8_t token = static_cast<uint8_t>((std::min<size_t>(literal_length, 0xF) << 4) | std::min<size_t>(extra_match_length, 0xF));
+	dst.push_back(token);
+
+	if (literal_length >= 0xF)
+	{
+		write_length(dst, literal_length - 0xF);
+	}
+
+	dst.insert(dst.end(), literals, literals + literal_length);
+
+	// The last sequence only carries literals
+	if (match_length == 0)
+	{
+		return;
+	}
+
+	dst.push_back(static_cast<uint8_t>(offset & 0xFF));
+	dst.push_back(static_cast<uint8_t>(offset >> 8));
+
+	if (extra_match_length >= 0xF)
+	{
+		write_length(dst, extra_match_length - 0xF);
+	}
+}
+
+/**
+ * @brief Compresses data with a byte oriented LZ77 scheme similar to the LZ4 block format:
+ *        each sequence is a token (literal and match lengths), the literals, and a 16-bit match offset
+ */
+std::vector<uint8_t> compress(const std::vector<uint8_t> &src)
+{
+	std::vector<uint8_t> dst;
+	dst.reserve(src.size() / 2 + 16);
+
+	std::vector<size_t> match_table(match_table_size, SIZE_MAX);
+
+	size_t literal_start = 0;
+	size_t pos           = 0;
+
+	while (pos + min_match_length <= src.size())
+	{
+		uint32_t sequence;
+		std::memcpy(&sequence, &src[pos], sizeof(sequence));
+
+		size_t  slot      = (sequence * 2654435761U) >> 20 & (match_table_size - 1);
+		size_t  candidate = match_table[slot];
+		match_table[slot] = pos;
+
+		if (candidate == SIZE_MAX || pos - candidate > max_match_offset || std::memcmp(&src[candidate], &src[pos], min_match_length) != 0)
+		{
+			++pos;
+			continue;
+		}
+
+		size_t match_length = min_match_length;
+		while (pos + match_length < src.size() && src[candidate + match_length] == src[pos + match_length])
+		{
+			++match_length;
+		}
+
+		write_sequence(dst, &src[literal_start], pos - literal_start, pos - candidate, match_length);
+
+		pos += match_length;
+		literal_start = pos;
+	}
+
+	write_sequence(dst, src.data() + literal_start, src.size() - literal_start, 0, 0);
+
+	return dst;
+}
+
+/**
+ * @brief Decompresses data written by compress(), validating every length and offset
+ * @return False if the data is corrupt or does not decompress to exactly dst.size() bytes
+ */
+bool decompress(const uint8_t *src, size_t size, std::vector<uint8_t> &dst)
 {
-	stream.str(std::string{data.begin(), data.end()});
+	const uint8_t *end = src + size;
+	size_t         pos = 0;
+
+	while (src < end)
+	{
+		uint8_t token = *src++;
+
+		size_t literal_length = token >> 4;
+		if (literal_length == 0xF && !read_length(src, end, literal_length))
+		{
+			return false;
+		}
+
+		if (literal_length > static_cast<size_t>(end - src) || literal_length > dst.size() - pos)
+		{
+			return false;
+		}
+
+		std::memcpy(dst.data() + pos, src, literal_length);
+		src += literal_length;
+		pos += literal_length;
+
+		if (src == end)
+		{
+			break;
+		}
+
+		if (end - src < 2)
+		{
+			return false;
+		}
+
+		size_t offset = src[0] | (src[1] << 8);
+		src += 2;
+
+		size_t match_length = token & 0xF;
+		if (match_length == 0xF && !read_length(src, end, match_length))
+		{
+			return false;
+		}
+		match_length += min_match_length;
+
+		if (offset == 0 || offset > pos || match_length > dst.size() - pos)
+		{
+			return false;
+		}
+
+		// Matches may overlap the bytes they produce, so copy one byte at a time
+		for (size_t i = 0; i < match_length; ++i, ++pos)
+		{
+			dst[pos] = dst[pos - offset];
+		}
+	}
+
+	return pos == dst.size();
 }
+}        // namespace
 
-std::vector<uint8_t> ResourceRecord::get_data()
+RecordReader::RecordReader(const uint8_t *data, size_t size, const VkPhysicalDeviceProperties &properties)
 {
-	std::string str = stream.str();
+	RecordHeader header{};
+
+	if (data == nullptr || size < sizeof(RecordHeader))
+	{
+		throw std::runtime_error{"Resource record is truncated"};
+	}
+
+	std::memcpy(&header, data, sizeof(RecordHeader));
+
+	if (header.magic != ResourceRecord::MAGIC)
+	{
+		throw std::runtime_error{"Not a resource record"};
+	}
+
+	if (header.version != ResourceRecord::VERSION)
+	{
+		throw std::runtime_error{"Resource record version " + std::to_string(header.version) + " is not supported"};
+	}
+
+	if (header.vendor_id != properties.vendorID ||
+	    header.device_id != properties.deviceID ||
+	    header.driver_version != properties.driverVersion ||
+	    std::memcmp(header.pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+	{
+		throw std::runtime_error{"Resource record was created for another device or driver"};
+	}
+
+	size_t table_size = header.section_count * sizeof(RecordSection);
 
-	return std::vector<uint8_t>{str.begin(), str.end()};
+	if (header.section_count > size || table_size > size - sizeof(RecordHeader))
+	{
+		throw std::runtime_error{"Resource record section table is truncated"};
+	}
+
+	const uint8_t *payload = data + sizeof(RecordHeader);
+
+	if (hash_bytes(payload, size - sizeof(RecordHeader)) != header.content_hash)
+	{
+		throw std::runtime_error{"Resource record is corrupt"};
+	}
+
+	for (uint32_t i = 0; i < header.section_count; ++i)
+	{
+		RecordSection section;
+		std::memcpy(&section, payload + i * sizeof(RecordSection), sizeof(RecordSection));
+
+		if (section.offset > size || section.size > size - section.offset)
+		{
+			throw std::runtime_error{"Resource record section is out of bounds"};
+		}
+
+		RecordSectionView view{section.type, section.count, data + section.offset, static_cast<size_t>(section.size)};
+
+		if (section.compression == RecordCompression::LZ)
+		{
+			std::vector<uint8_t> section_data(static_cast<size_t>(section.uncompressed_size));
+
+			if (!decompress(view.data, view.size, section_data))
+			{
+				throw std::runtime_error{"Resource record section cannot be decompressed"};
+			}
+
+			view.data = section_data.data();
+			view.size = section_data.size();
+
+			decompressed_sections.push_back(std::move(section_data));
+		}
+		else if (section.compression != RecordCompression::None)
+		{
+			throw std::runtime_error{"Resource record section compression is not supported"};
+		}
+
+		sections.push_back(view);
+	}
+}
+
+const std::vector<RecordSectionView> &RecordReader::get_sections() const
+{
+	return sections;
 }
 
-const std::ostringstream &ResourceRecord::get_stream()
+std::vector<uint8_t> ResourceRecord::get_data(const VkPhysicalDeviceProperties &properties, RecordCompression compression)
 {
-	return stream;
+	std::lock_guard<std::mutex> guard(mutex);
+
+	std::vector<RecordSection>        section_table;
+	std::vector<std::vector<uint8_t>> section_payloads;
+
+	size_t offset = sizeof(RecordHeader);
+
+	for (auto type : section_order)
+	{
+		auto stream_it = streams.find(type);
+		if (stream_it == streams.end())
+		{
+			continue;
+		}
+
+		std::string          str = stream_it->second.str();
+		std::vector<uint8_t> section_data{str.begin(), str.end()};
+
+		RecordSection section{};
+		section.type              = type;
+		section.compression       = compression;
+		section.uncompressed_size = section_data.size();
+
+		switch (type)
+		{
+			case ResourceType::ShaderModule:
+				section.count = to_u32(shader_module_indices.size());
+				break;
+			case ResourceType::DescriptorSetLayout:
+				section.count = to_u32(descriptor_set_layout_indices.size());
+				break;
+			case ResourceType::PipelineLayout:
+				section.count = to_u32(pipeline_layout_indices.size());
+				break;
+			case ResourceType::RenderPass:
+				section.count = to_u32(render_pass_indices.size());
+				break;
+			case ResourceType::GraphicsPipeline:
+				section.count = to_u32(graphics_pipeline_indices.size());
+				break;
+			case ResourceType::ComputePipeline:
+				section.count = to_u32(compute_pipeline_indices.size());
+				break;
+		}
+
+		if (compression == RecordCompression::LZ)
+		{
+			section_data = compress(section_data);
+		}
+
+		section.size = section_data.size();
+
+		section_table.push_back(section);
+		section_payloads.push_back(std::move(section_data));
+	}
+
+	// Payloads follow the section table
+	offset += section_table.size() * sizeof(RecordSection);
+	for (auto &section : section_table)
+	{
+		section.offset = offset;
+		offset += static_cast<size_t>(section.size);
+	}
+
+	std::vector<uint8_t> data(offset);
+
+	RecordHeader header;
+	std::memset(&header, 0, sizeof(RecordHeader));
+
+	header.magic          = MAGIC;
+	header.version        = VERSION;
+	header.vendor_id      = properties.vendorID;
+	header.device_id      = properties.deviceID;
+	header.driver_version = properties.driverVersion;
+	header.section_count  = to_u32(section_table.size());
+	std::memcpy(header.pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+	uint8_t *dst = data.data() + sizeof(RecordHeader);
+
+	for (size_t i = 0; i < section_table.size(); ++i)
+	{
+		// Copies of a section do not keep its padding, so write each one from a zeroed struct to hash the same bytes every time
+		RecordSection section;
+		std::memset(&section, 0, sizeof(RecordSection));
+
+		section.type              = section_table[i].type;
+		section.compression       = section_table[i].compression;
+		section.count             = section_table[i].count;
+		section.offset            = section_table[i].offset;
+		section.size              = section_table[i].size;
+		section.uncompressed_size = section_table[i].uncompressed_size;
+
+		std::memcpy(dst + i * sizeof(RecordSection), &section, sizeof(RecordSection));
+	}
+
+	for (size_t i = 0; i < section_table.size(); ++i)
+	{
+		std::copy(section_payloads[i].begin(), section_payloads[i].end(), data.begin() + section_table[i].offset);
+	}
+
+	header.content_hash = hash_bytes(dst, data.size() - sizeof(RecordHeader));
+
+	std::memcpy(data.data(), &header, sizeof(RecordHeader));
+
+	return data;
 }
 
 size_t ResourceRecord::register_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const std::string &entry_point, const ShaderVariant &shader_variant)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	shader_module_indices.push_back(shader_module_indices.size());
 
-	write(stream, ResourceType::ShaderModule, stage, glsl_source.get_data(), entry_point, shader_variant.get_preamble());
+	auto &stream = streams[ResourceType::ShaderModule];
+
+	write(stream, stage, glsl_source.get_data(), entry_point, shader_variant.get_preamble());
 
 	write_processes(stream, shader_variant.get_processes());
 
 	return shader_module_indices.back();
 }
 
+size_t ResourceRecord::register_descriptor_set_layout(const std::vector<ShaderResource> &set_resources, bool use_dynamic_resources)
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	descriptor_set_layout_indices.push_back(descriptor_set_layout_indices.size());
+
+	auto &stream = streams[ResourceType::DescriptorSetLayout];
+
+	write_shader_resources(stream, set_resources);
+
+	write(stream, use_dynamic_resources);
+
+	return descriptor_set_layout_indices.back();
+}
+
 size_t ResourceRecord::register_pipeline_layout(const std::vector<ShaderModule *> &shader_modules, bool use_dynamic_resources)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	pipeline_layout_indices.push_back(pipeline_layout_indices.size());
 
 	std::vector<size_t> shader_indices(shader_modules.size());
 	std::transform(shader_modules.begin(), shader_modules.end(), shader_indices.begin(),
 	               [this](ShaderModule *shader_module) { return shader_module_to_index.at(shader_module); });
-	write(stream,
-	      ResourceType::PipelineLayout,
+	write(streams[ResourceType::PipelineLayout],
 	      shader_indices,
 	      use_dynamic_resources);
 
@@ -95,10 +498,13 @@ size_t ResourceRecord::register_pipeline_layout(const std::vector<ShaderModule *
 
 size_t ResourceRecord::register_render_pass(const std::vector<Attachment> &attachments, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<SubpassInfo> &subpasses)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	render_pass_indices.push_back(render_pass_indices.size());
 
+	auto &stream = streams[ResourceType::RenderPass];
+
 	write(stream,
-	      ResourceType::RenderPass,
 	      attachments,
 	      load_store_infos);
 
@@ -109,13 +515,16 @@ size_t ResourceRecord::register_render_pass(const std::vector<Attachment> &attac
 
 size_t ResourceRecord::register_graphics_pipeline(VkPipelineCache /*pipeline_cache*/, PipelineState &pipeline_state)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	graphics_pipeline_indices.push_back(graphics_pipeline_indices.size());
 
+	auto &stream = streams[ResourceType::GraphicsPipeline];
+
 	auto &pipeline_layout = pipeline_state.get_pipeline_layout();
 	auto  render_pass     = pipeline_state.get_render_pass();
 
 	write(stream,
-	      ResourceType::GraphicsPipeline,
 	      pipeline_layout_to_index.at(&pipeline_layout),
 	      render_pass_to_index.at(render_pass),
 	      pipeline_state.get_subpass_index());
@@ -148,24 +557,61 @@ size_t ResourceRecord::register_graphics_pipeline(VkPipelineCache /*pipeline_cac
 	return graphics_pipeline_indices.back();
 }
 
+size_t ResourceRecord::register_compute_pipeline(VkPipelineCache /*pipeline_cache*/, PipelineState &pipeline_state)
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	compute_pipeline_indices.push_back(compute_pipeline_indices.size());
+
+	auto &stream = streams[ResourceType::ComputePipeline];
+
+	write(stream,
+	      pipeline_layout_to_index.at(&pipeline_state.get_pipeline_layout()),
+	      pipeline_state.get_specialization_constant_state().get_specialization_constant_state());
+
+	return compute_pipeline_indices.back();
+}
+
 void ResourceRecord::set_shader_module(size_t index, const ShaderModule &shader_module)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	shader_module_to_index[&shader_module] = index;
 }
 
+void ResourceRecord::set_descriptor_set_layout(size_t index, const DescriptorSetLayout &descriptor_set_layout)
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	descriptor_set_layout_to_index[&descriptor_set_layout] = index;
+}
+
 void ResourceRecord::set_pipeline_layout(size_t index, const PipelineLayout &pipeline_layout)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	pipeline_layout_to_index[&pipeline_layout] = index;
 }
 
 void ResourceRecord::set_render_pass(size_t index, const RenderPass &render_pass)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	render_pass_to_index[&render_pass] = index;
 }
 
 void ResourceRecord::set_graphics_pipeline(size_t index, const GraphicsPipeline &graphics_pipeline)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	graphics_pipeline_to_index[&graphics_pipeline] = index;
 }
 
+void ResourceRecord::set_compute_pipeline(size_t index, const ComputePipeline &compute_pipeline)
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	compute_pipeline_to_index[&compute_pipeline] = index;
+}
+
 }        // namespace vkb
@@ -20,39 +20,143 @@
 
 #pragma once
 
+#include <map>
+#include <mutex>
 #include <vector>
 
 #include "rendering/pipeline_state.h"
 
 namespace vkb
 {
+class ComputePipeline;
+class DescriptorSetLayout;
 class GraphicsPipeline;
 class PipelineLayout;
 class RenderPass;
 class ShaderModule;
+struct ShaderResource;
 
-enum class ResourceType
+enum class ResourceType : uint32_t
 {
 	ShaderModule,
 	PipelineLayout,
 	RenderPass,
-	GraphicsPipeline
+	GraphicsPipeline,
+	DescriptorSetLayout,
+	ComputePipeline
+};
+
+enum class RecordCompression : uint32_t
+{
+	None,
+	LZ
+};
+
+/**
+ * @brief Header of a serialized ResourceRecord, followed by the section table and the section payloads.
+ *        The identity of the physical device and driver is stored so that records created by another
+ *        GPU or driver version are rejected, and the content hash covers the section table and payloads.
+ */
+struct RecordHeader
+{
+	uint32_t magic;
+
+	uint32_t version;
+
+	uint32_t vendor_id;
+
+	uint32_t device_id;
+
+	uint32_t driver_version;
+
+	uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+
+	uint32_t section_count;
+
+	uint64_t content_hash;
+};
+
+/**
+ * @brief Location of the records of one resource type within a serialized ResourceRecord
+ */
+struct RecordSection
+{
+	ResourceType type;
+
+	RecordCompression compression;
+
+	uint32_t count;
+
+	uint64_t offset;
+
+	uint64_t size;
+
+	uint64_t uncompressed_size;
+};
+
+/**
+ * @brief Records of one resource type, ready to be replayed
+ */
+struct RecordSectionView
+{
+	ResourceType type;
+
+	uint32_t count;
+
+	const uint8_t *data;
+
+	size_t size;
+};
+
+/**
+ * @brief Validates a serialized ResourceRecord and exposes its sections in replay order.
+ *        Uncompressed sections point directly into the memory passed to the constructor,
+ *        which must outlive the reader. Only compressed sections are copied.
+ */
+class RecordReader
+{
+  public:
+	/**
+	 * @brief Validates the header, section table and content hash of a record
+	 * @param data Pointer to the serialized record, e.g. a mapped file
+	 * @param size Size of the serialized record in bytes
+	 * @param properties Properties of the device the record will be replayed on
+	 * @throws std::runtime_error if the record is corrupt or was created for another device or driver
+	 */
+	RecordReader(const uint8_t *data, size_t size, const VkPhysicalDeviceProperties &properties);
+
+	const std::vector<RecordSectionView> &get_sections() const;
+
+  private:
+	std::vector<RecordSectionView> sections;
+
+	std::vector<std::vector<uint8_t>> decompressed_sections;
 };
 
 /**
- * @brief Writes Vulkan objects in a memory stream.
+ * @brief Writes Vulkan objects in memory streams, one per resource type.
+ *        Objects may be registered from several threads, e.g. during a parallel replay.
  */
 class ResourceRecord
 {
   public:
-	void set_data(const std::vector<uint8_t> &data);
+	static const uint32_t MAGIC = 0x52424b56;        // "VKBR"
 
-	std::vector<uint8_t> get_data();
+	static const uint32_t VERSION = 2;
 
-	const std::ostringstream &get_stream();
+	/**
+	 * @brief Serializes the recorded objects
+	 * @param properties Properties of the device the objects were created on
+	 * @param compression Compression applied to each section
+	 * @return A header, a section table and the section payloads
+	 */
+	std::vector<uint8_t> get_data(const VkPhysicalDeviceProperties &properties, RecordCompression compression = RecordCompression::None);
 
 	size_t register_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const std::string &entry_point, const ShaderVariant &shader_variant);
 
+	size_t register_descriptor_set_layout(const std::vector<ShaderResource> &set_resources,
+	                                      bool                               use_dynamic_resources);
+
 	size_t register_pipeline_layout(const std::vector<ShaderModule *> &shader_modules,
 	                                bool                               use_dynamic_resources);
 
@@ -63,31 +167,49 @@ class ResourceRecord
 	size_t register_graphics_pipeline(VkPipelineCache pipeline_cache,
 	                                  PipelineState & pipeline_state);
 
+	size_t register_compute_pipeline(VkPipelineCache pipeline_cache,
+	                                 PipelineState & pipeline_state);
+
 	void set_shader_module(size_t index, const ShaderModule &shader_module);
 
+	void set_descriptor_set_layout(size_t index, const DescriptorSetLayout &descriptor_set_layout);
+
 	void set_pipeline_layout(size_t index, const PipelineLayout &pipeline_layout);
 
 	void set_render_pass(size_t index, const RenderPass &render_pass);
 
 	void set_graphics_pipeline(size_t index, const GraphicsPipeline &graphics_pipeline);
 
+	void set_compute_pipeline(size_t index, const ComputePipeline &compute_pipeline);
+
   private:
-	std::ostringstream stream;
+	std::mutex mutex;
+
+	/// Records of each resource type, sections are written in dependency order
+	std::map<ResourceType, std::ostringstream> streams;
 
 	std::vector<size_t> shader_module_indices;
 
+	std::vector<size_t> descriptor_set_layout_indices;
+
 	std::vector<size_t> pipeline_layout_indices;
 
 	std::vector<size_t> render_pass_indices;
 
 	std::vector<size_t> graphics_pipeline_indices;
 
+	std::vector<size_t> compute_pipeline_indices;
+
 	std::unordered_map<const ShaderModule *, size_t> shader_module_to_index;
 
+	std::unordered_map<const DescriptorSetLayout *, size_t> descriptor_set_layout_to_index;
+
 	std::unordered_map<const PipelineLayout *, size_t> pipeline_layout_to_index;
 
 	std::unordered_map<const RenderPass *, size_t> render_pass_to_index;
 
 	std::unordered_map<const GraphicsPipeline *, size_t> graphics_pipeline_to_index;
+
+	std::unordered_map<const ComputePipeline *, size_t> compute_pipeline_to_index;
 };
 }        // namespace vkb
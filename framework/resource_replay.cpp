@@ -20,16 +20,19 @@
 
 #include "resource_replay.h"
 
+#include <ctpl_stl.h>
+
 #include "common/logging.h"
 #include "common/vk_common.h"
 #include "rendering/pipeline_state.h"
 #include "resource_cache.h"
+#include "timer.h"
 
 namespace vkb
 {
 namespace
 {
-inline void read_subpass_info(std::istringstream &is, std::vector<SubpassInfo> &value)
+inline void read_subpass_info(std::istream &is, std::vector<SubpassInfo> &value)
 {
 	std::size_t size;
 	read(is, size);
@@ -41,7 +44,45 @@ inline void read_subpass_info(std::istringstream &is, std::vector<SubpassInfo> &
 	}
 }
 
-inline void read_processes(std::istringstream &is, std::vector<std::string> &value)
+inline void read_shader_resources(std::istream &is, std::vector<ShaderResource> &value)
+{
+	std::size_t size;
+	read(is, size);
+	value.resize(size);
+	for (ShaderResource &item : value)
+	{
+		read(is,
+		     item.stages,
+		     item.type,
+		     item.set,
+		     item.binding,
+		     item.location,
+		     item.input_attachment_index,
+		     item.vec_size,
+		     item.columns,
+		     item.array_size,
+		     item.offset,
+		     item.size,
+		     item.constant_id,
+		     item.dynamic,
+		     item.name);
+	}
+}
+
+/**
+ * @brief Read-only stream buffer over memory owned by someone else, avoiding a copy of the record
+ */
+class MemoryBuffer : public std::streambuf
+{
+  public:
+	MemoryBuffer(const uint8_t *data, size_t size)
+	{
+		char *begin = const_cast<char *>(reinterpret_cast<const char *>(data));
+		setg(begin, begin, begin + size);
+	}
+};
+
+inline void read_processes(std::istream &is, std::vector<std::string> &value)
 {
 	std::size_t size;
 	read(is, size);
@@ -51,48 +92,136 @@ inline void read_processes(std::istringstream &is, std::vector<std::string> &val
 		read(is, item);
 	}
 }
+
+/**
+ * @brief Checks that a record refers to an object read from an earlier section, so that
+ *        a corrupt record is rejected before any object is created
+ */
+template <class T>
+inline void check_index(const std::vector<T> &objects, size_t index, const char *type_name)
+{
+	if (index >= objects.size())
+	{
+		throw std::runtime_error{std::string{"Resource record refers to a missing "} + type_name};
+	}
+}
 }        // namespace
 
 ResourceReplay::ResourceReplay()
 {
-	stream_resources[ResourceType::ShaderModule]     = std::bind(&ResourceReplay::create_shader_module, this, std::placeholders::_1, std::placeholders::_2);
-	stream_resources[ResourceType::PipelineLayout]   = std::bind(&ResourceReplay::create_pipeline_layout, this, std::placeholders::_1, std::placeholders::_2);
-	stream_resources[ResourceType::RenderPass]       = std::bind(&ResourceReplay::create_render_pass, this, std::placeholders::_1, std::placeholders::_2);
-	stream_resources[ResourceType::GraphicsPipeline] = std::bind(&ResourceReplay::create_graphics_pipeline, this, std::placeholders::_1, std::placeholders::_2);
+	stream_resources[ResourceType::ShaderModule]        = std::bind(&ResourceReplay::read_shader_module, this, std::placeholders::_1, std::placeholders::_2);
+	stream_resources[ResourceType::DescriptorSetLayout] = std::bind(&ResourceReplay::read_descriptor_set_layout, this, std::placeholders::_1, std::placeholders::_2);
+	stream_resources[ResourceType::PipelineLayout]      = std::bind(&ResourceReplay::read_pipeline_layout, this, std::placeholders::_1, std::placeholders::_2);
+	stream_resources[ResourceType::RenderPass]          = std::bind(&ResourceReplay::read_render_pass, this, std::placeholders::_1, std::placeholders::_2);
+	stream_resources[ResourceType::GraphicsPipeline]    = std::bind(&ResourceReplay::read_graphics_pipeline, this, std::placeholders::_1, std::placeholders::_2);
+	stream_resources[ResourceType::ComputePipeline]     = std::bind(&ResourceReplay::read_compute_pipeline, this, std::placeholders::_1, std::placeholders::_2);
 }
 
-void ResourceReplay::play(ResourceCache &resource_cache, ResourceRecord &recorder)
+void ResourceReplay::play(ResourceCache &resource_cache, const RecordReader &reader)
 {
-	std::istringstream stream{recorder.get_stream().str()};
-
-	while (true)
+	// Records refer to other objects by their index within the record
+	shader_modules.clear();
+	pipeline_layouts.clear();
+	render_passes.clear();
+	graphics_pipelines.clear();
+	compute_pipelines.clear();
+	stage_times.clear();
+
+	// Objects of a stage only depend on objects of earlier stages
+	std::map<ReplayStage, std::vector<ResourceTask>> stage_tasks;
+
+	for (auto &section : reader.get_sections())
 	{
-		// Read command id
-		ResourceType resource_type;
-		read(stream, resource_type);
+		// Find command function for the section type
+		auto cmd_it = stream_resources.find(section.type);
 
-		if (stream.eof())
+		// Check if command replayer supports the given command
+		if (cmd_it == stream_resources.end())
 		{
-			break;
+			LOGE("Replay command not supported.");
+			continue;
 		}
 
-		// Find command function for the given command id
-		auto cmd_it = stream_resources.find(resource_type);
+		MemoryBuffer buffer{section.data, section.size};
+		std::istream stream{&buffer};
 
-		// Check if command replayer supports the given command
-		if (cmd_it != stream_resources.end())
+		auto &tasks = stage_tasks[get_replay_stage(section.type)];
+
+		for (uint32_t i = 0; i < section.count; ++i)
 		{
 			// Run command function
-			cmd_it->second(resource_cache, stream);
+			tasks.push_back(cmd_it->second(stream, i));
+
+			if (!stream)
+			{
+				throw std::runtime_error{"Resource record section ended unexpectedly"};
+			}
+		}
+	}
+
+	auto thread_count = std::thread::hardware_concurrency();
+	thread_count      = thread_count == 0 ? 1 : thread_count;
+	ctpl::thread_pool thread_pool(thread_count);
+
+	for (auto &stage : stage_tasks)
+	{
+		Timer timer;
+		timer.start();
+
+		std::vector<std::future<void>> task_futures;
+		for (auto &task : stage.second)
+		{
+			task_futures.push_back(thread_pool.push([&resource_cache, &task](size_t) { task(resource_cache); }));
 		}
-		else
+
+		// Wait for the whole stage, rethrowing the first creation error
+		for (auto &fut : task_futures)
 		{
-			LOGE("Replay command not supported.");
+			fut.get();
 		}
+
+		auto elapsed = timer.stop<Timer::Milliseconds>();
+
+		LOGI("Replayed {} cache objects ({} stage) in {:.2f} ms", stage.second.size(), get_replay_stage_name(stage.first), elapsed);
+
+		stage_times.push_back({stage.first, stage.second.size(), elapsed});
 	}
 }
 
-void ResourceReplay::create_shader_module(ResourceCache &resource_cache, std::istringstream &stream)
+const std::vector<ReplayStageTime> &ResourceReplay::get_stage_times() const
+{
+	return stage_times;
+}
+
+ReplayStage ResourceReplay::get_replay_stage(ResourceType type)
+{
+	switch (type)
+	{
+		case ResourceType::ShaderModule:
+		case ResourceType::DescriptorSetLayout:
+		case ResourceType::RenderPass:
+			return ReplayStage::Modules;
+		case ResourceType::PipelineLayout:
+			return ReplayStage::Layouts;
+		default:
+			return ReplayStage::Pipelines;
+	}
+}
+
+const char *ResourceReplay::get_replay_stage_name(ReplayStage stage)
+{
+	switch (stage)
+	{
+		case ReplayStage::Modules:
+			return "modules";
+		case ReplayStage::Layouts:
+			return "layouts";
+		default:
+			return "pipelines";
+	}
+}
+
+ResourceReplay::ResourceTask ResourceReplay::read_shader_module(std::istream &stream, size_t index)
 {
 	VkShaderStageFlagBits    stage{};
 	std::vector<uint8_t>     glsl_code;
@@ -108,15 +237,31 @@ void ResourceReplay::create_shader_module(ResourceCache &resource_cache, std::is
 
 	read_processes(stream, processes);
 
-	ShaderSource  shader_source(std::move(glsl_code));
-	ShaderVariant shader_variant(std::move(preamble), std::move(processes));
+	shader_modules.resize(std::max(shader_modules.size(), index + 1));
 
-	auto &shader_module = resource_cache.request_shader_module(stage, shader_source, shader_variant);
+	auto shader_source  = std::make_shared<ShaderSource>(std::move(glsl_code));
+	auto shader_variant = std::make_shared<ShaderVariant>(std::move(preamble), std::move(processes));
 
-	shader_modules.push_back(&shader_module);
+	return [this, index, stage, shader_source, shader_variant](ResourceCache &resource_cache) {
+		shader_modules[index] = &resource_cache.request_shader_module(stage, *shader_source, *shader_variant);
+	};
 }
 
-void ResourceReplay::create_pipeline_layout(ResourceCache &resource_cache, std::istringstream &stream)
+ResourceReplay::ResourceTask ResourceReplay::read_descriptor_set_layout(std::istream &stream, size_t /*index*/)
+{
+	auto set_resources = std::make_shared<std::vector<ShaderResource>>();
+	bool use_dynamic_resources;
+
+	read_shader_resources(stream, *set_resources);
+
+	read(stream, use_dynamic_resources);
+
+	return [set_resources, use_dynamic_resources](ResourceCache &resource_cache) {
+		resource_cache.request_descriptor_set_layout(*set_resources, use_dynamic_resources);
+	};
+}
+
+ResourceReplay::ResourceTask ResourceReplay::read_pipeline_layout(std::istream &stream, size_t index)
 {
 	std::vector<size_t> shader_indices;
 	bool                use_dynamic_resources;
@@ -125,15 +270,23 @@ void ResourceReplay::create_pipeline_layout(ResourceCache &resource_cache, std::
 	     shader_indices,
 	     use_dynamic_resources);
 
-	std::vector<ShaderModule *> shader_stages(shader_indices.size());
-	std::transform(shader_indices.begin(), shader_indices.end(), shader_stages.begin(),
-	               [&](size_t shader_index) { return shader_modules.at(shader_index); });
-	auto &pipeline_layout = resource_cache.request_pipeline_layout(shader_stages, use_dynamic_resources);
+	for (auto shader_index : shader_indices)
+	{
+		check_index(shader_modules, shader_index, "shader module");
+	}
+
+	pipeline_layouts.resize(std::max(pipeline_layouts.size(), index + 1));
+
+	return [this, index, shader_indices, use_dynamic_resources](ResourceCache &resource_cache) {
+		std::vector<ShaderModule *> shader_stages(shader_indices.size());
+		std::transform(shader_indices.begin(), shader_indices.end(), shader_stages.begin(),
+		               [&](size_t shader_index) { return shader_modules.at(shader_index); });
 
-	pipeline_layouts.push_back(&pipeline_layout);
+		pipeline_layouts[index] = &resource_cache.request_pipeline_layout(shader_stages, use_dynamic_resources);
+	};
 }
 
-void ResourceReplay::create_render_pass(ResourceCache &resource_cache, std::istringstream &stream)
+ResourceReplay::ResourceTask ResourceReplay::read_render_pass(std::istream &stream, size_t index)
 {
 	std::vector<Attachment>    attachments;
 	std::vector<LoadStoreInfo> load_store_infos;
@@ -145,12 +298,14 @@ void ResourceReplay::create_render_pass(ResourceCache &resource_cache, std::istr
 
 	read_subpass_info(stream, subpasses);
 
-	auto &render_pass = resource_cache.request_render_pass(attachments, load_store_infos, subpasses);
+	render_passes.resize(std::max(render_passes.size(), index + 1));
 
-	render_passes.push_back(&render_pass);
+	return [this, index, attachments, load_store_infos, subpasses](ResourceCache &resource_cache) {
+		render_passes[index] = &resource_cache.request_render_pass(attachments, load_store_infos, subpasses);
+	};
 }
 
-void ResourceReplay::create_graphics_pipeline(ResourceCache &resource_cache, std::istringstream &stream)
+ResourceReplay::ResourceTask ResourceReplay::read_graphics_pipeline(std::istream &stream, size_t index)
 {
 	size_t   pipeline_layout_index{};
 	size_t   render_pass_index{};
@@ -161,6 +316,9 @@ void ResourceReplay::create_graphics_pipeline(ResourceCache &resource_cache, std
 	     render_pass_index,
 	     subpass_index);
 
+	check_index(pipeline_layouts, pipeline_layout_index, "pipeline layout");
+	check_index(render_passes, render_pass_index, "render pass");
+
 	std::map<uint32_t, std::vector<uint8_t>> specialization_constant_state{};
 	read(stream,
 	     specialization_constant_state);
@@ -191,26 +349,58 @@ void ResourceReplay::create_graphics_pipeline(ResourceCache &resource_cache, std
 	     color_blend_state.logic_op_enable,
 	     color_blend_state.attachments);
 
-	PipelineState pipeline_state{};
-	pipeline_state.set_pipeline_layout(*pipeline_layouts.at(pipeline_layout_index));
-	pipeline_state.set_render_pass(*render_passes.at(render_pass_index));
+	// Layouts and render passes are only known once their stage has been replayed
+	auto pipeline_state = std::make_shared<PipelineState>();
+
+	for (auto &item : specialization_constant_state)
+	{
+		pipeline_state->set_specialization_constant(item.first, item.second);
+	}
+
+	pipeline_state->set_subpass_index(subpass_index);
+	pipeline_state->set_vertex_input_state(vertex_input_sate);
+	pipeline_state->set_input_assembly_state(input_assembly_state);
+	pipeline_state->set_rasterization_state(rasterization_state);
+	pipeline_state->set_viewport_state(viewport_state);
+	pipeline_state->set_multisample_state(multisample_state);
+	pipeline_state->set_depth_stencil_state(depth_stencil_state);
+	pipeline_state->set_color_blend_state(color_blend_state);
+
+	graphics_pipelines.resize(std::max(graphics_pipelines.size(), index + 1));
+
+	return [this, index, pipeline_layout_index, render_pass_index, pipeline_state](ResourceCache &resource_cache) {
+		pipeline_state->set_pipeline_layout(*pipeline_layouts.at(pipeline_layout_index));
+		pipeline_state->set_render_pass(*render_passes.at(render_pass_index));
+
+		graphics_pipelines[index] = &resource_cache.request_graphics_pipeline(*pipeline_state);
+	};
+}
+
+ResourceReplay::ResourceTask ResourceReplay::read_compute_pipeline(std::istream &stream, size_t index)
+{
+	size_t pipeline_layout_index{};
+
+	std::map<uint32_t, std::vector<uint8_t>> specialization_constant_state{};
+
+	read(stream,
+	     pipeline_layout_index,
+	     specialization_constant_state);
+
+	check_index(pipeline_layouts, pipeline_layout_index, "pipeline layout");
+
+	auto pipeline_state = std::make_shared<PipelineState>();
 
 	for (auto &item : specialization_constant_state)
 	{
-		pipeline_state.set_specialization_constant(item.first, item.second);
+		pipeline_state->set_specialization_constant(item.first, item.second);
 	}
 
-	pipeline_state.set_subpass_index(subpass_index);
-	pipeline_state.set_vertex_input_state(vertex_input_sate);
-	pipeline_state.set_input_assembly_state(input_assembly_state);
-	pipeline_state.set_rasterization_state(rasterization_state);
-	pipeline_state.set_viewport_state(viewport_state);
-	pipeline_state.set_multisample_state(multisample_state);
-	pipeline_state.set_depth_stencil_state(depth_stencil_state);
-	pipeline_state.set_color_blend_state(color_blend_state);
+	compute_pipelines.resize(std::max(compute_pipelines.size(), index + 1));
 
-	auto &graphics_pipeline = resource_cache.request_graphics_pipeline(pipeline_state);
+	return [this, index, pipeline_layout_index, pipeline_state](ResourceCache &resource_cache) {
+		pipeline_state->set_pipeline_layout(*pipeline_layouts.at(pipeline_layout_index));
 
-	graphics_pipelines.push_back(&graphics_pipeline);
+		compute_pipelines[index] = &resource_cache.request_compute_pipeline(*pipeline_state);
+	};
 }
 }        // namespace vkb
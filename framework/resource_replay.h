@@ -27,26 +27,71 @@ namespace vkb
 class ResourceCache;
 
 /**
- * @brief Reads Vulkan objects from a memory stream and creates them in the resource cache.
+ * @brief Replay stages, objects of a stage only depend on objects of earlier stages
+ */
+enum class ReplayStage
+{
+	Modules,
+	Layouts,
+	Pipelines
+};
+
+struct ReplayStageTime
+{
+	ReplayStage stage;
+
+	size_t count;
+
+	/// Wall time to create all objects of the stage, in milliseconds
+	double time;
+};
+
+/**
+ * @brief Reads Vulkan objects from the sections of a record and creates them in the resource cache.
+ *
+ * All records are read first, then each stage is created in parallel on a worker pool.
+ * Shader modules, descriptor set layouts and render passes come first, then pipeline layouts,
+ * then graphics and compute pipelines, which all feed the pipeline cache set on the resource cache.
  */
 class ResourceReplay
 {
   public:
 	ResourceReplay();
 
-	void play(ResourceCache &resource_cache, ResourceRecord &recorder);
+	/**
+	 * @brief Reads every record, then creates the objects stage by stage
+	 * @throws std::runtime_error if a record is truncated or refers to a missing object, which is
+	 *         detected before any object is created, or if an object cannot be created
+	 */
+	void play(ResourceCache &resource_cache, const RecordReader &reader);
+
+	/**
+	 * @return Time spent in each stage of the last play()
+	 */
+	const std::vector<ReplayStageTime> &get_stage_times() const;
 
   protected:
-	void create_shader_module(ResourceCache &resource_cache, std::istringstream &stream);
+	/// Creates a replayed object, may run on any thread
+	using ResourceTask = std::function<void(ResourceCache &)>;
+
+	ResourceTask read_shader_module(std::istream &stream, size_t index);
+
+	ResourceTask read_descriptor_set_layout(std::istream &stream, size_t index);
+
+	ResourceTask read_pipeline_layout(std::istream &stream, size_t index);
 
-	void create_pipeline_layout(ResourceCache &resource_cache, std::istringstream &stream);
+	ResourceTask read_render_pass(std::istream &stream, size_t index);
 
-	void create_render_pass(ResourceCache &resource_cache, std::istringstream &stream);
+	ResourceTask read_graphics_pipeline(std::istream &stream, size_t index);
 
-	void create_graphics_pipeline(ResourceCache &resource_cache, std::istringstream &stream);
+	ResourceTask read_compute_pipeline(std::istream &stream, size_t index);
 
   private:
-	using ResourceFunc = std::function<void(ResourceCache &, std::istringstream &)>;
+	using ResourceFunc = std::function<ResourceTask(std::istream &, size_t)>;
+
+	static ReplayStage get_replay_stage(ResourceType type);
+
+	static const char *get_replay_stage_name(ReplayStage stage);
 
 	std::unordered_map<ResourceType, ResourceFunc> stream_resources;
 
@@ -57,5 +102,9 @@ class ResourceReplay
 	std::vector<const RenderPass *> render_passes;
 
 	std::vector<const GraphicsPipeline *> graphics_pipelines;
+
+	std::vector<const ComputePipeline *> compute_pipelines;
+
+	std::vector<ReplayStageTime> stage_times;
 };
 }        // namespace vkb
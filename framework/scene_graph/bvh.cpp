@@ -0,0 +1,549 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "bvh.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace sg
+{
+namespace
+{
+/// Objects held by a leaf at most
+constexpr uint32_t MAX_LEAF_OBJECTS = 4;
+
+/// Tree depth which queries can traverse, far more than a median split builds
+constexpr size_t MAX_DEPTH = 64;
+
+constexpr uint32_t INVALID_INDEX = ~0U;
+
+/**
+ * @brief Finds the distance at which a ray enters a box
+ * @return Whether the ray hits the box before the maximum distance
+ */
+bool intersect_ray(const glm::vec3 &origin, const glm::vec3 &inverse_direction, const glm::vec3 &min, const glm::vec3 &max, float max_distance, float &distance)
+{
+	glm::vec3 t0 = (min - origin) * inverse_direction;
+	glm::vec3 t1 = (max - origin) * inverse_direction;
+
+	glm::vec3 t_near = glm::min(t0, t1);
+	glm::vec3 t_far  = glm::max(t0, t1);
+
+	float enter = std::max({t_near.x, t_near.y, t_near.z, 0.0f});
+	float exit  = std::min({t_far.x, t_far.y, t_far.z, max_distance});
+
+	distance = enter;
+
+	return enter <= exit;
+}
+}        // namespace
+
+BVH::~BVH()
+{
+	for (auto &transform_it : transform_objects)
+	{
+		transform_it.first->remove_observer(*this);
+	}
+}
+
+uint32_t BVH::add(Node &node, Component &component, ObjectType type, const glm::vec3 &min, const glm::vec3 &max)
+{
+	auto object_index = static_cast<uint32_t>(objects.size());
+
+	Object object{};
+	object.node      = &node;
+	object.component = &component;
+	object.type      = type;
+	object.local_min = min;
+	object.local_max = max;
+	object.leaf      = INVALID_INDEX;
+	object.moved     = false;
+
+	update_world_bounds(object);
+
+	objects.push_back(object);
+
+	auto &transform                = node.get_transform();
+	auto &transform_object_indices = transform_objects[&transform];
+	if (transform_object_indices.empty())
+	{
+		transform.add_observer(*this);
+	}
+	transform_object_indices.push_back(object_index);
+
+	return object_index;
+}
+
+void BVH::build()
+{
+	// Moved objects are up to date once the tree is built
+	for (auto object_index : moved_objects)
+	{
+		update_world_bounds(objects[object_index]);
+		objects[object_index].moved = false;
+	}
+	moved_objects.clear();
+
+	tree_nodes.clear();
+	tree_nodes.reserve(objects.size() * 2 / MAX_LEAF_OBJECTS + 1);
+
+	leaf_objects.resize(objects.size());
+	for (uint32_t i = 0; i < leaf_objects.size(); ++i)
+	{
+		leaf_objects[i] = i;
+	}
+
+	if (!objects.empty())
+	{
+		build_node(0, static_cast<uint32_t>(objects.size()), INVALID_INDEX);
+	}
+}
+
+uint32_t BVH::build_node(uint32_t first_object, uint32_t object_count, uint32_t parent)
+{
+	auto node_index = static_cast<uint32_t>(tree_nodes.size());
+
+	TreeNode tree_node{};
+	tree_node.parent       = parent;
+	tree_node.left         = INVALID_INDEX;
+	tree_node.right        = INVALID_INDEX;
+	tree_node.first_object = first_object;
+	tree_node.object_count = object_count;
+
+	tree_nodes.push_back(tree_node);
+
+	auto begin = leaf_objects.begin() + first_object;
+	auto end   = begin + object_count;
+
+	if (object_count <= MAX_LEAF_OBJECTS)
+	{
+		for (auto it = begin; it != end; ++it)
+		{
+			objects[*it].leaf = node_index;
+		}
+
+		refit_node(node_index);
+
+		return node_index;
+	}
+
+	// Split along the axis where the centers are the most spread
+	glm::vec3 center_min{std::numeric_limits<float>::max()};
+	glm::vec3 center_max{std::numeric_limits<float>::lowest()};
+
+	for (auto it = begin; it != end; ++it)
+	{
+		auto center = get_center(*it);
+		center_min  = glm::min(center_min, center);
+		center_max  = glm::max(center_max, center);
+	}
+
+	auto extent = center_max - center_min;
+	int  axis   = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+	auto middle = begin + object_count / 2;
+
+	std::nth_element(begin, middle, end, [this, axis](uint32_t a, uint32_t b) {
+		return get_center(a)[axis] < get_center(b)[axis];
+	});
+
+	uint32_t left_count = object_count / 2;
+
+	auto left  = build_node(first_object, left_count, node_index);
+	auto right = build_node(first_object + left_count, object_count - left_count, node_index);
+
+	// The children were pushed after the node, which may have moved in memory
+	tree_nodes[node_index].left         = left;
+	tree_nodes[node_index].right        = right;
+	tree_nodes[node_index].object_count = 0;
+
+	refit_node(node_index);
+
+	return node_index;
+}
+
+bool BVH::refit_node(uint32_t node_index)
+{
+	auto &tree_node = tree_nodes[node_index];
+
+	glm::vec3 min{std::numeric_limits<float>::max()};
+	glm::vec3 max{std::numeric_limits<float>::lowest()};
+	uint32_t  type_mask{0};
+
+	if (tree_node.object_count > 0)
+	{
+		for (uint32_t i = 0; i < tree_node.object_count; ++i)
+		{
+			const auto &object = objects[leaf_objects[tree_node.first_object + i]];
+
+			min = glm::min(min, object.min);
+			max = glm::max(max, object.max);
+			type_mask |= object.type;
+		}
+	}
+	else
+	{
+		for (auto child_index : {tree_node.left, tree_node.right})
+		{
+			const auto &child = tree_nodes[child_index];
+
+			min = glm::min(min, child.min);
+			max = glm::max(max, child.max);
+			type_mask |= child.type_mask;
+		}
+	}
+
+	bool changed = min != tree_node.min || max != tree_node.max;
+
+	tree_node.min       = min;
+	tree_node.max       = max;
+	tree_node.type_mask = type_mask;
+
+	return changed;
+}
+
+size_t BVH::update()
+{
+	size_t moved_count = moved_objects.size();
+
+	for (auto object_index : moved_objects)
+	{
+		auto &object = objects[object_index];
+
+		update_world_bounds(object);
+		object.moved = false;
+
+		// Refit up the tree until the bounds stop changing, as the nodes above are unions of their children
+		for (auto node_index = object.leaf; node_index != INVALID_INDEX; node_index = tree_nodes[node_index].parent)
+		{
+			if (!refit_node(node_index))
+			{
+				break;
+			}
+		}
+	}
+
+	moved_objects.clear();
+
+	return moved_count;
+}
+
+void BVH::update_world_bounds(Object &object)
+{
+	auto world_matrix = object.node->get_transform().get_world_matrix();
+
+	glm::vec3 center      = glm::vec3(world_matrix * glm::vec4((object.local_min + object.local_max) * 0.5f, 1.0f));
+	glm::vec3 half_extent = (object.local_max - object.local_min) * 0.5f;
+
+	// The range of a light is not affected by the scale of its node (KHR_lights_punctual)
+	if (object.type == LightObject)
+	{
+		object.min = center - half_extent;
+		object.max = center + half_extent;
+
+		return;
+	}
+
+	// Extent of the transformed box along the axes
+	glm::vec3 extent = glm::abs(glm::vec3(world_matrix[0])) * half_extent.x +
+	                   glm::abs(glm::vec3(world_matrix[1])) * half_extent.y +
+	                   glm::abs(glm::vec3(world_matrix[2])) * half_extent.z;
+
+	object.min = center - extent;
+	object.max = center + extent;
+}
+
+void BVH::on_world_matrix_invalidated(Transform &transform)
+{
+	auto transform_it = transform_objects.find(&transform);
+	if (transform_it == transform_objects.end())
+	{
+		return;
+	}
+
+	for (auto object_index : transform_it->second)
+	{
+		auto &object = objects[object_index];
+		if (!object.moved)
+		{
+			object.moved = true;
+			moved_objects.push_back(object_index);
+		}
+	}
+}
+
+size_t BVH::get_object_count() const
+{
+	return objects.size();
+}
+
+Node &BVH::get_node(uint32_t object) const
+{
+	return *objects[object].node;
+}
+
+Component &BVH::get_component(uint32_t object) const
+{
+	return *objects[object].component;
+}
+
+BVH::ObjectType BVH::get_type(uint32_t object) const
+{
+	return objects[object].type;
+}
+
+void BVH::get_bounds(uint32_t object, glm::vec3 &min, glm::vec3 &max) const
+{
+	min = objects[object].min;
+	max = objects[object].max;
+}
+
+glm::vec3 BVH::get_center(uint32_t object) const
+{
+	return (objects[object].min + objects[object].max) * 0.5f;
+}
+
+template <class Classify>
+void BVH::query(Classify classify, std::vector<uint32_t> &found_objects, uint32_t type_mask) const
+{
+	if (tree_nodes.empty())
+	{
+		return;
+	}
+
+	uint32_t stack[MAX_DEPTH];
+	size_t   stack_size{0};
+
+	stack[stack_size++] = 0;
+
+	while (stack_size > 0)
+	{
+		const auto &tree_node = tree_nodes[stack[--stack_size]];
+
+		if ((tree_node.type_mask & type_mask) == 0)
+		{
+			continue;
+		}
+
+		auto overlap = classify(tree_node.min, tree_node.max);
+
+		if (overlap == Overlap::Outside)
+		{
+			continue;
+		}
+
+		if (overlap == Overlap::Inside)
+		{
+			add_subtree_objects(static_cast<uint32_t>(&tree_node - tree_nodes.data()), found_objects, type_mask);
+			continue;
+		}
+
+		if (tree_node.object_count > 0)
+		{
+			for (uint32_t i = 0; i < tree_node.object_count; ++i)
+			{
+				auto        object_index = leaf_objects[tree_node.first_object + i];
+				const auto &object       = objects[object_index];
+
+				if ((object.type & type_mask) != 0 && classify(object.min, object.max) != Overlap::Outside)
+				{
+					found_objects.push_back(object_index);
+				}
+			}
+		}
+		else
+		{
+			assert(stack_size + 2 <= MAX_DEPTH && "BVH is too deep to traverse");
+
+			stack[stack_size++] = tree_node.right;
+			stack[stack_size++] = tree_node.left;
+		}
+	}
+}
+
+void BVH::add_subtree_objects(uint32_t node_index, std::vector<uint32_t> &found_objects, uint32_t type_mask) const
+{
+	// The objects of a subtree are a contiguous range, as the tree was built by partitioning them
+	uint32_t first = node_index;
+	uint32_t last  = node_index;
+
+	while (tree_nodes[first].object_count == 0)
+	{
+		first = tree_nodes[first].left;
+	}
+
+	while (tree_nodes[last].object_count == 0)
+	{
+		last = tree_nodes[last].right;
+	}
+
+	uint32_t begin = tree_nodes[first].first_object;
+	uint32_t end   = tree_nodes[last].first_object + tree_nodes[last].object_count;
+
+	for (uint32_t i = begin; i < end; ++i)
+	{
+		if ((objects[leaf_objects[i]].type & type_mask) != 0)
+		{
+			found_objects.push_back(leaf_objects[i]);
+		}
+	}
+}
+
+void BVH::query_frustum(const glm::vec4 *planes, std::vector<uint32_t> &found_objects, uint32_t type_mask) const
+{
+	query([planes](const glm::vec3 &min, const glm::vec3 &max) {
+		glm::vec3 center = (min + max) * 0.5f;
+		glm::vec3 extent = (max - min) * 0.5f;
+
+		auto overlap = Overlap::Inside;
+
+		for (size_t i = 0; i < 6; ++i)
+		{
+			const auto &plane = planes[i];
+
+			float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+			float radius   = glm::dot(glm::abs(glm::vec3(plane)), extent);
+
+			if (distance + radius < 0.0f)
+			{
+				return Overlap::Outside;
+			}
+
+			if (distance - radius < 0.0f)
+			{
+				overlap = Overlap::Intersecting;
+			}
+		}
+
+		return overlap;
+	},
+	      found_objects, type_mask);
+}
+
+void BVH::query_sphere(const glm::vec3 &center, float radius, std::vector<uint32_t> &found_objects, uint32_t type_mask) const
+{
+	float radius_squared = radius * radius;
+
+	query([&center, radius_squared](const glm::vec3 &min, const glm::vec3 &max) {
+		// Closest point of the box to the center of the sphere
+		glm::vec3 closest = glm::clamp(center, min, max) - center;
+
+		if (glm::dot(closest, closest) > radius_squared)
+		{
+			return Overlap::Outside;
+		}
+
+		// Farthest corner of the box from the center of the sphere
+		glm::vec3 farthest = glm::max(glm::abs(min - center), glm::abs(max - center));
+
+		return glm::dot(farthest, farthest) <= radius_squared ? Overlap::Inside : Overlap::Intersecting;
+	},
+	      found_objects, type_mask);
+}
+
+void BVH::query_box(const glm::vec3 &query_min, const glm::vec3 &query_max, std::vector<uint32_t> &found_objects, uint32_t type_mask) const
+{
+	query([&query_min, &query_max](const glm::vec3 &min, const glm::vec3 &max) {
+		if (glm::any(glm::lessThan(max, query_min)) || glm::any(glm::greaterThan(min, query_max)))
+		{
+			return Overlap::Outside;
+		}
+
+		if (glm::all(glm::greaterThanEqual(min, query_min)) && glm::all(glm::lessThanEqual(max, query_max)))
+		{
+			return Overlap::Inside;
+		}
+
+		return Overlap::Intersecting;
+	},
+	      found_objects, type_mask);
+}
+
+bool BVH::raycast(const glm::vec3 &origin, const glm::vec3 &direction, float max_distance, uint32_t &hit_object, float &hit_distance, uint32_t type_mask) const
+{
+	if (tree_nodes.empty())
+	{
+		return false;
+	}
+
+	glm::vec3 inverse_direction = 1.0f / direction;
+
+	bool  hit{false};
+	float closest_distance = max_distance;
+
+	uint32_t stack[MAX_DEPTH];
+	size_t   stack_size{0};
+
+	stack[stack_size++] = 0;
+
+	while (stack_size > 0)
+	{
+		const auto &tree_node = tree_nodes[stack[--stack_size]];
+
+		float distance;
+
+		// Skip nodes entered beyond the closest hit so far
+		if ((tree_node.type_mask & type_mask) == 0 ||
+		    !intersect_ray(origin, inverse_direction, tree_node.min, tree_node.max, closest_distance, distance))
+		{
+			continue;
+		}
+
+		if (tree_node.object_count > 0)
+		{
+			for (uint32_t i = 0; i < tree_node.object_count; ++i)
+			{
+				auto        object_index = leaf_objects[tree_node.first_object + i];
+				const auto &object       = objects[object_index];
+
+				if ((object.type & type_mask) != 0 &&
+				    intersect_ray(origin, inverse_direction, object.min, object.max, closest_distance, distance))
+				{
+					hit              = true;
+					hit_object       = object_index;
+					closest_distance = distance;
+				}
+			}
+		}
+		else
+		{
+			assert(stack_size + 2 <= MAX_DEPTH && "BVH is too deep to traverse");
+
+			stack[stack_size++] = tree_node.right;
+			stack[stack_size++] = tree_node.left;
+		}
+	}
+
+	if (hit)
+	{
+		hit_distance = closest_distance;
+	}
+
+	return hit;
+}
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,242 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "scene_graph/components/transform.h"
+
+namespace vkb
+{
+namespace sg
+{
+class Component;
+class Node;
+
+/**
+ * @brief Bounding volume hierarchy over the world bounds of scene objects, such as mesh
+ *        instances and light ranges. It is built once, then refitted as objects move:
+ *        their transforms notify the tree, so that an update costs as much as the moved
+ *        objects times the depth of the tree. Refitting keeps the topology of the tree,
+ *        which should be built again if the objects move far from where they started
+ */
+class BVH : public TransformObserver
+{
+  public:
+	/**
+	 * @brief Types of the objects, combined into masks to filter queries
+	 */
+	enum ObjectType : uint32_t
+	{
+		MeshObject  = 1U << 0,
+		LightObject = 1U << 1,
+		AllObjects  = ~0U
+	};
+
+	BVH() = default;
+
+	BVH(const BVH &) = delete;
+
+	BVH(BVH &&) = delete;
+
+	virtual ~BVH();
+
+	BVH &operator=(const BVH &) = delete;
+
+	BVH &operator=(BVH &&) = delete;
+
+	/**
+	 * @brief Adds an object, which is part of the tree once it is built
+	 * @param node Node placing the object in the world
+	 * @param component Component the object stands for, such as a Mesh or a Light
+	 * @param type Type of the object, to filter queries
+	 * @param min Minimum corner of the bounds of the object, in the space of the node
+	 * @param max Maximum corner of the bounds of the object, in the space of the node
+	 *            The bounds of a light are only moved by the node, as its range is not scaled
+	 * @return The index of the object
+	 */
+	uint32_t add(Node &node, Component &component, ObjectType type, const glm::vec3 &min, const glm::vec3 &max);
+
+	/**
+	 * @brief Builds the tree over all the objects, splitting them at the median
+	 *        of their centers along the longest axis
+	 */
+	void build();
+
+	/**
+	 * @brief Refits the bounds of the objects which moved since the last update,
+	 *        and of the tree nodes above them
+	 * @return The number of objects which moved
+	 */
+	size_t update();
+
+	size_t get_object_count() const;
+
+	Node &get_node(uint32_t object) const;
+
+	Component &get_component(uint32_t object) const;
+
+	ObjectType get_type(uint32_t object) const;
+
+	/**
+	 * @brief World bounds of an object, as of the last update
+	 */
+	void get_bounds(uint32_t object, glm::vec3 &min, glm::vec3 &max) const;
+
+	glm::vec3 get_center(uint32_t object) const;
+
+	/**
+	 * @brief Finds the objects intersecting a frustum. Subtrees outside a plane are skipped,
+	 *        and the objects of subtrees inside every plane are found without testing them
+	 * @param planes The six planes of the frustum, with normals pointing inside
+	 * @param objects Receives the indices of the objects found, after its existing elements
+	 * @param type_mask The types of the objects to find
+	 */
+	void query_frustum(const glm::vec4 *planes, std::vector<uint32_t> &objects, uint32_t type_mask = AllObjects) const;
+
+	/**
+	 * @brief Finds the objects intersecting a sphere, such as the range of a light
+	 * @param center Center of the sphere
+	 * @param radius Radius of the sphere
+	 * @param objects Receives the indices of the objects found, after its existing elements
+	 * @param type_mask The types of the objects to find
+	 */
+	void query_sphere(const glm::vec3 &center, float radius, std::vector<uint32_t> &objects, uint32_t type_mask = AllObjects) const;
+
+	/**
+	 * @brief Finds the objects intersecting an axis aligned box
+	 * @param min Minimum corner of the box
+	 * @param max Maximum corner of the box
+	 * @param objects Receives the indices of the objects found, after its existing elements
+	 * @param type_mask The types of the objects to find
+	 */
+	void query_box(const glm::vec3 &min, const glm::vec3 &max, std::vector<uint32_t> &objects, uint32_t type_mask = AllObjects) const;
+
+	/**
+	 * @brief Finds the closest object whose bounds are hit by a ray
+	 * @param origin Origin of the ray
+	 * @param direction Direction of the ray, distances are measured in its length
+	 * @param max_distance Distance beyond which objects are not hit
+	 * @param object Receives the index of the object hit
+	 * @param distance Receives the distance to the bounds of the object hit
+	 * @param type_mask The types of the objects to hit
+	 * @return Whether an object was hit
+	 */
+	bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, float max_distance, uint32_t &object, float &distance, uint32_t type_mask = AllObjects) const;
+
+	virtual void on_world_matrix_invalidated(Transform &transform) override;
+
+  private:
+	struct Object
+	{
+		Node *node;
+
+		Component *component;
+
+		ObjectType type;
+
+		glm::vec3 local_min;
+
+		glm::vec3 local_max;
+
+		glm::vec3 min;
+
+		glm::vec3 max;
+
+		/// Tree node holding the object
+		uint32_t leaf;
+
+		/// Whether the object is waiting for the next update
+		bool moved;
+	};
+
+	struct TreeNode
+	{
+		glm::vec3 min;
+
+		glm::vec3 max;
+
+		uint32_t parent;
+
+		/// Children of an internal node
+		uint32_t left;
+
+		uint32_t right;
+
+		/// Range of leaf_objects held by a leaf, which has no children
+		uint32_t first_object;
+
+		uint32_t object_count;
+
+		/// Types of the objects below the node
+		uint32_t type_mask;
+	};
+
+	/// Whether the bounds of a tree node are outside, partly inside or inside a query volume
+	enum class Overlap
+	{
+		Outside,
+		Intersecting,
+		Inside
+	};
+
+	uint32_t build_node(uint32_t first_object, uint32_t object_count, uint32_t parent);
+
+	/**
+	 * @brief Recomputes the bounds of a tree node from its children or its objects
+	 * @return Whether the bounds changed
+	 */
+	bool refit_node(uint32_t node_index);
+
+	void update_world_bounds(Object &object);
+
+	/**
+	 * @brief Visits the tree nodes overlapping a query volume and finds their objects
+	 * @param classify Function telling how a box overlaps the query volume
+	 */
+	template <class Classify>
+	void query(Classify classify, std::vector<uint32_t> &objects, uint32_t type_mask) const;
+
+	void add_subtree_objects(uint32_t node_index, std::vector<uint32_t> &objects, uint32_t type_mask) const;
+
+	std::vector<Object> objects;
+
+	std::vector<TreeNode> tree_nodes;
+
+	/// Objects ordered by leaf
+	std::vector<uint32_t> leaf_objects;
+
+	/// Objects placed by each transform observed
+	std::unordered_map<Transform *, std::vector<uint32_t>> transform_objects;
+
+	std::vector<uint32_t> moved_objects;
+};
+}        // namespace sg
+}        // namespace vkb
@@ -20,6 +20,8 @@
 
 #include "transform.h"
 
+#include <algorithm>
+
 VKBP_DISABLE_WARNINGS()
 #include <glm/gtx/matrix_decompose.hpp>
 VKBP_ENABLE_WARNINGS()
@@ -105,9 +107,43 @@ glm::mat4 Transform::get_world_matrix()
 	return world_matrix;
 }
 
+uint32_t Transform::get_world_matrix_version()
+{
+	update_world_transform();
+
+	return world_matrix_version;
+}
+
 void Transform::invalidate_world_matrix()
 {
+	// Observers and children were told when the matrix became invalid, and stay so until it is updated
+	if (update_world_matrix)
+	{
+		return;
+	}
+
 	update_world_matrix = true;
+
+	for (auto observer : observers)
+	{
+		observer->on_world_matrix_invalidated(*this);
+	}
+
+	// The world matrices of the children depend on this one
+	for (auto child : node.get_children())
+	{
+		child->get_transform().invalidate_world_matrix();
+	}
+}
+
+void Transform::add_observer(TransformObserver &observer)
+{
+	observers.push_back(&observer);
+}
+
+void Transform::remove_observer(TransformObserver &observer)
+{
+	observers.erase(std::remove(observers.begin(), observers.end(), &observer), observers.end());
 }
 
 void Transform::update_world_transform()
@@ -128,6 +164,8 @@ void Transform::update_world_transform()
 	}
 
 	update_world_matrix = false;
+
+	world_matrix_version++;
 }
 
 }        // namespace sg
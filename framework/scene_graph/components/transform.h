@@ -39,6 +39,19 @@ namespace vkb
 namespace sg
 {
 class Node;
+class Transform;
+
+/**
+ * @brief Interface of the structures which cache values derived from world matrices,
+ *        to be told when they become invalid
+ */
+class TransformObserver
+{
+  public:
+	virtual ~TransformObserver() = default;
+
+	virtual void on_world_matrix_invalidated(Transform &transform) = 0;
+};
 
 class Transform : public Component
 {
@@ -69,13 +82,29 @@ class Transform : public Component
 
 	glm::mat4 get_world_matrix();
 
+	/**
+	 * @brief Counts the updates of the world matrix, so that values derived from it
+	 *        can be cached until it changes
+	 * @return A number which changes whenever the world matrix is updated
+	 */
+	uint32_t get_world_matrix_version();
+
 	/**
 	 * @brief Marks the world transform invalid if any of
 	 *        the local transform are changed or the parent
-	 *        world transform has changed.
+	 *        world transform has changed, along with the
+	 *        world transforms of the children.
 	 */
 	void invalidate_world_matrix();
 
+	/**
+	 * @brief Registers an observer to be notified when the world matrix is invalidated,
+	 *        which must be removed before it is destroyed
+	 */
+	void add_observer(TransformObserver &observer);
+
+	void remove_observer(TransformObserver &observer);
+
   private:
 	Node &node;
 
@@ -89,6 +118,10 @@ class Transform : public Component
 
 	bool update_world_matrix = false;
 
+	uint32_t world_matrix_version = 0;
+
+	std::vector<TransformObserver *> observers;
+
 	void update_world_transform();
 };
 
@@ -24,6 +24,7 @@
 
 #include "common/error.h"
 #include "component.h"
+#include "components/mesh.h"
 #include "node.h"
 
 namespace vkb
@@ -130,5 +131,40 @@ Node &Scene::get_root_node()
 {
 	return *root;
 }
+
+BVH &Scene::get_bvh()
+{
+	if (bvh)
+	{
+		return *bvh;
+	}
+
+	bvh = std::make_unique<BVH>();
+
+	for (auto mesh : get_components<Mesh>())
+	{
+		const auto &bounds = mesh->get_bounds();
+
+		for (auto node : mesh->get_nodes())
+		{
+			bvh->add(*node, *mesh, BVH::MeshObject, bounds.get_min(), bounds.get_max());
+		}
+	}
+
+	// Directional lights and lights without a range reach the whole scene
+	for (auto light : get_components<Light>())
+	{
+		float range = light->get_properties().range;
+
+		if (light->get_node() && light->get_light_type() != LightType::Directional && range > 0.0f)
+		{
+			bvh->add(*light->get_node(), *light, BVH::LightObject, glm::vec3{-range}, glm::vec3{range});
+		}
+	}
+
+	bvh->build();
+
+	return *bvh;
+}
 }        // namespace sg
 }        // namespace vkb
@@ -27,6 +27,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "scene_graph/bvh.h"
 #include "scene_graph/components/light.h"
 #include "scene_graph/components/texture.h"
 
@@ -130,6 +131,13 @@ class Scene
 
 	Node &get_root_node();
 
+	/**
+	 * @brief Bounding volume hierarchy over the world bounds of the mesh instances and of the
+	 *        ranges of the point and spot lights, built from the components on first use.
+	 *        BVH::update refits it once nodes moved
+	 */
+	BVH &get_bvh();
+
   private:
 	std::string name;
 
@@ -139,6 +147,9 @@ class Scene
 	Node *root{nullptr};
 
 	std::unordered_map<std::type_index, std::vector<std::unique_ptr<Component>>> components;
+
+	/// Destroyed before the nodes it observes
+	std::unique_ptr<BVH> bvh;
 };
 }        // namespace sg
 }        // namespace vkb
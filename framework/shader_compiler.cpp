@@ -0,0 +1,128 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "shader_compiler.h"
+
+#include <ctpl_stl.h>
+
+#include "glsl_compiler.h"
+#include "spirv_cache.h"
+
+namespace vkb
+{
+namespace
+{
+ShaderCompileResult compile_glsl(VkShaderStageFlagBits stage, const std::vector<uint8_t> &glsl_source, const std::string &entry_point, const ShaderVariant &shader_variant)
+{
+	ShaderCompileResult result;
+
+	GLSLCompiler glsl_compiler;
+
+	result.success = glsl_compiler.compile_to_spirv(stage, glsl_source, entry_point, shader_variant, result.spirv, result.info_log);
+
+	return result;
+}
+}        // namespace
+
+ShaderCompiler &ShaderCompiler::get()
+{
+	static ShaderCompiler shader_compiler;
+
+	return shader_compiler;
+}
+
+ShaderCompiler::ShaderCompiler()
+{
+	// Make glslang outlive the worker pool
+	GLSLCompiler::initialize_process();
+
+	auto thread_count = std::thread::hardware_concurrency();
+	thread_count      = thread_count == 0 ? 1 : thread_count;
+
+	thread_pool = std::make_unique<ctpl::thread_pool>(thread_count);
+}
+
+ShaderCompiler::~ShaderCompiler()
+{
+	thread_pool.reset();
+}
+
+ShaderCompileJob ShaderCompiler::compile_async(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant, const std::string &entry_point)
+{
+	uint64_t key = SpirvCache::get_key(stage, glsl_source, entry_point, shader_variant);
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto job_it = jobs.find(key);
+
+	if (job_it != jobs.end())
+	{
+		return job_it->second;
+	}
+
+	// The job keeps its own copies, as the caller may release them before it runs
+	auto job = thread_pool->push([stage, source = glsl_source.get_data(), entry_point, shader_variant](size_t) {
+		return compile_glsl(stage, source, entry_point, shader_variant);
+	});
+
+	return jobs.emplace(key, job.share()).first->second;
+}
+
+ShaderCompileResult ShaderCompiler::compile(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const std::string &entry_point, const ShaderVariant &shader_variant)
+{
+	uint64_t key = SpirvCache::get_key(stage, glsl_source, entry_point, shader_variant);
+
+	ShaderCompileJob job;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto job_it = jobs.find(key);
+
+		if (job_it != jobs.end())
+		{
+			job = std::move(job_it->second);
+			jobs.erase(job_it);
+		}
+	}
+
+	if (job.valid())
+	{
+		return job.get();
+	}
+
+	return compile_glsl(stage, glsl_source.get_data(), entry_point, shader_variant);
+}
+
+void ShaderCompiler::release(uint64_t key)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	jobs.erase(key);
+}
+
+void ShaderCompiler::wait(const std::vector<ShaderCompileJob> &jobs)
+{
+	for (auto &job : jobs)
+	{
+		job.wait();
+	}
+}
+}        // namespace vkb
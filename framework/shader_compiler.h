@@ -0,0 +1,121 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/vk_common.h"
+#include "core/shader_module.h"
+
+namespace ctpl
+{
+class thread_pool;
+}
+
+namespace vkb
+{
+/**
+ * @brief Output of a GLSL to SPIR-V compilation
+ */
+struct ShaderCompileResult
+{
+	bool success{false};
+
+	std::vector<uint32_t> spirv;
+
+	std::string info_log;
+};
+
+using ShaderCompileJob = std::shared_future<ShaderCompileResult>;
+
+/**
+ * @brief Process-wide service compiling GLSL to SPIR-V on a pool of worker threads.
+ *
+ * Jobs are identified by the SPIR-V cache key of their inputs: submitting the same shader twice
+ * returns the pending job, and a ShaderModule created for a submitted shader takes its result
+ * instead of compiling again. This lets a subpass submit all its variants up front, wait once,
+ * and then create its modules without touching glslang. Jobs which no ShaderModule takes must be
+ * released, as the compiler keeps their result until then.
+ */
+class ShaderCompiler
+{
+  public:
+	/**
+	 * @return The compiler service of the process
+	 */
+	static ShaderCompiler &get();
+
+	ShaderCompiler(const ShaderCompiler &) = delete;
+
+	ShaderCompiler(ShaderCompiler &&) = delete;
+
+	~ShaderCompiler();
+
+	ShaderCompiler &operator=(const ShaderCompiler &) = delete;
+
+	ShaderCompiler &operator=(ShaderCompiler &&) = delete;
+
+	/**
+	 * @brief Queues the compilation of a shader on the worker pool
+	 * @return The job, which holds the result until a ShaderModule takes it or it is released
+	 */
+	ShaderCompileJob compile_async(VkShaderStageFlagBits stage,
+	                               const ShaderSource &  glsl_source,
+	                               const ShaderVariant & shader_variant,
+	                               const std::string &   entry_point = "main");
+
+	/**
+	 * @brief Compiles a shader, taking the result of its pending job if there is one,
+	 *        otherwise compiling on the calling thread
+	 */
+	ShaderCompileResult compile(VkShaderStageFlagBits stage,
+	                            const ShaderSource &  glsl_source,
+	                            const std::string &   entry_point,
+	                            const ShaderVariant & shader_variant);
+
+	/**
+	 * @brief Drops the job of a shader, if any, once its result is not needed anymore
+	 * @param key The SPIR-V cache key of the shader
+	 */
+	void release(uint64_t key);
+
+	/**
+	 * @brief Waits for a batch of jobs
+	 */
+	static void wait(const std::vector<ShaderCompileJob> &jobs);
+
+  private:
+	ShaderCompiler();
+
+	/// Pending and finished jobs not taken yet, by SPIR-V cache key
+	std::unordered_map<uint64_t, ShaderCompileJob> jobs;
+
+	std::mutex mutex;
+
+	std::unique_ptr<ctpl::thread_pool> thread_pool;
+};
+}        // namespace vkb
@@ -0,0 +1,591 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "spirv_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <sstream>
+
+#include "common/helpers.h"
+#include "common/logging.h"
+#include "core/shader_module.h"
+#include "glsl_compiler.h"
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+namespace
+{
+inline uint64_t hash_string(const std::string &value, uint64_t seed)
+{
+	// Hash the length as well, so that consecutive strings cannot alias
+	uint64_t size = value.size();
+	seed          = hash_bytes(reinterpret_cast<const uint8_t *>(&size), sizeof(size), seed);
+
+	return hash_bytes(reinterpret_cast<const uint8_t *>(value.data()), value.size(), seed);
+}
+
+template <class T>
+inline uint64_t hash_value(const T &value, uint64_t seed)
+{
+	return hash_bytes(reinterpret_cast<const uint8_t *>(&value), sizeof(T), seed);
+}
+
+inline void write_shader_resources(std::ostringstream &os, const std::vector<ShaderResource> &value)
+{
+	write(os, value.size());
+	for (const ShaderResource &item : value)
+	{
+		write(os,
+		      item.stages,
+		      item.type,
+		      item.set,
+		      item.binding,
+		      item.location,
+		      item.input_attachment_index,
+		      item.vec_size,
+		      item.columns,
+		      item.array_size,
+		      item.offset,
+		      item.size,
+		      item.constant_id,
+		      item.dynamic,
+		      item.name);
+	}
+}
+
+inline bool read_shader_resources(std::istream &is, size_t end, std::vector<ShaderResource> &value)
+{
+	std::size_t size{0};
+	read(is, size);
+
+	// Every resource takes more than one byte, which bounds the count of a corrupt entry
+	if (!is || size > end - static_cast<size_t>(is.tellg()))
+	{
+		return false;
+	}
+
+	value.resize(size);
+	for (ShaderResource &item : value)
+	{
+		read(is,
+		     item.stages,
+		     item.type,
+		     item.set,
+		     item.binding,
+		     item.location,
+		     item.input_attachment_index,
+		     item.vec_size,
+		     item.columns,
+		     item.array_size,
+		     item.offset,
+		     item.size,
+		     item.constant_id,
+		     item.dynamic);
+
+		std::size_t name_size{0};
+		read(is, name_size);
+
+		if (!is || name_size > end - static_cast<size_t>(is.tellg()))
+		{
+			return false;
+		}
+
+		item.name.resize(name_size);
+		is.read(&item.name[0], name_size);
+	}
+
+	return static_cast<bool>(is);
+}
+
+/**
+ * @brief Read-only stream buffer over the mapped cache file, which reports its position to tellg()
+ */
+class MemoryBuffer : public std::streambuf
+{
+  public:
+	MemoryBuffer(const uint8_t *data, size_t size)
+	{
+		char *begin = const_cast<char *>(reinterpret_cast<const char *>(data));
+		setg(begin, begin, begin + size);
+	}
+
+  protected:
+	pos_type seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+	{
+		if (which != std::ios_base::in || dir != std::ios_base::cur || offset != 0)
+		{
+			return pos_type(off_type(-1));
+		}
+
+		return pos_type(gptr() - eback());
+	}
+};
+}        // namespace
+
+const uint32_t SpirvCache::MAGIC;
+
+const uint32_t SpirvCache::VERSION;
+
+SpirvCache::SpirvCache(const std::string &filename, std::size_t max_size) :
+    filename{filename},
+    max_size{max_size}
+{
+}
+
+SpirvCache::~SpirvCache()
+{
+	save();
+}
+
+uint64_t SpirvCache::get_key(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const std::string &entry_point, const ShaderVariant &shader_variant)
+{
+	auto &data = glsl_source.get_data();
+
+	uint64_t key = hash_bytes(data.data(), data.size());
+
+	key = hash_value(static_cast<uint32_t>(stage), key);
+	key = hash_value(GLSLCompiler::get_version(), key);
+	key = hash_string(entry_point, key);
+	key = hash_string(shader_variant.get_preamble(), key);
+
+	for (auto &process : shader_variant.get_processes())
+	{
+		key = hash_string(process, key);
+	}
+
+	return key;
+}
+
+uint64_t SpirvCache::get_reflection_key(const ShaderVariant &shader_variant)
+{
+	// Sort the sizes, as the hash must not depend on the map order
+	std::vector<std::pair<std::string, size_t>> runtime_array_sizes{shader_variant.get_runtime_array_sizes().begin(),
+	                                                                 shader_variant.get_runtime_array_sizes().end()};
+	std::sort(runtime_array_sizes.begin(), runtime_array_sizes.end());
+
+	uint64_t key = hash_bytes(nullptr, 0);
+
+	for (auto &runtime_array_size : runtime_array_sizes)
+	{
+		key = hash_string(runtime_array_size.first, key);
+		key = hash_value(static_cast<uint64_t>(runtime_array_size.second), key);
+	}
+
+	return key;
+}
+
+bool SpirvCache::find(uint64_t key, std::vector<uint32_t> &spirv)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	load();
+
+	auto it = entries.find(key);
+
+	if (it == entries.end())
+	{
+		++counters.misses;
+		return false;
+	}
+
+	++counters.hits;
+
+	it->second.last_used = ++access_clock;
+
+	spirv.resize(it->second.word_count);
+	std::memcpy(spirv.data(), get_spirv_bytes(it->second), it->second.word_count * sizeof(uint32_t));
+
+	return true;
+}
+
+bool SpirvCache::find_resources(uint64_t key, uint64_t reflection_key, std::vector<ShaderResource> &resources)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	load();
+
+	auto it = entries.find(key);
+
+	if (it == entries.end() || !it->second.has_resources || it->second.reflection_key != reflection_key)
+	{
+		return false;
+	}
+
+	resources = it->second.resources;
+
+	return true;
+}
+
+void SpirvCache::insert_resources(uint64_t key, uint64_t reflection_key, const std::vector<ShaderResource> &resources)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	load();
+
+	auto it = entries.find(key);
+
+	// The SPIR-V may have been evicted meanwhile
+	if (it == entries.end())
+	{
+		return;
+	}
+
+	it->second.has_resources  = true;
+	it->second.reflection_key = reflection_key;
+	it->second.resources      = resources;
+
+	dirty = true;
+}
+
+bool SpirvCache::contains(uint64_t key)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	load();
+
+	return entries.find(key) != entries.end();
+}
+
+void SpirvCache::insert(uint64_t key, const std::vector<uint32_t> &spirv)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	load();
+
+	auto &entry = entries[key];
+
+	counters.size -= entry.word_count * sizeof(uint32_t);
+
+	entry.last_used  = ++access_clock;
+	entry.spirv      = spirv;
+	entry.word_count = spirv.size();
+
+	counters.size += entry.word_count * sizeof(uint32_t);
+
+	dirty = true;
+
+	evict();
+}
+
+void SpirvCache::set_max_size(std::size_t new_max_size)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	max_size = new_max_size;
+
+	evict();
+}
+
+bool SpirvCache::save()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (!dirty)
+	{
+		return true;
+	}
+
+	std::ostringstream os;
+
+	write(os, MAGIC, VERSION, GLSLCompiler::get_version(), access_clock, entries.size());
+
+	// Where the SPIR-V of each entry is written, to read it from the file once it is mapped
+	std::vector<std::pair<uint64_t, size_t>> file_offsets;
+	file_offsets.reserve(entries.size());
+
+	for (auto &entry_it : entries)
+	{
+		auto &entry = entry_it.second;
+
+		write(os, entry_it.first, entry.last_used, entry.word_count);
+
+		file_offsets.emplace_back(entry_it.first, static_cast<size_t>(os.tellp()));
+		os.write(reinterpret_cast<const char *>(get_spirv_bytes(entry)), entry.word_count * sizeof(uint32_t));
+
+		write(os, entry.has_resources, entry.reflection_key);
+		write_shader_resources(os, entry.resources);
+	}
+
+	std::string          payload = os.str();
+	std::vector<uint8_t> data{payload.begin(), payload.end()};
+
+	// Trailing checksum, to reject files which were truncated or corrupted
+	uint64_t checksum = hash_bytes(data.data(), data.size());
+	data.insert(data.end(), reinterpret_cast<const uint8_t *>(&checksum), reinterpret_cast<const uint8_t *>(&checksum) + sizeof(checksum));
+
+	// Written next to the cache file and renamed over it, so that a crash while writing leaves the
+	// previous file intact, and processes which mapped it keep reading the previous content
+	std::random_device random;
+	std::string        temp_filename = filename + "." + std::to_string(random()) + ".tmp";
+
+	bool written = true;
+
+	try
+	{
+		fs::write_temp(data, temp_filename);
+	}
+	catch (const std::runtime_error &e)
+	{
+		LOGW("SPIR-V cache not saved: {}", e.what());
+		written = false;
+	}
+
+	if (written)
+	{
+		// Windows cannot replace a file this process maps
+		file.reset();
+
+		try
+		{
+			fs::rename_temp(temp_filename, filename);
+		}
+		catch (const std::runtime_error &e)
+		{
+			LOGW("SPIR-V cache not saved: {}", e.what());
+			written = false;
+		}
+	}
+
+	if (!written)
+	{
+		std::remove((fs::path::get(fs::path::Type::Temp) + temp_filename).c_str());
+
+		// The entries still read from the previous file if it is mapped
+		if (file)
+		{
+			return false;
+		}
+	}
+	else
+	{
+		try
+		{
+			file = fs::map_temp(filename);
+		}
+		catch (const std::runtime_error &e)
+		{
+			LOGW("SPIR-V cache file not mapped: {}", e.what());
+		}
+	}
+
+	if (file && file->get_size() != data.size())
+	{
+		file.reset();
+	}
+
+	// Read the SPIR-V from the new file, or keep it in memory if it cannot be mapped
+	for (auto &file_offset : file_offsets)
+	{
+		auto &entry = entries[file_offset.first];
+
+		if (file)
+		{
+			entry.file_offset = file_offset.second;
+			std::vector<uint32_t>{}.swap(entry.spirv);
+		}
+		else
+		{
+			entry.spirv.resize(entry.word_count);
+			std::memcpy(entry.spirv.data(), data.data() + file_offset.second, entry.word_count * sizeof(uint32_t));
+		}
+	}
+
+	if (!written)
+	{
+		return false;
+	}
+
+	dirty = false;
+
+	return true;
+}
+
+void SpirvCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	entries.clear();
+	file.reset();
+
+	counters.entry_count = 0;
+	counters.size        = 0;
+
+	// Overwrite the file on the next save, even if nothing is added
+	loaded = true;
+	dirty  = true;
+}
+
+SpirvCacheCounters SpirvCache::get_counters() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	SpirvCacheCounters result = counters;
+
+	result.entry_count = entries.size();
+
+	return result;
+}
+
+void SpirvCache::load()
+{
+	if (loaded)
+	{
+		return;
+	}
+
+	loaded = true;
+
+	std::unique_ptr<fs::MappedFile> mapped_file;
+
+	try
+	{
+		mapped_file = fs::map_temp(filename);
+	}
+	catch (const std::runtime_error &)
+	{
+		// No cache yet
+		return;
+	}
+
+	const uint8_t *data = mapped_file->get_data();
+
+	if (mapped_file->get_size() < sizeof(uint64_t))
+	{
+		LOGW("SPIR-V cache discarded: file is truncated");
+		return;
+	}
+
+	size_t   payload_size = mapped_file->get_size() - sizeof(uint64_t);
+	uint64_t checksum     = 0;
+	std::memcpy(&checksum, data + payload_size, sizeof(checksum));
+
+	if (hash_bytes(data, payload_size) != checksum)
+	{
+		LOGW("SPIR-V cache discarded: checksum mismatch");
+		return;
+	}
+
+	MemoryBuffer buffer{data, payload_size};
+	std::istream is{&buffer};
+
+	uint32_t    magic{0};
+	uint32_t    version{0};
+	uint32_t    compiler_version{0};
+	uint64_t    clock{0};
+	std::size_t entry_count{0};
+
+	read(is, magic, version, compiler_version, clock, entry_count);
+
+	if (!is || magic != MAGIC || version != VERSION || compiler_version != GLSLCompiler::get_version())
+	{
+		LOGI("SPIR-V cache discarded: created by a different version");
+		return;
+	}
+
+	std::unordered_map<uint64_t, Entry> loaded_entries;
+	std::size_t                         loaded_size = 0;
+
+	for (std::size_t i = 0; i < entry_count; ++i)
+	{
+		uint64_t key{0};
+		Entry    entry;
+
+		read(is, key, entry.last_used, entry.word_count);
+
+		if (!is || entry.word_count > (payload_size - static_cast<size_t>(is.tellg())) / sizeof(uint32_t))
+		{
+			LOGW("SPIR-V cache discarded: malformed entry");
+			return;
+		}
+
+		// The SPIR-V stays in the file, and is copied on a hit
+		entry.file_offset = static_cast<size_t>(is.tellg());
+		is.ignore(static_cast<std::streamsize>(entry.word_count * sizeof(uint32_t)));
+
+		read(is, entry.has_resources, entry.reflection_key);
+
+		if (!read_shader_resources(is, payload_size, entry.resources))
+		{
+			LOGW("SPIR-V cache discarded: malformed entry");
+			return;
+		}
+
+		loaded_size += entry.word_count * sizeof(uint32_t);
+		loaded_entries[key] = std::move(entry);
+	}
+
+	entries      = std::move(loaded_entries);
+	file         = std::move(mapped_file);
+	access_clock = clock;
+
+	counters.size = loaded_size;
+
+	evict();
+}
+
+void SpirvCache::evict()
+{
+	if (counters.size <= max_size)
+	{
+		return;
+	}
+
+	std::vector<std::pair<uint64_t, uint64_t>> by_last_use;
+	by_last_use.reserve(entries.size());
+
+	for (auto &entry_it : entries)
+	{
+		by_last_use.emplace_back(entry_it.second.last_used, entry_it.first);
+	}
+
+	std::sort(by_last_use.begin(), by_last_use.end());
+
+	for (auto &item : by_last_use)
+	{
+		if (counters.size <= max_size)
+		{
+			break;
+		}
+
+		auto it = entries.find(item.second);
+
+		counters.size -= it->second.word_count * sizeof(uint32_t);
+		++counters.evictions;
+
+		entries.erase(it);
+	}
+
+	dirty = true;
+}
+
+const uint8_t *SpirvCache::get_spirv_bytes(const Entry &entry) const
+{
+	if (!entry.spirv.empty() || entry.word_count == 0)
+	{
+		return reinterpret_cast<const uint8_t *>(entry.spirv.data());
+	}
+
+	return file->get_data() + entry.file_offset;
+}
+}        // namespace vkb
@@ -0,0 +1,207 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/vk_common.h"
+#include "core/shader_module.h"
+
+namespace vkb
+{
+namespace fs
+{
+class MappedFile;
+}        // namespace fs
+
+/**
+ * @brief Lookups served by a SpirvCache
+ */
+struct SpirvCacheCounters
+{
+	uint64_t hits{0};
+
+	uint64_t misses{0};
+
+	/// Entries dropped to stay within the size limit
+	uint64_t evictions{0};
+
+	std::size_t entry_count{0};
+
+	/// Total size of the cached SPIR-V in bytes
+	std::size_t size{0};
+};
+
+/**
+ * @brief Persistent cache of SPIR-V compiled from GLSL, and of the resources reflected from it.
+ *
+ * Entries are keyed by a stable hash of the GLSL source, the shader variant preamble and processes,
+ * the stage, the entry point and the glslang version, so a hit can skip the compiler entirely.
+ * Reflected resources also depend on the runtime array sizes of the variant, which are checked
+ * against a separate reflection key.
+ * The cache file is mapped from the temporary directory on first use, and the SPIR-V of its entries
+ * is read from the mapping on a hit, so it is not copied to the heap. SPIR-V added since is held in
+ * memory until save() writes the file again and maps it, which the cache does on destruction, so that
+ * the render loop never waits for the file to be written. The least recently used entries are
+ * evicted above the size limit.
+ * All methods are thread-safe.
+ */
+class SpirvCache
+{
+  public:
+	/**
+	 * @param filename Name of the cache file in the temporary directory
+	 * @param max_size Size limit of the cached SPIR-V in bytes
+	 */
+	SpirvCache(const std::string &filename = "spirv_cache.bin", std::size_t max_size = 32 * 1024 * 1024);
+
+	SpirvCache(const SpirvCache &) = delete;
+
+	SpirvCache(SpirvCache &&) = delete;
+
+	~SpirvCache();
+
+	SpirvCache &operator=(const SpirvCache &) = delete;
+
+	SpirvCache &operator=(SpirvCache &&) = delete;
+
+	/**
+	 * @return The key of the SPIR-V compiled from the given GLSL source and options
+	 */
+	static uint64_t get_key(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const std::string &entry_point, const ShaderVariant &shader_variant);
+
+	/**
+	 * @return The key of the resources reflected with the runtime array sizes of a variant
+	 */
+	static uint64_t get_reflection_key(const ShaderVariant &shader_variant);
+
+	/**
+	 * @brief Looks up the SPIR-V of a key
+	 * @param key The key returned by get_key()
+	 * @param[out] spirv The cached SPIR-V, if found
+	 * @return True on a hit
+	 */
+	bool find(uint64_t key, std::vector<uint32_t> &spirv);
+
+	/**
+	 * @return True if the SPIR-V of a key is cached, without counting a lookup
+	 */
+	bool contains(uint64_t key);
+
+	/**
+	 * @brief Adds the SPIR-V of a key, evicting old entries over the size limit
+	 */
+	void insert(uint64_t key, const std::vector<uint32_t> &spirv);
+
+	/**
+	 * @brief Looks up the resources reflected from the SPIR-V of a key
+	 * @param key The key returned by get_key()
+	 * @param reflection_key The key returned by get_reflection_key()
+	 * @param[out] resources The cached resources, if found
+	 * @return True if the resources were cached for both keys
+	 */
+	bool find_resources(uint64_t key, uint64_t reflection_key, std::vector<ShaderResource> &resources);
+
+	/**
+	 * @brief Stores the resources reflected from the SPIR-V of a key, if it is cached
+	 */
+	void insert_resources(uint64_t key, uint64_t reflection_key, const std::vector<ShaderResource> &resources);
+
+	/**
+	 * @brief Sets the size limit, evicting old entries if needed
+	 */
+	void set_max_size(std::size_t max_size);
+
+	/**
+	 * @brief Writes the cache to its file if it changed since it was loaded, then maps the file
+	 *        and frees the SPIR-V held in memory. The file is written under a temporary name and
+	 *        renamed over the previous one, so that it is never seen partially written
+	 * @return False if the file could not be written
+	 */
+	bool save();
+
+	/**
+	 * @brief Removes all entries, the file is emptied by the next save()
+	 */
+	void clear();
+
+	SpirvCacheCounters get_counters() const;
+
+  private:
+	struct Entry
+	{
+		/// Value of the access clock when the entry was last used
+		uint64_t last_used{0};
+
+		/// SPIR-V added since the file was mapped, empty if it is in the file
+		std::vector<uint32_t> spirv;
+
+		/// Location of the SPIR-V in the mapped file, in bytes
+		std::size_t file_offset{0};
+
+		std::size_t word_count{0};
+
+		bool has_resources{false};
+
+		uint64_t reflection_key{0};
+
+		std::vector<ShaderResource> resources;
+	};
+
+	static const uint32_t MAGIC = 0x56505353;
+
+	static const uint32_t VERSION = 2;
+
+	std::string filename;
+
+	std::size_t max_size;
+
+	std::unordered_map<uint64_t, Entry> entries;
+
+	/// The cache file, which holds the SPIR-V of the entries not in memory
+	std::unique_ptr<fs::MappedFile> file;
+
+	/// Increased on every access, to order entries by last use
+	uint64_t access_clock{0};
+
+	bool loaded{false};
+
+	bool dirty{false};
+
+	SpirvCacheCounters counters;
+
+	mutable std::mutex mutex;
+
+	/// Maps the cache file and reads its entries, the caller must hold the mutex
+	void load();
+
+	/// @return The SPIR-V of an entry, in memory or in the mapped file, the caller must hold the mutex
+	const uint8_t *get_spirv_bytes(const Entry &entry) const;
+
+	/// Drops least recently used entries over the size limit, the caller must hold the mutex
+	void evict();
+};
+}        // namespace vkb
@@ -20,7 +20,9 @@
 
 #include "stats.h"
 
+#include "common/allocation_counter.h"
 #include "common/error.h"
+#include "resource_cache.h"
 
 namespace vkb
 {
@@ -58,6 +60,29 @@ Stats::Stats(const std::set<StatIndex> &enabled_stats, CounterSamplingConfig sam
 	    {StatIndex::l2_ext_read_bytes, {hwcpipe::GpuCounter::ExternalMemoryReadBytes}},
 	    {StatIndex::l2_ext_write_bytes, {hwcpipe::GpuCounter::ExternalMemoryWriteBytes}},
 	    {StatIndex::tex_cycles, {hwcpipe::GpuCounter::ShaderTextureCycles}},
+	    {StatIndex::cache_hits, {ResourceCacheCounter::Hits}},
+	    {StatIndex::cache_creation_time, {ResourceCacheCounter::CreationTime}},
+	    {StatIndex::cache_objects, {ResourceCacheCounter::Objects}},
+	    {StatIndex::cache_host_bytes, {ResourceCacheCounter::HostBytes}},
+	    {StatIndex::shader_module_misses, {ResourceCacheCounter::Misses, {"shader_modules"}}},
+	    {StatIndex::pipeline_layout_misses, {ResourceCacheCounter::Misses, {"pipeline_layouts"}}},
+	    {StatIndex::descriptor_set_layout_misses, {ResourceCacheCounter::Misses, {"descriptor_set_layouts"}}},
+	    {StatIndex::pipeline_misses, {ResourceCacheCounter::Misses, {"graphics_pipelines", "compute_pipelines"}}},
+	    {StatIndex::descriptor_set_misses, {ResourceCacheCounter::Misses, {"descriptor_sets"}}},
+	    {StatIndex::render_pass_misses, {ResourceCacheCounter::Misses, {"render_passes"}}},
+	    {StatIndex::framebuffer_misses, {ResourceCacheCounter::Misses, {"framebuffers"}}},
+	    {StatIndex::descriptor_pools_created, {FrameCounter::DescriptorPoolsCreated}},
+	    {StatIndex::descriptor_sets_allocated, {FrameCounter::DescriptorSetsAllocated}},
+	    {StatIndex::descriptor_allocation_failures, {FrameCounter::DescriptorAllocationFailures}},
+	    {StatIndex::heap_allocations, {StatScaling::None}},
+	    {StatIndex::state_commands_issued, {FrameCounter::StateCommandsIssued}},
+	    {StatIndex::state_commands_eliminated, {FrameCounter::StateCommandsEliminated}},
+	    {StatIndex::pipeline_binds_eliminated, {FrameCounter::StateCommandsEliminated, {StateCommand::BindPipeline}}},
+	    {StatIndex::descriptor_set_binds_eliminated, {FrameCounter::StateCommandsEliminated, {StateCommand::BindDescriptorSets}}},
+	    {StatIndex::buffer_binds_eliminated, {FrameCounter::StateCommandsEliminated, {StateCommand::BindVertexBuffers, StateCommand::BindIndexBuffer}}},
+	    {StatIndex::dynamic_state_sets_eliminated, {FrameCounter::StateCommandsEliminated, {StateCommand::SetViewport, StateCommand::SetScissor}}},
+	    {StatIndex::meshes_visible, {FrameCounter::MeshesVisible}},
+	    {StatIndex::meshes_culled, {FrameCounter::MeshesCulled}},
 	};
 
 	hwcpipe::CpuCounterSet enabled_cpu_counters{};
@@ -140,6 +165,11 @@ bool Stats::is_available(const StatIndex index) const
 		return false;
 	}
 
+	if (index == StatIndex::heap_allocations)
+	{
+		return is_heap_allocation_tracking_enabled();
+	}
+
 	switch (data->second.type)
 	{
 		case StatType::Cpu:
@@ -160,6 +190,8 @@ bool Stats::is_available(const StatIndex index) const
 			}
 			break;
 		}
+		case StatType::ResourceCache:
+		case StatType::Frame:
 		case StatType::Other:
 		{
 			return true;
@@ -183,7 +215,7 @@ void add_smoothed_value(std::vector<float> &values, float value, float alpha)
 	values.back() = value * alpha + *(values.end() - 2) * (1.0f - alpha);
 }
 
-void Stats::update()
+void Stats::update(const ResourceCache *resource_cache, const FrameCounters *frame_counters)
 {
 	auto delta_time = static_cast<float>(main_timer.tick());
 
@@ -235,6 +267,25 @@ void Stats::update()
 		add_smoothed_value(delta_time_counter->second, delta_time, alpha_smoothing);
 	}
 
+	// Handle heap allocations counter
+	auto heap_allocations_counter = counters.find(StatIndex::heap_allocations);
+	if (heap_allocations_counter != counters.end())
+	{
+		auto heap_allocation_count = get_heap_allocation_count();
+		add_smoothed_value(heap_allocations_counter->second, static_cast<float>(heap_allocation_count - previous_heap_allocation_count), alpha_smoothing);
+		previous_heap_allocation_count = heap_allocation_count;
+	}
+
+	if (resource_cache)
+	{
+		push_resource_cache_sample(*resource_cache);
+	}
+
+	if (frame_counters)
+	{
+		push_frame_sample(*frame_counters);
+	}
+
 	if (pending_samples.size() == 0)
 	{
 		return;
@@ -358,4 +409,121 @@ void Stats::push_sample(const MeasurementSample &sample)
 	}
 }
 
+void Stats::push_resource_cache_sample(const ResourceCache &resource_cache)
+{
+	auto cache_counters = resource_cache.get_counters();
+	auto cache_usage    = resource_cache.get_usage();
+
+	for (auto &c : counters)
+	{
+		const auto data = stat_data.find(c.first);
+		if (data == stat_data.end() || data->second.type != StatType::ResourceCache)
+		{
+			continue;
+		}
+
+		std::vector<std::string> types = data->second.cache_types;
+		if (types.empty())
+		{
+			for (auto &counters_it : cache_counters)
+			{
+				types.push_back(counters_it.first);
+			}
+		}
+
+		float measurement = 0;
+		for (auto &type : types)
+		{
+			const auto &current  = cache_counters.at(type);
+			const auto &previous = previous_cache_counters[type];
+
+			switch (data->second.cache_counter)
+			{
+				case ResourceCacheCounter::Hits:
+					measurement += static_cast<float>(current.hits - previous.hits);
+					break;
+				case ResourceCacheCounter::Misses:
+					measurement += static_cast<float>(current.misses - previous.misses);
+					break;
+				case ResourceCacheCounter::CreationTime:
+					measurement += static_cast<float>(current.creation_time - previous.creation_time) / 1000.0f;
+					break;
+				case ResourceCacheCounter::Objects:
+					measurement += static_cast<float>(cache_usage.at(type).count);
+					break;
+				case ResourceCacheCounter::HostBytes:
+					measurement += static_cast<float>(cache_usage.at(type).host_bytes);
+					break;
+				default:
+					break;
+			}
+		}
+
+		add_smoothed_value(c.second, measurement, alpha_smoothing);
+	}
+
+	previous_cache_counters = cache_counters;
+}
+
+void Stats::push_frame_sample(const FrameCounters &frame_counters)
+{
+	for (auto &c : counters)
+	{
+		const auto data = stat_data.find(c.first);
+		if (data == stat_data.end() || data->second.type != StatType::Frame)
+		{
+			continue;
+		}
+
+		float measurement = 0;
+
+		switch (data->second.frame_counter)
+		{
+			case FrameCounter::StateCommandsIssued:
+			case FrameCounter::StateCommandsEliminated:
+			{
+				const auto &commands = data->second.state_commands;
+
+				for (size_t i = 0; i < frame_counters.state_commands.size(); ++i)
+				{
+					auto command = static_cast<StateCommand>(i);
+					if (!commands.empty() && std::find(commands.begin(), commands.end(), command) == commands.end())
+					{
+						continue;
+					}
+
+					const auto &counter = frame_counters.state_commands[i];
+
+					if (data->second.frame_counter == FrameCounter::StateCommandsIssued)
+					{
+						measurement += static_cast<float>(counter.issued);
+					}
+					else
+					{
+						measurement += static_cast<float>(counter.eliminated);
+					}
+				}
+				break;
+			}
+			case FrameCounter::MeshesVisible:
+				measurement = static_cast<float>(frame_counters.culling.visible);
+				break;
+			case FrameCounter::MeshesCulled:
+				measurement = static_cast<float>(frame_counters.culling.culled);
+				break;
+			case FrameCounter::DescriptorPoolsCreated:
+				measurement = static_cast<float>(frame_counters.descriptor_pools.pools_created);
+				break;
+			case FrameCounter::DescriptorSetsAllocated:
+				measurement = static_cast<float>(frame_counters.descriptor_pools.sets_allocated);
+				break;
+			case FrameCounter::DescriptorAllocationFailures:
+				measurement = static_cast<float>(frame_counters.descriptor_pools.failed_allocations);
+				break;
+		}
+
+		add_smoothed_value(c.second, measurement, alpha_smoothing);
+	}
+}
+
 }        // namespace vkb
@@ -25,6 +25,7 @@
 #include <future>
 #include <map>
 #include <set>
+#include <string>
 #include <vector>
 
 #include "common/error.h"
@@ -33,10 +34,17 @@ VKBP_DISABLE_WARNINGS()
 #include <hwcpipe.h>
 VKBP_ENABLE_WARNINGS()
 
+#include "common/frustum_culling.h"
+#include "common/resource_map.h"
+#include "core/command_buffer.h"
+#include "core/descriptor_pool.h"
+#include "resource_cache.h"
 #include "timer.h"
 
 namespace vkb
 {
+class ResourceCache;
+
 /**
  * @brief Handles of stats to be optionally enabled in @ref Stats
  */
@@ -61,7 +69,30 @@ enum class StatIndex
 	l2_ext_write_stalls,
 	l2_ext_read_bytes,
 	l2_ext_write_bytes,
-	tex_cycles
+	tex_cycles,
+	cache_hits,
+	cache_creation_time,
+	cache_objects,
+	cache_host_bytes,
+	shader_module_misses,
+	pipeline_layout_misses,
+	descriptor_set_layout_misses,
+	pipeline_misses,
+	descriptor_set_misses,
+	render_pass_misses,
+	framebuffer_misses,
+	descriptor_pools_created,
+	descriptor_sets_allocated,
+	descriptor_allocation_failures,
+	heap_allocations,
+	state_commands_issued,
+	state_commands_eliminated,
+	pipeline_binds_eliminated,
+	descriptor_set_binds_eliminated,
+	buffer_binds_eliminated,
+	dynamic_state_sets_eliminated,
+	meshes_visible,
+	meshes_culled
 };
 
 struct StatIndexHash
@@ -77,9 +108,74 @@ enum class StatType
 {
 	Cpu,
 	Gpu,
+	ResourceCache,
+	Frame,
 	Other
 };
 
+/**
+ * @brief Values gathered from the ResourceCache, per frame unless stated otherwise
+ */
+enum class ResourceCacheCounter
+{
+	// Requests served by cached objects
+	Hits,
+
+	// Requests which created a new object
+	Misses,
+
+	// Milliseconds spent creating objects
+	CreationTime,
+
+	// Number of cached objects
+	Objects,
+
+	// Estimated host memory of the cached objects
+	HostBytes
+};
+
+/**
+ * @brief Values gathered from the objects which recorded the last frame
+ */
+enum class FrameCounter
+{
+	// State commands recorded by command buffers
+	StateCommandsIssued,
+
+	// State commands skipped by command buffers as the state was already bound
+	StateCommandsEliminated,
+
+	// Mesh instances drawn, after culling against the camera frustum
+	MeshesVisible,
+
+	// Mesh instances skipped as they were outside the camera frustum
+	MeshesCulled,
+
+	// Descriptor pools created by the device
+	DescriptorPoolsCreated,
+
+	// Descriptor sets allocated by the device
+	DescriptorSetsAllocated,
+
+	// Descriptor set allocations which failed
+	DescriptorAllocationFailures
+};
+
+/**
+ * @brief Counters of the last frame, read from the objects which own them
+ */
+struct FrameCounters
+{
+	/// State commands recorded and skipped by the command buffers of the frame
+	StateCommandCounters state_commands{};
+
+	/// Mesh instances drawn and culled by the geometry subpasses of the frame
+	CullingCounters culling{};
+
+	/// Descriptor pool activity of the frame, summed over the pools of the frame and of the resource cache
+	DescriptorPoolCounters descriptor_pools{};
+};
+
 enum class StatScaling
 {
 	// The stat is not scaled
@@ -94,12 +190,16 @@ enum class StatScaling
 
 struct StatData
 {
-	StatType            type;
-	StatScaling         scaling;
-	hwcpipe::CpuCounter cpu_counter;
-	hwcpipe::CpuCounter divisor_cpu_counter;
-	hwcpipe::GpuCounter gpu_counter;
-	hwcpipe::GpuCounter divisor_gpu_counter;
+	StatType                  type;
+	StatScaling               scaling;
+	hwcpipe::CpuCounter       cpu_counter;
+	hwcpipe::CpuCounter       divisor_cpu_counter;
+	hwcpipe::GpuCounter       gpu_counter;
+	hwcpipe::GpuCounter       divisor_gpu_counter;
+	ResourceCacheCounter      cache_counter{};
+	std::vector<std::string>  cache_types;
+	FrameCounter              frame_counter{};
+	std::vector<StateCommand> state_commands;
 
 	/**
 	 * @brief Constructor for simple stats that do not use any counter
@@ -137,6 +237,38 @@ struct StatData
 	    gpu_counter(c),
 	    divisor_gpu_counter(divisor)
 	{}
+
+	/**
+	 * @brief Constructor for resource cache counters
+	 * @param c The resource cache counter to be gathered
+	 * @param types The cached types to be summed, as named by ResourceCache::get_counters(), or all types if empty
+	 */
+	StatData(ResourceCacheCounter c, const std::vector<std::string> &types = {}) :
+	    type(StatType::ResourceCache),
+	    scaling(StatScaling::None),
+	    cpu_counter(hwcpipe::CpuCounter::MaxValue),
+	    divisor_cpu_counter(hwcpipe::CpuCounter::MaxValue),
+	    gpu_counter(hwcpipe::GpuCounter::MaxValue),
+	    divisor_gpu_counter(hwcpipe::GpuCounter::MaxValue),
+	    cache_counter(c),
+	    cache_types(types)
+	{}
+
+	/**
+	 * @brief Constructor for frame counters
+	 * @param c The frame counter to be gathered
+	 * @param commands The state commands to be summed, or all commands if empty
+	 */
+	StatData(FrameCounter c, const std::vector<StateCommand> &commands = {}) :
+	    type(StatType::Frame),
+	    scaling(StatScaling::None),
+	    cpu_counter(hwcpipe::CpuCounter::MaxValue),
+	    divisor_cpu_counter(hwcpipe::CpuCounter::MaxValue),
+	    gpu_counter(hwcpipe::GpuCounter::MaxValue),
+	    divisor_gpu_counter(hwcpipe::GpuCounter::MaxValue),
+	    frame_counter(c),
+	    state_commands(commands)
+	{}
 };
 
 using StatDataMap = std::unordered_map<StatIndex, StatData, StatIndexHash>;
@@ -215,8 +347,10 @@ class Stats
 
 	/**
 	 * @brief Update statistics, must be called after every frame
+	 * @param resource_cache The cache to gather resource cache stats from, if any
+	 * @param frame_counters The counters of the last frame, if any
 	 */
-	void update();
+	void update(const ResourceCache *resource_cache = nullptr, const FrameCounters *frame_counters = nullptr);
 
   private:
 	struct MeasurementSample
@@ -268,12 +402,24 @@ class Stats
 	/// The samples waiting to be displayed
 	std::vector<MeasurementSample> pending_samples;
 
+	/// Resource cache counters read in the previous update, to compute per frame values
+	std::map<std::string, ResourceCounters> previous_cache_counters;
+
+	/// Heap allocation count read in the previous update, to compute per frame values
+	uint64_t previous_heap_allocation_count{0};
+
 	/// The worker thread function for continuous sampling;
 	/// it adds a new entry to continuous_samples at every interval
 	void continuous_sampling_worker(std::future<void> should_terminate);
 
 	/// Updates circular buffers for CPU and GPU counters
 	void push_sample(const MeasurementSample &sample);
+
+	/// Updates circular buffers for resource cache counters
+	void push_resource_cache_sample(const ResourceCache &resource_cache);
+
+	/// Updates circular buffers for frame counters
+	void push_frame_sample(const FrameCounters &frame_counters);
 };
 
 }        // namespace vkb
@@ -20,6 +20,8 @@
 
 #include "vulkan_sample.h"
 
+#include <thread>
+
 #include "common/error.h"
 
 VKBP_DISABLE_WARNINGS()
@@ -33,6 +35,7 @@ VKBP_ENABLE_WARNINGS()
 #include "gltf_loader.h"
 #include "platform/platform.h"
 #include "platform/window.h"
+#include "rendering/subpasses/geometry_subpass.h"
 #include "scene_graph/components/camera.h"
 #include "utils/graphs.h"
 #include "utils/strings.h"
@@ -51,6 +54,9 @@ VulkanSample::~VulkanSample()
 {
 	device->wait_idle();
 
+	// Subpasses may observe the transforms of the scene nodes
+	render_pipeline.reset();
+
 	scene.reset();
 
 	stats.reset();
@@ -100,7 +106,7 @@ bool VulkanSample::prepare(Platform &platform)
 
 void VulkanSample::prepare_render_context()
 {
-	render_context->prepare();
+	render_context->prepare(std::max(std::thread::hardware_concurrency(), 1U));
 }
 
 void VulkanSample::update_scene(float delta_time)
@@ -124,7 +130,30 @@ void VulkanSample::update_stats(float delta_time)
 {
 	if (stats)
 	{
-		stats->update();
+		FrameCounters frame_counters{};
+		frame_counters.state_commands = render_context->get_last_rendered_frame().get_state_command_counters();
+
+		// Sets are allocated both from the pools of the frame and from the pools owned by the resource cache
+		auto frame_pool_counters = render_context->get_last_rendered_frame().get_descriptor_pool_counters();
+		auto cache_pool_counters = device->get_resource_cache().get_descriptor_pool_counters();
+
+		frame_counters.descriptor_pools.pools_created      = frame_pool_counters.pools_created + cache_pool_counters.pools_created;
+		frame_counters.descriptor_pools.sets_allocated     = frame_pool_counters.sets_allocated + cache_pool_counters.sets_allocated;
+		frame_counters.descriptor_pools.failed_allocations = frame_pool_counters.failed_allocations + cache_pool_counters.failed_allocations;
+
+		if (render_pipeline)
+		{
+			for (auto &subpass : render_pipeline->get_subpasses())
+			{
+				if (auto geometry_subpass = dynamic_cast<GeometrySubpass *>(subpass.get()))
+				{
+					frame_counters.culling.visible += geometry_subpass->get_culling_counters().visible;
+					frame_counters.culling.culled += geometry_subpass->get_culling_counters().culled;
+				}
+			}
+		}
+
+		stats->update(&device->get_resource_cache(), &frame_counters);
 
 		static float stats_view_count = 0.0f;
 		stats_view_count += delta_time;
@@ -235,11 +264,11 @@ void VulkanSample::draw_renderpass(CommandBuffer &command_buffer, RenderTarget &
 	viewport.height   = static_cast<float>(extent.height);
 	viewport.minDepth = 0.0f;
 	viewport.maxDepth = 1.0f;
-	command_buffer.set_viewport(0, {viewport});
+	command_buffer.set_viewport(0, 1, &viewport);
 
 	VkRect2D scissor{};
 	scissor.extent = extent;
-	command_buffer.set_scissor(0, {scissor});
+	command_buffer.set_scissor(0, 1, &scissor);
 
 	render(command_buffer);
 
@@ -232,6 +232,7 @@ class VulkanSample : public Application
 
 	/**
 	 * @brief Virtual function, prepares the render_context, can be overriden to customise the render context creation
+	 *        By default, the render frames have resources for one thread per core, so that subpasses can record in parallel
 	 */
 	virtual void prepare_render_context();
 
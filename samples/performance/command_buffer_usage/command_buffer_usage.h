@@ -20,9 +20,6 @@
 
 #pragma once
 
-#include <ctpl_stl.h>
-
-#include "buffer_pool.h"
 #include "common/utils.h"
 #include "rendering/render_pipeline.h"
 #include "rendering/subpasses/forward_subpass.h"
@@ -47,93 +44,36 @@ class CommandBufferUsage : public vkb::VulkanSample
 
 	virtual void update(float delta_time) override;
 
-	/**
-	 * @brief Helper structure used to set subpass state
-	 */
-	struct ForwardSubpassSecondaryState
-	{
-		uint32_t secondary_cmd_buf_count = 0;
-
-		vkb::CommandBuffer::ResetMode command_buffer_reset_mode = vkb::CommandBuffer::ResetMode::ResetPool;
+  private:
+	virtual void prepare_render_context() override;
 
-		bool multi_threading = false;
+	virtual void render(vkb::CommandBuffer &command_buffer) override;
 
-		uint32_t thread_count = 0;
-	};
+	vkb::sg::PerspectiveCamera *camera{nullptr};
 
 	/**
-	 * @brief Overrides the draw method to allow for dividing draw calls
-	 *        into multiple secondary command buffers, optionally
-	 *        in different threads
+	 * @brief Creates a pipeline with a forward subpass drawing the scene
+	 * @param instancing Whether the subpass instances repeated sub meshes
+	 * @param gpu_driven Whether the subpass culls and counts the instances of its opaque draws on the GPU
 	 */
-	class ForwardSubpassSecondary : public vkb::ForwardSubpass
-	{
-	  public:
-		ForwardSubpassSecondary(vkb::RenderContext &render_context,
-		                        vkb::ShaderSource &&vertex_source, vkb::ShaderSource &&fragment_source,
-		                        vkb::sg::Scene &scene, vkb::sg::Camera &camera);
-
-		void draw(vkb::CommandBuffer &primary_command_buffer) override;
-
-		void set_viewport(VkViewport &viewport);
-
-		void set_scissor(VkRect2D &scissor);
-
-		float get_avg_draws_per_buffer() const;
-
-		ForwardSubpassSecondaryState &get_state();
-
-	  private:
-		/**
-		 * @brief Records the necessary commands to draw the specified range of scene meshes
-		 * @param command_buffer The primary command buffer to record
-		 * @param nodes The meshes to draw
-		 * @param mesh_start Index to the first mesh to draw
-		 * @param mesh_end Index to the mesh where recording will stop (not included)
-		 * @param thread_index Identifies the resources allocated for this thread
-		 */
-		void record_draw(vkb::CommandBuffer &command_buffer, const std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> &nodes,
-		                 uint32_t mesh_start, uint32_t mesh_end, size_t thread_index = 0);
-
-		/**
-		 * @brief Records the necessary commands to draw the specified range of scene meshes
-		 *        The primary command buffer provided is used to initialize, record, end and return a
-		 *        pointer to a new secondary command buffer.
-		 * @param primary_command_buffer The primary command buffer used to inherit a secondary
-		 * @param nodes The meshes to draw
-		 * @param mesh_start Index to the first mesh to draw
-		 * @param mesh_end Index to the mesh where recording will stop (not included)
-		 * @param thread_index Identifies the resources allocated for this thread
-		 * @return a pointer to the recorded secondary command buffer
-		 */
-		vkb::CommandBuffer *record_draw_secondary(vkb::CommandBuffer &primary_command_buffer, const std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> &nodes,
-		                                          uint32_t mesh_start, uint32_t mesh_end, size_t thread_index = 0);
-
-		VkViewport viewport{};
-
-		VkRect2D scissor{};
+	vkb::RenderPipeline create_render_pipeline(bool instancing, bool gpu_driven = false);
 
-		vkb::ColorBlendAttachmentState color_blend_attachment{};
-
-		vkb::ColorBlendState color_blend_state{};
-
-		ForwardSubpassSecondaryState state{};
-
-		float avg_draws_per_buffer{0};
-
-		ctpl::thread_pool thread_pool;
-
-		vkb::BufferAllocation light_buffer;
-	};
-
-  private:
-	virtual void prepare_render_context() override;
+	/**
+	 * @return The GPU driven pipeline if GPU driven drawing is selected, the instanced pipeline if instancing
+	 *         is selected, otherwise the sample render pipeline
+	 */
+	vkb::RenderPipeline &get_active_render_pipeline();
 
-	vkb::sg::PerspectiveCamera *camera{nullptr};
+	/**
+	 * @return The scene subpass of the active pipeline, which splits its draws into secondary command buffers
+	 */
+	vkb::ForwardSubpass &get_scene_subpass();
 
-	void render(vkb::CommandBuffer &command_buffer) override;
+	/// Same scene as the render pipeline, with the draws of repeated sub meshes instanced
+	std::unique_ptr<vkb::RenderPipeline> instanced_render_pipeline{};
 
-	void draw_renderpass(vkb::CommandBuffer &primary_command_buffer, vkb::RenderTarget &render_target) override;
+	/// Same scene as the render pipeline, with the opaque draws culled by a compute shader and drawn indirectly
+	std::unique_ptr<vkb::RenderPipeline> gpu_driven_render_pipeline{};
 
 	void draw_gui() override;
 
@@ -141,12 +81,14 @@ class CommandBufferUsage : public vkb::VulkanSample
 
 	uint32_t max_secondary_command_buffer_count{100};
 
-	bool use_secondary_command_buffers{false};
-
 	int gui_command_buffer_reset_mode{0};
 
 	bool gui_multi_threading{false};
 
+	bool gui_instancing{false};
+
+	bool gui_gpu_driven{false};
+
 	const uint32_t MIN_THREAD_COUNT{4};
 
 	uint32_t max_thread_count{0};
@@ -34,9 +34,15 @@ DescriptorManagement::DescriptorManagement()
 
 	config.insert<vkb::IntSetting>(0, descriptor_caching.value, 0);
 	config.insert<vkb::IntSetting>(0, buffer_allocation.value, 0);
+	config.insert<vkb::IntSetting>(0, bindless_textures.value, 0);
 
 	config.insert<vkb::IntSetting>(1, descriptor_caching.value, 1);
 	config.insert<vkb::IntSetting>(1, buffer_allocation.value, 1);
+	config.insert<vkb::IntSetting>(1, bindless_textures.value, 0);
+
+	config.insert<vkb::IntSetting>(2, descriptor_caching.value, 1);
+	config.insert<vkb::IntSetting>(2, buffer_allocation.value, 1);
+	config.insert<vkb::IntSetting>(2, bindless_textures.value, 1);
 }
 
 bool DescriptorManagement::prepare(vkb::Platform &platform)
@@ -53,15 +59,12 @@ bool DescriptorManagement::prepare(vkb::Platform &platform)
 	auto &camera_node = vkb::add_free_camera(*scene, "main_camera", get_render_context().get_surface_extent());
 	camera            = dynamic_cast<vkb::sg::PerspectiveCamera *>(&camera_node.get_component<vkb::sg::Camera>());
 
-	vkb::ShaderSource vert_shader("base.vert");
-	vkb::ShaderSource frag_shader("base.frag");
-	auto              scene_subpass   = std::make_unique<vkb::ForwardSubpass>(get_render_context(), std::move(vert_shader), std::move(frag_shader), *scene, *camera);
-	auto              render_pipeline = vkb::RenderPipeline();
-	render_pipeline.add_subpass(std::move(scene_subpass));
-	set_render_pipeline(std::move(render_pipeline));
+	// Both pipelines draw the same sub meshes, each subpass keeps the shader variants of its own options
+	set_render_pipeline(create_render_pipeline(false));
+	bindless_pipeline = std::make_unique<vkb::RenderPipeline>(create_render_pipeline(true));
 
 	// Add a GUI with the stats you want to monitor
-	stats = std::make_unique<vkb::Stats>(std::set<vkb::StatIndex>{vkb::StatIndex::frame_times});
+	stats = std::make_unique<vkb::Stats>(std::set<vkb::StatIndex>{vkb::StatIndex::frame_times, vkb::StatIndex::descriptor_pools_created, vkb::StatIndex::descriptor_sets_allocated});
 	gui   = std::make_unique<vkb::Gui>(*this, platform.get_window().get_dpi_factor());
 
 	return true;
@@ -145,6 +148,33 @@ void DescriptorManagement::draw_gui()
 	    /* lines = */ vkb::to_u32(lines));
 }
 
+vkb::RenderPipeline DescriptorManagement::create_render_pipeline(bool bindless)
+{
+	vkb::ShaderSource vert_shader("base.vert");
+	vkb::ShaderSource frag_shader("base.frag");
+	auto              scene_subpass = std::make_unique<vkb::ForwardSubpass>(get_render_context(), std::move(vert_shader), std::move(frag_shader), *scene, *camera);
+
+	// All scene textures are written once into a single descriptor set, instead of a set per material
+	scene_subpass->set_bindless_textures(bindless);
+
+	std::vector<std::unique_ptr<vkb::Subpass>> scene_subpasses{};
+	scene_subpasses.push_back(std::move(scene_subpass));
+
+	return vkb::RenderPipeline(std::move(scene_subpasses));
+}
+
+void DescriptorManagement::render(vkb::CommandBuffer &command_buffer)
+{
+	if (bindless_textures.value == 1)
+	{
+		bindless_pipeline->draw(command_buffer, get_render_context().get_active_frame().get_render_target());
+	}
+	else
+	{
+		VulkanSample::render(command_buffer);
+	}
+}
+
 std::unique_ptr<vkb::VulkanSample> create_descriptor_management()
 {
 	return std::make_unique<DescriptorManagement>();
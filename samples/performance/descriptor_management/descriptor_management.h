@@ -57,11 +57,23 @@ class DescriptorManagement : public vkb::VulkanSample
 	    {"Disabled", "Enabled"},
 	    0};
 
-	std::vector<RadioButtonGroup *> radio_buttons = {&descriptor_caching, &buffer_allocation};
+	RadioButtonGroup bindless_textures{
+	    "Bindless textures",
+	    {"Disabled", "Enabled"},
+	    0};
+
+	std::vector<RadioButtonGroup *> radio_buttons = {&descriptor_caching, &buffer_allocation, &bindless_textures};
 
 	vkb::sg::PerspectiveCamera *camera{nullptr};
 
+	/// Pipeline whose subpass binds all scene textures at once, drawn when bindless textures are enabled
+	std::unique_ptr<vkb::RenderPipeline> bindless_pipeline{};
+
+	vkb::RenderPipeline create_render_pipeline(bool bindless);
+
 	virtual void draw_gui() override;
+
+	virtual void render(vkb::CommandBuffer &command_buffer) override;
 };
 
 std::unique_ptr<vkb::VulkanSample> create_descriptor_management();
@@ -180,11 +180,11 @@ void LayoutTransitions::draw(vkb::CommandBuffer &command_buffer, vkb::RenderTarg
 	viewport.height   = static_cast<float>(extent.height);
 	viewport.minDepth = 0.0f;
 	viewport.maxDepth = 1.0f;
-	command_buffer.set_viewport(0, {viewport});
+	command_buffer.set_viewport(0, 1, &viewport);
 
 	VkRect2D scissor{};
 	scissor.extent = extent;
-	command_buffer.set_scissor(0, {scissor});
+	command_buffer.set_scissor(0, 1, &scissor);
 
 	gbuffer_pipeline.draw(command_buffer, get_render_context().get_active_frame().get_render_target());
 
@@ -36,7 +36,11 @@ PipelineCache::PipelineCache()
 	auto &config = get_configuration();
 
 	config.insert<vkb::BoolSetting>(0, enable_pipeline_cache, true);
+	config.insert<vkb::BoolSetting>(0, enable_async_compilation, false);
 	config.insert<vkb::BoolSetting>(1, enable_pipeline_cache, false);
+	config.insert<vkb::BoolSetting>(1, enable_async_compilation, false);
+	config.insert<vkb::BoolSetting>(2, enable_pipeline_cache, true);
+	config.insert<vkb::BoolSetting>(2, enable_async_compilation, true);
 }
 
 PipelineCache::~PipelineCache()
@@ -58,6 +62,7 @@ PipelineCache::~PipelineCache()
 		vkDestroyPipelineCache(device->get_handle(), pipeline_cache, nullptr);
 	}
 
+	// Uncompressed, so that the next run replays the sections in place from the mapped file
 	vkb::fs::write_temp(device->get_resource_cache().serialize(), "cache.data");
 }
 
@@ -93,21 +98,19 @@ bool PipelineCache::prepare(vkb::Platform &platform)
 	// Use pipeline cache to store pipelines
 	resource_cache.set_pipeline_cache(pipeline_cache);
 
-	std::vector<uint8_t> data_cache;
-
+	// Build all pipelines from a previous run, reading the mapped file in place
 	try
 	{
-		data_cache = vkb::fs::read_temp("cache.data");
+		auto data_cache = vkb::fs::map_temp("cache.data");
+
+		resource_cache.warmup(data_cache->get_data(), data_cache->get_size());
 	}
 	catch (std::runtime_error &ex)
 	{
 		LOGW("No data cache found. {}", ex.what());
 	}
 
-	// Build all pipelines from a previous run
-	resource_cache.warmup(data_cache);
-
-	stats = std::make_unique<vkb::Stats>(std::set<vkb::StatIndex>{vkb::StatIndex::frame_times});
+	stats = std::make_unique<vkb::Stats>(std::set<vkb::StatIndex>{vkb::StatIndex::frame_times, vkb::StatIndex::cache_creation_time});
 
 	float dpi_factor = platform.get_window().get_dpi_factor();
 
@@ -157,9 +160,7 @@ void PipelineCache::draw_gui()
 
 		    if (ImGui::Button("Destroy Pipelines", button_size))
 		    {
-			    device->wait_idle();
-			    device->get_resource_cache().clear_pipelines();
-			    record_frame_time_next_frame = true;
+			    destroy_pipelines();
 		    }
 
 		    if (rebuild_pipelines_frame_time_ms > 0.0f)
@@ -170,12 +171,66 @@ void PipelineCache::draw_gui()
 		    {
 			    ImGui::Text("Pipeline rebuild frame time: N/A");
 		    }
+
+		    // Applied by update(), so that the configurations can enable it too
+		    ImGui::Checkbox("Async compilation", &enable_async_compilation);
+
+		    ImGui::SameLine();
+
+		    ImGui::Checkbox("Fallbacks", &enable_fallback_pipelines);
+
+		    auto counters = device->get_resource_cache().get_async_pipeline_counters();
+
+		    ImGui::Text("Compiling: %u, fallback draws: %llu, skipped draws: %llu",
+		                counters.pending,
+		                static_cast<unsigned long long>(counters.fallback_draws),
+		                static_cast<unsigned long long>(counters.skipped_draws));
 	    },
-	    /* lines = */ 2);
+	    /* lines = */ 4);
+}
+
+void PipelineCache::destroy_pipelines()
+{
+	device->wait_idle();
+
+	auto &resource_cache = device->get_resource_cache();
+
+	// Copied first, as requesting the fallbacks inserts into the map of pipelines
+	std::vector<vkb::PipelineState> pipeline_states;
+
+	if (enable_async_compilation && enable_fallback_pipelines)
+	{
+		resource_cache.wait_for_pipelines();
+
+		for (auto &pipeline_it : resource_cache.get_internal_state().graphics_pipelines)
+		{
+			pipeline_states.push_back(pipeline_it.second.get_state());
+		}
+	}
+
+	resource_cache.clear_pipelines();
+
+	// The other pipelines are compiled in the background, and their draws use the fallbacks meanwhile
+	for (auto &pipeline_state : pipeline_states)
+	{
+		if (!resource_cache.has_fallback_pipeline(pipeline_state))
+		{
+			resource_cache.set_fallback_pipeline(resource_cache.request_graphics_pipeline(pipeline_state));
+		}
+	}
+
+	record_frame_time_next_frame = true;
 }
 
 void PipelineCache::update(float delta_time)
 {
+	auto &resource_cache = device->get_resource_cache();
+
+	if (enable_async_compilation != resource_cache.is_async_pipeline_compilation())
+	{
+		resource_cache.set_async_pipeline_compilation(enable_async_compilation);
+	}
+
 	if (record_frame_time_next_frame)
 	{
 		rebuild_pipelines_frame_time_ms = delta_time * 1000.0f;
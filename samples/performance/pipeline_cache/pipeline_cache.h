@@ -49,10 +49,21 @@ class PipelineCache : public vkb::VulkanSample
 
 	bool enable_pipeline_cache{true};
 
+	bool enable_async_compilation{false};
+
+	bool enable_fallback_pipelines{false};
+
 	bool record_frame_time_next_frame{false};
 
 	float rebuild_pipelines_frame_time_ms{0.0f};
 
+	/**
+	 * @brief Destroys the pipelines, so that they are built again by the next frame
+	 *        With asynchronous compilation and fallbacks enabled, the fallbacks are rebuilt
+	 *        right away, one for each pipeline layout and vertex input of the destroyed pipelines
+	 */
+	void destroy_pipelines();
+
 	virtual void draw_gui() override;
 };
 
@@ -159,13 +159,18 @@ void RenderPassesSample::draw_renderpass(vkb::CommandBuffer &command_buffer, vkb
 	viewport.height   = static_cast<float>(extent.height);
 	viewport.minDepth = 0.0f;
 	viewport.maxDepth = 1.0f;
-	command_buffer.set_viewport(0, {viewport});
+	command_buffer.set_viewport(0, 1, &viewport);
 
 	VkRect2D scissor{};
 	scissor.extent = extent;
-	command_buffer.set_scissor(0, {scissor});
+	command_buffer.set_scissor(0, 1, &scissor);
 
 	auto &subpasses = render_pipeline->get_subpasses();
+	for (auto &subpass : subpasses)
+	{
+		subpass->pre_render_pass(command_buffer);
+	}
+
 	command_buffer.begin_render_pass(render_target, load_store, render_pipeline->get_clear_value(), subpasses);
 
 	if (cmd_clear)
@@ -64,7 +64,6 @@ bool SpecializationConstants::prepare(vkb::Platform &platform)
 
 void SpecializationConstants::ForwardSubpassCustomLights::prepare()
 {
-	auto &device = render_context.get_device();
 	for (auto &mesh : meshes)
 	{
 		for (auto &sub_mesh : mesh->get_submeshes())
@@ -74,12 +73,6 @@ void SpecializationConstants::ForwardSubpassCustomLights::prepare()
 			// Same as Geometry except adds lighting definitions to sub mesh variants.
 			add_definitions(variant, {"MAX_FORWARD_LIGHT_COUNT " + std::to_string(LIGHT_COUNT)});
 			add_definitions(variant, vkb::light_type_definitions);
-
-			auto &vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
-			auto &frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
-
-			vert_module.set_resource_dynamic("GlobalUniform");
-			frag_module.set_resource_dynamic("GlobalUniform");
 		}
 	}
 }
@@ -140,8 +133,7 @@ std::unique_ptr<vkb::RenderPipeline> SpecializationConstants::create_standard_re
 void SpecializationConstants::ForwardSubpassCustomLights::draw(vkb::CommandBuffer &command_buffer)
 {
 	// Override forward light subpass draw function to provide a custom number of lights
-	auto lights_buffer = allocate_set_num_lights<CustomForwardLights>(scene.get_components<vkb::sg::Light>(), static_cast<size_t>(LIGHT_COUNT));
-	command_buffer.bind_buffer(lights_buffer.get_buffer(), lights_buffer.get_offset(), lights_buffer.get_size(), 0, 4, 0);
+	light_buffer = allocate_set_num_lights<CustomForwardLights>(scene.get_components<vkb::sg::Light>(), static_cast<size_t>(LIGHT_COUNT));
 
 	vkb::GeometrySubpass::draw(command_buffer);
 }
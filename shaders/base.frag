@@ -21,7 +21,10 @@
 
 precision highp float;
 
-#ifdef HAS_BASE_COLOR_TEXTURE
+#ifdef BINDLESS_TEXTURE_COUNT
+// All scene textures, indexed by the material push constants
+layout(set = 1, binding = 0) uniform sampler2D textures[BINDLESS_TEXTURE_COUNT];
+#elif defined(HAS_BASE_COLOR_TEXTURE)
 layout(set = 0, binding = 0) uniform sampler2D base_color_texture;
 #endif
 
@@ -61,6 +64,9 @@ layout(push_constant, std430) uniform PBRMaterialUniform
 	vec4  base_color_factor;
 	float metallic_factor;
 	float roughness_factor;
+#ifdef BINDLESS_TEXTURE_COUNT
+	uint base_color_texture_index;
+#endif
 }
 pbr_material_uniform;
 
@@ -110,7 +116,9 @@ void main(void)
 
 	vec4 base_color = vec4(1.0, 0.0, 0.0, 1.0);
 
-#ifdef HAS_BASE_COLOR_TEXTURE
+#if defined(HAS_BASE_COLOR_TEXTURE) && defined(BINDLESS_TEXTURE_COUNT)
+	base_color = texture(textures[pbr_material_uniform.base_color_texture_index], in_uv);
+#elif defined(HAS_BASE_COLOR_TEXTURE)
 	base_color = texture(base_color_texture, in_uv);
 #else
 	base_color = pbr_material_uniform.base_color_factor;
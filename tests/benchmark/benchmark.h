@@ -0,0 +1,67 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+namespace vkbbench
+{
+/**
+ * @brief Keeps a value alive, so that the compiler does not remove the code computing it
+ */
+template <class T>
+void keep(T value)
+{
+	static thread_local volatile T sink;
+	sink = value;
+	static_cast<void>(sink);
+}
+
+/**
+ * @brief Runs a function once to warm caches up, then several times, and prints the mean time of a run
+ * @param name Name printed with the result
+ * @param runs Number of timed runs
+ * @param func The function to measure
+ * @return The mean time of a run in microseconds
+ */
+template <class F>
+double run(const char *name, size_t runs, F func)
+{
+	func();
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < runs; ++i)
+	{
+		func();
+	}
+
+	std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+	double mean = elapsed.count() / static_cast<double>(runs);
+
+	std::printf("%-56s %12.2f us\n", name, mean);
+
+	return mean;
+}
+}        // namespace vkbbench
@@ -0,0 +1,284 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "benchmark.h"
+#include "common/resource_map.h"
+
+namespace
+{
+/// Number of cached descriptor sets
+constexpr size_t SET_COUNT = 10000;
+
+/// Sampled textures bound by the cached sets, which are not recreated on resize
+constexpr size_t TEXTURE_COUNT = 2000;
+
+/// Texture bindings of each set
+constexpr uint32_t TEXTURE_BINDING_COUNT = 4;
+
+/// Attachment views recreated on a resize, e.g. the G-buffer read by the lighting subpass
+constexpr size_t ATTACHMENT_COUNT = 4;
+
+/// Cached sets reading the attachments
+constexpr size_t ATTACHMENT_SET_COUNT = 64;
+
+/**
+ * @brief Image bindings of a cached descriptor set, as a binding map of image views
+ */
+struct DescriptorSet
+{
+	uint64_t layout{0};
+
+	std::map<uint32_t, std::map<uint32_t, uint64_t>> image_views;
+};
+
+size_t get_key(const DescriptorSet &descriptor_set)
+{
+	size_t key = std::hash<uint64_t>{}(descriptor_set.layout);
+
+	for (auto &binding_it : descriptor_set.image_views)
+	{
+		for (auto &element_it : binding_it.second)
+		{
+			key ^= std::hash<uint64_t>{}(element_it.second) + 0x9e3779b9 + (key << 6) + (key >> 2);
+		}
+	}
+
+	return key;
+}
+
+/**
+ * @brief Cached descriptor sets, with the index of the sets referring to each image view
+ */
+struct Cache
+{
+	vkb::ResourceMap<DescriptorSet> descriptor_sets;
+
+	std::unordered_map<uint64_t, std::unordered_set<size_t>> image_view_descriptor_sets;
+};
+
+void add(Cache &cache, DescriptorSet &&descriptor_set)
+{
+	size_t key = get_key(descriptor_set);
+
+	for (auto &binding_it : descriptor_set.image_views)
+	{
+		for (auto &element_it : binding_it.second)
+		{
+			cache.image_view_descriptor_sets[element_it.second].insert(key);
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(cache.descriptor_sets.get_mutex());
+	cache.descriptor_sets.emplace(key, std::move(descriptor_set));
+}
+
+/**
+ * @brief Replaces the old views in a set
+ * @return True if the set referred to one of them
+ */
+bool replace_views(DescriptorSet &descriptor_set, const std::unordered_map<uint64_t, uint64_t> &new_views)
+{
+	bool replaced = false;
+
+	for (auto &binding_it : descriptor_set.image_views)
+	{
+		for (auto &element_it : binding_it.second)
+		{
+			auto view_it = new_views.find(element_it.second);
+
+			if (view_it != new_views.end())
+			{
+				element_it.second = view_it->second;
+				replaced          = true;
+			}
+		}
+	}
+
+	return replaced;
+}
+
+/**
+ * @brief Re-keys the updated sets, as ResourceCache::update_descriptor_sets does
+ * @param batched Whether the old entries are erased at once, or one at a time
+ */
+void rekey(Cache &cache, const std::set<size_t> &matches, bool batched)
+{
+	std::vector<std::pair<size_t, DescriptorSet>> updated_sets;
+	updated_sets.reserve(matches.size());
+
+	for (auto match : matches)
+	{
+		updated_sets.emplace_back(match, std::move(*cache.descriptor_sets.find(match)));
+
+		if (!batched)
+		{
+			cache.descriptor_sets.erase(match);
+		}
+	}
+
+	if (batched)
+	{
+		cache.descriptor_sets.erase_all(matches);
+	}
+
+	for (auto &updated_set : updated_sets)
+	{
+		size_t new_key = get_key(updated_set.second);
+
+		for (auto &binding_it : updated_set.second.image_views)
+		{
+			for (auto &element_it : binding_it.second)
+			{
+				auto &keys = cache.image_view_descriptor_sets[element_it.second];
+				keys.erase(updated_set.first);
+				keys.insert(new_key);
+			}
+		}
+
+		cache.descriptor_sets.emplace(new_key, std::move(updated_set.second));
+	}
+}
+
+/**
+ * @brief Finds the sets referring to the old views by visiting every cached set
+ */
+void update_by_scanning(Cache &cache, const std::unordered_map<uint64_t, uint64_t> &new_views)
+{
+	std::set<size_t> matches;
+
+	for (auto &set_it : cache.descriptor_sets)
+	{
+		if (replace_views(set_it.second, new_views))
+		{
+			matches.insert(set_it.first);
+		}
+	}
+
+	for (auto &view_it : new_views)
+	{
+		cache.image_view_descriptor_sets.erase(view_it.first);
+	}
+
+	rekey(cache, matches, true);
+}
+
+/**
+ * @brief Finds the sets referring to the old views through the image view index
+ */
+void update_by_index(Cache &cache, const std::unordered_map<uint64_t, uint64_t> &new_views, bool batched)
+{
+	std::set<size_t> matches;
+
+	for (auto &view_it : new_views)
+	{
+		auto index_it = cache.image_view_descriptor_sets.find(view_it.first);
+
+		if (index_it == cache.image_view_descriptor_sets.end())
+		{
+			continue;
+		}
+
+		for (auto key : index_it->second)
+		{
+			auto descriptor_set = cache.descriptor_sets.find(key);
+
+			if (descriptor_set != nullptr && replace_views(*descriptor_set, new_views))
+			{
+				matches.insert(key);
+			}
+		}
+
+		cache.image_view_descriptor_sets.erase(index_it);
+	}
+
+	rekey(cache, matches, batched);
+}
+}        // namespace
+
+int main()
+{
+	std::mt19937_64 random{42};
+
+	// Views of the attachments before and after a resize, texture views start after them
+	std::unordered_map<uint64_t, uint64_t> resize_views;
+	std::unordered_map<uint64_t, uint64_t> restore_views;
+
+	for (uint64_t i = 1; i <= ATTACHMENT_COUNT; ++i)
+	{
+		resize_views[i]                    = i + ATTACHMENT_COUNT;
+		restore_views[i + ATTACHMENT_COUNT] = i;
+	}
+
+	std::vector<DescriptorSet> descriptor_sets(SET_COUNT);
+
+	for (size_t i = 0; i < SET_COUNT; ++i)
+	{
+		auto &descriptor_set = descriptor_sets[i];
+
+		descriptor_set.layout = i;
+
+		for (uint32_t binding = 0; binding < TEXTURE_BINDING_COUNT; ++binding)
+		{
+			descriptor_set.image_views[binding][0] = 2 * ATTACHMENT_COUNT + 1 + random() % TEXTURE_COUNT;
+		}
+
+		if (i < ATTACHMENT_SET_COUNT)
+		{
+			descriptor_set.image_views[TEXTURE_BINDING_COUNT][0] = 1 + i % ATTACHMENT_COUNT;
+		}
+	}
+
+	Cache scanned_cache;
+	Cache indexed_cache;
+	Cache batched_cache;
+
+	for (auto &descriptor_set : descriptor_sets)
+	{
+		add(scanned_cache, DescriptorSet{descriptor_set});
+		add(indexed_cache, DescriptorSet{descriptor_set});
+		add(batched_cache, DescriptorSet{descriptor_set});
+	}
+
+	// Each run recreates the attachment views, then the next one restores them
+	bool resized = false;
+
+	auto next_views = [&]() -> const std::unordered_map<uint64_t, uint64_t> & {
+		resized = !resized;
+		return resized ? resize_views : restore_views;
+	};
+
+	std::printf("%zu cached sets, %zu of them reading %zu recreated views\n", SET_COUNT, ATTACHMENT_SET_COUNT, ATTACHMENT_COUNT);
+
+	vkbbench::run("Scan every cached set", 100, [&]() { update_by_scanning(scanned_cache, next_views()); });
+	vkbbench::run("Image view index, erase each updated set", 100, [&]() { update_by_index(indexed_cache, next_views(), false); });
+	vkbbench::run("Image view index, erase updated sets at once", 100, [&]() { update_by_index(batched_cache, next_views(), true); });
+
+	return 0;
+}
@@ -0,0 +1,117 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "core/buffer.h"
+#include "core/descriptor_pool.h"
+#include "core/descriptor_set.h"
+#include "core/descriptor_set_layout.h"
+#include "core/device.h"
+#include "core/instance.h"
+
+namespace
+{
+/// Uniform buffer bindings written by each update
+constexpr uint32_t BINDING_COUNT = 8;
+
+/// Range of each uniform buffer binding, a multiple of any minUniformBufferOffsetAlignment
+constexpr VkDeviceSize BINDING_RANGE = 256;
+
+/// Descriptor set updates of each timed run
+constexpr size_t UPDATE_COUNT = 1000;
+
+std::vector<vkb::ShaderResource> get_uniform_buffers(uint32_t binding_count)
+{
+	std::vector<vkb::ShaderResource> resources;
+
+	for (uint32_t binding = 0; binding < binding_count; ++binding)
+	{
+		vkb::ShaderResource resource{};
+
+		resource.stages     = VK_SHADER_STAGE_FRAGMENT_BIT;
+		resource.type       = vkb::ShaderResourceType::BufferUniform;
+		resource.binding    = binding;
+		resource.array_size = 1;
+		resource.name       = "uniform_buffer_" + std::to_string(binding);
+
+		resources.push_back(resource);
+	}
+
+	return resources;
+}
+}        // namespace
+
+int main()
+{
+	vkb::Instance instance{"descriptor_update_template_benchmark", {}, {}, true};
+
+	vkb::Device device{instance.get_gpu(), VK_NULL_HANDLE};
+
+	if (!device.is_extension_enabled(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME))
+	{
+		std::printf("%s is not supported by the device\n", VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+		return 0;
+	}
+
+	// Sets of the second layout are written partially, as it has one more binding,
+	// so DescriptorSet::update writes them with vkUpdateDescriptorSets
+	vkb::DescriptorSetLayout template_layout{device, get_uniform_buffers(BINDING_COUNT), false};
+	vkb::DescriptorSetLayout write_layout{device, get_uniform_buffers(BINDING_COUNT + 1), false};
+
+	vkb::DescriptorPool template_pool{device, template_layout};
+	vkb::DescriptorPool write_pool{device, write_layout};
+
+	vkb::core::Buffer buffer{device, 2 * BINDING_COUNT * BINDING_RANGE, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU};
+
+	// Each run alternates between two sets of buffer ranges, so every update changes the descriptors
+	vkb::BindingMap<VkDescriptorBufferInfo> buffer_infos[2];
+
+	for (uint32_t binding = 0; binding < BINDING_COUNT; ++binding)
+	{
+		buffer_infos[0][binding][0] = {buffer.get_handle(), binding * BINDING_RANGE, BINDING_RANGE};
+		buffer_infos[1][binding][0] = {buffer.get_handle(), (BINDING_COUNT + binding) * BINDING_RANGE, BINDING_RANGE};
+	}
+
+	vkb::DescriptorSet template_set{device, template_layout, template_pool};
+	vkb::DescriptorSet write_set{device, write_layout, write_pool};
+
+	std::printf("%zu updates of a set of %u uniform buffers\n", UPDATE_COUNT, BINDING_COUNT);
+
+	vkbbench::run("vkUpdateDescriptorSets", 100, [&]() {
+		for (size_t i = 0; i < UPDATE_COUNT; ++i)
+		{
+			write_set.update(buffer_infos[i % 2], {});
+		}
+	});
+
+	vkbbench::run("vkUpdateDescriptorSetWithTemplate", 100, [&]() {
+		for (size_t i = 0; i < UPDATE_COUNT; ++i)
+		{
+			template_set.update(buffer_infos[i % 2], {});
+		}
+	});
+
+	return 0;
+}
@@ -0,0 +1,247 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "benchmark.h"
+#include "common/helpers.h"
+#include "common/resource_caching.h"
+#include "common/resource_map.h"
+#include "core/device.h"
+#include "core/instance.h"
+#include "rendering/pipeline_state.h"
+
+namespace
+{
+/// Draws recorded in a run, in the range of a scene like Sponza drawn without instancing
+constexpr size_t DRAW_COUNT = 10000;
+
+/// Vertex shader reading positions, normals and texture coordinates
+const char *VERTEX_SHADER =
+    "#version 320 es\n"
+    "layout(location = 0) in vec3 position;\n"
+    "layout(location = 1) in vec3 normal;\n"
+    "layout(location = 2) in vec2 texcoord_0;\n"
+    "layout(location = 0) out vec2 out_uv;\n"
+    "void main()\n"
+    "{\n"
+    "	out_uv      = texcoord_0 + normal.xy;\n"
+    "	gl_Position = vec4(position, 1.0);\n"
+    "}\n";
+
+const char *FRAGMENT_SHADER =
+    "#version 320 es\n"
+    "precision mediump float;\n"
+    "layout(location = 0) in vec2 in_uv;\n"
+    "layout(location = 0) out vec4 o_color;\n"
+    "void main()\n"
+    "{\n"
+    "	o_color = vec4(in_uv, 0.0, 1.0);\n"
+    "}\n";
+
+/**
+ * @brief Hashes the whole state, as the pipeline lookup did before the hash was maintained by the setters
+ */
+size_t hash_whole_state(const vkb::PipelineState &pipeline_state)
+{
+	size_t result = 0;
+
+	vkb::hash_combine(result, pipeline_state.get_pipeline_layout().get_handle());
+
+	for (auto stage : pipeline_state.get_pipeline_layout().get_shader_program().get_shader_modules())
+	{
+		vkb::hash_combine(result, stage->get_id());
+	}
+
+	if (auto render_pass = pipeline_state.get_render_pass())
+	{
+		vkb::hash_combine(result, render_pass->get_handle());
+	}
+
+	vkb::hash_combine(result, pipeline_state.get_specialization_constant_state());
+
+	vkb::hash_combine(result, pipeline_state.get_subpass_index());
+
+	for (auto &attribute : pipeline_state.get_vertex_input_state().attributes)
+	{
+		vkb::hash_combine(result, attribute);
+	}
+
+	for (auto &binding : pipeline_state.get_vertex_input_state().bindings)
+	{
+		vkb::hash_combine(result, binding);
+	}
+
+	vkb::hash_combine(result, pipeline_state.get_input_assembly_state().primitive_restart_enable);
+	vkb::hash_combine(result, static_cast<std::underlying_type<VkPrimitiveTopology>::type>(pipeline_state.get_input_assembly_state().topology));
+
+	vkb::hash_combine(result, pipeline_state.get_viewport_state().viewport_count);
+	vkb::hash_combine(result, pipeline_state.get_viewport_state().scissor_count);
+
+	vkb::hash_combine(result, pipeline_state.get_rasterization_state().cull_mode);
+	vkb::hash_combine(result, pipeline_state.get_rasterization_state().depth_bias_enable);
+	vkb::hash_combine(result, pipeline_state.get_rasterization_state().depth_clamp_enable);
+	vkb::hash_combine(result, static_cast<std::underlying_type<VkFrontFace>::type>(pipeline_state.get_rasterization_state().front_face));
+	vkb::hash_combine(result, static_cast<std::underlying_type<VkPolygonMode>::type>(pipeline_state.get_rasterization_state().polygon_mode));
+	vkb::hash_combine(result, pipeline_state.get_rasterization_state().rasterizer_discard_enable);
+
+	vkb::hash_combine(result, pipeline_state.get_multisample_state().alpha_to_coverage_enable);
+	vkb::hash_combine(result, pipeline_state.get_multisample_state().alpha_to_one_enable);
+	vkb::hash_combine(result, pipeline_state.get_multisample_state().min_sample_shading);
+	vkb::hash_combine(result, static_cast<std::underlying_type<VkSampleCountFlagBits>::type>(pipeline_state.get_multisample_state().rasterization_samples));
+	vkb::hash_combine(result, pipeline_state.get_multisample_state().sample_shading_enable);
+	vkb::hash_combine(result, pipeline_state.get_multisample_state().sample_mask);
+
+	vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().back);
+	vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().depth_bounds_test_enable);
+	vkb::hash_combine(result, static_cast<std::underlying_type<VkCompareOp>::type>(pipeline_state.get_depth_stencil_state().depth_compare_op));
+	vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().depth_test_enable);
+	vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().depth_write_enable);
+	vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().front);
+	vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().stencil_test_enable);
+
+	vkb::hash_combine(result, static_cast<std::underlying_type<VkLogicOp>::type>(pipeline_state.get_color_blend_state().logic_op));
+	vkb::hash_combine(result, pipeline_state.get_color_blend_state().logic_op_enable);
+
+	for (auto &attachment : pipeline_state.get_color_blend_state().attachments)
+	{
+		vkb::hash_combine(result, attachment);
+	}
+
+	return result;
+}
+
+/**
+ * @brief Sets up the state of a geometry subpass drawing a mesh with positions, normals and texture coordinates
+ */
+void set_mesh_state(vkb::ResourceCache &resource_cache, vkb::PipelineState &pipeline_state)
+{
+	vkb::ShaderSource vertex_source{std::vector<uint8_t>{VERTEX_SHADER, VERTEX_SHADER + std::strlen(VERTEX_SHADER)}};
+	vkb::ShaderSource fragment_source{std::vector<uint8_t>{FRAGMENT_SHADER, FRAGMENT_SHADER + std::strlen(FRAGMENT_SHADER)}};
+
+	auto &vertex_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, vertex_source);
+	auto &fragment_module = resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, fragment_source);
+
+	pipeline_state.set_pipeline_layout(resource_cache.request_pipeline_layout({&vertex_module, &fragment_module}, false));
+
+	vkb::VertexInputState vertex_input_state;
+
+	for (uint32_t location = 0; location < 3; ++location)
+	{
+		vertex_input_state.bindings.push_back({location, location == 2 ? 8u : 12u, VK_VERTEX_INPUT_RATE_VERTEX});
+		vertex_input_state.attributes.push_back({location, location, location == 2 ? VK_FORMAT_R32G32_SFLOAT : VK_FORMAT_R32G32B32_SFLOAT, 0});
+	}
+
+	pipeline_state.set_vertex_input_state(vertex_input_state);
+
+	vkb::ColorBlendState color_blend_state;
+	color_blend_state.attachments.resize(1);
+
+	pipeline_state.set_color_blend_state(color_blend_state);
+
+	for (uint32_t constant_id = 0; constant_id < 4; ++constant_id)
+	{
+		pipeline_state.set_specialization_constant(constant_id, std::vector<uint8_t>(sizeof(uint32_t), static_cast<uint8_t>(constant_id)));
+	}
+}
+
+/**
+ * @brief Changes the state which differs between the draws of a geometry subpass
+ */
+void set_draw_state(vkb::PipelineState &pipeline_state, size_t draw)
+{
+	vkb::RasterizationState rasterization_state;
+	rasterization_state.cull_mode = draw % 4 == 0 ? VK_CULL_MODE_NONE : VK_CULL_MODE_BACK_BIT;
+
+	pipeline_state.set_rasterization_state(rasterization_state);
+}
+}        // namespace
+
+int main()
+{
+	vkb::Instance instance{"pipeline_state_hash_benchmark", {}, {}, true};
+
+	vkb::Device device{instance.get_gpu(), VK_NULL_HANDLE};
+
+	auto &resource_cache = device.get_resource_cache();
+
+	auto &render_pass = resource_cache.request_render_pass({{VK_FORMAT_R8G8B8A8_UNORM, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT}},
+	                                                       {vkb::LoadStoreInfo{}},
+	                                                       {vkb::SubpassInfo{{}, {0}}});
+
+	vkb::PipelineState pipeline_state;
+
+	set_mesh_state(resource_cache, pipeline_state);
+
+	// The pipelines of both cull modes, found through the hash of the whole state as before
+	vkb::ResourceMap<vkb::GraphicsPipeline *> whole_state_pipelines;
+
+	for (size_t draw = 0; draw < 2; ++draw)
+	{
+		set_draw_state(pipeline_state, draw);
+
+		pipeline_state.set_render_pass(render_pass);
+
+		whole_state_pipelines.emplace(hash_whole_state(pipeline_state), &resource_cache.request_graphics_pipeline(pipeline_state));
+	}
+
+	// Both variants follow CommandBuffer::flush_pipeline_state, which looks the pipeline up when the state is dirty
+	vkbbench::run("flush_pipeline_state, maintained hash, 10000 draws", 100, [&]() {
+		for (size_t draw = 0; draw < DRAW_COUNT; ++draw)
+		{
+			set_draw_state(pipeline_state, draw);
+
+			if (pipeline_state.is_dirty())
+			{
+				pipeline_state.set_render_pass(render_pass);
+
+				pipeline_state.clear_dirty();
+
+				vkbbench::keep(resource_cache.request_graphics_pipeline(pipeline_state).get_handle());
+			}
+		}
+	});
+
+	vkbbench::run("flush_pipeline_state, whole state hashed, 10000 draws", 100, [&]() {
+		for (size_t draw = 0; draw < DRAW_COUNT; ++draw)
+		{
+			set_draw_state(pipeline_state, draw);
+
+			if (pipeline_state.is_dirty())
+			{
+				pipeline_state.set_render_pass(render_pass);
+
+				pipeline_state.clear_dirty();
+
+				auto pipeline = whole_state_pipelines.find(hash_whole_state(pipeline_state));
+
+				whole_state_pipelines.record_hit();
+
+				vkbbench::keep((*pipeline)->get_handle());
+			}
+		}
+	});
+
+	return 0;
+}
@@ -0,0 +1,106 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "common/radix_sort.h"
+
+namespace
+{
+/**
+ * @brief A draw as listed by the geometry subpass: a sort key and the node and sub mesh to draw
+ */
+struct Draw
+{
+	uint64_t sort_key;
+
+	const void *node;
+
+	const void *sub_mesh;
+};
+
+/**
+ * @brief Makes keys laid out as opaque draw keys: a pipeline id, a material id and a distance
+ */
+std::vector<Draw> make_draws(size_t count, std::mt19937_64 &random)
+{
+	std::vector<Draw> draws(count);
+
+	for (auto &draw : draws)
+	{
+		uint64_t pipeline_id = random() % 32;
+		uint64_t material_id = random() % 256;
+		uint64_t distance    = random() & 0xFFFFFFFF;
+
+		draw.sort_key = (pipeline_id << 48) | (material_id << 32) | distance;
+		draw.node     = &draw;
+		draw.sub_mesh = &draw;
+	}
+
+	return draws;
+}
+}        // namespace
+
+int main()
+{
+	std::mt19937_64 random{42};
+
+	for (size_t draw_count : {1000, 10000, 100000})
+	{
+		auto draws = make_draws(draw_count, random);
+
+		std::vector<Draw> sorted(draw_count);
+		std::vector<Draw> scratch(draw_count);
+
+		std::string draws_name = std::to_string(draw_count) + " draws";
+
+		vkbbench::run(("radix_sort, " + draws_name).c_str(), 20, [&]() {
+			sorted = draws;
+			vkb::radix_sort(sorted.data(), scratch.data(), sorted.size(), [](const Draw &draw) { return draw.sort_key; });
+			vkbbench::keep(sorted.front().sort_key);
+		});
+
+		vkbbench::run(("std::stable_sort, " + draws_name).c_str(), 20, [&]() {
+			sorted = draws;
+			std::stable_sort(sorted.begin(), sorted.end(), [](const Draw &lhs, const Draw &rhs) { return lhs.sort_key < rhs.sort_key; });
+			vkbbench::keep(sorted.front().sort_key);
+		});
+
+		// The subpass used to insert its draws in a multimap keyed by distance
+		vkbbench::run(("std::multimap inserts, " + draws_name).c_str(), 20, [&]() {
+			std::multimap<uint64_t, std::pair<const void *, const void *>> draw_map;
+
+			for (auto &draw : draws)
+			{
+				draw_map.emplace(draw.sort_key, std::make_pair(draw.node, draw.sub_mesh));
+			}
+
+			vkbbench::keep(draw_map.begin()->first);
+		});
+	}
+
+	return 0;
+}
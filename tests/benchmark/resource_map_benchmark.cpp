@@ -0,0 +1,163 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark.h"
+#include "common/resource_map.h"
+
+namespace
+{
+/// Number of cached resources, in the range of the pipelines and descriptor sets of a sample
+constexpr size_t RESOURCE_COUNT = 4096;
+
+/// Lookups made by each thread in a run, about the draws of a few frames
+constexpr size_t LOOKUP_COUNT = 100000;
+
+struct Resource
+{
+	uint64_t value{0};
+};
+
+/**
+ * @brief The cache before lookups were made lock-free: one mutex per resource type
+ */
+class LockedMap
+{
+  public:
+	void emplace(size_t hash, Resource &&resource)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		resources.emplace(hash, std::move(resource));
+	}
+
+	Resource *find(size_t hash)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = resources.find(hash);
+
+		if (it == resources.end())
+		{
+			return nullptr;
+		}
+
+		++hit_count;
+
+		return &it->second;
+	}
+
+	/**
+	 * @brief Hits are already counted by find(), under the lock
+	 */
+	void record_hit()
+	{}
+
+  private:
+	std::mutex mutex;
+
+	uint64_t hit_count{0};
+
+	std::unordered_map<size_t, Resource> resources;
+};
+
+/**
+ * @brief Looks the keys up from several threads at once, as command buffers recorded in parallel do
+ */
+template <class Map>
+void look_up_in_parallel(Map &map, const std::vector<std::vector<size_t>> &thread_keys)
+{
+	std::vector<std::thread> threads;
+
+	for (auto &keys : thread_keys)
+	{
+		threads.emplace_back([&map, &keys]() {
+			uint64_t sum = 0;
+
+			for (auto key : keys)
+			{
+				sum += map.find(key)->value;
+
+				// Counted on every hit, as request_resource does
+				map.record_hit();
+			}
+
+			vkbbench::keep(sum);
+		});
+	}
+
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+}
+}        // namespace
+
+int main()
+{
+	std::mt19937_64 random{42};
+
+	std::vector<size_t> hashes(RESOURCE_COUNT);
+
+	vkb::ResourceMap<Resource> resource_map;
+	LockedMap                  locked_map;
+
+	for (size_t i = 0; i < RESOURCE_COUNT; ++i)
+	{
+		hashes[i] = static_cast<size_t>(random());
+
+		{
+			std::lock_guard<std::mutex> lock(resource_map.get_mutex());
+			resource_map.emplace(hashes[i], Resource{i});
+		}
+
+		locked_map.emplace(hashes[i], Resource{i});
+	}
+
+	size_t max_thread_count = std::max<size_t>(4, std::thread::hardware_concurrency());
+
+	for (size_t thread_count = 1; thread_count <= max_thread_count; thread_count *= 2)
+	{
+		std::vector<std::vector<size_t>> thread_keys(thread_count, std::vector<size_t>(LOOKUP_COUNT));
+
+		for (auto &keys : thread_keys)
+		{
+			for (auto &key : keys)
+			{
+				key = hashes[random() % RESOURCE_COUNT];
+			}
+		}
+
+		std::string threads = std::to_string(thread_count) + " thread(s), " + std::to_string(LOOKUP_COUNT) + " lookups each";
+
+		vkbbench::run(("mutex and unordered_map, " + threads).c_str(), 10, [&]() { look_up_in_parallel(locked_map, thread_keys); });
+		vkbbench::run(("ResourceMap, " + threads).c_str(), 10, [&]() { look_up_in_parallel(resource_map, thread_keys); });
+	}
+
+	return 0;
+}
@@ -0,0 +1,122 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "gpu_driven.h"
+
+#include "gltf_loader.h"
+#include "platform/platform.h"
+#include "rendering/subpasses/forward_subpass.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+#include <glm/gtx/quaternion.hpp>
+VKBP_ENABLE_WARNINGS()
+
+bool GpuDrivenTest::prepare(vkb::Platform &platform)
+{
+	if (!VulkanTest::prepare(platform))
+	{
+		return false;
+	}
+
+	load_scene("scenes/sponza/Sponza01.gltf");
+
+	scene->clear_components<vkb::sg::Light>();
+
+	vkb::add_directional_light(get_scene(), glm::quat({glm::radians(-90.0f), 0.0f, glm::radians(30.0f)}));
+
+	auto camera_node = scene->find_node("main_camera");
+
+	if (!camera_node)
+	{
+		LOGW("Camera node not found. Looking for `default_camera` node.");
+
+		camera_node = scene->find_node("default_camera");
+	}
+
+	camera = &camera_node->get_component<vkb::sg::Camera>();
+
+	instanced_pipeline  = create_pipeline(false);
+	gpu_driven_pipeline = create_pipeline(true);
+
+	// The test would only compare CPU drawing with itself if the subpass fell back to it
+	auto &gpu_driven_subpass = static_cast<vkb::ForwardSubpass &>(*gpu_driven_pipeline->get_subpasses().at(0));
+	if (!gpu_driven_subpass.is_gpu_driven())
+	{
+		LOGE("GPU driven drawing is not supported by the device");
+		return false;
+	}
+
+	return true;
+}
+
+void GpuDrivenTest::update(float delta_time)
+{
+	// The frame drawn with CPU instancing is saved as the reference of the test image
+	gpu_driven_enabled = false;
+	VulkanSample::update(delta_time);
+	vkb::screenshot(get_render_context(), get_name() + "_reference");
+
+	gpu_driven_enabled = true;
+	VulkanSample::update(delta_time);
+	vkb::screenshot(get_render_context(), get_name());
+
+	end();
+}
+
+void GpuDrivenTest::render(vkb::CommandBuffer &command_buffer)
+{
+	auto &render_target = get_render_context().get_active_frame().get_render_target();
+
+	// The render pipeline dispatches the cull shader of the GPU driven subpass before its render pass
+	if (gpu_driven_enabled)
+	{
+		gpu_driven_pipeline->draw(command_buffer, render_target);
+	}
+	else
+	{
+		instanced_pipeline->draw(command_buffer, render_target);
+	}
+}
+
+std::unique_ptr<vkb::RenderPipeline> GpuDrivenTest::create_pipeline(bool gpu_driven)
+{
+	vkb::ShaderSource vert_shader("base.vert");
+	vkb::ShaderSource frag_shader("base.frag");
+
+	auto scene_subpass = std::make_unique<vkb::ForwardSubpass>(get_render_context(), std::move(vert_shader), std::move(frag_shader), *scene, *camera);
+
+	// Both pipelines instance the draws, so that only how the instances are culled and counted differs
+	scene_subpass->set_instancing(true);
+	scene_subpass->set_gpu_driven(gpu_driven);
+
+	std::vector<std::unique_ptr<vkb::Subpass>> subpasses{};
+	subpasses.push_back(std::move(scene_subpass));
+
+	return std::make_unique<vkb::RenderPipeline>(std::move(subpasses));
+}
+
+std::unique_ptr<vkb::VulkanSample> create_gpu_driven_test()
+{
+	return std::make_unique<GpuDrivenTest>();
+}
@@ -0,0 +1,52 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "rendering/render_pipeline.h"
+#include "scene_graph/components/camera.h"
+#include "vulkan_test.h"
+
+class GpuDrivenTest : public vkbtest::VulkanTest
+{
+  public:
+	GpuDrivenTest() = default;
+
+	virtual ~GpuDrivenTest() = default;
+
+	virtual bool prepare(vkb::Platform &platform) override;
+
+	virtual void update(float delta_time) override;
+
+  private:
+	virtual void render(vkb::CommandBuffer &command_buffer) override;
+
+	std::unique_ptr<vkb::RenderPipeline> create_pipeline(bool gpu_driven);
+
+	vkb::sg::Camera *camera{nullptr};
+
+	std::unique_ptr<vkb::RenderPipeline> instanced_pipeline{};
+
+	std::unique_ptr<vkb::RenderPipeline> gpu_driven_pipeline{};
+
+	bool gpu_driven_enabled{false};
+};
+
+std::unique_ptr<vkb::VulkanSample> create_gpu_driven_test();
@@ -0,0 +1,109 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "spec_constants.h"
+
+#include "gltf_loader.h"
+#include "platform/platform.h"
+#include "rendering/subpasses/forward_subpass.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+#include <glm/gtx/quaternion.hpp>
+VKBP_ENABLE_WARNINGS()
+
+bool SpecConstantsTest::prepare(vkb::Platform &platform)
+{
+	if (!VulkanTest::prepare(platform))
+	{
+		return false;
+	}
+
+	load_scene("scenes/sponza/Sponza01.gltf");
+
+	scene->clear_components<vkb::sg::Light>();
+
+	vkb::add_directional_light(get_scene(), glm::quat({glm::radians(-90.0f), 0.0f, glm::radians(30.0f)}));
+
+	auto camera_node = scene->find_node("main_camera");
+
+	if (!camera_node)
+	{
+		LOGW("Camera node not found. Looking for `default_camera` node.");
+
+		camera_node = scene->find_node("default_camera");
+	}
+
+	camera = &camera_node->get_component<vkb::sg::Camera>();
+
+	specialization_constants_pipeline = create_pipeline("specialization_constants/specialization_constants.frag");
+	uniform_buffers_pipeline          = create_pipeline("specialization_constants/UBOs.frag");
+
+	return true;
+}
+
+void SpecConstantsTest::update(float delta_time)
+{
+	// The uniform buffers frame is saved as the reference of the test image
+	specialization_constants_enabled = false;
+	VulkanSample::update(delta_time);
+	vkb::screenshot(get_render_context(), get_name() + "_reference");
+
+	specialization_constants_enabled = true;
+	VulkanSample::update(delta_time);
+	vkb::screenshot(get_render_context(), get_name());
+
+	end();
+}
+
+void SpecConstantsTest::render(vkb::CommandBuffer &command_buffer)
+{
+	auto &render_target = get_render_context().get_active_frame().get_render_target();
+
+	if (specialization_constants_enabled)
+	{
+		// Set on the primary command buffer, as the sample does, so that secondary command buffers must inherit it
+		command_buffer.set_specialization_constant(0, vkb::to_u32(scene->get_components<vkb::sg::Light>().size()));
+		specialization_constants_pipeline->draw(command_buffer, render_target);
+	}
+	else
+	{
+		uniform_buffers_pipeline->draw(command_buffer, render_target);
+	}
+}
+
+std::unique_ptr<vkb::RenderPipeline> SpecConstantsTest::create_pipeline(const std::string &fragment_shader)
+{
+	vkb::ShaderSource vert_shader("base.vert");
+	vkb::ShaderSource frag_shader(fragment_shader);
+
+	std::vector<std::unique_ptr<vkb::Subpass>> subpasses{};
+	subpasses.push_back(std::make_unique<vkb::ForwardSubpass>(get_render_context(), std::move(vert_shader), std::move(frag_shader), *scene, *camera));
+
+	return std::make_unique<vkb::RenderPipeline>(std::move(subpasses));
+}
+
+std::unique_ptr<vkb::VulkanSample> create_spec_constants_test()
+{
+	return std::make_unique<SpecConstantsTest>();
+}
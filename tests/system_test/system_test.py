@@ -39,6 +39,7 @@ outputs_path      = "output/images/"
 tmp_path          = os.path.join(script_path, "tmp/")
 archive_path      = os.path.join(script_path, "artifacts/")
 image_ext         = ".png"
+reference_suffix  = "_reference"
 android_timeout   = 60 # How long in seconds should we wait before timing out on Android
 check_step        = 5
 threshold         = 0.999 # How similar the images are allowed to be before they pass
@@ -76,6 +77,10 @@ class Subtest:
             print("\t\t\t(Error) Couldn't find screenshot ({}), perhaps test crashed".format(os.path.join(root_path, outputs_path) + self.test_name + image_ext))
             self.result = False
             return
+        # Tests may save a reference screenshot, which replaces the gold image
+        reference_image = os.path.join(root_path, outputs_path) + self.test_name + reference_suffix + image_ext
+        if os.path.isfile(reference_image):
+            shutil.move(reference_image, screenshot_path + self.test_name + reference_suffix + image_ext)
         if not test(self.test_name, screenshot_path):
             self.result = False
         if self.result:
@@ -119,6 +124,7 @@ class AndroidSubtest(Subtest):
             activity = "".join(output.decode("utf-8").split())
         if timeout_counter <= android_timeout:
             subprocess.run(["adb", "pull", "/sdcard/Android/data/com.arm.vulkan_best_practice/files/" + outputs_path + self.test_name + image_ext, os.path.join(root_path, outputs_path)], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+            subprocess.run(["adb", "pull", "/sdcard/Android/data/com.arm.vulkan_best_practice/files/" + outputs_path + self.test_name + reference_suffix + image_ext, os.path.join(root_path, outputs_path)], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
             return True
         else:
             print("\t\t\t(Error) Timed out")
@@ -179,7 +185,7 @@ def compare(metric, base_image, test_image, diff_image = "null:"):
 
 def test(test_name, screenshot_path):
     """
-    @brief   Tests each screenshot within the tmp/ folder against the goldtest, saving the results if it fails
+    @brief   Tests each screenshot within the tmp/ folder against the goldtest, or against the reference screenshot the test saved, saving the results if it fails
     @param   test_name       The name of the test, used to retrieve the respective goldtest image
     @param   screenshot_path The directory where to store screenshots
     @return  True if the image tests pass
@@ -189,7 +195,10 @@ def test(test_name, screenshot_path):
     image = test_name + image_ext
     base_image = screenshot_path + image
     test_image = script_path + "/gold/{0}/{1}.png".format(test_name, get_resolution(base_image))
-    if not os.path.isfile(test_image):
+    reference_image = screenshot_path + test_name + reference_suffix + image_ext
+    if os.path.isfile(reference_image):
+        test_image = reference_image
+    elif not os.path.isfile(test_image):
         print("\t\t\t(Error) Resolution not supported, gold image not found ({})".format(test_image))
         return False
     diff_image = "{0}{1}-diff.png".format(screenshot_path, image[0:image.find(".")])
@@ -200,6 +209,8 @@ def test(test_name, screenshot_path):
     if similarity >= threshold:
         os.remove(base_image)
         os.remove(diff_image)
+        if test_image == reference_image:
+            os.remove(reference_image)
         result = True
     return result
 
@@ -0,0 +1,323 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "scene_graph/bvh.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/node.h"
+#include "unit_test.h"
+
+namespace
+{
+using vkb::sg::BVH;
+
+/**
+ * @brief Component standing for a mesh, as the tree only keeps a reference to it
+ */
+class TestMesh : public vkb::sg::Component
+{
+  public:
+	virtual std::type_index get_type() override
+	{
+		return typeid(TestMesh);
+	}
+};
+
+/**
+ * @brief Unit boxes scattered in a cube, with a node each. The tree is declared last,
+ *        so that it stops observing the transforms before they are destroyed
+ */
+struct TestScene
+{
+	TestMesh mesh;
+
+	std::vector<std::unique_ptr<vkb::sg::Node>> nodes;
+
+	std::unique_ptr<BVH> bvh;
+
+	explicit TestScene(size_t object_count)
+	{
+		std::mt19937                          generator{42};
+		std::uniform_real_distribution<float> position{-50.0f, 50.0f};
+
+		bvh = std::make_unique<BVH>();
+
+		for (size_t i = 0; i < object_count; ++i)
+		{
+			nodes.push_back(std::make_unique<vkb::sg::Node>("node"));
+			nodes.back()->get_transform().set_translation({position(generator), position(generator), position(generator)});
+
+			bvh->add(*nodes.back(), mesh, BVH::MeshObject, glm::vec3{-0.5f}, glm::vec3{0.5f});
+		}
+
+		bvh->build();
+	}
+};
+
+bool overlaps_sphere(const glm::vec3 &min, const glm::vec3 &max, const glm::vec3 &center, float radius)
+{
+	glm::vec3 closest = glm::clamp(center, min, max) - center;
+
+	return glm::dot(closest, closest) <= radius * radius;
+}
+
+bool overlaps_box(const glm::vec3 &min, const glm::vec3 &max, const glm::vec3 &query_min, const glm::vec3 &query_max)
+{
+	return glm::all(glm::lessThanEqual(query_min, max)) && glm::all(glm::lessThanEqual(min, query_max));
+}
+
+/**
+ * @return The distance at which a ray enters a box, or infinity if it misses it
+ */
+float ray_distance(const glm::vec3 &min, const glm::vec3 &max, const glm::vec3 &origin, const glm::vec3 &direction)
+{
+	// Multiplies by the inverse direction as the tree does, to find the same distances
+	glm::vec3 inverse_direction = 1.0f / direction;
+
+	glm::vec3 t0 = (min - origin) * inverse_direction;
+	glm::vec3 t1 = (max - origin) * inverse_direction;
+
+	glm::vec3 t_near = glm::min(t0, t1);
+	glm::vec3 t_far  = glm::max(t0, t1);
+
+	float enter = std::max({t_near.x, t_near.y, t_near.z, 0.0f});
+	float exit  = std::min({t_far.x, t_far.y, t_far.z});
+
+	return enter <= exit ? enter : std::numeric_limits<float>::infinity();
+}
+
+/**
+ * @brief Finds the objects passing a test by visiting all of them, to compare with the tree
+ */
+template <class Test>
+std::vector<uint32_t> find_brute_force(const BVH &bvh, Test test)
+{
+	std::vector<uint32_t> found_objects;
+
+	for (uint32_t object = 0; object < bvh.get_object_count(); ++object)
+	{
+		glm::vec3 min, max;
+		bvh.get_bounds(object, min, max);
+
+		if (test(min, max))
+		{
+			found_objects.push_back(object);
+		}
+	}
+
+	return found_objects;
+}
+
+std::vector<uint32_t> sorted(std::vector<uint32_t> objects)
+{
+	std::sort(objects.begin(), objects.end());
+	return objects;
+}
+
+void test_query_sphere_matches_brute_force()
+{
+	TestScene scene{500};
+
+	const glm::vec3 centers[] = {{0.0f, 0.0f, 0.0f}, {30.0f, -20.0f, 10.0f}, {-60.0f, 0.0f, 0.0f}, {49.0f, 49.0f, 49.0f}};
+	const float     radii[]   = {0.0f, 5.0f, 20.0f, 200.0f};
+
+	for (const auto &center : centers)
+	{
+		for (auto radius : radii)
+		{
+			std::vector<uint32_t> found_objects;
+			scene.bvh->query_sphere(center, radius, found_objects);
+
+			auto expected_objects = find_brute_force(*scene.bvh, [&center, radius](const glm::vec3 &min, const glm::vec3 &max) {
+				return overlaps_sphere(min, max, center, radius);
+			});
+
+			VKBTEST_CHECK(sorted(found_objects) == expected_objects);
+		}
+	}
+}
+
+void test_query_box_matches_brute_force()
+{
+	TestScene scene{500};
+
+	const glm::vec3 mins[] = {{-10.0f, -10.0f, -10.0f}, {20.0f, -50.0f, 0.0f}, {-100.0f, -100.0f, -100.0f}, {60.0f, 60.0f, 60.0f}};
+	const glm::vec3 size{25.0f, 40.0f, 10.0f};
+
+	for (const auto &min : mins)
+	{
+		glm::vec3 max = min + size;
+
+		std::vector<uint32_t> found_objects;
+		scene.bvh->query_box(min, max, found_objects);
+
+		auto expected_objects = find_brute_force(*scene.bvh, [&min, &max](const glm::vec3 &object_min, const glm::vec3 &object_max) {
+			return overlaps_box(object_min, object_max, min, max);
+		});
+
+		VKBTEST_CHECK(sorted(found_objects) == expected_objects);
+	}
+
+	// A box around the whole scene finds every object, through the subtrees inside it
+	std::vector<uint32_t> found_objects;
+	scene.bvh->query_box(glm::vec3{-100.0f}, glm::vec3{100.0f}, found_objects);
+
+	VKBTEST_CHECK(found_objects.size() == scene.bvh->get_object_count());
+}
+
+void test_raycast_finds_closest_object()
+{
+	TestScene scene{500};
+
+	std::mt19937                          generator{7};
+	std::uniform_real_distribution<float> coordinate{-1.0f, 1.0f};
+
+	for (uint32_t i = 0; i < 64; ++i)
+	{
+		glm::vec3 origin{coordinate(generator) * 60.0f, coordinate(generator) * 60.0f, coordinate(generator) * 60.0f};
+
+		// Aimed near an object, as random rays through the sparse scene would all miss
+		glm::vec3 target_min, target_max;
+		scene.bvh->get_bounds(i * 7 % scene.bvh->get_object_count(), target_min, target_max);
+
+		glm::vec3 target{(target_min + target_max) * 0.5f + glm::vec3{coordinate(generator), coordinate(generator), coordinate(generator)} * 0.6f};
+		glm::vec3 direction{target - origin};
+
+		float expected_distance = std::numeric_limits<float>::infinity();
+		for (uint32_t object = 0; object < scene.bvh->get_object_count(); ++object)
+		{
+			glm::vec3 min, max;
+			scene.bvh->get_bounds(object, min, max);
+
+			expected_distance = std::min(expected_distance, ray_distance(min, max, origin, direction));
+		}
+
+		uint32_t hit_object{0};
+		float    hit_distance{0.0f};
+		bool     hit = scene.bvh->raycast(origin, direction, std::numeric_limits<float>::max(), hit_object, hit_distance);
+
+		VKBTEST_CHECK(hit == (expected_distance != std::numeric_limits<float>::infinity()));
+
+		if (hit)
+		{
+			// Objects may be entered at the same distance, so the distances are compared
+			glm::vec3 min, max;
+			scene.bvh->get_bounds(hit_object, min, max);
+
+			VKBTEST_CHECK(hit_distance == expected_distance);
+			VKBTEST_CHECK(ray_distance(min, max, origin, direction) == expected_distance);
+		}
+	}
+
+	// Objects beyond the maximum distance are not hit
+	uint32_t hit_object{0};
+	float    hit_distance{0.0f};
+	VKBTEST_CHECK(!scene.bvh->raycast(glm::vec3{-200.0f}, glm::vec3{1.0f}, 1.0f, hit_object, hit_distance));
+}
+
+void test_update_refits_moved_objects()
+{
+	TestScene scene{100};
+
+	glm::vec3 far_position{500.0f, 0.0f, 0.0f};
+
+	// A node changed twice before an update moves its objects once
+	scene.nodes[3]->get_transform().set_translation(far_position);
+	scene.nodes[3]->get_transform().set_scale(glm::vec3{2.0f});
+
+	VKBTEST_CHECK(scene.bvh->update() == 1);
+	VKBTEST_CHECK(scene.bvh->update() == 0);
+
+	std::vector<uint32_t> found_objects;
+	scene.bvh->query_sphere(far_position, 1.5f, found_objects);
+
+	VKBTEST_CHECK(found_objects == std::vector<uint32_t>{3});
+
+	glm::vec3 min, max;
+	scene.bvh->get_bounds(3, min, max);
+
+	VKBTEST_CHECK(min == far_position - 1.0f);
+	VKBTEST_CHECK(max == far_position + 1.0f);
+
+	// Moving a parent moves the objects of its children
+	scene.nodes[5]->set_parent(*scene.nodes[4]);
+	scene.nodes[4]->add_child(*scene.nodes[5]);
+	scene.bvh->update();
+
+	scene.nodes[4]->get_transform().set_translation(far_position);
+
+	VKBTEST_CHECK(scene.bvh->update() == 2);
+}
+
+void test_light_range_is_not_scaled()
+{
+	TestMesh       mesh;
+	vkb::sg::Light light{"light"};
+	vkb::sg::Node  node{"node"};
+
+	node.get_transform().set_translation({10.0f, 0.0f, 0.0f});
+	node.get_transform().set_scale(glm::vec3{4.0f});
+
+	BVH bvh;
+
+	auto mesh_object  = bvh.add(node, mesh, BVH::MeshObject, glm::vec3{-1.0f}, glm::vec3{1.0f});
+	auto light_object = bvh.add(node, light, BVH::LightObject, glm::vec3{-2.0f}, glm::vec3{2.0f});
+
+	bvh.build();
+
+	glm::vec3 min, max;
+
+	bvh.get_bounds(mesh_object, min, max);
+	VKBTEST_CHECK(min == glm::vec3(6.0f, -4.0f, -4.0f));
+	VKBTEST_CHECK(max == glm::vec3(14.0f, 4.0f, 4.0f));
+
+	bvh.get_bounds(light_object, min, max);
+	VKBTEST_CHECK(min == glm::vec3(8.0f, -2.0f, -2.0f));
+	VKBTEST_CHECK(max == glm::vec3(12.0f, 2.0f, 2.0f));
+
+	// Queries only find the objects of the types asked for
+	std::vector<uint32_t> found_objects;
+	bvh.query_sphere({10.0f, 0.0f, 0.0f}, 1.0f, found_objects, BVH::LightObject);
+
+	VKBTEST_CHECK(found_objects == std::vector<uint32_t>{light_object});
+}
+}        // namespace
+
+int main()
+{
+	test_query_sphere_matches_brute_force();
+	test_query_box_matches_brute_force();
+	test_raycast_finds_closest_object();
+	test_update_refits_moved_objects();
+	test_light_range_is_not_scaled();
+
+	return vkbtest::get_test_result();
+}
@@ -0,0 +1,259 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "common/linear_arena.h"
+#include "core/command_stream.h"
+#include "unit_test.h"
+
+namespace
+{
+/**
+ * @brief A command as received by the Vulkan entry points, which the test replaces
+ *        so that the stream is executed without a device
+ */
+struct ExecutedCommand
+{
+	std::string name;
+
+	std::vector<uint64_t> args;
+};
+
+std::vector<ExecutedCommand> executed_commands;
+
+/**
+ * @brief Creates a handle which is never dereferenced, for commands which only pass it on
+ */
+template <class T>
+T make_handle(uintptr_t value)
+{
+	// Non-dispatchable handles are pointers or 64-bit integers depending on the platform
+	return (T)(value);
+}
+
+template <class T>
+uint64_t handle_value(T handle)
+{
+	return (uint64_t)(handle);
+}
+
+VKAPI_ATTR void VKAPI_CALL cmd_begin_render_pass(VkCommandBuffer, const VkRenderPassBeginInfo *begin_info, VkSubpassContents contents)
+{
+	ExecutedCommand command{"BeginRenderPass", {handle_value(begin_info->renderPass), handle_value(begin_info->framebuffer),
+	                                            begin_info->renderArea.extent.width, begin_info->clearValueCount, contents}};
+
+	for (uint32_t i = 0; i < begin_info->clearValueCount; ++i)
+	{
+		command.args.push_back(begin_info->pClearValues[i].color.uint32[0]);
+	}
+
+	executed_commands.push_back(command);
+}
+
+VKAPI_ATTR void VKAPI_CALL cmd_next_subpass(VkCommandBuffer, VkSubpassContents contents)
+{
+	executed_commands.push_back({"NextSubpass", {contents}});
+}
+
+VKAPI_ATTR void VKAPI_CALL cmd_end_render_pass(VkCommandBuffer)
+{
+	executed_commands.push_back({"EndRenderPass", {}});
+}
+
+VKAPI_ATTR void VKAPI_CALL cmd_bind_vertex_buffers(VkCommandBuffer, uint32_t first_binding, uint32_t binding_count, const VkBuffer *buffers, const VkDeviceSize *offsets)
+{
+	ExecutedCommand command{"BindVertexBuffers", {first_binding, binding_count}};
+
+	for (uint32_t i = 0; i < binding_count; ++i)
+	{
+		command.args.push_back(handle_value(buffers[i]));
+		command.args.push_back(offsets[i]);
+	}
+
+	executed_commands.push_back(command);
+}
+
+VKAPI_ATTR void VKAPI_CALL cmd_push_constants(VkCommandBuffer, VkPipelineLayout layout, VkShaderStageFlags stage_flags, uint32_t offset, uint32_t size, const void *values)
+{
+	ExecutedCommand command{"PushConstants", {handle_value(layout), stage_flags, offset, size}};
+
+	auto bytes = static_cast<const uint8_t *>(values);
+	command.args.insert(command.args.end(), bytes, bytes + size);
+
+	executed_commands.push_back(command);
+}
+
+VKAPI_ATTR void VKAPI_CALL cmd_draw_indexed(VkCommandBuffer, uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance)
+{
+	executed_commands.push_back({"DrawIndexed", {index_count, instance_count, first_index, static_cast<uint64_t>(vertex_offset), first_instance}});
+}
+
+void install_command_stubs()
+{
+	vkCmdBeginRenderPass   = cmd_begin_render_pass;
+	vkCmdNextSubpass       = cmd_next_subpass;
+	vkCmdEndRenderPass     = cmd_end_render_pass;
+	vkCmdBindVertexBuffers = cmd_bind_vertex_buffers;
+	vkCmdPushConstants     = cmd_push_constants;
+	vkCmdDrawIndexed       = cmd_draw_indexed;
+}
+
+void test_replays_commands_in_order()
+{
+	vkb::LinearArena   arena;
+	vkb::CommandStream stream;
+	stream.reset(arena);
+
+	std::vector<VkClearValue> clear_values(2);
+	clear_values[0].color.uint32[0] = 7;
+	clear_values[1].color.uint32[0] = 9;
+
+	VkRenderPassBeginInfo begin_info{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+	begin_info.renderPass               = make_handle<VkRenderPass>(0x10);
+	begin_info.framebuffer              = make_handle<VkFramebuffer>(0x20);
+	begin_info.renderArea.extent.width  = 640;
+	begin_info.renderArea.extent.height = 480;
+	begin_info.clearValueCount          = 2;
+	begin_info.pClearValues             = clear_values.data();
+
+	stream.begin_render_pass(begin_info, VK_SUBPASS_CONTENTS_INLINE);
+
+	std::vector<VkBuffer>     buffers{make_handle<VkBuffer>(0x30), make_handle<VkBuffer>(0x31)};
+	std::vector<VkDeviceSize> offsets{64, 128};
+	stream.bind_vertex_buffers(1, 2, buffers.data(), offsets.data());
+
+	uint8_t values[4]{1, 2, 3, 4};
+	stream.push_constants(make_handle<VkPipelineLayout>(0x40), VK_SHADER_STAGE_FRAGMENT_BIT, 16, 4, values);
+
+	stream.draw_indexed(36, 2, 6, -3, 1);
+	stream.next_subpass(VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	stream.end_render_pass();
+
+	// Arrays are copied when recorded, so the caller's storage can change or go away
+	clear_values[0].color.uint32[0] = 0;
+	clear_values.clear();
+	buffers.assign(2, VK_NULL_HANDLE);
+	offsets.assign(2, 0);
+	std::memset(values, 0, sizeof(values));
+
+	VKBTEST_CHECK(stream.get_command_count() == 6);
+
+	executed_commands.clear();
+	stream.execute(VK_NULL_HANDLE);
+
+	VKBTEST_CHECK(executed_commands.size() == 6);
+	if (executed_commands.size() != 6)
+	{
+		return;
+	}
+
+	VKBTEST_CHECK(executed_commands[0].name == "BeginRenderPass");
+	VKBTEST_CHECK((executed_commands[0].args == std::vector<uint64_t>{0x10, 0x20, 640, 2, VK_SUBPASS_CONTENTS_INLINE, 7, 9}));
+
+	VKBTEST_CHECK(executed_commands[1].name == "BindVertexBuffers");
+	VKBTEST_CHECK((executed_commands[1].args == std::vector<uint64_t>{1, 2, 0x30, 64, 0x31, 128}));
+
+	VKBTEST_CHECK(executed_commands[2].name == "PushConstants");
+	VKBTEST_CHECK((executed_commands[2].args == std::vector<uint64_t>{0x40, VK_SHADER_STAGE_FRAGMENT_BIT, 16, 4, 1, 2, 3, 4}));
+
+	VKBTEST_CHECK(executed_commands[3].name == "DrawIndexed");
+	VKBTEST_CHECK((executed_commands[3].args == std::vector<uint64_t>{36, 2, 6, static_cast<uint64_t>(-3), 1}));
+
+	VKBTEST_CHECK(executed_commands[4].name == "NextSubpass");
+	VKBTEST_CHECK((executed_commands[4].args == std::vector<uint64_t>{VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS}));
+
+	VKBTEST_CHECK(executed_commands[5].name == "EndRenderPass");
+}
+
+void test_replays_more_than_once()
+{
+	vkb::LinearArena   arena;
+	vkb::CommandStream stream;
+	stream.reset(arena);
+
+	stream.draw_indexed(3, 1, 0, 0, 0);
+
+	executed_commands.clear();
+	stream.execute(VK_NULL_HANDLE);
+	stream.execute(VK_NULL_HANDLE);
+
+	VKBTEST_CHECK(executed_commands.size() == 2);
+}
+
+void test_reset_empties_stream()
+{
+	vkb::LinearArena   arena;
+	vkb::CommandStream stream;
+	stream.reset(arena);
+
+	stream.end_render_pass();
+
+	arena.reset();
+	stream.reset(arena);
+
+	VKBTEST_CHECK(stream.get_command_count() == 0);
+
+	executed_commands.clear();
+	stream.execute(VK_NULL_HANDLE);
+
+	VKBTEST_CHECK(executed_commands.empty());
+}
+
+void test_records_many_commands()
+{
+	// A small arena, so that commands span several of its blocks
+	vkb::LinearArena   arena{256};
+	vkb::CommandStream stream;
+	stream.reset(arena);
+
+	for (uint32_t i = 0; i < 1000; ++i)
+	{
+		stream.draw_indexed(i, 1, 0, 0, 0);
+	}
+
+	executed_commands.clear();
+	stream.execute(VK_NULL_HANDLE);
+
+	VKBTEST_CHECK(executed_commands.size() == 1000);
+
+	bool in_order{true};
+	for (uint32_t i = 0; i < executed_commands.size(); ++i)
+	{
+		in_order = in_order && executed_commands[i].args.front() == i;
+	}
+
+	VKBTEST_CHECK(in_order);
+}
+}        // namespace
+
+int main()
+{
+	install_command_stubs();
+
+	test_replays_commands_in_order();
+	test_replays_more_than_once();
+	test_reset_empties_stream();
+	test_records_many_commands();
+
+	return vkbtest::get_test_result();
+}
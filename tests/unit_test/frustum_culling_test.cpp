@@ -0,0 +1,212 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+#include <glm/gtc/matrix_transform.hpp>
+VKBP_ENABLE_WARNINGS()
+
+#include "common/frustum_culling.h"
+#include "unit_test.h"
+
+namespace
+{
+/// Boxes closer than this to a plane may be classified either way, depending on the rounding of the SIMD path
+constexpr float BOUNDARY_EPSILON = 1e-3f;
+
+/**
+ * @brief Box transformed as BoundsArray::set does, tested against the planes one box at a time
+ */
+struct ReferenceBox
+{
+	glm::vec3 center;
+
+	glm::vec3 extent;
+};
+
+ReferenceBox make_reference_box(const glm::vec3 &min, const glm::vec3 &max, const glm::mat4 &transform)
+{
+	glm::vec3 half_extent = (max - min) * 0.5f;
+
+	ReferenceBox box{};
+	box.center = glm::vec3(transform * glm::vec4((min + max) * 0.5f, 1.0f));
+	box.extent = glm::abs(glm::vec3(transform[0])) * half_extent.x +
+	             glm::abs(glm::vec3(transform[1])) * half_extent.y +
+	             glm::abs(glm::vec3(transform[2])) * half_extent.z;
+
+	return box;
+}
+
+/**
+ * @brief Tests a box against the planes with scalar code
+ * @param on_boundary Set if the box nearly touches a plane it is outside of, or is inside only by a rounding error
+ * @return Whether the box intersects the frustum
+ */
+bool is_visible(const ReferenceBox &box, const glm::vec4 *planes, bool &on_boundary)
+{
+	bool visible{true};
+
+	on_boundary = false;
+
+	for (size_t i = 0; i < 6; ++i)
+	{
+		const auto &plane = planes[i];
+
+		float distance = glm::dot(glm::vec3(plane), box.center) + plane.w;
+		float radius   = glm::dot(glm::abs(glm::vec3(plane)), box.extent);
+		float scale    = glm::length(glm::vec3(plane));
+
+		if (std::abs(distance + radius) < BOUNDARY_EPSILON * scale)
+		{
+			on_boundary = true;
+		}
+
+		if (distance + radius < 0.0f)
+		{
+			visible = false;
+		}
+	}
+
+	return visible;
+}
+
+std::vector<glm::vec4> make_planes()
+{
+	glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3{0.0f, 2.0f, 10.0f}, glm::vec3{0.0f}, glm::vec3{0.0f, 1.0f, 0.0f});
+
+	std::vector<glm::vec4> planes(6);
+	vkb::extract_frustum_planes(proj * view, planes.data());
+
+	return planes;
+}
+
+/**
+ * @brief Culls random boxes, rotated and scaled, and compares the result with the scalar reference
+ */
+void check_matches_reference(size_t count)
+{
+	auto planes = make_planes();
+
+	std::mt19937                          generator{static_cast<uint32_t>(count)};
+	std::uniform_real_distribution<float> position{-120.0f, 120.0f};
+	std::uniform_real_distribution<float> size{0.1f, 5.0f};
+	std::uniform_real_distribution<float> angle{0.0f, 6.28f};
+
+	vkb::BoundsArray          bounds;
+	std::vector<ReferenceBox> reference_boxes;
+
+	bounds.resize(count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		glm::vec3 half_size{size(generator), size(generator), size(generator)};
+
+		glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3{position(generator), position(generator), position(generator)});
+		transform           = glm::rotate(transform, angle(generator), glm::normalize(glm::vec3{1.0f, 2.0f, 3.0f}));
+		transform           = glm::scale(transform, glm::vec3{size(generator)});
+
+		bounds.set(i, -half_size, half_size, transform);
+		reference_boxes.push_back(make_reference_box(-half_size, half_size, transform));
+	}
+
+	// One more element than the boxes, to check that the padding is not written
+	std::vector<uint8_t> visible(count + 1, 2);
+
+	size_t visible_count = bounds.cull(planes.data(), visible.data());
+
+	size_t expected_visible_count{0};
+	size_t boundary_count{0};
+	bool   matches{true};
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		bool on_boundary{false};
+		bool expected_visible = is_visible(reference_boxes[i], planes.data(), on_boundary);
+
+		if (on_boundary)
+		{
+			// Counted as the SIMD path found it, as either result is right
+			expected_visible_count += visible[i];
+			++boundary_count;
+			continue;
+		}
+
+		expected_visible_count += expected_visible ? 1 : 0;
+		matches = matches && visible[i] == (expected_visible ? 1 : 0);
+	}
+
+	VKBTEST_CHECK(matches);
+	VKBTEST_CHECK(visible_count == expected_visible_count);
+	VKBTEST_CHECK(visible[count] == 2);
+
+	// The boxes must straddle the frustum for the test to mean anything
+	VKBTEST_CHECK(count < 100 || (expected_visible_count > 0 && expected_visible_count < count - boundary_count));
+}
+
+void test_cull_matches_reference()
+{
+	// Counts around the SIMD width, so that the last iteration has every number of padding boxes
+	for (size_t count : {0, 1, 2, 3, 4, 5, 7, 8, 9, 1000, 1001, 1002, 1003})
+	{
+		check_matches_reference(count);
+	}
+}
+
+void test_cull_boxes_around_planes()
+{
+	auto planes = make_planes();
+
+	vkb::BoundsArray bounds;
+	bounds.resize(3);
+
+	// In front of the camera, behind it and beyond the far plane
+	bounds.set(0, glm::vec3{-1.0f}, glm::vec3{1.0f}, glm::mat4(1.0f));
+	bounds.set(1, glm::vec3{-1.0f}, glm::vec3{1.0f}, glm::translate(glm::mat4(1.0f), glm::vec3{0.0f, 0.0f, 20.0f}));
+	bounds.set(2, glm::vec3{-1.0f}, glm::vec3{1.0f}, glm::translate(glm::mat4(1.0f), glm::vec3{0.0f, 0.0f, -200.0f}));
+
+	uint8_t visible[3]{};
+
+	VKBTEST_CHECK(bounds.cull(planes.data(), visible) == 1);
+	VKBTEST_CHECK(visible[0] == 1);
+	VKBTEST_CHECK(visible[1] == 0);
+	VKBTEST_CHECK(visible[2] == 0);
+
+	// A box large enough to reach inside is visible, even if its center is behind the camera
+	bounds.set(1, glm::vec3{-15.0f}, glm::vec3{15.0f}, glm::translate(glm::mat4(1.0f), glm::vec3{0.0f, 0.0f, 20.0f}));
+
+	VKBTEST_CHECK(bounds.cull(planes.data(), visible) == 2);
+	VKBTEST_CHECK(visible[1] == 1);
+}
+}        // namespace
+
+int main()
+{
+	test_cull_matches_reference();
+	test_cull_boxes_around_planes();
+
+	return vkbtest::get_test_result();
+}
@@ -0,0 +1,187 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstring>
+#include <vector>
+
+#include "common/linear_arena.h"
+#include "unit_test.h"
+
+namespace
+{
+bool is_aligned(const void *pointer, size_t alignment)
+{
+	return reinterpret_cast<uintptr_t>(pointer) % alignment == 0;
+}
+
+struct alignas(64) CacheLine
+{
+	uint8_t data[64];
+};
+
+void test_aligns_allocations()
+{
+	vkb::LinearArena arena{4096};
+
+	bool aligned{true};
+
+	// Odd sizes between the allocations, so that every alignment needs padding
+	for (size_t alignment = 1; alignment <= 256; alignment *= 2)
+	{
+		arena.allocate(3);
+
+		aligned = aligned && is_aligned(arena.allocate(10, alignment), alignment);
+	}
+
+	VKBTEST_CHECK(aligned);
+
+	arena.allocate(1);
+	VKBTEST_CHECK(is_aligned(arena.allocate<double>(3), alignof(double)));
+
+	arena.allocate(1);
+	VKBTEST_CHECK(is_aligned(arena.allocate<CacheLine>(2), alignof(CacheLine)));
+
+	arena.allocate(1);
+	VKBTEST_CHECK(is_aligned(arena.allocate(1), alignof(std::max_align_t)));
+
+	// The padding is part of the used size
+	VKBTEST_CHECK(arena.get_used_size() > 9 * (3 + 10));
+}
+
+void test_overflows_into_new_blocks()
+{
+	vkb::LinearArena arena{256};
+
+	// Fill the allocations with their index, to check that new blocks leave the previous ones intact
+	std::vector<uint8_t *> allocations;
+
+	for (uint8_t i = 0; i < 20; ++i)
+	{
+		auto allocation = arena.allocate<uint8_t>(100);
+		std::memset(allocation, i, 100);
+		allocations.push_back(allocation);
+	}
+
+	// An allocation bigger than a block gets a block of its own
+	auto big_allocation = arena.allocate<uint8_t>(1000);
+	std::memset(big_allocation, 0xFF, 1000);
+
+	bool intact{true};
+	for (uint8_t i = 0; i < allocations.size(); ++i)
+	{
+		for (size_t j = 0; j < 100; ++j)
+		{
+			intact = intact && allocations[i][j] == i;
+		}
+	}
+
+	VKBTEST_CHECK(intact);
+	VKBTEST_CHECK(arena.get_capacity() >= 10 * 256 + 1000);
+	VKBTEST_CHECK(arena.get_used_size() <= arena.get_capacity());
+	VKBTEST_CHECK(arena.get_used_size() >= 20 * 100 + 1000);
+}
+
+void test_reset_merges_blocks()
+{
+	vkb::LinearArena arena{256};
+
+	auto first_allocation = arena.allocate(16);
+
+	for (size_t i = 0; i < 10; ++i)
+	{
+		arena.allocate(200);
+	}
+
+	size_t capacity = arena.get_capacity();
+
+	arena.reset();
+
+	VKBTEST_CHECK(arena.get_used_size() == 0);
+	VKBTEST_CHECK(arena.get_capacity() == capacity);
+
+	// The same frame fits in the merged block, so the arena does not grow again
+	first_allocation = arena.allocate(16);
+
+	for (size_t i = 0; i < 10; ++i)
+	{
+		arena.allocate(200);
+	}
+
+	VKBTEST_CHECK(arena.get_capacity() == capacity);
+
+	// Allocations after a reset start over at the beginning of the block
+	arena.reset();
+
+	VKBTEST_CHECK(arena.allocate(16) == first_allocation);
+}
+
+void test_reset_shrinks_after_spike()
+{
+	vkb::LinearArena arena{1024};
+
+	// A single frame needing far more than the steady ones
+	for (size_t i = 0; i < 100; ++i)
+	{
+		arena.allocate(1000);
+	}
+
+	arena.reset();
+
+	size_t spike_capacity = arena.get_capacity();
+	VKBTEST_CHECK(spike_capacity >= 100 * 1000);
+
+	// The block is kept while the frames use more than half of it
+	for (uint32_t i = 0; i < vkb::LinearArena::SHRINK_RESET_COUNT; ++i)
+	{
+		arena.allocate(spike_capacity / 2 + 1);
+		arena.reset();
+	}
+
+	VKBTEST_CHECK(arena.get_capacity() == spike_capacity);
+
+	// Then shrunk to the peak of the steady frames
+	for (uint32_t i = 0; i < vkb::LinearArena::SHRINK_RESET_COUNT; ++i)
+	{
+		arena.allocate(i % 2 == 0 ? 500 : 2000);
+		arena.reset();
+	}
+
+	VKBTEST_CHECK(arena.get_capacity() == 2000);
+
+	// But not below the size of the first block
+	for (uint32_t i = 0; i < vkb::LinearArena::SHRINK_RESET_COUNT; ++i)
+	{
+		arena.allocate(10);
+		arena.reset();
+	}
+
+	VKBTEST_CHECK(arena.get_capacity() == 1024);
+}
+}        // namespace
+
+int main()
+{
+	test_aligns_allocations();
+	test_overflows_into_new_blocks();
+	test_reset_merges_blocks();
+	test_reset_shrinks_after_spike();
+
+	return vkbtest::get_test_result();
+}
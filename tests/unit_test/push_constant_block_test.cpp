@@ -0,0 +1,116 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <array>
+#include <stdexcept>
+
+#include "common/push_constant_block.h"
+#include "unit_test.h"
+
+namespace
+{
+void test_accumulates_stored_data_first()
+{
+	vkb::PushConstantBlock block;
+
+	std::array<uint8_t, 4> stored{{1, 2, 3, 4}};
+	block.store(stored.data(), static_cast<uint32_t>(stored.size()));
+
+	VKBTEST_CHECK(block.get_size() == 4);
+
+	std::array<uint8_t, 2> appended{{5, 6}};
+
+	std::array<uint8_t, vkb::PushConstantBlock::MAX_SIZE> accumulated{};
+
+	uint32_t size = block.accumulate(appended.data(), static_cast<uint32_t>(appended.size()), accumulated);
+
+	VKBTEST_CHECK(size == 6);
+
+	bool in_order = true;
+	for (uint32_t i = 0; i < size; ++i)
+	{
+		in_order = in_order && accumulated[i] == i + 1;
+	}
+
+	VKBTEST_CHECK(in_order);
+
+	// Accumulating does not change the stored data
+	VKBTEST_CHECK(block.get_size() == 4);
+}
+
+void test_store_overflow_throws()
+{
+	vkb::PushConstantBlock block;
+
+	std::array<uint8_t, vkb::PushConstantBlock::MAX_SIZE> data{};
+
+	block.store(data.data(), vkb::PushConstantBlock::MAX_SIZE);
+
+	VKBTEST_CHECK(block.get_size() == vkb::PushConstantBlock::MAX_SIZE);
+
+	VKBTEST_CHECK_THROWS(block.store(data.data(), 1), std::runtime_error);
+
+	// The block is left as it was
+	VKBTEST_CHECK(block.get_size() == vkb::PushConstantBlock::MAX_SIZE);
+}
+
+void test_accumulate_overflow_throws()
+{
+	vkb::PushConstantBlock block;
+
+	std::array<uint8_t, vkb::PushConstantBlock::MAX_SIZE> data{};
+
+	block.store(data.data(), 16);
+
+	std::array<uint8_t, vkb::PushConstantBlock::MAX_SIZE> accumulated{};
+
+	// Filling the block exactly is allowed, one more byte is not
+	VKBTEST_CHECK(block.accumulate(data.data(), vkb::PushConstantBlock::MAX_SIZE - 16, accumulated) == vkb::PushConstantBlock::MAX_SIZE);
+
+	VKBTEST_CHECK_THROWS(block.accumulate(data.data(), vkb::PushConstantBlock::MAX_SIZE - 15, accumulated), std::runtime_error);
+}
+
+void test_clear_empties_block()
+{
+	vkb::PushConstantBlock block;
+
+	std::array<uint8_t, vkb::PushConstantBlock::MAX_SIZE> data{};
+
+	block.store(data.data(), vkb::PushConstantBlock::MAX_SIZE);
+	block.clear();
+
+	VKBTEST_CHECK(block.get_size() == 0);
+
+	// The whole capacity is available again
+	block.store(data.data(), vkb::PushConstantBlock::MAX_SIZE);
+
+	VKBTEST_CHECK(block.get_size() == vkb::PushConstantBlock::MAX_SIZE);
+}
+}        // namespace
+
+int main()
+{
+	test_accumulates_stored_data_first();
+	test_store_overflow_throws();
+	test_accumulate_overflow_throws();
+	test_clear_empties_block();
+
+	return vkbtest::get_test_result();
+}
@@ -0,0 +1,156 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/radix_sort.h"
+#include "unit_test.h"
+
+namespace
+{
+/**
+ * @brief Item remembering its position before the sort, so that the order of equal keys can be checked
+ */
+struct Item
+{
+	uint64_t key;
+
+	size_t original_index;
+};
+
+bool operator==(const Item &a, const Item &b)
+{
+	return a.key == b.key && a.original_index == b.original_index;
+}
+
+std::vector<Item> make_items(const std::vector<uint64_t> &keys)
+{
+	std::vector<Item> items;
+
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		items.push_back({keys[i], i});
+	}
+
+	return items;
+}
+
+/**
+ * @brief Sorts the keys with radix_sort and std::stable_sort, and checks that both give the same order
+ */
+void check_matches_stable_sort(const std::vector<uint64_t> &keys)
+{
+	auto items          = make_items(keys);
+	auto expected_items = items;
+
+	std::vector<Item> scratch(items.size());
+	vkb::radix_sort(items.data(), scratch.data(), items.size(), [](const Item &item) { return item.key; });
+
+	std::stable_sort(expected_items.begin(), expected_items.end(), [](const Item &a, const Item &b) { return a.key < b.key; });
+
+	VKBTEST_CHECK(items == expected_items);
+}
+
+std::vector<uint64_t> make_random_keys(size_t count, uint64_t mask, uint32_t seed)
+{
+	std::mt19937_64       generator{seed};
+	std::vector<uint64_t> keys(count);
+
+	for (auto &key : keys)
+	{
+		key = generator() & mask;
+	}
+
+	return keys;
+}
+
+void test_sorts_random_keys()
+{
+	// Full keys sort in eight passes, leaving the result in the items
+	check_matches_stable_sort(make_random_keys(10000, ~0ULL, 1));
+
+	// Keys using one, two or three bytes sort in an odd or even number of passes
+	check_matches_stable_sort(make_random_keys(10000, 0xFFULL, 2));
+	check_matches_stable_sort(make_random_keys(10000, 0xFFFFULL, 3));
+	check_matches_stable_sort(make_random_keys(10000, 0xFF00FF00000000ULL, 4));
+}
+
+void test_keeps_order_of_duplicate_keys()
+{
+	// Few distinct keys, each shared by many items
+	check_matches_stable_sort(make_random_keys(10000, 0x7ULL, 5));
+	check_matches_stable_sort(make_random_keys(10000, 0x8000000000000003ULL, 6));
+
+	// All keys equal, which skips every pass
+	check_matches_stable_sort(std::vector<uint64_t>(1000, 42));
+}
+
+void test_sorts_ordered_keys()
+{
+	std::vector<uint64_t> keys(1000);
+
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		keys[i] = i * 1000;
+	}
+
+	check_matches_stable_sort(keys);
+
+	std::reverse(keys.begin(), keys.end());
+
+	check_matches_stable_sort(keys);
+}
+
+void test_sorts_few_items()
+{
+	check_matches_stable_sort({});
+	check_matches_stable_sort({7});
+	check_matches_stable_sort({7, 3});
+	check_matches_stable_sort({3, 3});
+	check_matches_stable_sort({~0ULL, 0, 1ULL << 63, 0});
+}
+
+void test_moves_items()
+{
+	// Items which own memory are moved between passes, not copied
+	std::vector<std::string> items{"delta", "alpha", "charlie", "bravo", "alpha"};
+	std::vector<std::string> scratch(items.size());
+
+	vkb::radix_sort(items.data(), scratch.data(), items.size(), [](const std::string &item) {
+		return static_cast<uint64_t>(static_cast<unsigned char>(item[0]));
+	});
+
+	VKBTEST_CHECK((items == std::vector<std::string>{"alpha", "alpha", "bravo", "charlie", "delta"}));
+}
+}        // namespace
+
+int main()
+{
+	test_sorts_random_keys();
+	test_keeps_order_of_duplicate_keys();
+	test_sorts_ordered_keys();
+	test_sorts_few_items();
+	test_moves_items();
+
+	return vkbtest::get_test_result();
+}
@@ -0,0 +1,69 @@
+/* Copyright (c) 2019, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * @brief Reports a failed check, with its location, and marks the test as failed
+ */
+#define VKBTEST_CHECK(condition)                                                                  \
+	do                                                                                            \
+	{                                                                                             \
+		if (!(condition))                                                                         \
+		{                                                                                         \
+			std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			++vkbtest::failed_check_count;                                                        \
+		}                                                                                         \
+	} while (false)
+
+/**
+ * @brief Checks that an expression throws an exception of a given type
+ */
+#define VKBTEST_CHECK_THROWS(expression, exception_type) \
+	do                                                   \
+	{                                                    \
+		bool thrown{false};                              \
+		try                                              \
+		{                                                \
+			expression;                                  \
+		}                                                \
+		catch (const exception_type &)                   \
+		{                                                \
+			thrown = true;                               \
+		}                                                \
+		VKBTEST_CHECK(thrown && #expression " throws");  \
+	} while (false)
+
+namespace vkbtest
+{
+/// Number of failed checks in the unit test executable
+static int failed_check_count{0};
+
+/**
+ * @return The exit code of a unit test executable
+ */
+inline int get_test_result()
+{
+	return failed_check_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+}        // namespace vkbtest